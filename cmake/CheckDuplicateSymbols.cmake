@@ -0,0 +1,59 @@
+# 检查一起以whole-archive链接的静态库中是否有重复定义的强符号。
+# 用法：cmake -DNM=<nm> -P CheckDuplicateSymbols.cmake <lib1.a> <lib2.a> ...
+# 符号只有在编译之后才存在，因此在链接samples之前执行，而不是在配置阶段；
+# 有重复时列出符号（未解码，可用c++filt查看）和定义它的目标文件，构建失败
+
+if (NOT NM)
+    message(FATAL_ERROR "CheckDuplicateSymbols: NM is not set")
+endif()
+
+# 脚本之后的参数为静态库路径
+set(libs)
+set(first -1)
+math(EXPR last "${CMAKE_ARGC} - 1")
+foreach (i RANGE ${last})
+    if (first EQUAL -1 AND "${CMAKE_ARGV${i}}" STREQUAL "-P")
+        math(EXPR first "${i} + 2")
+    elseif (NOT first EQUAL -1 AND i GREATER_EQUAL first)
+        list(APPEND libs "${CMAKE_ARGV${i}}")
+    endif()
+endforeach()
+
+set(duplicates)
+foreach (lib ${libs})
+    execute_process(COMMAND ${NM} -A -P -g --defined-only ${lib}
+        OUTPUT_VARIABLE output
+        RESULT_VARIABLE result
+        ERROR_QUIET)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "CheckDuplicateSymbols: ${NM} failed on ${lib}")
+    endif()
+    # 每行为"lib.a[member.o]: symbol type value size"；弱符号(W/V)、common
+    # 符号(C)和GNU unique符号(u)允许重复，不检查
+    string(REGEX MATCHALL "[^\n]+" lines "${output}")
+    foreach (line ${lines})
+        if (NOT line MATCHES "^(.*): ([^ ]+) [ABDGRST]( |$)")
+            continue()
+        endif()
+        set(object "${CMAKE_MATCH_1}")
+        set(symbol "${CMAKE_MATCH_2}")
+        if (DEFINED owner_${symbol})
+            if (NOT owner_${symbol} STREQUAL object)
+                list(APPEND duplicates ${symbol})
+                set(owner_${symbol} "${owner_${symbol}}, ${object}")
+            endif()
+        else()
+            set(owner_${symbol} "${object}")
+        endif()
+    endforeach()
+endforeach()
+
+if (duplicates)
+    list(REMOVE_DUPLICATES duplicates)
+    set(report)
+    foreach (symbol ${duplicates})
+        string(APPEND report "\n  ${symbol}: ${owner_${symbol}}")
+    endforeach()
+    message(FATAL_ERROR "Duplicate symbols in statically linked libraries, "
+        "rename them or give them internal linkage:${report}")
+endif()
@@ -20,6 +20,7 @@
 #include "common/bmnn_utils.h"
 #include "common/common_defs.h"
 #include "common/object_metadata.h"
+#include "common/tensor_mem_pool.h"
 
 namespace sophon_stream {
 namespace element {
@@ -32,8 +33,115 @@ class Context {
  public:
   Context() = default;
   virtual ~Context() = default;
+
+  /**
+   * @brief NPU heap上的显存池，由initTensorMemPool按网络shape预热
+   */
+  std::shared_ptr<common::TensorMemPool> tensorMemPool;
+
+  /**
+   * @brief VPP饱和时交给CPU做前处理的帧的比例，0表示只使用VPP
+   */
+  float cpuPreprocessRatio = 0.f;
 };
 
+/**
+ * @brief 获取context所在设备的NPU显存池
+ */
+template <typename T, typename U = Context,
+          typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+              nullptr>
+std::shared_ptr<common::TensorMemPool> getTensorMemPool(
+    std::shared_ptr<T> context) {
+  if (context->tensorMemPool) return context->tensorMemPool;
+  return common::TensorMemPool::getInstance(context->deviceId,
+                                            STREAM_NPU_HEAP);
+}
+
+/**
+ * @brief 绑定显存池，并按网络输入输出shape预热：每个输入预留max_batch份单帧显存，
+ * 输出预留一份整batch显存和max_batch份单帧显存
+ * @brief 需要在bmNetwork和max_batch初始化之后调用
+ */
+template <typename T, typename U = Context,
+          typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+              nullptr>
+void initTensorMemPool(std::shared_ptr<T> context) {
+  context->tensorMemPool = common::TensorMemPool::getInstance(
+      context->deviceId, STREAM_NPU_HEAP);
+  const bm_net_info_t* netinfo = context->bmNetwork->m_netinfo;
+  int maxBatch = context->max_batch > 0 ? context->max_batch : 1;
+  for (int i = 0; i < netinfo->input_num; ++i) {
+    size_t bytes = bmrt_shape_count(&netinfo->stages[0].input_shapes[i]) *
+                   bmrt_data_type_size(netinfo->input_dtypes[i]);
+    context->tensorMemPool->reserve(bytes / maxBatch, maxBatch);
+    if (maxBatch > 1) context->tensorMemPool->reserve(bytes, 1);
+  }
+  for (int i = 0; i < netinfo->output_num; ++i) {
+    size_t bytes = 0;
+    for (int s = 0; s < netinfo->stage_num; ++s) {
+      size_t stageBytes =
+          bmrt_shape_count(&netinfo->stages[s].output_shapes[i]) *
+          bmrt_data_type_size(netinfo->output_dtypes[i]);
+      if (bytes < stageBytes) bytes = stageBytes;
+    }
+    context->tensorMemPool->reserve(bytes, 1);
+    if (maxBatch > 1)
+      context->tensorMemPool->reserve(bytes / maxBatch, maxBatch);
+  }
+}
+
+/**
+ * @brief bmTensors的deleter，池内显存归还显存池，其余显存直接释放
+ */
+inline void recycleTensors(common::bmTensors* p) {
+  // batch视图的显存由batch统一回收
+  for (int i = 0; p->batch == nullptr && i < p->tensors.size(); ++i) {
+    if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
+      common::TensorMemPool::recycle(p->handle, p->tensors[i]->device_mem);
+    }
+  }
+  delete p;
+}
+
+/**
+ * @brief 生成batch中第slot帧的视图：tensor的device_mem指向batch显存中第slot个
+ * 大小为sliceBytes[i]的切片，shape的batch维除以batchSize
+ * @brief 视图持有batch的引用，所有视图释放后batch显存才归还显存池
+ */
+inline std::shared_ptr<common::bmTensors> makeBatchSlotView(
+    std::shared_ptr<common::bmTensors> batch, int slot, int batchSize,
+    const std::vector<unsigned int>& sliceBytes) {
+  auto view = std::make_shared<common::bmTensors>();
+  view->handle = batch->handle;
+  view->batch = batch;
+  view->batch_slot = slot;
+  view->tensors.resize(batch->tensors.size());
+  for (int i = 0; i < batch->tensors.size(); ++i) {
+    view->tensors[i] = std::make_shared<bm_tensor_t>(*batch->tensors[i]);
+    view->tensors[i]->shape.dims[0] /= batchSize;
+    unsigned long long addr =
+        bm_mem_get_device_addr(batch->tensors[i]->device_mem) +
+        static_cast<unsigned long long>(slot) * sliceBytes[i];
+    view->tensors[i]->device_mem = bm_mem_from_device(addr, sliceBytes[i]);
+  }
+  return view;
+}
+
+/**
+ * @brief bmSubTensors的deleter，语义同recycleTensors
+ */
+inline void recycleSubTensors(common::bmSubTensors* p) {
+  for (int i = 0; i < p->tensors.size(); ++i) {
+    for (int j = 0; j < p->tensors[i].size(); ++j) {
+      if (p->tensors[i][j]->device_mem.u.device.device_addr != 0) {
+        common::TensorMemPool::recycle(p->handle, p->tensors[i][j]->device_mem);
+      }
+    }
+  }
+  delete p;
+}
+
 }  // namespace element
 }  // namespace sophon_stream
 
@@ -22,19 +22,13 @@ class Inference {
                 nullptr>
   std::shared_ptr<sophon_stream::common::bmTensors> mergeInputDeviceMem(
       std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas) {
+    // 前处理已经写入同一块batch显存时直接使用，不再拷贝
+    auto batchSlots = getBatchSlotsInput(context, objectMetadatas);
+    if (batchSlots) return batchSlots;
     // 合并inputBMtensors，并且申请连续的outputBMtensors
     std::shared_ptr<sophon_stream::common::bmTensors> inputTensors =
         std::make_shared<sophon_stream::common::bmTensors>();
-    inputTensors.reset(
-        new sophon_stream::common::bmTensors(),
-        [](sophon_stream::common::bmTensors* p) {
-          for (int i = 0; i < p->tensors.size(); ++i)
-            if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i]->device_mem);
-            }
-          delete p;
-          p = nullptr;
-        });
+    inputTensors.reset(new sophon_stream::common::bmTensors(), recycleTensors);
     inputTensors->handle = context->handle;
     inputTensors->tensors.resize(context->input_num);
     for (int i = 0; i < context->input_num; ++i) {
@@ -50,10 +44,9 @@ class Inference {
                         context->net_h * context->net_w;
       if (BM_FLOAT32 == context->bmNetwork->m_netinfo->input_dtypes[0])
         input_bytes *= 4;
-      // malloc空间
-      auto ret = bm_malloc_device_byte_heap(
-          inputTensors->handle, &inputTensors->tensors[i]->device_mem, STREAM_NPU_HEAP,
-          input_bytes);
+      // 从显存池获取空间
+      auto ret = getTensorMemPool(context)->acquire(
+          input_bytes, &inputTensors->tensors[i]->device_mem);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
       // d2d
       for (int j = 0; j < objectMetadatas.size(); ++j) {
@@ -68,6 +61,30 @@ class Inference {
     return inputTensors;
   }
 
+  /**
+   * @brief 若各帧的mInputBMtensors依次是同一块batch显存（见initBatchSlots）的
+   * 第0,1,2...个切片，返回该batch，否则返回nullptr
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  std::shared_ptr<sophon_stream::common::bmTensors> getBatchSlotsInput(
+      std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas) {
+    auto& first = objectMetadatas[0]->mInputBMtensors;
+    if (first == nullptr || first->batch == nullptr) return nullptr;
+    auto batch = first->batch;
+    if (batch->tensors.size() != context->input_num ||
+        batch->tensors[0]->shape.dims[0] != context->max_batch)
+      return nullptr;
+    for (int j = 0; j < objectMetadatas.size(); ++j) {
+      if (objectMetadatas[j]->mFrame->mEndOfStream) break;
+      auto& input = objectMetadatas[j]->mInputBMtensors;
+      if (input == nullptr || input->batch != batch || input->batch_slot != j)
+        return nullptr;
+    }
+    return batch;
+  }
+
   template <typename T, typename U = Context,
             typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
                 nullptr>
@@ -75,16 +92,8 @@ class Inference {
       std::shared_ptr<T> context) {
     std::shared_ptr<sophon_stream::common::bmTensors> outputTensors =
         std::make_shared<sophon_stream::common::bmTensors>();
-    outputTensors.reset(
-        new sophon_stream::common::bmTensors(),
-        [](sophon_stream::common::bmTensors* p) {
-          for (int i = 0; i < p->tensors.size(); ++i)
-            if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i]->device_mem);
-            }
-          delete p;
-          p = nullptr;
-        });
+    outputTensors.reset(new sophon_stream::common::bmTensors(),
+                        recycleTensors);
     outputTensors->handle = context->handle;
     outputTensors->tensors.resize(context->output_num);
     for (int i = 0; i < context->output_num; ++i) {
@@ -110,10 +119,9 @@ class Inference {
       else if (BM_FLOAT16 == context->bmNetwork->m_netinfo->output_dtypes[i])
         max_size *= 2;
       
-      // malloc空间
-      auto ret = bm_malloc_device_byte_heap(
-          outputTensors->handle, &outputTensors->tensors[i]->device_mem, STREAM_NPU_HEAP,
-          max_size);
+      // 从显存池获取空间
+      auto ret = getTensorMemPool(context)->acquire(
+          max_size, &outputTensors->tensors[i]->device_mem);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
     }
     return outputTensors;
@@ -125,54 +133,53 @@ class Inference {
   void splitOutputMemIntoObjectMetadatas(
       std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas,
       std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
-    // 把outputTensors的显存拆出来给objectMetadatas
+    // 每帧的输出是outputTensors中对应切片的视图，不再申请显存和拷贝
+    std::vector<unsigned int> sliceBytes(context->output_num);
+    bool useView = true;
+    for (int j = 0; j < context->output_num; ++j) {
+      size_t max_size = 0;
+      for (int s = 0; s < context->bmNetwork->m_netinfo->stage_num; s++) {
+        size_t out_size = bmrt_shape_count(
+            &context->bmNetwork->m_netinfo->stages[s].output_shapes[j]);
+        if (max_size < out_size) {
+          max_size = out_size;
+        }
+      }
+      max_size *=
+          bmrt_data_type_size(context->bmNetwork->m_netinfo->output_dtypes[j]);
+      sliceBytes[j] = max_size / context->max_batch;
+      // SoC上后处理会mmap输出显存，切片不按页对齐时退回拷贝
+      if (context->bmNetwork->is_soc && sliceBytes[j] % 4096 != 0)
+        useView = false;
+    }
     for (int i = 0; i < objectMetadatas.size(); ++i) {
       if (objectMetadatas[i]->mFrame->mEndOfStream) break;
+      if (useView) {
+        objectMetadatas[i]->mOutputBMtensors = makeBatchSlotView(
+            outputTensors, i, context->max_batch, sliceBytes);
+        continue;
+      }
       objectMetadatas[i]->mOutputBMtensors =
           std::make_shared<sophon_stream::common::bmTensors>();
       objectMetadatas[i]->mOutputBMtensors.reset(
-          new sophon_stream::common::bmTensors(),
-          [](sophon_stream::common::bmTensors* p) {
-            for (int i = 0; i < p->tensors.size(); ++i)
-              if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i]->device_mem);
-              }
-            delete p;
-            p = nullptr;
-          });
+          new sophon_stream::common::bmTensors(), recycleTensors);
       objectMetadatas[i]->mOutputBMtensors->tensors.resize(context->output_num);
       objectMetadatas[i]->mOutputBMtensors->handle = context->handle;
       for (int j = 0; j < context->output_num; ++j) {
         objectMetadatas[i]->mOutputBMtensors->tensors[j] =
-            std::make_shared<bm_tensor_t>();
-        objectMetadatas[i]->mOutputBMtensors->tensors[j]->dtype =
-            context->bmNetwork->m_netinfo->output_dtypes[j];
-        objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape =
-            context->bmNetwork->m_netinfo->stages[0].output_shapes[j];
+            std::make_shared<bm_tensor_t>(*outputTensors->tensors[j]);
         objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape.dims[0] /=
             context->max_batch;
-        objectMetadatas[i]->mOutputBMtensors->tensors[j]->st_mode = BM_STORE_1N;
-        size_t max_size = 0;
-        for (int s = 0; s < context->bmNetwork->m_netinfo->stage_num; s++) {
-          size_t out_size = bmrt_shape_count(
-              &context->bmNetwork->m_netinfo->stages[s].output_shapes[j]);
-          if (max_size < out_size) {
-            max_size = out_size;
-          }
-        }
-        if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[j])
-          max_size *= 4;
-        max_size /= context->max_batch;
-        auto ret = bm_malloc_device_byte_heap(
-            objectMetadatas[i]->mOutputBMtensors->handle,
-            &objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem, STREAM_NPU_HEAP,
-            max_size);
+        auto ret = getTensorMemPool(context)->acquire(
+            sliceBytes[j],
+            &objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem);
         STREAM_CHECK(ret == 0,
                      "Alloc Device Memory Failed! Program Terminated.")
         bm_memcpy_d2d_byte(
             context->handle,
             objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem, 0,
-            outputTensors->tensors[j]->device_mem, i * max_size, max_size);
+            outputTensors->tensors[j]->device_mem, i * sliceBytes[j],
+            sliceBytes[j]);
       }
     }
   }
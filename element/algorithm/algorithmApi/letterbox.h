@@ -0,0 +1,416 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <tuple>
+#include <vector>
+
+#include "common/common_defs.h"
+#include "common/logger.h"
+#include "common/vpp_monitor.h"
+#include "letterbox_host.h"
+
+namespace sophon_stream {
+namespace element {
+
+#ifndef FFALIGN
+#define FFALIGN(x, a) (((x) + (a) - 1) & ~((a) - 1))
+#endif
+
+/**
+ * @brief 把bm_image下载到主机并转换为BGR packed的cv::Mat，只依赖bmlib，
+ * 不使用VPP。支持YUV420P、NV12、NV16、YUV422P、YUV444P、GRAY以及BGR/RGB的
+ * packed和planar格式，其他格式返回false
+ */
+inline bool letterboxDownload(const bm_image& image, cv::Mat& bgr) {
+  if (image.data_type != DATA_TYPE_EXT_1N_BYTE) return false;
+  int w = image.width;
+  int h = image.height;
+  int plane_num = bm_image_get_plane_num(image);
+  int stride[4] = {0};
+  bm_device_mem_t mems[4];
+  bm_image_get_stride(image, stride);
+  bm_image_get_device_mem(image, mems);
+  std::vector<std::vector<uint8_t>> planes(plane_num);
+  void* buffers[4] = {nullptr};
+  for (int i = 0; i < plane_num; ++i) {
+    planes[i].resize(bm_mem_get_device_size(mems[i]));
+    buffers[i] = planes[i].data();
+  }
+  if (bm_image_copy_device_to_host(image, buffers) != BM_SUCCESS) return false;
+
+  // 按步长逐行拷贝为紧密排列的单通道图像
+  auto pack = [](const uint8_t* src, int src_stride, int row_bytes, int rows,
+                 uint8_t* dst) {
+    for (int y = 0; y < rows; ++y)
+      memcpy(dst + y * row_bytes, src + y * src_stride, row_bytes);
+  };
+  switch (image.image_format) {
+    case FORMAT_YUV420P: {
+      cv::Mat yuv(h * 3 / 2, w, CV_8UC1);
+      pack(planes[0].data(), stride[0], w, h, yuv.data);
+      pack(planes[1].data(), stride[1], w / 2, h / 2, yuv.data + w * h);
+      pack(planes[2].data(), stride[2], w / 2, h / 2,
+           yuv.data + w * h + w * h / 4);
+      cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_I420);
+      return true;
+    }
+    case FORMAT_NV12: {
+      cv::Mat yuv(h * 3 / 2, w, CV_8UC1);
+      pack(planes[0].data(), stride[0], w, h, yuv.data);
+      pack(planes[1].data(), stride[1], w, h / 2, yuv.data + w * h);
+      cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_NV12);
+      return true;
+    }
+    case FORMAT_NV16:
+    case FORMAT_YUV422P: {
+      // 重排为YUYV后由OpenCV转换
+      cv::Mat yuyv(h, w, CV_8UC2);
+      bool nv16 = image.image_format == FORMAT_NV16;
+      for (int y = 0; y < h; ++y) {
+        const uint8_t* luma = planes[0].data() + y * stride[0];
+        const uint8_t* u = planes[1].data() + y * stride[1];
+        const uint8_t* v = nv16 ? u + 1 : planes[2].data() + y * stride[2];
+        int step = nv16 ? 2 : 1;
+        uint8_t* dst = yuyv.ptr<uint8_t>(y);
+        for (int x = 0; x + 1 < w; x += 2) {
+          dst[2 * x] = luma[x];
+          dst[2 * x + 1] = u[x / 2 * step];
+          dst[2 * x + 2] = luma[x + 1];
+          dst[2 * x + 3] = v[x / 2 * step];
+        }
+      }
+      cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
+      return true;
+    }
+    case FORMAT_YUV444P: {
+      std::vector<cv::Mat> channels(3);
+      for (int c = 0; c < 3; ++c)
+        channels[c] = cv::Mat(h, w, CV_8UC1, planes[c].data(), stride[c]);
+      cv::Mat yuv;
+      cv::merge(channels, yuv);
+      cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR);
+      return true;
+    }
+    case FORMAT_GRAY: {
+      cv::Mat gray(h, w, CV_8UC1, planes[0].data(), stride[0]);
+      cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+      return true;
+    }
+    case FORMAT_BGR_PACKED:
+    case FORMAT_RGB_PACKED: {
+      cv::Mat packed(h, w, CV_8UC3, planes[0].data(), stride[0]);
+      if (image.image_format == FORMAT_BGR_PACKED)
+        packed.copyTo(bgr);
+      else
+        cv::cvtColor(packed, bgr, cv::COLOR_RGB2BGR);
+      return true;
+    }
+    case FORMAT_BGR_PLANAR:
+    case FORMAT_RGB_PLANAR: {
+      std::vector<cv::Mat> channels(3);
+      for (int c = 0; c < 3; ++c)
+        channels[c] = cv::Mat(h, w, CV_8UC1,
+                              planes[0].data() + c * h * stride[0], stride[0]);
+      if (image.image_format == FORMAT_RGB_PLANAR)
+        std::swap(channels[0], channels[2]);
+      cv::merge(channels, bgr);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief letterboxTensor的cv::Mat版本
+ * @param bgr BGR packed的源图像，letterboxDownload的输出
+ * @param dst 网络单帧输入的主机内存
+ */
+inline void letterboxTensor(const cv::Mat& bgr, const bmcv_rect_t& crop,
+                            const LetterboxParam& param, void* dst) {
+  letterboxTensor(bgr.data, (int)bgr.step, crop, param, dst);
+}
+
+/**
+ * @brief 每个线程、每种网络输入各一份的前处理缓冲，跨batch复用，不再逐帧申请显存
+ * @brief resized为连续显存，可以一次convert_to处理整个batch；converted只有
+ * bm_image头，使用时attach到输出tensor的显存上
+ */
+class LetterboxBuffers {
+ public:
+  /**
+   * @brief 当前线程对应handle和param的缓冲，第一次调用时创建，线程退出时释放
+   */
+  static LetterboxBuffers& local(bm_handle_t handle,
+                                 const LetterboxParam& param) {
+    using Key = std::tuple<bm_handle_t, int, int, int, int>;
+    static thread_local std::map<Key, std::unique_ptr<LetterboxBuffers>>
+        buffers;
+    Key key{handle, param.net_w, param.net_h, param.format, param.dtype};
+    auto& buffer = buffers[key];
+    if (!buffer) buffer.reset(new LetterboxBuffers(handle, param));
+    return *buffer;
+  }
+
+  ~LetterboxBuffers() {
+    if (!resized.empty()) {
+      bm_image_free_contiguous_mem(resized.size(), resized.data());
+      for (auto& image : resized) bm_image_destroy(image);
+    }
+    for (auto& image : converted) bm_image_destroy(image);
+    for (auto& image : mAligned) bm_image_destroy(image);
+  }
+
+  /**
+   * @brief 保证resized和converted至少有num个
+   */
+  void reserve(int num) {
+    if (num <= resized.size()) return;
+    if (!resized.empty()) {
+      bm_image_free_contiguous_mem(resized.size(), resized.data());
+      for (auto& image : resized) bm_image_destroy(image);
+    }
+    // some API only accept bm_image whose stride is aligned to 64
+    int strides[3] = {stride(), stride(), stride()};
+    resized.resize(num);
+    for (auto& image : resized) {
+      bm_image_create(mHandle, mParam.net_h, mParam.net_w, mParam.format,
+                      DATA_TYPE_EXT_1N_BYTE, &image, strides);
+    }
+    auto ret = bm_image_alloc_contiguous_mem_heap_mask(num, resized.data(),
+                                                       STREAM_VPP_HEAP_MASK);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    while (converted.size() < num) {
+      converted.emplace_back();
+      bm_image_create(mHandle, mParam.net_h, mParam.net_w, mParam.format,
+                      mParam.dtype, &converted.back());
+    }
+  }
+
+  /**
+   * @brief 第i路输入的64字节对齐缓冲，尺寸变化时重新申请
+   */
+  bm_image& aligned(int i, const bm_image& src) {
+    if (mAligned.size() <= i) mAligned.resize(i + 1);
+    bm_image& image = mAligned[i];
+    if (image.image_private != nullptr && image.width == src.width &&
+        image.height == src.height)
+      return image;
+    if (image.image_private != nullptr) bm_image_destroy(image);
+    int aligned_w = FFALIGN(src.width, 64);
+    int strides[3] = {aligned_w, aligned_w, aligned_w};
+    bm_image_create(mHandle, src.height, src.width, mParam.format,
+                    DATA_TYPE_EXT_1N_BYTE, &image, strides);
+    auto ret = bm_image_alloc_dev_mem_heap_mask(image, STREAM_VPU_HEAP_MASK);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    return image;
+  }
+
+  int stride() const { return FFALIGN(mParam.net_w, 64); }
+
+  std::vector<bm_image> resized;
+  std::vector<bm_image> converted;
+
+  /**
+   * @brief VPP失败后的退避期内返回true，这期间的帧都在CPU上处理
+   * @param frames 本次要处理的帧数，从退避期中扣除
+   */
+  bool vppSuspended(int frames) {
+    if (mVppSkipFrames <= 0) return false;
+    mVppSkipFrames -= frames;
+    return true;
+  }
+
+  /**
+   * @brief VPP调用失败：暂停使用VPP一段时间后再重试，连续失败时退避期加倍，
+   * 偶发错误不会让该线程一直停留在CPU路径
+   */
+  void vppFailed() {
+    mVppBackoff = std::min(std::max(mVppBackoff * 2, VPP_RETRY_FRAMES),
+                           VPP_RETRY_MAX_FRAMES);
+    mVppSkipFrames = mVppBackoff;
+  }
+
+  void vppSucceeded() { mVppBackoff = 0; }
+
+  /**
+   * @brief 按ratio的比例决定下一帧是否分给CPU
+   */
+  bool takeCpuShare(float ratio) {
+    mCpuCredit += ratio;
+    if (mCpuCredit < 1.f) return false;
+    mCpuCredit -= 1.f;
+    return true;
+  }
+
+  /**
+   * @brief CPU路径的主机缓冲，容纳网络单帧输入
+   */
+  void* host(size_t bytes) {
+    if (mHost.size() < bytes) mHost.resize(bytes);
+    return mHost.data();
+  }
+
+ private:
+  LetterboxBuffers(bm_handle_t handle, const LetterboxParam& param)
+      : mHandle(handle), mParam(param) {}
+
+  bm_handle_t mHandle;
+  LetterboxParam mParam;
+  std::vector<bm_image> mAligned;
+  std::vector<uint8_t> mHost;
+  float mCpuCredit = 0.f;
+  static constexpr int VPP_RETRY_FRAMES = 64;
+  static constexpr int VPP_RETRY_MAX_FRAMES = 4096;
+  int mVppBackoff = 0;
+  int mVppSkipFrames = 0;
+};
+
+/**
+ * @brief 对一批图像做letterbox和归一化，结果写入dsts
+ * @brief 步长满足64字节对齐的源图像直接送入VPP，否则先转换到持久的对齐缓冲；
+ * 色彩空间转换、裁剪、缩放和填充由一次VPP调用完成，输出显存连续时一次convert_to
+ * 处理整个batch。
+ * @brief VPP饱和时按param.cpu_ratio把一部分帧交给CPU完整处理，VPP失败后的
+ * 退避期内全部交给CPU；对齐转换失败的帧也交给CPU
+ * @param crops 每幅图像的裁剪区域
+ * @param dsts 每幅图像的输出显存，大小不小于网络单帧输入
+ * @return 处理失败的图像下标（CPU路径不支持的格式），对应的输出被清零
+ */
+inline std::vector<int> letterboxBatch(bm_handle_t handle, std::vector<bm_image>& srcs,
+                           std::vector<bmcv_rect_t>& crops,
+                           const std::vector<bm_device_mem_t>& dsts,
+                           const LetterboxParam& param) {
+  int num = srcs.size();
+  std::vector<int> failed;
+  if (num == 0) return failed;
+  auto& buffers = LetterboxBuffers::local(handle, param);
+  buffers.reserve(num);
+  auto& monitor = common::VppMonitor::getInstance(bm_get_devid(handle));
+
+  int size_byte = 0;
+  bm_image_get_byte_size(buffers.converted[0], &size_byte);
+  for (int i = 0; i < num; ++i) {
+    STREAM_CHECK(size_byte <= bm_mem_get_device_size(dsts[i]),
+                 "Input Tensor Too Small! Program Terminated.")
+  }
+
+  // 分配到VPP和CPU的帧
+  std::vector<int> vpp;
+  std::vector<int> cpu;
+  bool suspended = buffers.vppSuspended(num);
+  bool offload = !suspended && param.cpu_ratio > 0.f && monitor.isSaturated();
+  for (int i = 0; i < num; ++i) {
+    if (suspended || (offload && buffers.takeCpuShare(param.cpu_ratio)))
+      cpu.push_back(i);
+    else
+      vpp.push_back(i);
+  }
+
+  // 步长不满足对齐的帧先转换到对齐缓冲，转换失败的帧改在CPU上处理
+  std::vector<bm_image> inputs;
+  std::vector<bmcv_rect_t> vpp_crops;
+  std::vector<bmcv_padding_atrr_t> paddings;
+  std::vector<int> accepted;
+  for (int i : vpp) {
+    bm_image input = srcs[i];
+    if (srcs[i].image_format != FORMAT_COMPRESSED) {
+      int stride[4] = {0};
+      bm_image_get_stride(srcs[i], stride);
+      bool need_align = false;
+      for (int p = 0; p < bm_image_get_plane_num(srcs[i]); ++p)
+        need_align |= stride[p] & (64 - 1);
+      if (need_align) {
+        input = buffers.aligned(inputs.size(), srcs[i]);
+        auto ret = bmcv_image_storage_convert(handle, 1, &srcs[i], &input);
+        if (ret != BM_SUCCESS) {
+          IVS_WARN("Align image for vpp failed, ret: {0}, fall back to cpu",
+                   ret);
+          cpu.push_back(i);
+          continue;
+        }
+      }
+    }
+    inputs.push_back(input);
+    vpp_crops.push_back(crops[i]);
+    paddings.push_back(
+        letterboxPadding(crops[i].crop_w, crops[i].crop_h, param));
+    accepted.push_back(i);
+  }
+  vpp.swap(accepted);
+
+  if (!vpp.empty()) {
+    int vpp_num = vpp.size();
+    std::vector<int> crop_num(vpp_num, 1);
+    bool idle = monitor.begin();
+    auto start = std::chrono::steady_clock::now();
+    auto ret = bmcv_image_vpp_basic(handle, vpp_num, inputs.data(),
+                                    buffers.resized.data(), crop_num.data(),
+                                    vpp_crops.data(), paddings.data());
+    monitor.end(vpp_num,
+                std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start)
+                    .count(),
+                idle);
+    if (ret == BM_SUCCESS) {
+      buffers.vppSucceeded();
+      // resized连续，输出也连续时整个batch一次完成归一化
+      for (int k = 0; k < vpp_num; ++k) {
+        bm_device_mem_t mem = dsts[vpp[k]];
+        bm_image_attach(buffers.converted[k], &mem);
+      }
+      int begin = 0;
+      for (int k = 1; k <= vpp_num; ++k) {
+        if (k < vpp_num && bm_mem_get_device_addr(dsts[vpp[k]]) ==
+                               bm_mem_get_device_addr(dsts[vpp[k - 1]]) +
+                                   bm_mem_get_device_size(dsts[vpp[k - 1]]))
+          continue;
+        bmcv_image_convert_to(handle, k - begin, param.converto_attr,
+                              &buffers.resized[begin],
+                              &buffers.converted[begin]);
+        begin = k;
+      }
+      for (int k = 0; k < vpp_num; ++k)
+        bm_image_detach(buffers.converted[k]);
+    } else {
+      IVS_WARN("Vpp letterbox failed, ret: {0}, fall back to cpu", ret);
+      buffers.vppFailed();
+      cpu.insert(cpu.end(), vpp.begin(), vpp.end());
+    }
+  }
+
+  cv::Mat bgr;
+  void* host = buffers.host(size_byte);
+  for (int i : cpu) {
+    if (letterboxDownload(srcs[i], bgr)) {
+      letterboxTensor(bgr, crops[i], param, host);
+    } else {
+      IVS_ERROR("Letterbox on cpu failed, image format: {0}",
+                (int)srcs[i].image_format);
+      memset(host, 0, size_byte);
+      failed.push_back(i);
+    }
+    bm_memcpy_s2d_partial(handle, dsts[i], host, size_byte);
+  }
+  return failed;
+}
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_H_
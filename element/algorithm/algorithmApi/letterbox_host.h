@@ -0,0 +1,269 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_HOST_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_HOST_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bmcv_api_ext.h"
+#include "bmruntime_interface.h"
+
+namespace sophon_stream {
+namespace element {
+
+/**
+ * @brief letterbox前处理的参数：等比缩放到net_w*net_h，其余部分填充padding，
+ * 再按converto_attr做归一化
+ */
+struct LetterboxParam {
+  int net_w = 0;
+  int net_h = 0;
+  bm_image_format_ext format = FORMAT_BGR_PLANAR;  // 网络输入格式
+  bm_image_data_format_ext dtype = DATA_TYPE_EXT_FLOAT32;  // 归一化后的类型
+  bmcv_convert_to_attr converto_attr;
+  bool center = true;            // 缩放后的图像居中，否则贴左上角
+  unsigned char padding = 114;   // 填充值
+  float cpu_ratio = 0.f;         // VPP饱和时分给CPU处理的帧的比例
+};
+
+/**
+ * @brief CPU路径缩放填充后的8位图像与VPP输出逐像素的最大误差，源图像为BGR时
+ * 成立；YUV源图像在CPU上另做色彩转换，误差还包括转换系数的差异
+ */
+constexpr int LETTERBOX_VPP_TOLERANCE = 1;
+
+/**
+ * @brief 双线性插值权重的小数位数，与VPP的定点精度相同
+ */
+constexpr int LETTERBOX_WEIGHT_BITS = 11;
+
+/**
+ * @brief 网络输入tensor类型对应的bm_image类型
+ */
+inline bm_image_data_format_ext letterboxDtype(bm_data_type_t dtype) {
+  if (dtype == BM_INT8) return DATA_TYPE_EXT_1N_BYTE_SIGNED;
+  if (dtype == BM_FLOAT16) return DATA_TYPE_EXT_FP16;
+  return DATA_TYPE_EXT_FLOAT32;
+}
+
+/**
+ * @brief 计算crop区域缩放后在网络输入中的位置，VPP与CPU路径共用，保证两者以及
+ * 后处理还原坐标时一致
+ */
+inline bmcv_padding_atrr_t letterboxPadding(int crop_w, int crop_h,
+                                            const LetterboxParam& param) {
+  bmcv_padding_atrr_t padding_attr;
+  memset(&padding_attr, 0, sizeof(padding_attr));
+  padding_attr.padding_b = param.padding;
+  padding_attr.padding_g = param.padding;
+  padding_attr.padding_r = param.padding;
+  padding_attr.if_memset = 1;
+  float r_w = (float)param.net_w / crop_w;
+  float r_h = (float)param.net_h / crop_h;
+  if (r_h > r_w) {
+    padding_attr.dst_crop_w = param.net_w;
+    padding_attr.dst_crop_h = crop_h * r_w;
+    if (param.center)
+      padding_attr.dst_crop_sty =
+          (int)((param.net_h - padding_attr.dst_crop_h) / 2);
+  } else {
+    padding_attr.dst_crop_w = crop_w * r_h;
+    padding_attr.dst_crop_h = param.net_h;
+    if (param.center)
+      padding_attr.dst_crop_stx =
+          (int)((param.net_w - padding_attr.dst_crop_w) / 2);
+  }
+  return padding_attr;
+}
+
+/**
+ * @brief 一个方向上的双线性插值表：输出第i个像素取源像素index[2i]和
+ * index[2i+1]，权重weight[2i]和weight[2i+1]之和为1<<LETTERBOX_WEIGHT_BITS
+ * @brief 与VPP相同按像素中心对齐：src = (dst + 0.5) * scale - 0.5，
+ * 越过边界的位置取边界像素
+ */
+inline void letterboxAxis(int src_len, int dst_len, std::vector<int>& index,
+                          std::vector<int>& weight) {
+  const int one = 1 << LETTERBOX_WEIGHT_BITS;
+  index.resize(dst_len * 2);
+  weight.resize(dst_len * 2);
+  float scale = (float)src_len / dst_len;
+  for (int d = 0; d < dst_len; ++d) {
+    float pos = (d + 0.5f) * scale - 0.5f;
+    int s = (int)std::floor(pos);
+    float frac = pos - s;
+    if (s < 0) {
+      s = 0;
+      frac = 0.f;
+    }
+    if (s >= src_len - 1) {
+      s = src_len - 1;
+      frac = 0.f;
+    }
+    int w1 = (int)std::lround(frac * one);
+    index[2 * d] = s;
+    index[2 * d + 1] = std::min(s + 1, src_len - 1);
+    weight[2 * d] = one - w1;
+    weight[2 * d + 1] = w1;
+  }
+}
+
+/**
+ * @brief CPU上的letterbox，裁剪区域、缩放尺寸和填充与VPP路径相同，不依赖设备
+ * 和OpenCV
+ * @brief 缩放为定点双线性插值，两个方向的权重相乘后四舍五入，与VPP的误差
+ * 不超过LETTERBOX_VPP_TOLERANCE；GRAY输出按BT.601系数由缩放后的BGR转换
+ * @param bgr BGR packed的源图像
+ * @param src_step 源图像每行的字节数
+ * @param crop 源图像上的裁剪区域
+ * @param param 网络输入参数，format为BGR/RGB planar或GRAY
+ * @param stride 输出每行的字节数，不小于net_w
+ * @param planar 输出，(通道数*net_h)行、每行stride字节，逐通道平铺
+ */
+inline void letterboxResize(const uint8_t* bgr, int src_step,
+                            const bmcv_rect_t& crop,
+                            const LetterboxParam& param, int stride,
+                            uint8_t* planar) {
+  int channels = param.format == FORMAT_GRAY ? 1 : 3;
+  memset(planar, param.padding, (size_t)channels * param.net_h * stride);
+  auto padding_attr = letterboxPadding(crop.crop_w, crop.crop_h, param);
+  int dst_w = padding_attr.dst_crop_w;
+  int dst_h = padding_attr.dst_crop_h;
+  std::vector<int> x_index, x_weight, y_index, y_weight;
+  letterboxAxis(crop.crop_w, dst_w, x_index, x_weight);
+  letterboxAxis(crop.crop_h, dst_h, y_index, y_weight);
+
+  // 输出通道c取BGR中的第order[c]个
+  int order[3] = {0, 1, 2};
+  if (param.format == FORMAT_RGB_PLANAR) std::swap(order[0], order[2]);
+  const int round = 1 << (2 * LETTERBOX_WEIGHT_BITS - 1);
+  const uint8_t* origin = bgr + (size_t)crop.start_y * src_step +
+                          (size_t)crop.start_x * 3;
+  for (int y = 0; y < dst_h; ++y) {
+    const uint8_t* row0 = origin + (size_t)y_index[2 * y] * src_step;
+    const uint8_t* row1 = origin + (size_t)y_index[2 * y + 1] * src_step;
+    int wy0 = y_weight[2 * y];
+    int wy1 = y_weight[2 * y + 1];
+    size_t offset = (size_t)(padding_attr.dst_crop_sty + y) * stride +
+                    padding_attr.dst_crop_stx;
+    for (int x = 0; x < dst_w; ++x) {
+      int x0 = x_index[2 * x] * 3;
+      int x1 = x_index[2 * x + 1] * 3;
+      int wx0 = x_weight[2 * x];
+      int wx1 = x_weight[2 * x + 1];
+      int pixel[3];
+      for (int c = 0; c < 3; ++c) {
+        int top = row0[x0 + c] * wx0 + row0[x1 + c] * wx1;
+        int bottom = row1[x0 + c] * wx0 + row1[x1 + c] * wx1;
+        pixel[c] = (top * wy0 + bottom * wy1 + round) >>
+                   (2 * LETTERBOX_WEIGHT_BITS);
+      }
+      if (channels == 1) {
+        planar[offset + x] =
+            (pixel[2] * 4899 + pixel[1] * 9617 + pixel[0] * 1868 + 8192) >> 14;
+        continue;
+      }
+      for (int c = 0; c < 3; ++c)
+        planar[(size_t)c * param.net_h * stride + offset + x] =
+            pixel[order[c]];
+    }
+  }
+}
+
+/**
+ * @brief float转IEEE半精度，就近舍入到偶数，与VPP的FP16输出一致
+ */
+inline uint16_t letterboxHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs = bits & 0x7fffffff;
+  // NaN、无穷以及舍入后超出65504的值
+  if (abs > 0x7f800000) return sign | 0x7e00;
+  if (abs >= 0x477ff000) return sign | 0x7c00;
+  uint32_t half, rem, halfway;
+  if (abs >= 0x38800000) {
+    // 规格化数：指数偏置127改为15，尾数保留10位
+    half = (abs - 0x38000000) >> 13;
+    rem = abs & 0x1fff;
+    halfway = 0x1000;
+  } else {
+    // 非规格化数，小于2^-25的值舍入为0
+    if (abs < 0x33000000) return sign;
+    uint32_t mant = (abs & 0x7fffff) | 0x800000;
+    int shift = 126 - (int)(abs >> 23);
+    half = mant >> shift;
+    rem = mant & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  }
+  if (rem > halfway || (rem == halfway && (half & 1))) ++half;
+  return sign | half;
+}
+
+/**
+ * @brief CPU上的归一化和量化，与bmcv_image_convert_to一致：
+ * dst = alpha * src + beta按float计算，INT8就近舍入到偶数后饱和，
+ * FP16就近舍入到偶数
+ * @param planar letterboxResize的输出
+ * @param stride planar每行的字节数
+ * @param dst 网络单帧输入的主机内存
+ */
+inline void letterboxNormalize(const uint8_t* planar, int stride,
+                               const LetterboxParam& param, void* dst) {
+  const auto& attr = param.converto_attr;
+  float alpha[3] = {attr.alpha_0, attr.alpha_1, attr.alpha_2};
+  float beta[3] = {attr.beta_0, attr.beta_1, attr.beta_2};
+  int channels = param.format == FORMAT_GRAY ? 1 : 3;
+  for (int c = 0; c < channels; ++c) {
+    for (int y = 0; y < param.net_h; ++y) {
+      const uint8_t* src = planar + ((size_t)c * param.net_h + y) * stride;
+      size_t index = ((size_t)c * param.net_h + y) * param.net_w;
+      if (param.dtype == DATA_TYPE_EXT_1N_BYTE_SIGNED) {
+        int8_t* out = static_cast<int8_t*>(dst) + index;
+        for (int x = 0; x < param.net_w; ++x) {
+          float value = std::nearbyint(alpha[c] * src[x] + beta[c]);
+          out[x] = (int8_t)std::min(std::max(value, -128.f), 127.f);
+        }
+      } else if (param.dtype == DATA_TYPE_EXT_FP16) {
+        uint16_t* out = static_cast<uint16_t*>(dst) + index;
+        for (int x = 0; x < param.net_w; ++x)
+          out[x] = letterboxHalf(alpha[c] * src[x] + beta[c]);
+      } else {
+        float* out = static_cast<float*>(dst) + index;
+        for (int x = 0; x < param.net_w; ++x)
+          out[x] = alpha[c] * src[x] + beta[c];
+      }
+    }
+  }
+}
+
+/**
+ * @brief 完整的CPU前处理：letterbox、归一化和量化，不依赖设备
+ * @param bgr BGR packed的源图像
+ * @param src_step 源图像每行的字节数
+ * @param dst 网络单帧输入的主机内存
+ */
+inline void letterboxTensor(const uint8_t* bgr, int src_step,
+                            const bmcv_rect_t& crop,
+                            const LetterboxParam& param, void* dst) {
+  int channels = param.format == FORMAT_GRAY ? 1 : 3;
+  std::vector<uint8_t> planar((size_t)channels * param.net_h * param.net_w);
+  letterboxResize(bgr, src_step, crop, param, param.net_w, planar.data());
+  letterboxNormalize(planar.data(), param.net_w, param, dst);
+}
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_LETTERBOX_HOST_H_
@@ -10,7 +10,12 @@
 #ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_PREPROCESS_H_
 #define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_PREPROCESS_H_
 
+#include <algorithm>
+#include <mutex>
+
+#include "common/preprocess_cache.h"
 #include "context.h"
+#include "letterbox.h"
 
 namespace sophon_stream {
 namespace element {
@@ -18,7 +23,9 @@ namespace element {
 class PreProcess {
  public:
   PreProcess() = default;
-  virtual ~PreProcess() = default;
+  virtual ~PreProcess() {
+    common::PreprocessDemand::getInstance().removeConsumer(this);
+  }
 
   float get_aspect_scaled_ratio(int src_w, int src_h, int dst_w, int dst_h,
                                 bool* pIsAligWidth) {
@@ -43,20 +50,8 @@ class PreProcess {
     for (auto& obj : objectMetadatas) {
       obj->mInputBMtensors =
           std::make_shared<sophon_stream::common::bmTensors>();
-      int channelId = obj->mFrame->mChannelId;
-      int frameId = obj->mFrame->mFrameId;
-      obj->mInputBMtensors.reset(
-          new sophon_stream::common::bmTensors(),
-          [channelId, frameId](sophon_stream::common::bmTensors* p) {
-            for (int i = 0; i < p->tensors.size(); ++i) {
-              if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i]->device_mem);
-              }
-            }
-
-            delete p;
-            p = nullptr;
-          });
+      obj->mInputBMtensors.reset(new sophon_stream::common::bmTensors(),
+                                 recycleTensors);
       obj->mInputBMtensors->handle = context->handle;
       obj->mInputBMtensors->tensors.resize(context->input_num);
       for (int i = 0; i < context->input_num; ++i) {
@@ -70,6 +65,157 @@ class PreProcess {
       }
     }
   }
+
+  /**
+   * @brief 与initTensors作用相同，但一个batch内所有帧的输入共用一块连续显存，
+   * 第i帧的mInputBMtensors是其中第i个切片的视图，device_mem已经分配好。
+   * @brief 前处理直接把结果写入该切片，推理时mergeInputDeviceMem不再拷贝
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  void initBatchSlots(std::shared_ptr<T> context,
+                      common::ObjectMetadatas& objectMetadatas) {
+    int batchSize = std::max<int>(context->max_batch, objectMetadatas.size());
+    std::shared_ptr<sophon_stream::common::bmTensors> batch(
+        new sophon_stream::common::bmTensors(), recycleTensors);
+    batch->handle = context->handle;
+    batch->tensors.resize(context->input_num);
+    std::vector<unsigned int> sliceBytes(context->input_num);
+    for (int i = 0; i < context->input_num; ++i) {
+      batch->tensors[i] = std::make_shared<bm_tensor_t>();
+      batch->tensors[i]->dtype = context->bmNetwork->m_netinfo->input_dtypes[i];
+      batch->tensors[i]->shape =
+          context->bmNetwork->m_netinfo->stages[0].input_shapes[i];
+      batch->tensors[i]->st_mode = BM_STORE_1N;
+      int netBatch = batch->tensors[i]->shape.dims[0];
+      sliceBytes[i] = bmrt_shape_count(&batch->tensors[i]->shape) / netBatch *
+                      bmrt_data_type_size(batch->tensors[i]->dtype);
+      batch->tensors[i]->shape.dims[0] = batchSize;
+      auto ret = getTensorMemPool(context)->acquire(
+          sliceBytes[i] * batchSize, &batch->tensors[i]->device_mem);
+      STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    }
+    for (int j = 0; j < objectMetadatas.size(); ++j) {
+      objectMetadatas[j]->mInputBMtensors =
+          makeBatchSlotView(batch, j, batchSize, sliceBytes);
+    }
+  }
+
+  /**
+   * @brief 对有图像的帧做letterbox前处理，结果写入各帧mInputBMtensors的第0个
+   * tensor，调用前需要已经通过initBatchSlots等分配好显存
+   * @brief 同一graph中有其他前处理的参数完全相同时，结果缓存在Frame上共用，
+   * 先到的前处理负责生成，后到的直接拷贝
+   * @param format 网络输入格式
+   * @param center 缩放后的图像是否居中，否则贴左上角
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  void letterboxObjects(std::shared_ptr<T> context,
+                        common::ObjectMetadatas& objectMetadatas,
+                        bm_image_format_ext format, bool center = true) {
+    LetterboxParam param;
+    param.net_w = context->net_w;
+    param.net_h = context->net_h;
+    param.format = format;
+    param.dtype =
+        letterboxDtype(context->bmNetwork->inputTensor(0)->get_dtype());
+    param.converto_attr = context->converto_attr;
+    param.center = center;
+    param.cpu_ratio = context->cpuPreprocessRatio;
+
+    common::PreprocessKey key;
+    key.mDevId = context->deviceId;
+    key.mNetW = param.net_w;
+    key.mNetH = param.net_h;
+    key.mFormat = param.format;
+    key.mDataType = param.dtype;
+    key.mCenter = param.center;
+    key.mPadding = param.padding;
+    const auto& attr = param.converto_attr;
+    float alpha[3] = {attr.alpha_0, attr.alpha_1, attr.alpha_2};
+    float beta[3] = {attr.beta_0, attr.beta_1, attr.beta_2};
+    std::copy(alpha, alpha + 3, key.mAlpha);
+    std::copy(beta, beta + 3, key.mBeta);
+    if (context->roi_predefined) {
+      key.mCrop[0] = context->roi.start_x;
+      key.mCrop[1] = context->roi.start_y;
+      key.mCrop[2] = context->roi.crop_w;
+      key.mCrop[3] = context->roi.crop_h;
+    }
+    auto& demand = common::PreprocessDemand::getInstance();
+    int graphId = objectMetadatas[0]->mGraphId;
+    std::call_once(mDemandOnce,
+                   [&]() { demand.addConsumer(graphId, this, key); });
+    // 还有其他前处理会用到同样的结果
+    int others = demand.getConsumerNum(graphId, key) - 1;
+
+    std::vector<std::shared_ptr<common::ObjectMetadata>> misses;
+    std::vector<bm_image> images;
+    std::vector<bmcv_rect_t> crops;
+    std::vector<bm_device_mem_t> mems;
+    for (auto& objMetadata : objectMetadatas) {
+      if (objMetadata->mFrame->mSpData == nullptr) continue;
+      auto& frame = objMetadata->mFrame;
+      auto& tensor = objMetadata->mInputBMtensors->tensors[0];
+      if (others > 0) {
+        auto cached = frame->mPreprocessCache.take(key, frame->mSpData.get());
+        if (cached) {
+          bm_memcpy_d2d_byte(context->handle, tensor->device_mem, 0, *cached,
+                             0, inputBytes(tensor));
+          continue;
+        }
+      }
+      bm_image image = *frame->mSpData;
+      bmcv_rect_t crop_rect{0, 0, image.width, image.height};
+      if (context->roi_predefined) {
+        if (context->roi.start_x > image.width ||
+            context->roi.start_y > image.height ||
+            (context->roi.start_x + context->roi.crop_w) > image.width ||
+            (context->roi.start_y + context->roi.crop_h) > image.height) {
+          IVS_CRITICAL("ROI AREA OUT OF RANGE");
+          abort();
+        }
+        crop_rect = context->roi;
+      }
+      misses.push_back(objMetadata);
+      images.push_back(image);
+      crops.push_back(crop_rect);
+      mems.push_back(tensor->device_mem);
+    }
+    auto failed = letterboxBatch(context->handle, images, crops, mems, param);
+    for (int i : failed) misses[i]->mErrorCode = common::ErrorCode::UNKNOWN;
+    if (others <= 0) return;
+
+    // 拷贝一份放到Frame上，供后续的前处理使用
+    bm_handle_t handle = context->handle;
+    for (auto& objMetadata : misses) {
+      if (common::ErrorCode::SUCCESS != objMetadata->mErrorCode) continue;
+      auto& tensor = objMetadata->mInputBMtensors->tensors[0];
+      unsigned int bytes = inputBytes(tensor);
+      std::shared_ptr<bm_device_mem_t> cached(
+          new bm_device_mem_t(), [handle](bm_device_mem_t* mem) {
+            if (mem->u.device.device_addr != 0)
+              common::TensorMemPool::recycle(handle, *mem);
+            delete mem;
+          });
+      if (getTensorMemPool(context)->acquire(bytes, cached.get()) != 0)
+        continue;
+      bm_memcpy_d2d_byte(handle, *cached, 0, tensor->device_mem, 0, bytes);
+      objMetadata->mFrame->mPreprocessCache.put(
+          key, objMetadata->mFrame->mSpData.get(), cached, others);
+    }
+  }
+
+ private:
+  static unsigned int inputBytes(const std::shared_ptr<bm_tensor_t>& tensor) {
+    return bmrt_shape_count(&tensor->shape) *
+           bmrt_data_type_size(tensor->dtype);
+  }
+
+  std::once_flag mDemandOnce;
 };
 }  // namespace element
 }  // namespace sophon_stream
@@ -41,7 +41,18 @@ class BYTETracker {
 
   void update(std::shared_ptr<common::ObjectMetadata>& objects);
 
+  /**
+   * @brief 没有检测结果的帧（检测被跳过）：按卡尔曼状态外推轨迹并输出，
+   * 超过max_time_lost帧未匹配到检测的轨迹转为丢失
+   */
+  void predict(std::shared_ptr<common::ObjectMetadata>& objects);
+
  private:
+  /**
+   * @brief 把已激活的轨迹写回objects的检测、跟踪结果
+   */
+  void fill_objects(std::shared_ptr<common::ObjectMetadata>& objects);
+
   void joint_stracks(STracks& tlista, STracks& tlistb, STracks& results);
 
   void sub_stracks(STracks& tlista, STracks& tlistb);
@@ -119,7 +119,11 @@ void Bytetrack::process(
   if (mByteTrackerMap.end() != byteTrackerIt) {
     auto byteTracker = byteTrackerIt->second;
     if (byteTracker) {
-      byteTracker->update(objectMetadata);
+      // 检测被跳过的帧没有检测结果，只外推轨迹
+      if (objectMetadata->mDetectionSkipped)
+        byteTracker->predict(objectMetadata);
+      else
+        byteTracker->update(objectMetadata);
     } else {
       IVS_WARN("empty byteTrackerMap for dataPipeId : {0}", dataPipeId);
     }
@@ -46,19 +46,19 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   STracks unconfirmed;
   STracks strack_pool;
   STracks r_tracked_stracks;
-  STracks output_stracks;
 
-  if (objects->mDetectedObjectMetadatas.size() > 0) {
-    for (auto subObj : objects->mDetectedObjectMetadatas) {
+  auto& table = objects->getDetectionTable();
+  if (table.size() > 0) {
+    for (int row = 0; row < table.size(); ++row) {
       std::vector<float> tlbr_;
       tlbr_.resize(4);
-      tlbr_[0] = subObj->mBox.mX;
-      tlbr_[1] = subObj->mBox.mY;
-      tlbr_[2] = subObj->mBox.mX + subObj->mBox.mWidth;
-      tlbr_[3] = subObj->mBox.mY + subObj->mBox.mHeight;
+      tlbr_[0] = table.mX[row];
+      tlbr_[1] = table.mY[row];
+      tlbr_[2] = table.mX[row] + table.mWidth[row];
+      tlbr_[3] = table.mY[row] + table.mHeight[row];
 
-      float score = subObj->mScores[0];
-      int class_id = subObj->mClassify;
+      float score = table.mScore[row];
+      int class_id = table.mClassId[row];
       if (!(this->agnostic)) {
         tlbr_[0] += class_id * this->class_offset;
         tlbr_[1] += class_id * this->class_offset;
@@ -225,6 +225,42 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   this->tracked_stracks.assign(resa.begin(), resa.end());
   this->lost_stracks.clear();
   this->lost_stracks.assign(resb.begin(), resb.end());
+  fill_objects(objects);
+}
+
+void BYTETracker::predict(std::shared_ptr<common::ObjectMetadata>& objects) {
+  this->frame_id++;
+  STracks temp_tracked_stracks;
+  STracks temp_lost_stracks;
+  STrack::multi_predict(this->tracked_stracks, this->kalman_filter);
+  STrack::multi_predict(this->lost_stracks, this->kalman_filter);
+  for (auto& track : this->tracked_stracks) {
+    track->static_tlwh();
+    track->static_tlbr();
+    if (this->frame_id - track->end_frame() > this->max_time_lost) {
+      track->mark_lost();
+      temp_lost_stracks.push_back(track);
+    } else {
+      temp_tracked_stracks.push_back(track);
+    }
+  }
+  this->tracked_stracks.swap(temp_tracked_stracks);
+
+  STracks lost_stracks_swap;
+  for (auto& track : this->lost_stracks) {
+    if (this->frame_id - track->end_frame() <= this->max_time_lost)
+      lost_stracks_swap.push_back(track);
+  }
+  for (auto& track : temp_lost_stracks) lost_stracks_swap.push_back(track);
+  this->lost_stracks.swap(lost_stracks_swap);
+
+  fill_objects(objects);
+}
+
+void BYTETracker::fill_objects(
+    std::shared_ptr<common::ObjectMetadata>& objects) {
+  STracks output_stracks;
+  auto& table = objects->mutableDetectionTable();
   for (int i = 0; i < this->tracked_stracks.size(); i++) {
     if (this->tracked_stracks[i]->is_activated &&
         this->tracked_stracks[i]->tlwh[2] * this->tracked_stracks[i]->tlwh[3] >
@@ -235,13 +271,15 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   // objects->mSubObjectMetadatas.clear();
   objects->mDetectedObjectMetadatas.clear();
   objects->mTrackedObjectMetadatas.clear();
+  table.clear();
+  table.reserve(output_stracks.size());
   for (auto track_box : output_stracks) {
     std::shared_ptr<common::ObjectMetadata> subOutputMetaData =
-        std::make_shared<common::ObjectMetadata>();
+        common::makePooled<common::ObjectMetadata>();
     std::shared_ptr<common::DetectedObjectMetadata> mDetectedObjectMetadata =
-        std::make_shared<common::DetectedObjectMetadata>();
+        common::makeInArena<common::DetectedObjectMetadata>(objects->mArena);
     std::shared_ptr<common::TrackedObjectMetadata> mTrackedObjectMetadata =
-        std::make_shared<common::TrackedObjectMetadata>();
+        common::makeInArena<common::TrackedObjectMetadata>(objects->mArena);
 
     mDetectedObjectMetadata->mBox.mX =
         track_box->tlwh[0] < 0 ? 0 : track_box->tlwh[0];
@@ -271,6 +309,8 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
 
     objects->mDetectedObjectMetadatas.push_back(mDetectedObjectMetadata);
     objects->mTrackedObjectMetadatas.push_back(mTrackedObjectMetadata);
+    table.addRow(mDetectedObjectMetadata->mBox, track_box->score,
+                 track_box->class_id, track_box->track_id);
   }
 }
 
@@ -0,0 +1,419 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_FASTPOSE_POSE_NMS_H_
+#define SOPHON_STREAM_ELEMENT_FASTPOSE_POSE_NMS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "common/detected_object_metadata.h"
+#include "common/posed_object_metadata.h"
+
+namespace sophon_stream {
+namespace element {
+namespace fastpose {
+
+struct PoseNMSParams {
+  float delta1;
+  float mu;
+  float delta2;
+  float gamma;
+  float scoreThreds;
+  float matchThreds;
+  float alpha;
+  float face_factor;
+  float hand_factor;
+  float hand_weight_score;
+  float face_weight_score;
+  float hand_weight_dist;
+  float face_weight_dist;
+};
+
+/**
+ * @brief 姿态NMS，每轮选出平均分最高的姿态，删除与其关键点距离相近的姿态并合并。
+ * @brief
+ * 关键点和分数按候选扁平存放，每轮先用关键点包围框的间距排除不可能被删除的候选，
+ * 只对剩余候选逐关节计算距离和匹配数，结果与逐候选全量计算逐位一致。
+ * @brief
+ * 实现放在头文件中，tools/pose_nms_bench不依赖SDK即可编译测试；
+ * 数学函数的写法与原实现相同，保证重载决议和浮点结果不变
+ */
+class PoseNMS {
+ public:
+  explicit PoseNMS(const PoseNMSParams& params) : mParams(params) {}
+
+  /**
+   * @brief 对一帧中所有检测框的关键点做NMS
+   * @param det_data 检测框，用于计算参考距离
+   * @param num_joints 关键点个数，136、133时按全身模型处理
+   * @param area_thresh 关键点包围框的面积阈值
+   * @param body_keypoints 每个检测框的关键点，保留的姿态会被合并结果覆盖
+   * @param pick_ids 保留的姿态在body_keypoints中的下标
+   */
+  void run(
+      const std::vector<std::shared_ptr<common::DetectedObjectMetadata>>&
+          det_data,
+      int num_joints, float area_thresh,
+      std::vector<std::shared_ptr<common::PosedObjectMetadata>>&
+          body_keypoints,
+      std::vector<int>& pick_ids) const;
+
+ private:
+  /**
+   * @brief 第i个候选的第j个关键点位于i * num_joints + j
+   */
+  struct Candidates {
+    int num_joints;
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> scores;
+    std::vector<float> boxes;  // 关键点包围框，每个候选xmin,ymin,xmax,ymax
+
+    float* x(int i) { return xs.data() + i * num_joints; }
+    float* y(int i) { return ys.data() + i * num_joints; }
+    float* score(int i) { return scores.data() + i * num_joints; }
+    void updateBox(int i);
+  };
+
+  /**
+   * @brief 关键点包围框间距超过该值的候选不会被删除，也不参与合并
+   */
+  float skipDistance(int num_joints, bool full_body) const;
+  bool farApart(Candidates& cands, int i, int pick_id, double skip2) const;
+  void pointDistance(Candidates& cands, int i, int pick_id, float* dist) const;
+  float parametricDistance(Candidates& cands, int i, int pick_id,
+                           const float* dist, bool use_dist_mask) const;
+  int PCKMatch(const float* dist, int num_joints, float ref_dist) const;
+  int PCKMatchFullBody(const float* dist, int num_joints, float ref_dist,
+                       int add_num) const;
+  /**
+   * @param merge_ids 被合并的候选在near中的下标
+   */
+  void pMergeFast(Candidates& cands, const std::vector<int>& near,
+                  const std::vector<float>& dist,
+                  const std::vector<int>& merge_ids, int pick_id,
+                  float ref_dist) const;
+
+  PoseNMSParams mParams;
+};
+
+inline void PoseNMS::Candidates::updateBox(int i) {
+  const float* px = x(i);
+  const float* py = y(i);
+  float* box = boxes.data() + i * 4;
+  box[0] = box[2] = px[0];
+  box[1] = box[3] = py[0];
+  for (int j = 1; j < num_joints; j++) {
+    if (px[j] < box[0]) box[0] = px[j];
+    if (py[j] < box[1]) box[1] = py[j];
+    if (px[j] > box[2]) box[2] = px[j];
+    if (py[j] > box[3]) box[3] = py[j];
+  }
+}
+
+inline float PoseNMS::skipDistance(int num_joints, bool full_body) const {
+  const float inf = std::numeric_limits<float>::infinity();
+  if (!(mParams.gamma > 0) || !(mParams.delta2 > 0)) return inf;
+  if (full_body && !(mParams.face_factor > 0 && mParams.hand_factor > 0))
+    return inf;
+
+  // PCK匹配的ref_dist不超过7，score_dist只在距离不超过1时非0
+  float skip = 7.f;
+  if (full_body)
+    skip *= std::max({1.f, mParams.face_factor, mParams.hand_factor});
+  skip = std::max(skip, 1.f) * 1.01f;
+
+  // 所有关节距离都不小于d时final_dist的上界，留出浮点累加误差的余量
+  auto bound = [&](double d) {
+    if (!full_body)
+      return num_joints * mParams.mu * std::exp(-d / mParams.delta2);
+    return mParams.mu *
+           (std::exp(-d / mParams.delta2) +
+            mParams.face_weight_dist *
+                std::exp(-d / (mParams.delta2 * mParams.face_factor)) +
+            mParams.hand_weight_dist *
+                std::exp(-d / (mParams.delta2 * mParams.hand_factor)));
+  };
+  while (bound(skip) > 0.9 * mParams.gamma) {
+    skip *= 1.25f;
+    if (std::isinf(skip)) return inf;
+  }
+  return skip;
+}
+
+inline bool PoseNMS::farApart(Candidates& cands, int i, int pick_id,
+                              double skip2) const {
+  const float* a = cands.boxes.data() + i * 4;
+  const float* b = cands.boxes.data() + pick_id * 4;
+  // 包围框间距是任一关节距离的下界，NaN按0处理
+  float gx = std::max(a[0] - b[2], b[0] - a[2]);
+  float gy = std::max(a[1] - b[3], b[1] - a[3]);
+  double gap2 = 0;
+  if (gx > 0) gap2 += (double)gx * gx;
+  if (gy > 0) gap2 += (double)gy * gy;
+  return gap2 > skip2;
+}
+
+inline void PoseNMS::pointDistance(Candidates& cands, int i, int pick_id,
+                                   float* dist) const {
+  const float* xi = cands.x(i);
+  const float* yi = cands.y(i);
+  const float* xp = cands.x(pick_id);
+  const float* yp = cands.y(pick_id);
+  for (int j = 0; j < cands.num_joints; j++)
+    dist[j] = sqrt(pow(xi[j] - xp[j], 2) + pow(yi[j] - yp[j], 2));
+}
+
+inline float PoseNMS::parametricDistance(Candidates& cands, int i, int pick_id,
+                                         const float* dist,
+                                         bool use_dist_mask) const {
+  const int num_joints = cands.num_joints;
+  const float* pick_scores = cands.score(pick_id);
+  const float* scores = cands.score(i);
+  float final_dist = 0;
+  for (int j = 0; j < num_joints; j++) {
+    bool mask = dist[j] <= 1;
+    bool dist_mask;
+    if (use_dist_mask) {
+      dist_mask = scores[j] < mParams.scoreThreds;
+      mask &= dist_mask;
+    }
+
+    float score_dist = 0;
+    if (mask)
+      score_dist = tanh(pick_scores[j] / mParams.delta1) *
+                   tanh(scores[j] / mParams.delta1);
+
+    if (use_dist_mask) {
+      float point_dist;
+      if (j < num_joints - 110) {
+        point_dist = exp((-1) * dist[j] / mParams.delta2);
+        final_dist += ((dist_mask ? score_dist
+                                  : (score_dist + mParams.mu * point_dist)) /
+                       (num_joints - 110));
+      } else if (j < num_joints - 42) {
+        point_dist =
+            exp((-1) * dist[j] / (mParams.delta2 * mParams.face_factor));
+        final_dist +=
+            ((dist_mask ? score_dist * mParams.face_weight_score
+                        : (score_dist * mParams.face_weight_score +
+                           mParams.mu * point_dist *
+                               mParams.face_weight_dist)) /
+             68);
+      } else {
+        point_dist =
+            exp((-1) * dist[j] / (mParams.delta2 * mParams.hand_factor));
+        final_dist +=
+            ((dist_mask ? score_dist * mParams.hand_weight_score
+                        : (score_dist * mParams.hand_weight_score +
+                           mParams.mu * point_dist *
+                               mParams.hand_weight_dist)) /
+             42);
+      }
+    } else {
+      float point_dist = exp((-1) * dist[j] / mParams.delta2);
+      final_dist += (score_dist + mParams.mu * point_dist);
+    }
+  }
+  return final_dist;
+}
+
+inline int PoseNMS::PCKMatch(const float* dist, int num_joints,
+                             float ref_dist) const {
+  int num_match = 0;
+  for (int j = 0; j < num_joints; j++) num_match += dist[j] / ref_dist <= 1;
+  return num_match;
+}
+
+inline int PoseNMS::PCKMatchFullBody(const float* dist, int num_joints,
+                                     float ref_dist, int add_num) const {
+  int num_match = 0;
+  for (int j = 0; j < num_joints; j++) {
+    float ratio = dist[j] / ref_dist;
+    if (j < 26 && ratio <= 1)
+      num_match += add_num;
+    else if (26 <= j && j < 94 && ratio <= mParams.face_factor)
+      num_match += add_num;
+    else if (94 <= j && ratio <= mParams.hand_factor)
+      num_match += add_num;
+  }
+  return num_match;
+}
+
+inline void PoseNMS::pMergeFast(Candidates& cands, const std::vector<int>& near,
+                                const std::vector<float>& dist,
+                                const std::vector<int>& merge_ids, int pick_id,
+                                float ref_dist) const {
+  const int num_joints = cands.num_joints;
+  const int merge_num = merge_ids.size();
+  ref_dist = std::min(ref_dist, 15.f);
+  std::vector<float> normed_scores(merge_num * num_joints);
+  std::vector<float> sum_score(num_joints, 0.f);
+  for (int i = 0; i < merge_num; i++) {
+    const float* d = dist.data() + merge_ids[i] * num_joints;
+    const float* s = cands.score(near[merge_ids[i]]);
+    float* normed = normed_scores.data() + i * num_joints;
+    for (int j = 0; j < num_joints; j++) {
+      if (d[j] <= ref_dist) {
+        normed[j] = s[j];
+        sum_score[j] += normed[j];
+      } else
+        normed[j] = 0;
+    }
+  }
+
+  for (int i = 0; i < merge_num; i++) {
+    float* normed = normed_scores.data() + i * num_joints;
+    for (int j = 0; j < num_joints; j++) normed[j] /= sum_score[j];
+  }
+
+  // 按关节逐个写回，选中姿态本身也可能在merge_ids中，读在写之前
+  float* pick_x = cands.x(pick_id);
+  float* pick_y = cands.y(pick_id);
+  float* pick_score = cands.score(pick_id);
+  for (int j = 0; j < num_joints; j++) {
+    float final_pose1 = 0, final_pose2 = 0, final_score = 0;
+    for (int i = 0; i < merge_num; i++) {
+      int id = near[merge_ids[i]];
+      float normed = normed_scores[i * num_joints + j];
+      final_pose1 += (cands.x(id)[j] * normed);
+      final_pose2 += (cands.y(id)[j] * normed);
+      final_score += (pow(normed, 2) * sum_score[j]);
+    }
+    pick_x[j] = final_pose1;
+    pick_y[j] = final_pose2;
+    pick_score[j] = final_score;
+  }
+  cands.updateBox(pick_id);
+}
+
+inline void PoseNMS::run(
+    const std::vector<std::shared_ptr<common::DetectedObjectMetadata>>&
+        det_data,
+    int num_joints, float area_thresh,
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<int>& pick_ids) const {
+  const int num_samples = det_data.size();
+  const bool full_body = num_joints == 136 || num_joints == 133;
+
+  Candidates cands;
+  cands.num_joints = num_joints;
+  cands.xs.resize(num_samples * num_joints);
+  cands.ys.resize(num_samples * num_joints);
+  cands.scores.resize(num_samples * num_joints);
+  cands.boxes.resize(num_samples * 4);
+  std::vector<float> ref_dists(num_samples);
+  std::vector<float> human_scores(num_samples);
+  std::vector<char> mask(num_samples, true);
+  int num_valid_samples = num_samples;
+  for (int i = 0; i < num_samples; i++) {
+    float width = det_data[i]->mBox.mWidth, height = det_data[i]->mBox.mHeight;
+    ref_dists[i] = mParams.alpha * std::max(width, height);
+    const std::vector<float>& keypoints = body_keypoints[i]->keypoints;
+    const std::vector<float>& scores = body_keypoints[i]->scores;
+    float joints_score_sum = 0;
+    for (int j = 0; j < num_joints; j++) {
+      cands.x(i)[j] = keypoints[j * 2];
+      cands.y(i)[j] = keypoints[j * 2 + 1];
+      cands.score(i)[j] = scores[j];
+      joints_score_sum += scores[j];
+    }
+    human_scores[i] = joints_score_sum / num_joints;
+    cands.updateBox(i);
+  }
+
+  const float skip = skipDistance(num_joints, full_body);
+  const double skip2 = (double)skip * skip;
+  std::vector<int> near;  // 本轮需要与选中姿态比较的候选，按下标升序
+  std::vector<float> dist;
+  std::vector<int> delete_ids;
+  while (num_valid_samples > 0) {
+    int pick_id = 0;
+    while (!mask[pick_id]) pick_id++;
+    for (int i = pick_id + 1; i < num_samples; i++) {
+      if (mask[i] && human_scores[i] > human_scores[pick_id]) pick_id = i;
+    }
+
+    int relative_pick_id = 0;
+    near.clear();
+    for (int i = 0; i < num_samples; i++) {
+      if (!mask[i]) continue;
+      if (i == pick_id)
+        relative_pick_id = near.size();
+      else if (farApart(cands, i, pick_id, skip2))
+        continue;
+      near.push_back(i);
+    }
+
+    const int keep_num = near.size();
+    dist.resize(keep_num * num_joints);
+    for (int k = 0; k < keep_num; k++)
+      pointDistance(cands, near[k], pick_id, dist.data() + k * num_joints);
+
+    int add_num = 0;
+    if (full_body) {
+      int mask_num = 0;
+      const float* pick_scores = cands.score(pick_id);
+      for (int j = 0; j < num_joints; j++)
+        if (pick_scores[j] > mParams.scoreThreds / 2) mask_num++;
+      if (mask_num > 0) add_num = 1 / mask_num / 2 * num_joints;
+    }
+    const float ref_dist = std::min(ref_dists[pick_id], 7.f);
+    delete_ids.clear();
+    for (int k = 0; k < keep_num; k++) {
+      const float* d = dist.data() + k * num_joints;
+      int num_match_keypoints =
+          full_body ? PCKMatchFullBody(d, num_joints, ref_dist, add_num)
+                    : PCKMatch(d, num_joints, ref_dist);
+      if (num_match_keypoints >= mParams.matchThreds ||
+          parametricDistance(cands, near[k], pick_id, d, full_body) >
+              mParams.gamma) {
+        delete_ids.push_back(k);
+        mask[near[k]] = false;
+        num_valid_samples -= 1;
+      }
+    }
+    if (delete_ids.size() == 0) {
+      delete_ids.push_back(relative_pick_id);
+      mask[pick_id] = false;
+      num_valid_samples -= 1;
+    }
+
+    float pick_max_score = 0;
+    for (int j = 0; j < num_joints; j++)
+      if (cands.score(pick_id)[j] > pick_max_score)
+        pick_max_score = cands.score(pick_id)[j];
+    if (pick_max_score < mParams.scoreThreds) continue;
+    pMergeFast(cands, near, dist, delete_ids, pick_id, ref_dists[pick_id]);
+    std::vector<float>& keypoints = body_keypoints[pick_id]->keypoints;
+    std::vector<float>& scores = body_keypoints[pick_id]->scores;
+    float merge_max_score = 0;
+    for (int j = 0; j < num_joints; j++) {
+      keypoints[j * 2] = cands.x(pick_id)[j];
+      keypoints[j * 2 + 1] = cands.y(pick_id)[j];
+      scores[j] = cands.score(pick_id)[j];
+      if (scores[j] > merge_max_score) merge_max_score = scores[j];
+    }
+    if (merge_max_score < mParams.scoreThreds) continue;
+    const float* box = cands.boxes.data() + pick_id * 4;
+    if (1.5 * 1.5 * (box[2] - box[0]) * (box[3] - box[1]) < area_thresh)
+      continue;
+    pick_ids.push_back(pick_id);
+  }
+}
+
+}  // namespace fastpose
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_FASTPOSE_POSE_NMS_H_
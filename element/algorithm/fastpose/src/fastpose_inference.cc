@@ -30,7 +30,8 @@ FastposeInference::mergeInputDeviceMem(
         for (int i = 0; i < p->tensors.size(); ++i)
           for (int j = 0; j < p->tensors[i].size(); ++j)
             if (p->tensors[i][j]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i][j]->device_mem);
+              common::TensorMemPool::recycle(p->handle,
+                                             p->tensors[i][j]->device_mem);
             }
         delete p;
         p = nullptr;
@@ -62,9 +63,8 @@ FastposeInference::mergeInputDeviceMem(
     if (BM_FLOAT32 == context->bmNetwork->m_netinfo->input_dtypes[0])
       input_bytes *= 4;
     // malloc空间
-    auto ret = bm_malloc_device_byte(inputTensors->handle,
-                                     &inputTensors->tensors[i][0]->device_mem,
-                                     input_bytes);
+    auto ret = getTensorMemPool(context)->acquire(
+        input_bytes, &inputTensors->tensors[i][0]->device_mem);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")                                    
 
     // d2d
@@ -113,7 +113,8 @@ FastposeInference::getOutputDeviceMem(
         for (int i = 0; i < p->tensors.size(); ++i)
           for (int j = 0; j < p->tensors[i].size(); j++)
             if (p->tensors[i][j]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i][j]->device_mem);
+              common::TensorMemPool::recycle(p->handle,
+                                             p->tensors[i][j]->device_mem);
             }
         delete p;
         p = nullptr;
@@ -149,9 +150,8 @@ FastposeInference::getOutputDeviceMem(
     if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[0])
       max_size *= 4;
     // malloc空间
-    auto ret = bm_malloc_device_byte(outputTensors->handle,
-                                     &outputTensors->tensors[i][0]->device_mem,
-                                     max_size);
+    auto ret = getTensorMemPool(context)->acquire(
+        max_size, &outputTensors->tensors[i][0]->device_mem);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")                                     
   }
   return outputTensors;
@@ -173,7 +173,8 @@ void FastposeInference::splitOutputMemIntoObjectMetadatas(
           for (int i = 0; i < p->tensors.size(); ++i)
             for (int j = 0; j < p->tensors[i].size(); j++)
               if (p->tensors[i][j]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i][j]->device_mem);
+                common::TensorMemPool::recycle(p->handle,
+                                               p->tensors[i][j]->device_mem);
               }
           delete p;
           p = nullptr;
@@ -208,10 +209,9 @@ void FastposeInference::splitOutputMemIntoObjectMetadatas(
         if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[z])
           max_size *= 4;
         max_size /= context->max_batch;
-        auto ret = bm_malloc_device_byte(
-            objectMetadatas[i]->mSubOutputBMtensors->handle,
-            &objectMetadatas[i]->mSubOutputBMtensors->tensors[j][z]->device_mem,
-            max_size);
+        auto ret = getTensorMemPool(context)->acquire(
+            max_size,
+            &objectMetadatas[i]->mSubOutputBMtensors->tensors[j][z]->device_mem);
         STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
         bm_memcpy_d2d_byte(
             context->handle,
@@ -28,7 +28,8 @@ void FastposePreProcess::initTensors(std::shared_ptr<FastposeContext> context,
           for (int i = 0; i < p->tensors.size(); ++i) {
             for (int j = 0; j < p->tensors[i].size(); j++) {
               if (p->tensors[i][j]->device_mem.u.device.device_addr != 0) {
-                bm_free_device(p->handle, p->tensors[i][j]->device_mem);
+                common::TensorMemPool::recycle(p->handle,
+                                               p->tensors[i][j]->device_mem);
               }
             }
           }
@@ -92,6 +93,7 @@ common::ErrorCode FastposePreProcess::preProcess(
     }
 
     int j = 0;
+    size_t numDetections = objMetadata->mDetectedObjectMetadatas.size();
     // filter noise box
     while (j < objMetadata->mDetectedObjectMetadatas.size()) {
       if (objMetadata->mDetectedObjectMetadatas[j]->mBox.mWidth < 16 ||
@@ -102,6 +104,8 @@ common::ErrorCode FastposePreProcess::preProcess(
       else
         j++;
     }
+    if (objMetadata->mDetectedObjectMetadatas.size() != numDetections)
+      objMetadata->detectionsChanged();
 
     j = 0;
     for (auto& detObj : objMetadata->mDetectedObjectMetadatas) {
@@ -185,8 +189,7 @@ common::ErrorCode FastposePreProcess::preProcess(
       bm_device_mem_t mem;
       int size_byte = 0;
       bm_image_get_byte_size(converto_img, &size_byte);
-      ret =
-          bm_malloc_device_byte(context->bmContext->handle(), &mem, size_byte);
+      ret = getTensorMemPool(context)->acquire(size_byte, &mem);
       STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
       bm_image_attach(converto_img, &mem);
 
@@ -76,6 +76,11 @@ namespace lightstereo {
         "bgr2rgb";
     static constexpr const char* CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD = "mean";
     static constexpr const char* CONFIG_INTERNAL_THRESHOLD_STD_FIELD = "std";
+    static constexpr const char* CONFIG_INTERNAL_OUTPUT_IMAGE_FIELD =
+        "output_image";
+    static constexpr const char* CONFIG_INTERNAL_COLORMAP_FIELD = "colormap";
+    static constexpr const char* CONFIG_INTERNAL_DEPTH_SCALE_FIELD =
+        "depth_scale";
 
    private:
     std::shared_ptr<LightstereoContext> mContext;          // context对象
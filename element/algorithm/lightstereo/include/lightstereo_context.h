@@ -35,6 +35,10 @@ class LightstereoContext : public ::sophon_stream::element::Context {
   int input_num;
   int output_num;
   bmcv_convert_to_attr converto_attr_left, converto_attr_right;
+
+  bool output_image = true;  // 是否生成视差可视化图像
+  bool colormap = false;     // 可视化使用伪彩色，否则为灰度
+  float depth_scale = 0.f;   // 焦距(像素)*基线，大于0时目标输出深度而非视差
 };
 }  // namespace lightstereo
 }  // namespace element
@@ -28,6 +28,29 @@ class LightstereoPostProcess : public ::sophon_stream::element::PostProcess {
   void postProcess(std::shared_ptr<LightstereoContext> context,
                    common::ObjectMetadatas& objectMetadatas);
  private:
+  /**
+   * @brief 网络输出中对应原图的区域，以及原图到该区域的缩放
+   */
+  struct DispRegion {
+    const float* data;  // 区域左上角
+    int stride;         // 行距，单位float
+    int w, h;
+    float sx, sy;       // 原图坐标乘以sx、sy得到区域坐标
+  };
+
+  /**
+   * @brief 一次遍历完成归一化、着色和缩放，直接写入BGR packed图像
+   */
+  void renderDisparity(const DispRegion& region, float minVal, float maxVal,
+                       cv::Mat& bgr);
+  /**
+   * @brief 给每个检测框填写框内视差（或深度）的中值
+   */
+  void fillObjectDepth(std::shared_ptr<LightstereoContext> context,
+                       const DispRegion& region,
+                       common::ObjectMetadata& obj);
+
+  std::vector<uint8_t> mColorLut;  // 256*3，BGR，init后只读
 };
 
 }  // namespace lightstereo
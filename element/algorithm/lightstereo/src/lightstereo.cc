@@ -47,6 +47,17 @@ namespace lightstereo {
 
       // 3. get output
       mContext->output_num = mContext->bmNetwork->outputTensorNum();
+      initTensorMemPool(mContext);
+
+      auto outputImageIt = configure.find(CONFIG_INTERNAL_OUTPUT_IMAGE_FIELD);
+      if (configure.end() != outputImageIt && outputImageIt->is_boolean())
+        mContext->output_image = outputImageIt->get<bool>();
+      auto colormapIt = configure.find(CONFIG_INTERNAL_COLORMAP_FIELD);
+      if (configure.end() != colormapIt && colormapIt->is_boolean())
+        mContext->colormap = colormapIt->get<bool>();
+      auto depthScaleIt = configure.find(CONFIG_INTERNAL_DEPTH_SCALE_FIELD);
+      if (configure.end() != depthScaleIt && depthScaleIt->is_number())
+        mContext->depth_scale = depthScaleIt->get<float>();
 
       // 4.converto
       float input_scale_left = mContext->bmNetwork->inputTensor(0)->get_scale();
@@ -111,6 +122,7 @@ namespace lightstereo {
 
       mContext->deviceId = getDeviceId();
       initContext(configure.dump());
+      setInputSyncConfig(common::InputSynchronizer::parseConfig(configure));
       // 前处理初始化
       mPreProcess->init(mContext);
       // 推理初始化
@@ -167,27 +179,43 @@ namespace lightstereo {
     }
     common::ObjectMetadatas outputObjectMetadatas;
     if(use_pre || use_infer) {
+      common::ObjectMetadatas inputs;
       while (leftObjectMetadatas.size() < mContext->max_batch &&
             (getThreadStatus() == ThreadStatus::RUN)) {
-        // 如果队列为空则等待
-        auto data0 = popInputData(inputPorts[0], dataPipeId);
-        if (!data0) {
+        // 左右目按帧号或时间戳对齐，队列为空或暂时无法对齐时等待
+        if (!popSyncedInputData(dataPipeId, inputs)) {
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
           continue;
         }
-        auto objectMetadata0 = std::static_pointer_cast<common::ObjectMetadata>(data0);
-        if (!objectMetadata0->mFilter) {
+        auto objectMetadata0 = inputs[0];
+        auto objectMetadata1 = inputs[1];
+        if (!objectMetadata0->mFilter && !objectMetadata1->mFilter) {
           leftObjectMetadatas.push_back(objectMetadata0);
+          rightObjectMetadatas.push_back(objectMetadata1);
           if(use_infer) {
-            std::shared_ptr<common::ObjectMetadata> outputObj = std::make_shared<common::ObjectMetadata>();
-            outputObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
+            std::shared_ptr<common::ObjectMetadata> outputObj = common::makePooled<common::ObjectMetadata>();
+            outputObj->mFrame = common::makePooled<common::Frame>();
+            outputObj->mArena = common::makePooled<common::FrameArena>();
             outputObj->mFrame->mWidth = objectMetadata0->mFrame->mWidth;
             outputObj->mFrame->mHeight = objectMetadata0->mFrame->mHeight;
             outputObj->mFrame->mChannelId = objectMetadata0->mFrame->mChannelId;
             outputObj->mFrame->mFrameId = objectMetadata0->mFrame->mFrameId;
+            outputObj->mFrame->mTimestamp = objectMetadata0->mFrame->mTimestamp;
+            outputObj->mFrame->mPts = objectMetadata0->mFrame->mPts;
             outputObj->mFrame->mChannelIdInternal = objectMetadata0->mFrame->mChannelIdInternal;
             outputObj->mFrame->mHandle = objectMetadata0->mFrame->mHandle;
             outputObj->mFrame->mEndOfStream = objectMetadata0->mFrame->mEndOfStream;
+            // 左目上的检测框在后处理中填写中值深度，复制一份再写，
+            // 左目的检测结果可能同时被其他分支使用
+            for (const auto& detObj :
+                 objectMetadata0->mDetectedObjectMetadatas) {
+              outputObj->addDetectedObject(
+                  common::makeInArena<common::DetectedObjectMetadata>(
+                      outputObj->mArena, *detObj));
+            }
+            outputObj->mTrackedObjectMetadatas =
+                objectMetadata0->mTrackedObjectMetadatas;
+            outputObj->detectionsChanged();
             outputObjectMetadatas.push_back(outputObj);
           }
         }
@@ -196,23 +224,6 @@ namespace lightstereo {
         }
       }
 
-      while (rightObjectMetadatas.size() < mContext->max_batch &&
-            (getThreadStatus() == ThreadStatus::RUN)) {
-        // 如果队列为空则等待
-        auto data1 = popInputData(inputPorts[1], dataPipeId);
-        if (!data1) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(10));
-          continue;
-        }
-        auto objectMetadata1 = std::static_pointer_cast<common::ObjectMetadata>(data1);
-        if (!objectMetadata1->mFilter) {
-          rightObjectMetadatas.push_back(objectMetadata1);
-        }
-        if (objectMetadata1->mFrame->mEndOfStream) {
-          break;
-        }
-      }
-
     } else if(use_post) {
       while (outputObjectMetadatas.size() < mContext->max_batch &&
             (getThreadStatus() == ThreadStatus::RUN)) {
@@ -29,7 +29,8 @@ LightstereoInference::mergeInputDeviceMem(std::shared_ptr<LightstereoContext> co
       [](sophon_stream::common::bmTensors* p) {
         for (int i = 0; i < p->tensors.size(); ++i)
           if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-            bm_free_device(p->handle, p->tensors[i]->device_mem);
+            common::TensorMemPool::recycle(p->handle,
+                                           p->tensors[i]->device_mem);
           }
         delete p;
         p = nullptr;
@@ -50,9 +51,8 @@ LightstereoInference::mergeInputDeviceMem(std::shared_ptr<LightstereoContext> co
     if (BM_FLOAT32 == context->bmNetwork->m_netinfo->input_dtypes[0])
       input_bytes *= 4;
     // malloc空间
-    auto ret = bm_malloc_device_byte(inputTensors->handle,
-                                     &inputTensors->tensors[i]->device_mem,
-                                     input_bytes);
+    auto ret = getTensorMemPool(context)->acquire(
+        input_bytes, &inputTensors->tensors[i]->device_mem);
     auto objectMetadatas = i == 0 ? leftObjectMetadatas : rightObjectMetadatas;
     // d2d
     for (int j = 0; j < objectMetadatas.size(); ++j) {
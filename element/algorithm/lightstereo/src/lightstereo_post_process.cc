@@ -9,19 +9,133 @@
 
 #include "lightstereo_post_process.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace sophon_stream {
 namespace element {
 namespace lightstereo {
 
-void LightstereoPostProcess::init(std::shared_ptr<LightstereoContext> context) {}
+void LightstereoPostProcess::init(std::shared_ptr<LightstereoContext> context) {
+  // 灰度或jet伪彩色查找表，着色只需一次查表
+  mColorLut.resize(256 * 3);
+  for (int i = 0; i < 256; ++i) {
+    uint8_t* bgr = &mColorLut[i * 3];
+    if (!context->colormap) {
+      bgr[0] = bgr[1] = bgr[2] = i;
+      continue;
+    }
+    float v = i / 255.f;
+    auto channel = [](float x) {
+      return (uint8_t)(255.f * std::min(1.f, std::max(0.f, 1.5f - std::abs(x))));
+    };
+    bgr[0] = channel(4.f * v - 1.f);
+    bgr[1] = channel(4.f * v - 2.f);
+    bgr[2] = channel(4.f * v - 3.f);
+  }
+}
+
+void LightstereoPostProcess::renderDisparity(const DispRegion& region,
+                                             float minVal, float maxVal,
+                                             cv::Mat& bgr) {
+  float scale = maxVal > minVal ? 255.f / (maxVal - minVal) : 0.f;
+  float bias = -minVal * scale + 0.5f;
+  const uint8_t* lut = mColorLut.data();
+  int out_w = bgr.cols, out_h = bgr.rows;
+
+  if (out_w == region.w && out_h == region.h) {
+    for (int y = 0; y < out_h; ++y) {
+      const float* src = region.data + (size_t)y * region.stride;
+      uint8_t* dst = bgr.ptr<uint8_t>(y);
+      for (int x = 0; x < out_w; ++x) {
+        int v = (int)(src[x] * scale + bias);
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        dst[3 * x] = lut[3 * v];
+        dst[3 * x + 1] = lut[3 * v + 1];
+        dst[3 * x + 2] = lut[3 * v + 2];
+      }
+    }
+    return;
+  }
+
+  // 双线性缩放与归一化合并：归一化是线性的，先插值后映射结果相同
+  // 缩放时每列的源列号与权重，后处理可能多线程并发执行，不能放在成员中
+  std::vector<int> xOffsets(out_w);
+  std::vector<float> xWeights(out_w);
+  for (int x = 0; x < out_w; ++x) {
+    float fx = std::max(0.f, (x + 0.5f) * region.sx - 0.5f);
+    int x0 = std::min((int)fx, region.w - 1);
+    xOffsets[x] = x0;
+    xWeights[x] = x0 + 1 < region.w ? fx - x0 : 0.f;
+  }
+  for (int y = 0; y < out_h; ++y) {
+    float fy = std::max(0.f, (y + 0.5f) * region.sy - 0.5f);
+    int y0 = std::min((int)fy, region.h - 1);
+    int y1 = std::min(y0 + 1, region.h - 1);
+    float wy = fy - y0;
+    const float* row0 = region.data + (size_t)y0 * region.stride;
+    const float* row1 = region.data + (size_t)y1 * region.stride;
+    uint8_t* dst = bgr.ptr<uint8_t>(y);
+    for (int x = 0; x < out_w; ++x) {
+      int x0 = xOffsets[x];
+      int x1 = x0 + (xWeights[x] > 0.f);
+      float wx = xWeights[x];
+      float top = row0[x0] + (row0[x1] - row0[x0]) * wx;
+      float bottom = row1[x0] + (row1[x1] - row1[x0]) * wx;
+      float d = top + (bottom - top) * wy;
+      int v = (int)(d * scale + bias);
+      v = v < 0 ? 0 : (v > 255 ? 255 : v);
+      dst[3 * x] = lut[3 * v];
+      dst[3 * x + 1] = lut[3 * v + 1];
+      dst[3 * x + 2] = lut[3 * v + 2];
+    }
+  }
+}
+
+void LightstereoPostProcess::fillObjectDepth(
+    std::shared_ptr<LightstereoContext> context, const DispRegion& region,
+    common::ObjectMetadata& obj) {
+  // 网络输出的视差以区域像素为单位，换算回原图像素
+  float dispToFrame = 1.f / region.sx;
+  // 大框只取均匀分布的约1024个采样点，中值足够稳定
+  constexpr int kMaxSamples = 1024;
+  std::vector<float> samples;
+  samples.reserve(kMaxSamples * 2);
+  for (auto& detObj : obj.mDetectedObjectMetadatas) {
+    const auto& box = detObj->mBox;
+    int x0 = std::max(0, (int)(box.mX * region.sx));
+    int y0 = std::max(0, (int)(box.mY * region.sy));
+    int x1 = std::min(region.w, (int)((box.mX + box.mWidth) * region.sx));
+    int y1 = std::min(region.h, (int)((box.mY + box.mHeight) * region.sy));
+    if (x1 <= x0 || y1 <= y0) continue;
+
+    int area = (x1 - x0) * (y1 - y0);
+    int step = std::max(1, (int)std::sqrt((float)area / kMaxSamples));
+    samples.clear();
+    for (int y = y0; y < y1; y += step) {
+      const float* row = region.data + (size_t)y * region.stride;
+      for (int x = x0; x < x1; x += step) {
+        if (row[x] > 0.f) samples.push_back(row[x]);
+      }
+    }
+    if (samples.empty()) continue;
+
+    auto mid = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), mid, samples.end());
+    float disparity = *mid * dispToFrame;
+    detObj->mDepth = context->depth_scale > 0.f
+                         ? context->depth_scale / disparity
+                         : disparity;
+  }
+}
 
 void LightstereoPostProcess::postProcess(std::shared_ptr<LightstereoContext> context,
                                     common::ObjectMetadatas& objectMetadatas) {
   if (objectMetadatas.size() == 0) return;
 
-  int ret = 0;
   for (auto obj : objectMetadatas){
     if (obj->mFrame->mEndOfStream) break;
+    if (obj->mOutputBMtensors == nullptr) continue;
     std::shared_ptr<BMNNTensor> outputTensor = std::make_shared<BMNNTensor>(
                                                 obj->mOutputBMtensors->handle,
                                                 context->bmNetwork->m_netinfo->output_names[0],
@@ -29,23 +143,36 @@ void LightstereoPostProcess::postProcess(std::shared_ptr<LightstereoContext> con
                                                 obj->mOutputBMtensors->tensors[0].get(),
                                                 context->bmNetwork->is_soc);
     float* output_data = (float*)outputTensor->get_cpu_data();
-    cv::Mat float_mat(context->net_h, context->net_w, CV_32FC1, output_data);
-    cv::Mat normalized_disp_pred;
-    if(obj->mFrame->mWidth <= context->net_w && obj->mFrame->mHeight <= context->net_h){
-      cv::Rect bound = cv::Rect{0, context->net_h - obj->mFrame->mHeight, obj->mFrame->mWidth, obj->mFrame->mHeight};
-      cv::Mat clipped = float_mat(bound);
-      double minVal, maxVal;
-      cv::minMaxLoc(clipped, &minVal, &maxVal);
-      clipped.convertTo(normalized_disp_pred, CV_8UC1, 255.0 / (maxVal - minVal), -minVal * 255.0 / (maxVal - minVal));
-    }else{
-      cv::Mat resized(obj->mFrame->mHeight, obj->mFrame->mWidth, CV_32FC1);
-      cv::resize(float_mat, resized, cv::Size(obj->mFrame->mWidth, obj->mFrame->mHeight));
-      double minVal, maxVal;
-      cv::minMaxLoc(resized, &minVal, &maxVal);
-      resized.convertTo(normalized_disp_pred, CV_8UC1, 255.0 / (maxVal - minVal), -minVal * 255.0 / (maxVal - minVal));
+    int frame_w = obj->mFrame->mWidth, frame_h = obj->mFrame->mHeight;
+
+    // 原图不大于网络输入时在右上角补边，对应区域为左下角；否则整图缩放
+    DispRegion region;
+    region.stride = context->net_w;
+    if (frame_w <= context->net_w && frame_h <= context->net_h) {
+      region.data = output_data + (size_t)(context->net_h - frame_h) * context->net_w;
+      region.w = frame_w;
+      region.h = frame_h;
+    } else {
+      region.data = output_data;
+      region.w = context->net_w;
+      region.h = context->net_h;
     }
-    cv::Mat color_normalized_disp_pred;
-    cv::cvtColor(normalized_disp_pred, color_normalized_disp_pred, cv::COLOR_GRAY2BGR);
+    region.sx = (float)region.w / frame_w;
+    region.sy = (float)region.h / frame_h;
+
+    if (!obj->mDetectedObjectMetadatas.empty())
+      fillObjectDepth(context, region, *obj);
+    if (!context->output_image) continue;
+
+    // 极值在网络分辨率上统计，双线性插值不会超出该范围
+    cv::Mat regionMat(region.h, region.w, CV_32FC1, (void*)region.data,
+                      region.stride * sizeof(float));
+    double minVal, maxVal;
+    cv::minMaxIdx(regionMat, &minVal, &maxVal);
+
+    cv::Mat color_normalized_disp_pred(frame_h, frame_w, CV_8UC3);
+    renderDisparity(region, (float)minVal, (float)maxVal,
+                    color_normalized_disp_pred);
     std::shared_ptr<bm_image> output_bmimg = nullptr;
     output_bmimg.reset(new bm_image, [](bm_image* p) {
       bm_image_destroy(*p);
@@ -50,6 +50,7 @@ common::ErrorCode Lprnet::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     auto output_tensor = mContext->bmNetwork->outputTensor(0);
     auto output_shape = output_tensor->get_shape();
     auto output_dims = output_shape->num_dims;
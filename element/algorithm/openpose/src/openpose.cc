@@ -61,6 +61,7 @@ common::ErrorCode Openpose::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     assert(mContext->output_num > 0);
     auto output_tensor = mContext->bmNetwork->outputTensor(0);
     auto output_shape = output_tensor->get_shape();
@@ -75,6 +75,8 @@ class Posec3d : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
       "class_names_file";
   static constexpr const char* CONFIG_INTERNAL_FRAMES_NUM_FIELD = "frames_num";
+  static constexpr const char* CONFIG_INTERNAL_CLIP_STRIDE_FIELD =
+      "clip_stride";
 
  private:
   std::shared_ptr<Posec3dContext> mContext;          // context对象
@@ -89,6 +91,12 @@ class Posec3d : public ::sophon_stream::framework::Element {
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
+  // 每个channel最近一次识别的结果，本批没有完成识别的帧沿用
+  std::mutex mLabelMutex;
+  std::map<int /* channelIdInternal */,
+           std::vector<std::shared_ptr<common::RecognizedObjectMetadata>>>
+      mLastLabels;
+
   common::ErrorCode initContext(const std::string& json);
   void process(common::ObjectMetadatas& objectMetadatas);
 };
@@ -28,7 +28,8 @@ class Posec3dContext : public ::sophon_stream::element::Context {
 
   int m_frame_h, m_frame_w;
   int m_net_crops_clips, m_net_channel, m_net_keypoints, net_h, net_w;
-  int max_batch;
+  int max_batch;   // 一次识别的帧数，即窗口长度
+  int clip_stride;  // 窗口每滑动clip_stride帧识别一次
   int input_num;
   int output_num;
 
@@ -10,6 +10,9 @@
 #ifndef SOPHON_STREAM_ELEMENT_POSEC3D_PRE_PROCESS_H_
 #define SOPHON_STREAM_ELEMENT_POSEC3D_PRE_PROCESS_H_
 
+#include <map>
+#include <mutex>
+
 #include "algorithmApi/pre_process.h"
 #include "posec3d_context.h"
 
@@ -17,16 +20,54 @@ namespace sophon_stream {
 namespace element {
 namespace posec3d {
 
-using fpptr_dim3 = std::vector<
-    std::shared_ptr<std::vector<std::shared_ptr<std::vector<float>>>>>;
-using fpptr_dim2 = std::vector<std::shared_ptr<std::vector<float>>>;
+/**
+ * @brief 一帧的关键点及其渲染结果
+ */
+struct ClipFrame {
+  std::vector<std::vector<float>> keypoints;  // 每人x0,y0,x1,y1...
+  std::vector<std::vector<float>> scores;     // 每人每个关键点的置信度
+  std::vector<float> heatmap;  // num_keypoints*h*w，按当前变换渲染
+  bool rendered = false;
+};
+
+/**
+ * @brief 原图关键点到heatmap坐标的变换：裁剪紧凑框、缩放、中心裁剪
+ */
+struct ClipTransform {
+  bool valid = false;
+  int frame_w = 0, frame_h = 0;
+  float min_x = 0, min_y = 0, max_x = 0, max_y = 0;  // 原图中的紧凑框
+  float kp_min_x = 0, kp_min_y = 0, kp_max_x = 0, kp_max_y = 0;  // 关键点范围
+  float scale_x = 1, scale_y = 1;
+  int left = 0, top = 0;  // 缩放后中心裁剪的偏移
+  int img_w = 0, img_h = 0;
+};
+
+/**
+ * @brief 一个channel的滑动窗口：最近frames_num帧的环形缓冲
+ */
+struct ClipState {
+  std::vector<ClipFrame> ring;
+  int head = 0;   // 最早一帧在ring中的位置
+  int count = 0;  // 已缓存的帧数
+  int sinceClip = 0;  // 上次识别后新到的帧数
+  int frame_w = 0, frame_h = 0;  // 最近一帧的图像尺寸
+  ClipTransform transform;
+  uint64_t rendered = 0;  // 渲染过的帧数
+  uint64_t reused = 0;    // 复用已渲染heatmap的帧数
+
+  ClipFrame& frame(int i) { return ring[(head + i) % ring.size()]; }
+};
 
 class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
  public:
   /**
-   * @brief 对一个batch的数据做预处理
+   * @brief 按到达顺序处理一批帧：每帧加入所属channel的窗口，
+   * 窗口满且距上次识别已有clip_stride帧时，在该帧上生成模型输入并置is_main。
+   * 结束帧释放该channel的缓存，未识别的剩余帧在本批该channel的最后一帧上
+   * 识别，本批中没有该channel的其他帧时在结束帧上识别
    * @param context context指针
-   * @param objectMetadatas 一个batch的数据
+   * @param objectMetadatas 一批数据，可以包含多个channel和结束帧
    * @return common::ErrorCode
    * common::ErrorCode::SUCCESS，中间过程失败会中断执行
    */
@@ -36,94 +77,95 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
 
  private:
   /**
-   * @brief 对一个batch的数据做重采样
-   * @param sampled_keypoints 重采样关键点结果
-   * @param sampled_keypoint_scores 重采样关键点置信度结果
+   * @brief 从窗口中均匀采样clip_len*num_clips帧
+   * @param num_frames 窗口帧数
    * @param clip_len 每次裁剪的长度
    * @param num_clips 裁剪次数
    * @param seed 当帧数大于裁剪长度时裁剪时的随机种子
-   * @return common::ErrorCode
-   * common::ErrorCode::SUCCESS，中间过程失败会中断执行
+   * @return 采样得到的窗口内帧序号
    */
-  common::ErrorCode uniformSampleFrames(fpptr_dim3& sampled_keypoints,
-                                        fpptr_dim3& sampled_keypoint_scores,
-                                        int clip_len, int num_clips, int seed);
+  std::vector<int> uniformSampleFrames(int num_frames, int clip_len,
+                                       int num_clips, int seed);
 
   /**
-   * @brief 对一个batch的关键点数据做偏移并生成下面预处理所需要的参数
-   * @param objectMetadatas 一个batch的数据
-   * @param keypoints 关键点输入
-   * @param padding padding尺寸
+   * @brief 由窗口内所有关键点计算紧凑框，紧凑框不足threshold时使用整帧
+   * @param clip 窗口
+   * @param padding 紧凑框向外扩展的比例
    * @param threshold 长宽阈值
    * @param hw_ratio 长宽比率
-   * @param new_shape 输出的长宽
-   * @param crop_quadruple 输出的被裁剪四边形几何属性
-   * @param allow_imgpad 是否进行输出长宽的裁剪
-   * @return common::ErrorCode
-   * common::ErrorCode::SUCCESS，中间过程失败会中断执行
+   * @param transform 输出紧凑框
+   * @param allow_imgpad 紧凑框是否可以超出图像
    */
-  common::ErrorCode poseCompact(common::ObjectMetadatas& objectMetadatas,
-                                fpptr_dim3& keypoints, float padding,
-                                int threshold, std::vector<float>& hw_ratio,
-                                std::vector<int>& new_shape,
-                                std::vector<float>& crop_quadruple,
-                                bool allow_imgpad);
+  void poseCompact(ClipState& clip, float padding, int threshold,
+                   std::vector<float>& hw_ratio, ClipTransform& transform,
+                   bool allow_imgpad);
 
   /**
-   * @brief 对一个batch的关键点数据做缩放，并生成下面预处理所需要的参数
-   * @param keypoints 关键点输入
+   * @brief 计算紧凑框缩放到scale的比例
+   * @param transform poseCompact输出的紧凑框，输出缩放比例及缩放后长宽
    * @param scale 缩放尺寸
-   * @param new_shape poseCompact输出的长宽，最终为输出的新长宽
    * @param keep_ratio 是否缩放时保持纵横比
-   * @return common::ErrorCode
-   * common::ErrorCode::SUCCESS，中间过程失败会中断执行
    */
-  common::ErrorCode resize(fpptr_dim3& keypoints, std::vector<int>& scale,
-                           std::vector<int>& new_shape, bool keep_ratio);
+  void resize(ClipTransform& transform, std::vector<int>& scale,
+              bool keep_ratio);
 
   /**
-   * @brief 对一个batch的关键点数据做偏移，并生成下面预处理所需要的参数
-   * @param keypoints 关键点输入
-   * @param new_shape resize输出的新长宽
-   * @param crop_quadruple 输出的新几何属性
+   * @brief 计算缩放后中心裁剪的偏移
+   * @param transform resize的输出，输出裁剪偏移及最终长宽
    * @param crop_size 裁剪尺寸
-   * @return common::ErrorCode
-   * common::ErrorCode::SUCCESS，中间过程失败会中断执行
    */
-  common::ErrorCode centerCrop(fpptr_dim3& keypoints,
-                               std::vector<int>& new_shape,
-                               std::vector<float>& crop_quadruple,
-                               std::vector<int>& crop_size);
+  void centerCrop(ClipTransform& transform, std::vector<int>& crop_size);
 
   /**
-   * @brief 生成模型输入heatmap
+   * @brief 窗口滑动后上一个窗口的变换是否仍可用：新窗口的关键点都在
+   * 原紧凑框内，且紧凑框没有明显缩小。沿用变换时已渲染的帧不用重新渲染
+   */
+  bool reuseTransform(const ClipTransform& current,
+                      const ClipTransform& next) const;
+
+  /**
+   * @brief 按变换渲染一帧各关键点的高斯heatmap，多人取最大值
+   * @param sigma 高斯核标准差
+   */
+  void renderFrame(std::shared_ptr<Posec3dContext> context,
+                   const ClipTransform& transform, ClipFrame& frame,
+                   float sigma);
+
+  /**
+   * @brief 生成模型输入heatmap：已渲染的帧直接复用，按采样结果拷贝到各位置
    * @param context context指针
-   * @param sampled_keypoints 来自uniformSampleFrames输出的重采样关键点结果
-   * @param sampled_keypoint_scores 关键点输入
-   * @param new_shape centerCrop输出的新长宽
+   * @param clip 窗口
    * @param heatmap 输出heatmap的指针
    * @param out_num 输出heatmap的长度
-   * @param sigma 缩放因子
-   * @param scaling 缩放因子
    * @param clip_len 每次裁剪的长度
-   * @return common::ErrorCode
-   * common::ErrorCode::SUCCESS，中间过程失败会中断执行
+   * @param num_clips 裁剪次数
    */
-  common::ErrorCode generatePoseTarget(std::shared_ptr<Posec3dContext> context,
-                                       fpptr_dim3& keypoints,
-                                       fpptr_dim3& sampled_keypoints,
-                                       fpptr_dim3& sampled_keypoint_scores,
-                                       std::vector<int>& new_shape,
-                                       float* heatmap, int out_num, float sigma,
-                                       float scaling, int clip_len);
+  void generatePoseTarget(std::shared_ptr<Posec3dContext> context,
+                          ClipState& clip, float* heatmap, int out_num,
+                          int clip_len, int num_clips);
 
   /**
-   * @brief 为一个batch的数据初始化设备内存
+   * @brief 在obj上生成窗口的模型输入
+   */
+  common::ErrorCode makeClip(std::shared_ptr<Posec3dContext> context,
+                             ClipState& clip,
+                             std::shared_ptr<common::ObjectMetadata> obj);
+
+  /**
+   * @brief 为obj初始化输入tensor
    * @param context context指针
-   * @param objectMetadatas 一个batch的数据
+   * @param obj 携带模型输入的帧
    */
   void initTensors(std::shared_ptr<Posec3dContext> context,
-                   common::ObjectMetadatas& objectMetadatas);
+                   std::shared_ptr<common::ObjectMetadata> obj);
+
+  static constexpr const int CLIP_LEN = 48;
+  static constexpr const int NUM_CLIPS = 10;
+  static constexpr const float SIGMA = 0.6f;
+  static constexpr const float MIN_REUSE_RATIO = 0.8f;
+
+  std::mutex mClipMutex;
+  std::map<int /* channelIdInternal */, std::shared_ptr<ClipState>> mClips;
 };
 
 }  // namespace posec3d
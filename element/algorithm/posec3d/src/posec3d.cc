@@ -43,6 +43,11 @@ common::ErrorCode Posec3d::initContext(const std::string& json) {
     // 2. get input
     auto frameNum = configure.find(CONFIG_INTERNAL_FRAMES_NUM_FIELD);
     mContext->max_batch = frameNum->get<int>();
+    mContext->clip_stride = mContext->max_batch;
+    auto clipStrideIt = configure.find(CONFIG_INTERNAL_CLIP_STRIDE_FIELD);
+    if (configure.end() != clipStrideIt && clipStrideIt->is_number_integer())
+      mContext->clip_stride = std::min(
+          mContext->max_batch, std::max(1, clipStrideIt->get<int>()));
     auto inputTensor = mContext->bmNetwork->inputTensor(0);
     mContext->input_num = mContext->bmNetwork->m_netinfo->input_num;
     mContext->m_net_crops_clips = inputTensor->get_shape()->dims[0];
@@ -53,6 +58,7 @@ common::ErrorCode Posec3d::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     auto output_tensor = mContext->bmNetwork->outputTensor(0);
     auto output_shape = output_tensor->get_shape();
     int cls_num = output_shape->dims[1];
@@ -131,7 +137,7 @@ common::ErrorCode Posec3d::initInternal(const std::string& json) {
 
 void Posec3d::process(common::ObjectMetadatas& objectMetadatas) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
-  // 预处理
+  // 预处理，窗口满的帧上生成模型输入并置is_main
   if (use_pre) {
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
     if (common::ErrorCode::SUCCESS != errorCode) {
@@ -141,18 +147,21 @@ void Posec3d::process(common::ObjectMetadatas& objectMetadatas) {
       return;
     }
   }
-  // 推理
-  if (use_infer) {
-    errorCode = mInference->predict(mContext, objectMetadatas);
-    if (common::ErrorCode::SUCCESS != errorCode) {
-      for (unsigned i = 0; i < objectMetadatas.size(); i++) {
-        objectMetadatas[i]->mErrorCode = errorCode;
+  // 一批数据中可能有多个窗口，逐个推理和后处理
+  for (auto& objectMetadata : objectMetadatas) {
+    if (!objectMetadata->is_main) continue;
+    common::ObjectMetadatas clip = {objectMetadata};
+    // 推理
+    if (use_infer) {
+      errorCode = mInference->predict(mContext, clip);
+      if (common::ErrorCode::SUCCESS != errorCode) {
+        objectMetadata->mErrorCode = errorCode;
+        continue;
       }
-      return;
     }
+    // 后处理
+    if (use_post) mPostProcess->postProcess(mContext, clip);
   }
-  // 后处理
-  if (use_post) mPostProcess->postProcess(mContext, objectMetadatas);
 }
 
 common::ErrorCode Posec3d::doWork(int dataPipeId) {
@@ -182,7 +191,9 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
       auto objectMetadata =
           std::static_pointer_cast<common::ObjectMetadata>(data);
       pendingObjectMetadatas.push_back(objectMetadata);
+      // 结束帧也交给预处理，用于释放该channel的窗口
       if (objectMetadata->mFrame->mEndOfStream) {
+        objectMetadatas.push_back(objectMetadata);
         break;
       }
       if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
@@ -200,22 +211,37 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
       auto objectMetadata =
           std::static_pointer_cast<common::ObjectMetadata>(data);
       pendingObjectMetadatas.push_back(objectMetadata);
-      if (objectMetadata->mFrame->mEndOfStream) {
-        break;
-      }
       // all frame inputs are put into main objectMetadata, then the following
-      // infer and postprocess are based on main objectMetadata
+      // infer and postprocess are based on main objectMetadata.
+      // 结束帧上也可能有channel剩余帧的识别
       if (!objectMetadata->mFilter && objectMetadata->is_main)
         objectMetadatas.push_back(objectMetadata);
+      if (objectMetadata->mFrame->mEndOfStream) {
+        break;
+      }
     }
   }
 
   process(objectMetadatas);
 
-  if (use_post && objectMetadatas.size() > 0) {
-    // for all frames, they have the same action label
-    for (auto& objectMetadata : pendingObjectMetadatas)
-      objectMetadata->mRecognizedObjectMetadatas = objectMetadatas[0]->mRecognizedObjectMetadatas;
+  if (use_post) {
+    // 每帧使用同channel到该帧为止最近一次识别的结果，
+    // 本批中没有完成识别的channel沿用之前批次的结果
+    std::lock_guard<std::mutex> lock(mLabelMutex);
+    for (auto& objectMetadata : pendingObjectMetadatas) {
+      int channel = objectMetadata->mFrame->mChannelIdInternal;
+      if (objectMetadata->mFrame->mEndOfStream) {
+        mLastLabels.erase(channel);
+        continue;
+      }
+      if (objectMetadata->is_main) {
+        mLastLabels[channel] = objectMetadata->mRecognizedObjectMetadatas;
+        continue;
+      }
+      auto labelIt = mLastLabels.find(channel);
+      if (mLastLabels.end() != labelIt)
+        objectMetadata->mRecognizedObjectMetadatas = labelIt->second;
+    }
   }
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
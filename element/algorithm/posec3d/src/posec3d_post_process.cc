@@ -27,8 +27,8 @@ void Posec3dPostProcess::postProcess(std::shared_ptr<Posec3dContext> context,
 
   // get 1 batch data
   auto& obj = objectMetadatas[0];
-  // stream end control
-  if (obj->mFrame->mEndOfStream) return;
+  // 结束帧上可能有channel剩余帧的识别，没有模型输出时跳过
+  if (obj->mOutputBMtensors == nullptr) return;
 
   // init output tensors
   std::vector<std::shared_ptr<BMNNTensor>> outputTensors(context->output_num);
@@ -22,10 +22,10 @@ namespace posec3d {
 
 void Posec3dPreProcess::init(std::shared_ptr<Posec3dContext> context) {}
 
-common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
-    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
-    int clip_len, int num_clips, int seed) {
-  int num_frames = sampled_keypoints.size();
+std::vector<int> Posec3dPreProcess::uniformSampleFrames(int num_frames,
+                                                        int clip_len,
+                                                        int num_clips,
+                                                        int seed) {
   std::vector<int> inds;
   srand(seed);
 
@@ -59,44 +59,36 @@ common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
       }
     }
   }
-
-  // filter frames
-  for (int i = 0; i < inds.size(); i++) {
-    sampled_keypoints.push_back(sampled_keypoints[inds[i]]);
-    sampled_keypoint_scores.push_back(sampled_keypoint_scores[inds[i]]);
-  }
-  sampled_keypoints.erase(sampled_keypoints.begin(),
-                          sampled_keypoints.begin() + num_frames);
-  sampled_keypoint_scores.erase(sampled_keypoint_scores.begin(),
-                                sampled_keypoint_scores.begin() + num_frames);
-
-  return common::ErrorCode::SUCCESS;
+  return inds;
 }
 
-common::ErrorCode Posec3dPreProcess::poseCompact(
-    common::ObjectMetadatas& objectMetadatas, fpptr_dim3& keypoints,
-    float padding, int threshold, std::vector<float>& hw_ratio,
-    std::vector<int>& new_shape, std::vector<float>& crop_quadruple,
-    bool allow_imgpad) {
+void Posec3dPreProcess::poseCompact(ClipState& clip, float padding,
+                                    int threshold,
+                                    std::vector<float>& hw_ratio,
+                                    ClipTransform& transform,
+                                    bool allow_imgpad) {
   float min_x = INT_MAX, min_y = INT_MAX, max_x = INT_MIN, max_y = INT_MIN;
-  // NOTE: assert frame1.h == frame2.h, frame1.w == frame2.w, ...
-  int h = (*objectMetadatas[0]->mFrame->mSpData).height,
-      w = (*objectMetadatas[0]->mFrame->mSpData).width;
-  new_shape.clear();
-  new_shape.push_back(h);
-  new_shape.push_back(w);
-  for (auto& obj : keypoints) {
-    for (int j = 0; j < obj->size(); j++) {
-      for (int i = 0; i < obj->at(j)->size(); i += 2) {
-        if (obj->at(j)->at(i) < min_x) min_x = obj->at(j)->at(i);
-        if (obj->at(j)->at(i + 1) < min_y) min_y = obj->at(j)->at(i + 1);
-        if (obj->at(j)->at(i) > max_x) max_x = obj->at(j)->at(i);
-        if (obj->at(j)->at(i + 1) > max_y) max_y = obj->at(j)->at(i + 1);
+  int h = transform.frame_h, w = transform.frame_w;
+  for (int f = 0; f < clip.count; f++) {
+    for (auto& person : clip.frame(f).keypoints) {
+      for (int i = 0; i + 1 < person.size(); i += 2) {
+        min_x = std::min(min_x, person[i]);
+        min_y = std::min(min_y, person[i + 1]);
+        max_x = std::max(max_x, person[i]);
+        max_y = std::max(max_y, person[i + 1]);
       }
     }
   }
-  if (max_x - min_x < threshold || max_y - min_y < threshold)
-    return common::ErrorCode::SUCCESS;
+  transform.kp_min_x = min_x;
+  transform.kp_min_y = min_y;
+  transform.kp_max_x = max_x;
+  transform.kp_max_y = max_y;
+  // 关键点范围太小时不裁剪，使用整帧
+  transform.min_x = 0;
+  transform.min_y = 0;
+  transform.max_x = w;
+  transform.max_y = h;
+  if (max_x - min_x < threshold || max_y - min_y < threshold) return;
 
   float center_x = (max_x + min_x) / 2;
   float center_y = (max_y + min_y) / 2;
@@ -125,33 +117,16 @@ common::ErrorCode Posec3dPreProcess::poseCompact(
     max_x = int(max_x);
     max_y = int(max_y);
   }
-
-  for (auto& obj : keypoints) {
-    for (int j = 0; j < obj->size(); j++) {
-      for (int i = 0; i < obj->at(j)->size(); i += 2) {
-        obj->at(j)->at(i) -= min_x;
-        obj->at(j)->at(i + 1) -= min_y;
-      }
-    }
-  }
-  new_shape[0] = int(max_y - min_y);
-  new_shape[1] = int(max_x - min_x);
-
-  // the order is x, y, w, h (in [0, 1]), a tuple
-  crop_quadruple.clear();
-  crop_quadruple.push_back(min_x / w);
-  crop_quadruple.push_back(min_y / h);
-  crop_quadruple.push_back((max_x - min_x) / w);
-  crop_quadruple.push_back((max_y - min_y) / h);
-
-  return common::ErrorCode::SUCCESS;
+  transform.min_x = min_x;
+  transform.min_y = min_y;
+  transform.max_x = max_x;
+  transform.max_y = max_y;
 }
 
-common::ErrorCode Posec3dPreProcess::resize(fpptr_dim3& keypoints,
-                                            std::vector<int>& scale,
-                                            std::vector<int>& new_shape,
-                                            bool keep_ratio) {
-  int img_h = new_shape[0], img_w = new_shape[1];
+void Posec3dPreProcess::resize(ClipTransform& transform,
+                               std::vector<int>& scale, bool keep_ratio) {
+  int img_h = int(transform.max_y - transform.min_y);
+  int img_w = int(transform.max_x - transform.min_x);
   int new_w = scale[0], new_h = scale[1];
   if (keep_ratio) {
     int max_long_edge = std::max(scale[0], scale[1]);
@@ -163,136 +138,116 @@ common::ErrorCode Posec3dPreProcess::resize(fpptr_dim3& keypoints,
     new_h = int(img_h * scale_factor + 0.5);
   }
 
-  float scale_factor_x = float(new_w) / float(img_w);
-  float scale_factor_y = float(new_h) / float(img_h);
-  new_shape[0] = new_h;
-  new_shape[1] = new_w;
-
-  for (auto& obj : keypoints) {
-    for (int j = 0; j < obj->size(); j++) {
-      for (int i = 0; i < obj->at(j)->size(); i += 2) {
-        obj->at(j)->at(i) *= scale_factor_x;
-        obj->at(j)->at(i + 1) *= scale_factor_y;
-      }
-    }
-  }
-  return common::ErrorCode::SUCCESS;
+  transform.scale_x = float(new_w) / float(img_w);
+  transform.scale_y = float(new_h) / float(img_h);
+  transform.img_h = new_h;
+  transform.img_w = new_w;
 }
 
-common::ErrorCode Posec3dPreProcess::centerCrop(
-    fpptr_dim3& keypoints, std::vector<int>& new_shape,
-    std::vector<float>& crop_quadruple, std::vector<int>& crop_size) {
-  int img_h = new_shape[0], img_w = new_shape[1];
+void Posec3dPreProcess::centerCrop(ClipTransform& transform,
+                                   std::vector<int>& crop_size) {
   int crop_w = crop_size[0], crop_h = crop_size[1];
-  int left = (img_w - crop_w) / 2;
-  int top = (img_h - crop_h) / 2;
-  int right = left + crop_w;
-  int bottom = top + crop_h;
-  int new_h = bottom - top, new_w = right - left;
-
-  new_shape[0] = new_h;
-  new_shape[1] = new_w;
-
-  float x_ratio = float(left) / img_w, y_ratio = float(top) / img_h;
-  float w_ratio = float(new_w) / img_w, h_ratio = float(new_h) / img_h;
-
-  float old_x_ratio = crop_quadruple[0], old_y_ratio = crop_quadruple[1];
-  float old_w_ratio = crop_quadruple[2], old_h_ratio = crop_quadruple[3];
-  crop_quadruple[0] = old_x_ratio + x_ratio * old_w_ratio;
-  crop_quadruple[1] = old_y_ratio + y_ratio * old_h_ratio;
-  crop_quadruple[2] = w_ratio * old_w_ratio;
-  crop_quadruple[3] = h_ratio * old_h_ratio;
-
-  for (auto& obj : keypoints) {
-    for (int j = 0; j < obj->size(); j++) {
-      for (int i = 0; i < obj->at(j)->size(); i += 2) {
-        obj->at(j)->at(i) -= left;
-        obj->at(j)->at(i + 1) -= top;
-      }
-    }
-  }
-  return common::ErrorCode::SUCCESS;
+  transform.left = (transform.img_w - crop_w) / 2;
+  transform.top = (transform.img_h - crop_h) / 2;
+  transform.img_w = crop_w;
+  transform.img_h = crop_h;
 }
 
-common::ErrorCode Posec3dPreProcess::generatePoseTarget(
-    std::shared_ptr<Posec3dContext> context, fpptr_dim3& keypoints,
-    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
-    std::vector<int>& new_shape, float* heatmap, int out_num, float sigma,
-    float scaling, int clip_len) {
-  // gen an aug
-  const float eps = 1e-4;
-  int img_h = new_shape[0], img_w = new_shape[1];
-  // scale img_h, img_w and kps
-  img_h = int(img_h * scaling + 0.5);
-  img_w = int(img_w * scaling + 0.5);
+bool Posec3dPreProcess::reuseTransform(const ClipTransform& current,
+                                       const ClipTransform& next) const {
+  if (!current.valid || current.frame_w != next.frame_w ||
+      current.frame_h != next.frame_h || current.img_w != next.img_w ||
+      current.img_h != next.img_h)
+    return false;
+  if (next.kp_min_x < current.min_x || next.kp_min_y < current.min_y ||
+      next.kp_max_x > current.max_x || next.kp_max_y > current.max_y)
+    return false;
+  return next.max_x - next.min_x >=
+             MIN_REUSE_RATIO * (current.max_x - current.min_x) &&
+         next.max_y - next.min_y >=
+             MIN_REUSE_RATIO * (current.max_y - current.min_y);
+}
 
+void Posec3dPreProcess::renderFrame(std::shared_ptr<Posec3dContext> context,
+                                    const ClipTransform& transform,
+                                    ClipFrame& frame, float sigma) {
+  const float eps = 1e-4;
+  int img_h = transform.img_h, img_w = transform.img_w;
   int num_c = context->m_net_keypoints;
-  int num_frame = sampled_keypoints.size();
-  for (auto& obj : keypoints) {
-    for (int j = 0; j < obj->size(); j++) {
-      for (int i = 0; i < obj->at(j)->size(); i += 2) {
-        obj->at(j)->at(i) *= scaling;
-        obj->at(j)->at(i + 1) *= scaling;
-      }
+  frame.heatmap.assign(num_c * img_h * img_w, 0.f);
+  for (int person_id = 0; person_id < frame.keypoints.size(); person_id++) {
+    auto& keypoints = frame.keypoints[person_id];
+    auto& scores = frame.scores[person_id];
+    for (int j = 0; j < num_c && j < scores.size(); j++) {
+      if (scores[j] < eps) continue;
+
+      float mu_x =
+          (keypoints[j * 2] - transform.min_x) * transform.scale_x -
+          transform.left;
+      float mu_y =
+          (keypoints[j * 2 + 1] - transform.min_y) * transform.scale_y -
+          transform.top;
+
+      int st_x = std::max(int(mu_x - 3 * sigma), 0);
+      int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
+      int st_y = std::max(int(mu_y - 3 * sigma), 0);
+      int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
+      if (st_x >= ed_x || st_y >= ed_y) continue;
+
+      float* base = frame.heatmap.data() + j * img_h * img_w;
+      for (int patch_x = st_x; patch_x < ed_x; patch_x++)
+        for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
+          float value = exp(-(std::pow(patch_x - mu_x, 2) +
+                              std::pow(patch_y - mu_y, 2)) /
+                            2 / std::pow(sigma, 2)) *
+                        scores[j];
+          value *= context->input_scale;
+          float& pixel = base[patch_y * img_w + patch_x];
+          if (value > pixel) pixel = value;
+        }
     }
   }
+  frame.rendered = true;
+}
+
+void Posec3dPreProcess::generatePoseTarget(
+    std::shared_ptr<Posec3dContext> context, ClipState& clip, float* heatmap,
+    int out_num, int clip_len, int num_clips) {
+  int img_h = clip.transform.img_h, img_w = clip.transform.img_w;
+  int plane = img_h * img_w;
+  int num_c = context->m_net_keypoints;
+
+  uint64_t rendered = 0;
+  for (int f = 0; f < clip.count; f++) {
+    if (clip.frame(f).rendered) continue;
+    renderFrame(context, clip.transform, clip.frame(f), SIGMA);
+    ++rendered;
+  }
 
-  float* data = heatmap;
-  memset((void*)data, 0, out_num * sizeof(float));
+  // 后一半与前一半相同
   int heatmap_start_indx = out_num / 2;
-  for (int i = 0; i < num_frame; i++) {
+  if (2 * num_clips * clip_len * num_c * plane != out_num)
+    memset((void*)heatmap, 0, out_num * sizeof(float));
+  std::vector<int> inds =
+      uniformSampleFrames(clip.count, clip_len, num_clips, 255);
+  for (int i = 0; i < inds.size(); i++) {
+    const float* src = clip.frame(inds[i]).heatmap.data();
     for (int j = 0; j < num_c; j++) {
-      for (int person_id = 0; person_id < sampled_keypoints[i]->size();
-           person_id++) {
-        if (sampled_keypoint_scores[i]->at(person_id)->at(j) < eps) continue;
-
-        float mu_x = sampled_keypoints[i]->at(person_id)->at(j * 2);
-        float mu_y = sampled_keypoints[i]->at(person_id)->at(j * 2 + 1);
-
-        int st_x = std::max(int(mu_x - 3 * sigma), 0);
-        int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
-        int st_y = std::max(int(mu_y - 3 * sigma), 0);
-        int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
-        if (st_x >= ed_x || st_y >= ed_y) continue;
-
-        float* base = data + i / clip_len * num_c * clip_len * img_h * img_w +
-                      j * clip_len * img_h * img_w +
-                      i % clip_len * img_h * img_w;
-        for (int patch_x = st_x; patch_x < ed_x; patch_x++)
-          for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
-            float value = exp(-(std::pow(patch_x - mu_x, 2) +
-                                std::pow(patch_y - mu_y, 2)) /
-                              2 / std::pow(sigma, 2)) *
-                          sampled_keypoint_scores[i]->at(person_id)->at(j);
-            value *= context->input_scale;
-            if (value > *(base + patch_y * img_w + patch_x)) {
-              *(base + patch_y * img_w + patch_x) = value;
-              *(base + patch_y * img_w + patch_x + heatmap_start_indx) = value;
-              /*
-              // original implement
-              if (j == 0)
-                *(base + heatmap_start_indx + patch_y * img_w + img_w - patch_x
-              - 1) = value; else if (j % 2 == 0)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j - 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              else if (j % 2 == 1)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j + 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              */
-            }
-          }
-      }
+      float* base = heatmap + i / clip_len * num_c * clip_len * plane +
+                    j * clip_len * plane + i % clip_len * plane;
+      memcpy(base, src + j * plane, plane * sizeof(float));
+      memcpy(base + heatmap_start_indx, src + j * plane,
+             plane * sizeof(float));
     }
   }
 
-  return common::ErrorCode::SUCCESS;
+  clip.rendered += rendered;
+  clip.reused += clip.count - rendered;
 }
 
-void Posec3dPreProcess::initTensors(std::shared_ptr<Posec3dContext> context,
-                                    common::ObjectMetadatas& objectMetadatas) {
-  auto& obj = objectMetadatas[0];
+void Posec3dPreProcess::initTensors(
+    std::shared_ptr<Posec3dContext> context,
+    std::shared_ptr<common::ObjectMetadata> obj) {
   obj->mInputBMtensors = std::make_shared<sophon_stream::common::bmTensors>();
   int channelId = obj->mFrame->mChannelId;
   int frameId = obj->mFrame->mFrameId;
@@ -308,7 +263,8 @@ void Posec3dPreProcess::initTensors(std::shared_ptr<Posec3dContext> context,
                   p->handle, p->cpu_data[i], tensor_size);
               assert(BM_SUCCESS == ret);
             }
-            bm_free_device(p->handle, p->tensors[i]->device_mem);
+            common::TensorMemPool::recycle(p->handle,
+                                           p->tensors[i]->device_mem);
           }
         }
 
@@ -327,56 +283,33 @@ void Posec3dPreProcess::initTensors(std::shared_ptr<Posec3dContext> context,
   }
 }
 
-common::ErrorCode Posec3dPreProcess::preProcess(
-    std::shared_ptr<Posec3dContext> context,
-    common::ObjectMetadatas& objectMetadatas) {
-  if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
-  initTensors(context, objectMetadatas);
+common::ErrorCode Posec3dPreProcess::makeClip(
+    std::shared_ptr<Posec3dContext> context, ClipState& clip,
+    std::shared_ptr<common::ObjectMetadata> obj) {
+  initTensors(context, obj);
 
-  fpptr_dim3 keypoints;
-  fpptr_dim3 keypoint_scores;
-  fpptr_dim3 sampled_keypoints;
-  fpptr_dim3 sampled_keypoint_scores;
-  for (auto& obj : objectMetadatas) {
-    std::shared_ptr<fpptr_dim2> single_person_keypoints =
-        std::make_shared<fpptr_dim2>();
-    std::shared_ptr<fpptr_dim2> single_person_keypoint_scores =
-        std::make_shared<fpptr_dim2>();
-    for (auto& poseObj : obj->mPosedObjectMetadatas) {
-      single_person_keypoints->push_back(
-          std::make_shared<std::vector<float>>(poseObj->keypoints));
-      single_person_keypoint_scores->push_back(
-          std::make_shared<std::vector<float>>(poseObj->scores));
-    }
-    keypoints.push_back(single_person_keypoints);
-    keypoint_scores.push_back(single_person_keypoint_scores);
-  }
-  sampled_keypoints = keypoints;
-  sampled_keypoint_scores = keypoint_scores;
-  int clip_len = 48, num_clips = 10;
-
-  // upsample frames to get 480 objs
-  uniformSampleFrames(sampled_keypoints, sampled_keypoint_scores, clip_len,
-                      num_clips, 255);
+  // rescale and shift keypoints
+  ClipTransform transform;
+  transform.valid = true;
+  transform.frame_w = clip.frame_w;
+  transform.frame_h = clip.frame_h;
   std::vector<float> hw_ratio = {1.0, 1.0};
-  std::vector<int> new_shape;
-  std::vector<float> crop_quadruple = {0, 0, 1, 1};
-
-  // rescale anf shift keypoints
-  poseCompact(objectMetadatas, keypoints, 0.25, 10, hw_ratio, new_shape,
-              crop_quadruple, true);
+  poseCompact(clip, 0.25, 10, hw_ratio, transform, true);
   std::vector<int> scale = {INT_MAX, 64};
-  resize(keypoints, scale, new_shape, true);
+  resize(transform, scale, true);
   std::vector<int> crop_size = {64, 64};
-  centerCrop(keypoints, new_shape, crop_quadruple, crop_size);
+  centerCrop(transform, crop_size);
+  // 变换改变时窗口内的帧都要重新渲染
+  if (!reuseTransform(clip.transform, transform)) {
+    clip.transform = transform;
+    for (auto& frame : clip.ring) frame.rendered = false;
+  }
+
   int out_num = context->m_net_crops_clips * context->m_net_channel *
                 context->m_net_keypoints * context->net_h * context->net_w;
   int size_byte = out_num * sizeof(float);
-  // input data set into obj0 mem
-  auto ret = bm_malloc_device_byte_heap(
-      context->handle,
-      &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem, STREAM_NPU_HEAP,
-      size_byte);
+  auto ret = getTensorMemPool(context)->acquire(
+      size_byte, &obj->mInputBMtensors->tensors[0]->device_mem);
   STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
 
   // generate heatmap input
@@ -384,34 +317,92 @@ common::ErrorCode Posec3dPreProcess::preProcess(
   if (context->bmNetwork->is_soc) {
     unsigned long long addr;
     assert(BM_SUCCESS ==
-           bm_mem_mmap_device_mem(
-               context->handle,
-               &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem,
-               &addr));
-    objectMetadatas[0]->mInputBMtensors->cpu_data.resize(1);
-    objectMetadatas[0]->mInputBMtensors->cpu_data[0] = (float*)addr;
-    heatmap = objectMetadatas[0]->mInputBMtensors->cpu_data[0];
+           bm_mem_mmap_device_mem(context->handle,
+                                  &obj->mInputBMtensors->tensors[0]->device_mem,
+                                  &addr));
+    obj->mInputBMtensors->cpu_data.resize(1);
+    obj->mInputBMtensors->cpu_data[0] = (float*)addr;
+    heatmap = obj->mInputBMtensors->cpu_data[0];
   } else
     heatmap = new float[out_num];
-  generatePoseTarget(context, keypoints, sampled_keypoints,
-                     sampled_keypoint_scores, new_shape, heatmap, out_num, 0.6,
-                     1.0, clip_len);
+  generatePoseTarget(context, clip, heatmap, out_num, CLIP_LEN, NUM_CLIPS);
 
   if (context->bmNetwork->is_soc)
     assert(BM_SUCCESS ==
            bm_mem_flush_device_mem(
-               context->handle,
-               &objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem));
+               context->handle, &obj->mInputBMtensors->tensors[0]->device_mem));
   else {
     assert(BM_SUCCESS ==
-           bm_memcpy_s2d(
-               context->handle,
-               objectMetadatas[0]->mInputBMtensors->tensors[0]->device_mem,
-               (void*)heatmap));
+           bm_memcpy_s2d(context->handle,
+                         obj->mInputBMtensors->tensors[0]->device_mem,
+                         (void*)heatmap));
     delete[] heatmap;
   }
 
-  objectMetadatas[0]->is_main = true;
+  obj->is_main = true;
+  clip.sinceClip = 0;
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode Posec3dPreProcess::preProcess(
+    std::shared_ptr<Posec3dContext> context,
+    common::ObjectMetadatas& objectMetadatas) {
+  if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
+
+  // 每个channel在本批中的最后一帧，结束时剩余的帧在它上面识别
+  std::map<int, std::shared_ptr<common::ObjectMetadata>> lastFrames;
+  for (auto& obj : objectMetadatas) {
+    int channel = obj->mFrame->mChannelIdInternal;
+    std::shared_ptr<ClipState> clip;
+    {
+      std::lock_guard<std::mutex> lock(mClipMutex);
+      auto& slot = mClips[channel];
+      if (slot == nullptr) {
+        slot = std::make_shared<ClipState>();
+        slot->ring.resize(context->max_batch);
+      }
+      clip = slot;
+    }
+
+    if (obj->mFrame->mEndOfStream) {
+      // sinceClip>0时该channel的最近一帧还没有识别过
+      if (clip->sinceClip > 0) {
+        auto lastIt = lastFrames.find(channel);
+        makeClip(context, *clip,
+                 lastFrames.end() != lastIt ? lastIt->second : obj);
+      }
+      IVS_INFO("Posec3d channel {0} ended, frames rendered {1}, reused {2}",
+               channel, clip->rendered, clip->reused);
+      // 缓存的heatmap随channel结束释放
+      std::lock_guard<std::mutex> lock(mClipMutex);
+      mClips.erase(channel);
+      continue;
+    }
+    if (obj->mFrame->mSpData == nullptr) continue;
+
+    // 加入窗口，满时覆盖最早一帧
+    int capacity = clip->ring.size();
+    int slot = (clip->head + clip->count) % capacity;
+    if (clip->count == capacity)
+      clip->head = (clip->head + 1) % capacity;
+    else
+      ++clip->count;
+    ClipFrame& frame = clip->ring[slot];
+    frame.keypoints.clear();
+    frame.scores.clear();
+    for (auto& poseObj : obj->mPosedObjectMetadatas) {
+      frame.keypoints.push_back(poseObj->keypoints);
+      frame.scores.push_back(poseObj->scores);
+    }
+    frame.rendered = false;
+    clip->frame_w = obj->mFrame->mSpData->width;
+    clip->frame_h = obj->mFrame->mSpData->height;
+    ++clip->sinceClip;
+    lastFrames[channel] = obj;
+
+    if (clip->count == capacity && clip->sinceClip >= context->clip_stride)
+      makeClip(context, *clip, obj);
+  }
 
   return common::ErrorCode::SUCCESS;
 }
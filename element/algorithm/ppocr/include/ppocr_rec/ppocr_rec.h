@@ -75,6 +75,7 @@ class PpocrRec : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_BEAM_WIDTH_FIELD = "beam_width";
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
       "class_names_file";
+  static constexpr const char* CONFIG_INTERNAL_REC_WIDTHS_FIELD = "rec_widths";
 
  private:
   std::shared_ptr<PpocrRecContext> mContext;          // context对象
@@ -10,6 +10,8 @@
 #ifndef SOPHON_STREAM_ELEMENT_PPOCR_REC_CONTEXT_H_
 #define SOPHON_STREAM_ELEMENT_PPOCR_REC_CONTEXT_H_
 
+#include <algorithm>
+
 #include "algorithmApi/context.h"
 
 namespace sophon_stream {
@@ -23,6 +25,16 @@ struct RecModelSize {
   int h;
 };
 
+/**
+ * @brief bmodel的一个stage：输入宽高、batch及其在m_netinfo->stages中的下标
+ */
+struct RecStage {
+  int index;
+  int w;
+  int h;
+  int batch;
+};
+
 class PpocrRecContext : public ::sophon_stream::element::Context {
  public:
   int deviceId;  // 设备ID
@@ -48,6 +60,35 @@ class PpocrRecContext : public ::sophon_stream::element::Context {
    * @brief ppocr network stage ratios, ratio = w / h
    */
   std::vector<float> img_ratio;
+  /**
+   * @brief 参与分桶的全部stage，宽度都在img_size中
+   */
+  std::vector<RecStage> stages;
+
+  /**
+   * @brief 宽度为w的桶一次最多能送入的对象数
+   */
+  int bucketMaxBatch(int w) const {
+    int batch = 0;
+    for (auto& stage : stages)
+      if (stage.w == w) batch = std::max(batch, stage.batch);
+    return batch;
+  }
+
+  /**
+   * @brief 宽度为w、能容纳num个对象的stage中batch最小的一个。num优先按
+   * BMNNNetwork::get_nearest_batch取整，各宽度的batch组合不同时再逐个查找
+   */
+  const RecStage* nearestStage(int w, int num) const {
+    int nearest = bmNetwork->get_nearest_batch(num);
+    const RecStage* best = nullptr;
+    for (auto& stage : stages) {
+      if (stage.w != w || stage.batch < num) continue;
+      if (stage.batch == nearest) return &stage;
+      if (best == nullptr || stage.batch < best->batch) best = &stage;
+    }
+    return best;
+  }
 };
 }  // namespace ppocr_rec
 }  // namespace element
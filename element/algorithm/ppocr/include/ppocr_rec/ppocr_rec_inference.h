@@ -31,6 +31,16 @@ class PpocrRecInference : public ::sophon_stream::element::Inference {
    */
   common::ErrorCode predict(std::shared_ptr<PpocrRecContext> context,
                             common::ObjectMetadatas& objectMetadatas);
+
+ private:
+  /**
+   * @brief 用一个stage推理同一宽度桶中的若干对象，对象数不超过stage的batch，
+   * 每个对象的输出是batch输出中对应切片
+   * @return 0表示成功
+   */
+  int forwardStage(std::shared_ptr<PpocrRecContext> context,
+                   const RecStage& stage,
+                   common::ObjectMetadatas& objectMetadatas);
 };
 
 }  // namespace ppocr_rec
@@ -57,6 +57,7 @@ namespace ppocr_det {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();    
+    initTensorMemPool(mContext);
 
     // 4.converto
     float input_scale = inputTensor->get_scale();
@@ -84,7 +84,7 @@ void Ppocr_detPostProcess::postProcess(
 
       for (auto ocrbox : ocrboxes) {
         std::shared_ptr<common::DetectedObjectMetadata> detData =
-            std::make_shared<common::DetectedObjectMetadata>();
+            common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
 
         // four conners of the box
         std::shared_ptr<common::PointMetadata> detPoint =
@@ -102,7 +102,7 @@ void Ppocr_detPostProcess::postProcess(
         detData->mKeyPoints.push_back(detPoint);
         // distributor需要用到
         detData->mClassify = 0;
-        obj->mDetectedObjectMetadatas.push_back(detData);
+        obj->addDetectedObject(detData);
       }
     }
   }
@@ -133,7 +133,7 @@ common::ErrorCode Ppocr_detPreProcess::preProcess(
     bm_device_mem_t mem;
     int size_byte = 0;
     bm_image_get_byte_size(converto_img, &size_byte);
-    ret = bm_malloc_device_byte_heap(context->handle, &mem, STREAM_NPU_HEAP, size_byte);
+    ret = getTensorMemPool(context)->acquire(size_byte, &mem);
     STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
     bm_image_attach(converto_img, &mem);
 
@@ -67,10 +67,13 @@ common::ErrorCode PpocrRec::initContext(const std::string& json) {
     mContext->beam_width = beamWidthIt->get<int>();
     STREAM_CHECK(mContext->beam_width >= 1 && mContext->beam_width <= 40,
                  "beam_size out of range, should be integer in range(1, 41)");
+    // 每个stage是一个宽度桶，宽度相同的stage只是batch不同
+    auto netinfo = mContext->bmNetwork->m_netinfo;
+    std::vector<RecStage> stages;
     int pre_net_h = -1;
-    for (int i = 0; i < mContext->bmNetwork->m_netinfo->stage_num; i++) {
-      auto tensor = mContext->bmNetwork->inputTensor(0);
-      int net_h_ = tensor->get_shape()->dims[2];
+    for (int i = 0; i < netinfo->stage_num; i++) {
+      const bm_shape_t& shape = netinfo->stages[i].input_shapes[0];
+      int net_h_ = shape.dims[2];
       if (pre_net_h == -1) {
         pre_net_h = net_h_;
       } else {
@@ -78,11 +81,29 @@ common::ErrorCode PpocrRec::initContext(const std::string& json) {
             pre_net_h == net_h_,
             "Invalid model size! All Stage's height must be identical.");
       }
-
-      int net_w_ = tensor->get_shape()->dims[3];
+      stages.push_back({i, shape.dims[3], net_h_, shape.dims[0]});
+    }
+    // 可选：只使用配置的宽度分桶，其余stage不参与
+    std::vector<int> rec_widths;
+    auto recWidthsIt = configure.find(CONFIG_INTERNAL_REC_WIDTHS_FIELD);
+    if (configure.end() != recWidthsIt && recWidthsIt->is_array()) {
+      rec_widths = recWidthsIt->get<std::vector<int>>();
+    }
+    for (int w : rec_widths) {
+      bool found = std::any_of(stages.begin(), stages.end(),
+                               [w](const RecStage& s) { return s.w == w; });
+      STREAM_CHECK(found, "rec_widths: ", std::to_string(w),
+                   " is not an input width of the bmodel.");
+    }
+    for (auto& stage : stages) {
+      if (!rec_widths.empty() &&
+          std::find(rec_widths.begin(), rec_widths.end(), stage.w) ==
+              rec_widths.end())
+        continue;
+      mContext->stages.push_back(stage);
       bool skip_flag = false;
       for (auto& tmp_size : mContext->img_size) {
-        if (tmp_size.w == net_w_) {
+        if (tmp_size.w == stage.w) {
           skip_flag = true;
           break;
         }
@@ -90,7 +111,7 @@ common::ErrorCode PpocrRec::initContext(const std::string& json) {
       if (skip_flag == true) {
         continue;
       }
-      mContext->img_size.push_back({net_w_, net_h_});
+      mContext->img_size.push_back({stage.w, stage.h});
     }
     std::sort(
         mContext->img_size.begin(), mContext->img_size.end(),
@@ -101,6 +122,7 @@ common::ErrorCode PpocrRec::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
 
     // 4.converto
     float input_scale = inputTensor->get_scale();
@@ -9,6 +9,8 @@
 
 #include "ppocr_rec_inference.h"
 
+#include <map>
+
 namespace sophon_stream {
 namespace element {
 namespace ppocr_rec {
@@ -22,25 +24,119 @@ common::ErrorCode PpocrRecInference::predict(
     common::ObjectMetadatas& objectMetadatas) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
 
-  if (context->max_batch > 1) {
-    auto inputTensors = mergeInputDeviceMem(context, objectMetadatas);
-    auto outputTensors = getOutputDeviceMem(context);
-
-    int ret = 0;
-    ret = context->bmNetwork->forward(inputTensors->tensors,
-                                      outputTensors->tensors);
+  // 按前处理选定的宽度分桶，可能来自不同帧，桶内保持原有顺序
+  std::map<int, common::ObjectMetadatas> buckets;
+  for (auto& obj : objectMetadatas) {
+    if (obj->mFrame->mEndOfStream) break;
+    if (obj->mInputBMtensors == nullptr ||
+        obj->mInputBMtensors->tensors[0]->device_mem.u.device.device_addr == 0)
+      continue;
+    buckets[obj->mInputBMtensors->tensors[0]->shape.dims[3]].push_back(obj);
+  }
 
-    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors);
-  } else {
-    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context);
-    int ret = context->bmNetwork->forward(
-        objectMetadatas[0]->mInputBMtensors->tensors,
-        objectMetadatas[0]->mOutputBMtensors->tensors);
+  for (auto& bucket : buckets) {
+    int width = bucket.first;
+    int maxBatch = context->bucketMaxBatch(width);
+    auto& objs = bucket.second;
+    for (int start = 0; start < objs.size(); start += maxBatch) {
+      int num = std::min<int>(maxBatch, objs.size() - start);
+      const RecStage* stage = context->nearestStage(width, num);
+      STREAM_CHECK(stage != nullptr, "No ppocr_rec stage for width ",
+                   std::to_string(width))
+      common::ObjectMetadatas chunk(objs.begin() + start,
+                                    objs.begin() + start + num);
+      int ret = forwardStage(context, *stage, chunk);
+      if (ret != 0) return common::ErrorCode::UNKNOWN;
+    }
   }
 
   return common::ErrorCode::SUCCESS;
 }
 
+int PpocrRecInference::forwardStage(std::shared_ptr<PpocrRecContext> context,
+                                    const RecStage& stage,
+                                    common::ObjectMetadatas& objectMetadatas) {
+  auto netinfo = context->bmNetwork->m_netinfo;
+  auto& stageInfo = netinfo->stages[stage.index];
+
+  // 输入：按stage的batch申请，不足batch的部分不拷贝
+  std::shared_ptr<common::bmTensors> inputTensors(new common::bmTensors(),
+                                                  recycleTensors);
+  inputTensors->handle = context->handle;
+  inputTensors->tensors.resize(context->input_num);
+  for (int i = 0; i < context->input_num; ++i) {
+    auto tensor = std::make_shared<bm_tensor_t>();
+    tensor->dtype = netinfo->input_dtypes[i];
+    tensor->shape = stageInfo.input_shapes[i];
+    tensor->st_mode = BM_STORE_1N;
+    unsigned int sliceBytes = bmrt_shape_count(&tensor->shape) *
+                              bmrt_data_type_size(tensor->dtype) / stage.batch;
+    auto ret = getTensorMemPool(context)->acquire(sliceBytes * stage.batch,
+                                                  &tensor->device_mem);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    for (int j = 0; j < objectMetadatas.size(); ++j) {
+      bm_memcpy_d2d_byte(context->handle, tensor->device_mem, j * sliceBytes,
+                         objectMetadatas[j]->mInputBMtensors->tensors[i]
+                             ->device_mem,
+                         0, sliceBytes);
+    }
+    inputTensors->tensors[i] = tensor;
+  }
+
+  // 输出：大小取该stage的shape，后处理据此得到时间步数
+  std::shared_ptr<common::bmTensors> outputTensors(new common::bmTensors(),
+                                                   recycleTensors);
+  outputTensors->handle = context->handle;
+  outputTensors->tensors.resize(context->output_num);
+  std::vector<unsigned int> sliceBytes(context->output_num);
+  bool useView = true;
+  for (int i = 0; i < context->output_num; ++i) {
+    auto tensor = std::make_shared<bm_tensor_t>();
+    tensor->dtype = netinfo->output_dtypes[i];
+    tensor->shape = stageInfo.output_shapes[i];
+    tensor->st_mode = BM_STORE_1N;
+    size_t bytes =
+        bmrt_shape_count(&tensor->shape) * bmrt_data_type_size(tensor->dtype);
+    sliceBytes[i] = bytes / stage.batch;
+    // SoC上后处理会mmap输出显存，切片不按页对齐时退回拷贝
+    if (context->bmNetwork->is_soc && sliceBytes[i] % 4096 != 0)
+      useView = false;
+    auto ret = getTensorMemPool(context)->acquire(bytes, &tensor->device_mem);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    outputTensors->tensors[i] = tensor;
+  }
+
+  int ret = context->bmNetwork->forward(inputTensors->tensors,
+                                        outputTensors->tensors);
+  if (ret != 0) return ret;
+
+  for (int j = 0; j < objectMetadatas.size(); ++j) {
+    if (useView) {
+      objectMetadatas[j]->mOutputBMtensors =
+          makeBatchSlotView(outputTensors, j, stage.batch, sliceBytes);
+      continue;
+    }
+    std::shared_ptr<common::bmTensors> output(new common::bmTensors(),
+                                              recycleTensors);
+    output->handle = context->handle;
+    output->tensors.resize(context->output_num);
+    for (int i = 0; i < context->output_num; ++i) {
+      output->tensors[i] =
+          std::make_shared<bm_tensor_t>(*outputTensors->tensors[i]);
+      output->tensors[i]->shape.dims[0] = 1;
+      auto status = getTensorMemPool(context)->acquire(
+          sliceBytes[i], &output->tensors[i]->device_mem);
+      STREAM_CHECK(status == 0,
+                   "Alloc Device Memory Failed! Program Terminated.")
+      bm_memcpy_d2d_byte(context->handle, output->tensors[i]->device_mem, 0,
+                         outputTensors->tensors[i]->device_mem,
+                         j * sliceBytes[i], sliceBytes[i]);
+    }
+    objectMetadatas[j]->mOutputBMtensors = output;
+  }
+  return 0;
+}
+
 }  // namespace ppocr_rec
 }  // namespace element
 }  // namespace sophon_stream
\ No newline at end of file
@@ -22,7 +22,10 @@ void PpocrRecPostProcess::postProcess(
 
   for (auto obj : objectMetadatas) {
     if (obj->mFrame->mEndOfStream) break;
-    if (obj->mOutputBMtensors->tensors.size() == 0) continue;
+    // 没有图像的对象不参与推理
+    if (obj->mOutputBMtensors == nullptr ||
+        obj->mOutputBMtensors->tensors.size() == 0)
+      continue;
     // hm_data
     std::vector<std::shared_ptr<BMNNTensor>> outputTensors(
         obj->mOutputBMtensors->tensors.size());
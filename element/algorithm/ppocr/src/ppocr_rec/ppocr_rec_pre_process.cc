@@ -50,25 +50,22 @@ common::ErrorCode PpocrRecPreProcess::preProcess(
       image_aligned = image1;
     }
 
+    // 按宽高比选择宽度桶：不超过桶宽时保持比例缩放，右侧补0；
+    // 比最宽的桶还宽时压缩到最宽的桶
     int h = image_aligned.height;
     int w = image_aligned.width;
     float ratio = w / float(h);
-    int resize_h;
-    int resize_w;
-    int padding_w;
-    if (ratio > context->img_ratio.back()) {
-      resize_h = context->img_size[context->img_size.size() - 1].h;
-      resize_w = context->img_size[context->img_size.size() - 1].w;
-    } else {
-      for (int i = 0; i < context->img_ratio.size(); i++) {
-        if (ratio <= context->img_ratio[i]) {
-          resize_h = context->img_size[i].h;
-          resize_w = (int)(resize_h * ratio);
-          padding_w = context->img_size[i].w;
-          break;
-        }
+    int bucket = context->img_size.size() - 1;
+    for (int i = 0; i < context->img_ratio.size(); i++) {
+      if (ratio <= context->img_ratio[i]) {
+        bucket = i;
+        break;
       }
     }
+    int bucket_w = context->img_size[bucket].w;
+    int bucket_h = context->img_size[bucket].h;
+    int resize_h = bucket_h;
+    int resize_w = std::min(bucket_w, std::max(1, (int)(resize_h * ratio)));
 
     // resize + padding
     bmcv_padding_atrr_t padding_attr;
@@ -84,10 +81,10 @@ common::ErrorCode PpocrRecPreProcess::preProcess(
     bmcv_rect_t crop_rect{0, 0, image_aligned.width, image_aligned.height};
 
     bm_image resized_img;
-    int aligned_net_w = FFALIGN(context->net_w, 64);
+    int aligned_net_w = FFALIGN(bucket_w, 64);
     int strides[3] = {aligned_net_w, aligned_net_w, aligned_net_w};
-    auto ret = bm_image_create(context->bmContext->handle(), context->net_h,
-                               context->net_w, FORMAT_BGR_PLANAR,
+    auto ret = bm_image_create(context->bmContext->handle(), bucket_h,
+                               bucket_w, FORMAT_BGR_PLANAR,
                                DATA_TYPE_EXT_1N_BYTE, &resized_img, strides);
     assert(BM_SUCCESS == ret);
 
@@ -102,15 +99,13 @@ common::ErrorCode PpocrRecPreProcess::preProcess(
       img_dtype = DATA_TYPE_EXT_1N_BYTE_SIGNED;
     }
     bm_image converto_img;
-    bm_image_create(context->bmNetwork->m_handle, context->net_h,
-                    context->net_w, FORMAT_BGR_PLANAR, img_dtype,
-                    &converto_img);
+    bm_image_create(context->bmNetwork->m_handle, bucket_h, bucket_w,
+                    FORMAT_BGR_PLANAR, img_dtype, &converto_img);
     bm_device_mem_t input_dev_mem;
     int size_byte = 0;
     bm_image_get_byte_size(converto_img, &size_byte);
-    ret = bm_malloc_device_byte(context->bmContext->handle(), &input_dev_mem,
-                                size_byte);
-    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")                                
+    ret = getTensorMemPool(context)->acquire(size_byte, &input_dev_mem);
+    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
     bm_image_attach(converto_img, &input_dev_mem);
     bmcv_image_convert_to(context->bmContext->handle(), 1,
                           context->converto_attr, &resized_img, &converto_img);
@@ -118,8 +113,11 @@ common::ErrorCode PpocrRecPreProcess::preProcess(
 
     bm_image_destroy(resized_img);
 
-    bm_image_get_device_mem(
-        converto_img, &objMetadata->mInputBMtensors->tensors[0]->device_mem);
+    // 输入shape记录所在的桶，推理时按宽度分组
+    auto& input = objMetadata->mInputBMtensors->tensors[0];
+    bm_image_get_device_mem(converto_img, &input->device_mem);
+    input->shape.dims[2] = bucket_h;
+    input->shape.dims[3] = bucket_w;
 
     bm_image_detach(converto_img);
     bm_image_destroy(converto_img);
@@ -33,6 +33,8 @@ class ResNet : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_MODEL_PATH_FIELD = "model_path";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD =
       "bgr2rgb";
+  static constexpr const char* CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD =
+      "cpu_preprocess_ratio";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_BGR2GRAY_FIELD =
       "bgr2gray";
 
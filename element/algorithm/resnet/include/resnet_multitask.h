@@ -10,13 +10,14 @@
 #ifndef SOPHON_STREAM_ELEMENT_RESNET_CLASSIFY_H_
 #define SOPHON_STREAM_ELEMENT_RESNET_CLASSIFY_H_
 
+#include "algorithmApi/pre_process.h"
 #include "resnet_context.h"
 
 namespace sophon_stream {
 namespace element {
 namespace resnet {
 
-class ResNetMultiTask {
+class ResNetMultiTask : public ::sophon_stream::element::PreProcess {
  public:
   ~ResNetMultiTask();
   /**
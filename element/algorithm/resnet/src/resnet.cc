@@ -40,6 +40,13 @@ common::ErrorCode ResNet::initContext(const std::string& json) {
     auto bgr2rgbIt = configure.find(CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD);
     mContext->bgr2rgb = bgr2rgbIt->get<bool>();
 
+    auto cpuRatioIt =
+        configure.find(CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD);
+    if (configure.end() != cpuRatioIt && cpuRatioIt->is_number()) {
+      mContext->cpuPreprocessRatio =
+          std::min(1.f, std::max(0.f, cpuRatioIt->get<float>()));
+    }
+
     auto bgr2grayIt = configure.find(CONFIG_INTERNAL_THRESHOLD_BGR2GRAY_FIELD);
     if (bgr2grayIt != configure.end()) {
       mContext->bgr2gray = bgr2grayIt->get<bool>();
@@ -82,6 +89,7 @@ common::ErrorCode ResNet::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     assert(mContext->output_num > 0);
     mContext->min_dim =
         mContext->bmNetwork->outputTensor(0)->get_shape()->num_dims;
@@ -72,6 +72,7 @@ common::ErrorCode Retinaface::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     mContext->min_dim =
         mContext->bmNetwork->outputTensor(0)->get_shape()->num_dims;
 
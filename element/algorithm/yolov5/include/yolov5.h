@@ -10,6 +10,9 @@
 #ifndef SOPHON_STREAM_ELEMENT_YOLOV5_H_
 #define SOPHON_STREAM_ELEMENT_YOLOV5_H_
 
+#include <map>
+#include <mutex>
+
 #include "element_factory.h"
 #include "group.h"
 #include "yolov5_context.h"
@@ -71,6 +74,8 @@ class Yolov5 : public ::sophon_stream::framework::Element {
       "use_tpu_kernel";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD =
       "bgr2rgb";
+  static constexpr const char* CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD =
+      "cpu_preprocess_ratio";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD = "mean";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_STD_FIELD = "std";
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
@@ -80,6 +85,11 @@ class Yolov5 : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_TOP_FILED = "top";
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FILED = "width";
   static constexpr const char* CONFIG_INTERNAL_HEIGHT_FILED = "height";
+  static constexpr const char* CONFIG_INTERNAL_TILE_FILED = "tile";
+  static constexpr const char* CONFIG_INTERNAL_TILE_OVERLAP_FILED = "overlap";
+  static constexpr const char* CONFIG_INTERNAL_TILE_FULL_FRAME_FILED =
+      "full_frame";
+  static constexpr const char* CONFIG_INTERNAL_TILE_ROIS_FILED = "tile_rois";
   static constexpr const char* CONFIG_INTERNAL_MAX_DET_FILED = "maxdet";
   static constexpr const char* CONFIG_INTERNAL_MIN_DET_FILED = "mindet";
 
@@ -96,8 +106,33 @@ class Yolov5 : public ::sophon_stream::framework::Element {
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
+  std::mutex mTileMutex;
+  std::map<std::pair<int, int>, std::vector<bmcv_rect_t>> mTileRects;
+
   common::ErrorCode initContext(const std::string& json);
   void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
+
+  /**
+   * @brief 取w x h图像的切块区域，按分辨率缓存
+   */
+  const std::vector<bmcv_rect_t>& getTileRects(int width, int height);
+  /**
+   * @brief 每帧的块数，整帧检测也算一块，用于按块数凑batch
+   */
+  int tileCount(const common::ObjectMetadata& objectMetadata);
+  /**
+   * @brief 分块推理：每帧一次裁出所有块，多帧的块凑成batch推理，
+   * 结果映射回原图后合并
+   */
+  void processTiled(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
+  /**
+   * @brief 块坐标映射回原图后类内去重：同一块内按iou，
+   * 不同块之间按交集/较小框面积抑制接缝处的重复框
+   * @param tiles 按rects顺序的各块，开启整帧检测时最后多一块整帧
+   */
+  void mergeTiles(common::ObjectMetadata& parent,
+                  const common::ObjectMetadatas& tiles,
+                  const std::vector<bmcv_rect_t>& rects);
 };
 
 }  // namespace yolov5
@@ -82,6 +82,13 @@ class Yolov5Context : public ::sophon_stream::element::Context {
 
   bmcv_rect_t roi;
   bool roi_predefined = false;
+
+  // 分块推理：大分辨率图像切成有重叠的块或按配置的多个roi分别检测
+  bool tile_enabled = false;
+  int tile_w = 0, tile_h = 0;
+  float tile_overlap = 0.2f;           // 相邻块的重叠比例
+  bool tile_full_frame = false;        // 是否同时检测整帧，用于大目标
+  std::vector<bmcv_rect_t> tile_rois;  // 非空时按roi切块，不再按网格
   int thread_number;
   unsigned int m_max_det = UINT_MAX, m_min_det = 0;
 };
@@ -9,6 +9,8 @@
 
 #include "yolov5.h"
 
+#include "common/common_tool.h"
+
 using namespace std::chrono_literals;
 
 namespace sophon_stream {
@@ -78,6 +80,13 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
     auto bgr2rgbIt = configure.find(CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD);
     mContext->bgr2rgb = bgr2rgbIt->get<bool>();
 
+    auto cpuRatioIt =
+        configure.find(CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD);
+    if (configure.end() != cpuRatioIt && cpuRatioIt->is_number()) {
+      mContext->cpuPreprocessRatio =
+          std::min(1.f, std::max(0.f, cpuRatioIt->get<float>()));
+    }
+
     auto meanIt = configure.find(CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD);
     mContext->mean = meanIt->get<std::vector<float>>();
     assert(mContext->mean.size() == 3);
@@ -130,6 +139,7 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     mContext->min_dim =
         mContext->bmNetwork->outputTensor(0)->get_shape()->num_dims;
     if (mContext->output_num == 3) {
@@ -203,6 +213,49 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
       mContext->roi.crop_h =
           roi_it->find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
     }
+
+    // 8. tile
+    auto tile_it = configure.find(CONFIG_INTERNAL_TILE_FILED);
+    if (configure.end() != tile_it && tile_it->is_object()) {
+      auto widthIt = tile_it->find(CONFIG_INTERNAL_WIDTH_FILED);
+      auto heightIt = tile_it->find(CONFIG_INTERNAL_HEIGHT_FILED);
+      if (tile_it->end() != widthIt && tile_it->end() != heightIt) {
+        mContext->tile_enabled = true;
+        // 裁剪起点和尺寸保持偶数，yuv420格式才能正确裁剪
+        mContext->tile_w = widthIt->get<int>() & ~1;
+        mContext->tile_h = heightIt->get<int>() & ~1;
+        STREAM_CHECK(mContext->tile_w > 0 && mContext->tile_h > 0,
+                     "Tile width and height should be positive! Please Check "
+                     "The Json File.");
+      }
+      auto overlapIt = tile_it->find(CONFIG_INTERNAL_TILE_OVERLAP_FILED);
+      if (tile_it->end() != overlapIt && overlapIt->is_number())
+        mContext->tile_overlap =
+            std::min(0.9f, std::max(0.f, overlapIt->get<float>()));
+      auto fullFrameIt = tile_it->find(CONFIG_INTERNAL_TILE_FULL_FRAME_FILED);
+      if (tile_it->end() != fullFrameIt && fullFrameIt->is_boolean())
+        mContext->tile_full_frame = fullFrameIt->get<bool>();
+    }
+    auto tile_rois_it = configure.find(CONFIG_INTERNAL_TILE_ROIS_FILED);
+    if (configure.end() != tile_rois_it && tile_rois_it->is_array()) {
+      for (auto& roi : *tile_rois_it) {
+        bmcv_rect_t rect;
+        rect.start_x = roi.find(CONFIG_INTERNAL_LEFT_FILED)->get<int>() & ~1;
+        rect.start_y = roi.find(CONFIG_INTERNAL_TOP_FILED)->get<int>() & ~1;
+        rect.crop_w = roi.find(CONFIG_INTERNAL_WIDTH_FILED)->get<int>() & ~1;
+        rect.crop_h = roi.find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>() & ~1;
+        mContext->tile_rois.push_back(rect);
+      }
+      mContext->tile_enabled = !mContext->tile_rois.empty();
+    }
+    if (mContext->tile_enabled) {
+      STREAM_CHECK(use_pre && use_infer && use_post,
+                   "Tile inference needs pre, infer and post stages in one "
+                   "element! Please Check The Json File.");
+      STREAM_CHECK(!mContext->roi_predefined,
+                   "Tile inference could not be used with roi! Please Check "
+                   "The Json File.");
+    }
     mContext->thread_number = getThreadNumber();
   } while (false);
   return common::ErrorCode::SUCCESS;
@@ -250,6 +303,9 @@ common::ErrorCode Yolov5::initInternal(const std::string& json) {
 
     mContext->deviceId = getDeviceId();
     initContext(configure.dump());
+    setDetectionSchedule(
+        common::DetectionScheduler::parseConfig(configure),
+        configure.value(CONFIG_INTERNAL_MODEL_PATH_FIELD, std::string()));
     // 前处理初始化
     mPreProcess->init(mContext);
     // 推理初始化
@@ -287,6 +343,169 @@ void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
     mPostProcess->postProcess(mContext, objectMetadatas, dataPipeId);
 }
 
+const std::vector<bmcv_rect_t>& Yolov5::getTileRects(int width, int height) {
+  std::lock_guard<std::mutex> lock(mTileMutex);
+  auto key = std::make_pair(width, height);
+  auto it = mTileRects.find(key);
+  if (mTileRects.end() != it) return it->second;
+
+  std::vector<bmcv_rect_t>& rects = mTileRects[key];
+  if (!mContext->tile_rois.empty()) {
+    // 超出图像的部分截掉，完全在图像外的roi忽略
+    for (auto roi : mContext->tile_rois) {
+      roi.crop_w = std::min(roi.crop_w, (width - roi.start_x) & ~1);
+      roi.crop_h = std::min(roi.crop_h, (height - roi.start_y) & ~1);
+      if (roi.start_x < 0 || roi.start_y < 0 || roi.crop_w <= 0 ||
+          roi.crop_h <= 0) {
+        IVS_WARN("Tile roi out of {0}x{1} image, ignored", width, height);
+        continue;
+      }
+      rects.push_back(roi);
+    }
+  } else {
+    // 每个方向上块数取满足重叠比例的最小值，起点均匀分布，最后一块贴齐边缘
+    auto starts = [this](int length, int tile) {
+      std::vector<int> result;
+      if (length <= tile) return std::vector<int>{0};
+      float stride = tile * (1.f - mContext->tile_overlap);
+      int num = (int)std::ceil((length - tile) / stride) + 1;
+      for (int i = 0; i < num; ++i)
+        result.push_back(((length - tile) * i / (num - 1)) & ~1);
+      return result;
+    };
+    int tile_w = std::min(mContext->tile_w, width & ~1);
+    int tile_h = std::min(mContext->tile_h, height & ~1);
+    for (int y : starts(height, tile_h)) {
+      for (int x : starts(width, tile_w))
+        rects.push_back({x, y, tile_w, tile_h});
+    }
+  }
+  IVS_INFO("Yolov5 tiles {0}x{1} image into {2} tiles", width, height,
+           rects.size());
+  return rects;
+}
+
+int Yolov5::tileCount(const common::ObjectMetadata& objectMetadata) {
+  if (!mContext->tile_enabled) return 1;
+  const auto& frame = objectMetadata.mFrame;
+  if (frame->mEndOfStream || frame->mSpData == nullptr) return 0;
+  return getTileRects(frame->mSpData->width, frame->mSpData->height).size() +
+         (mContext->tile_full_frame ? 1 : 0);
+}
+
+void Yolov5::processTiled(common::ObjectMetadatas& objectMetadatas,
+                          int dataPipeId) {
+  std::vector<common::ObjectMetadatas> frameTiles(objectMetadatas.size());
+  // 指向getTileRects的缓存，整帧检测的块不在其中
+  std::vector<const std::vector<bmcv_rect_t>*> frameRects(
+      objectMetadatas.size(), nullptr);
+  common::ObjectMetadatas allTiles;
+
+  for (size_t i = 0; i < objectMetadatas.size(); ++i) {
+    auto& parent = objectMetadatas[i];
+    // 结束帧、空帧不参与推理，直接透传
+    if (tileCount(*parent) == 0) continue;
+    auto& frame = parent->mFrame;
+    const std::vector<bmcv_rect_t>& rects =
+        getTileRects(frame->mSpData->width, frame->mSpData->height);
+    // 一帧的所有块一次裁出
+    auto crops = crop_images(frame->mHandle, *frame->mSpData, rects);
+    if (crops.size() != rects.size()) {
+      parent->mErrorCode = common::ErrorCode::UNKNOWN;
+      continue;
+    }
+    if (mContext->tile_full_frame) crops.push_back(frame->mSpData);
+
+    for (size_t j = 0; j < crops.size(); ++j) {
+      auto tile = common::makePooled<common::ObjectMetadata>();
+      tile->mArena = parent->mArena;
+      tile->mGraphId = parent->mGraphId;
+      tile->mFrame = common::makePooled<common::Frame>();
+      tile->mFrame->mSpData = crops[j];
+      tile->mFrame->mWidth = crops[j]->width;
+      tile->mFrame->mHeight = crops[j]->height;
+      tile->mFrame->mHandle = frame->mHandle;
+      tile->mFrame->mChannelId = frame->mChannelId;
+      tile->mFrame->mChannelIdInternal = frame->mChannelIdInternal;
+      tile->mFrame->mFrameId = frame->mFrameId;
+      frameTiles[i].push_back(tile);
+      allTiles.push_back(tile);
+    }
+    frameRects[i] = &rects;
+  }
+
+  for (size_t begin = 0; begin < allTiles.size();
+       begin += mContext->max_batch) {
+    size_t end = std::min(allTiles.size(), begin + mContext->max_batch);
+    common::ObjectMetadatas batch(allTiles.begin() + begin,
+                                  allTiles.begin() + end);
+    process(batch, dataPipeId);
+  }
+
+  for (size_t i = 0; i < objectMetadatas.size(); ++i) {
+    if (frameTiles[i].empty()) continue;
+    mergeTiles(*objectMetadatas[i], frameTiles[i], *frameRects[i]);
+  }
+}
+
+void Yolov5::mergeTiles(common::ObjectMetadata& parent,
+                        const common::ObjectMetadatas& tiles,
+                        const std::vector<bmcv_rect_t>& rects) {
+  struct Candidate {
+    std::shared_ptr<common::DetectedObjectMetadata> det;
+    float score;
+    size_t tile;
+  };
+  std::vector<Candidate> boxes;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (common::ErrorCode::SUCCESS != tiles[i]->mErrorCode)
+      parent.mErrorCode = tiles[i]->mErrorCode;
+    // rects之后的一块是整帧，坐标不需要平移
+    int dx = i < rects.size() ? rects[i].start_x : 0;
+    int dy = i < rects.size() ? rects[i].start_y : 0;
+    for (auto& detData : tiles[i]->mDetectedObjectMetadatas) {
+      detData->mBox.mX += dx;
+      detData->mBox.mY += dy;
+      float score = detData->mScores.empty() ? 0.f : detData->mScores[0];
+      boxes.push_back({detData, score, i});
+    }
+  }
+  std::stable_sort(boxes.begin(), boxes.end(),
+                   [](const Candidate& a, const Candidate& b) {
+                     return a.score > b.score;
+                   });
+
+  // 同一块内的框按类内iou抑制；接缝处被截断的目标在相邻块里只有部分框，
+  // 与完整框的iou不高，所以不同块（包括整帧）之间用交集占较小框面积的比例
+  std::vector<Candidate> kept;
+  for (auto& box : boxes) {
+    const auto& b = box.det->mBox;
+    bool duplicated = false;
+    for (auto& keep : kept) {
+      if (keep.det->mClassify != box.det->mClassify) continue;
+      const auto& k = keep.det->mBox;
+      int w = std::min(b.mX + b.mWidth, k.mX + k.mWidth) - std::max(b.mX, k.mX);
+      int h = std::min(b.mY + b.mHeight, k.mY + k.mHeight) -
+              std::max(b.mY, k.mY);
+      if (w <= 0 || h <= 0) continue;
+      float inter = (float)w * h;
+      float areaB = (float)b.mWidth * b.mHeight;
+      float areaK = (float)k.mWidth * k.mHeight;
+      float overlap = keep.tile == box.tile
+                          ? inter / (areaB + areaK - inter)
+                          : inter / std::min(areaB, areaK);
+      if (overlap > mContext->thresh_nms) {
+        duplicated = true;
+        break;
+      }
+    }
+    if (!duplicated) kept.push_back(box);
+  }
+  parent.mDetectedObjectMetadatas.clear();
+  for (auto& keep : kept) parent.mDetectedObjectMetadatas.push_back(keep.det);
+  parent.detectionsChanged();
+}
+
 common::ErrorCode Yolov5::doWork(int dataPipeId) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
 
@@ -301,7 +520,9 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
 
   common::ObjectMetadatas pendingObjectMetadatas;
 
-  while (objectMetadatas.size() < mContext->max_batch &&
+  // 分块推理时按块数凑batch，一个batch可以包含多帧的块
+  int batchUnits = 0;
+  while (batchUnits < mContext->max_batch &&
          (getThreadStatus() == ThreadStatus::RUN)) {
     // 如果队列为空则等待
     auto data = popInputData(inputPort, dataPipeId);
@@ -312,7 +533,11 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
 
     auto objectMetadata =
         std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+    // 按检测间隔跳过的帧与被过滤的帧一样直接透传
+    if (!objectMetadata->mFilter && !skipDetection(*objectMetadata)) {
+      objectMetadatas.push_back(objectMetadata);
+      batchUnits += tileCount(*objectMetadata);
+    }
 
     pendingObjectMetadatas.push_back(objectMetadata);
 
@@ -321,7 +546,10 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
     }
   }
 
-  process(objectMetadatas, dataPipeId);
+  if (mContext->tile_enabled)
+    processTiled(objectMetadatas, dataPipeId);
+  else
+    process(objectMetadatas, dataPipeId);
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
     int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
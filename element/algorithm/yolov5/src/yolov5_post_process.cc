@@ -247,7 +247,8 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
       temp_bbox.y = std::max(int(centerY - temp_bbox.height / 2), 0);
 
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(
+              objectMetadatas[i]->mArena);
       detData->mBox.mX = temp_bbox.x;
       detData->mBox.mY = temp_bbox.y;
       detData->mBox.mWidth =
@@ -264,7 +265,7 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
           detData->mBox.mHeight > context->m_min_det &&
           detData->mBox.mWidth < context->m_max_det &&
           detData->mBox.mHeight < context->m_max_det)
-        objectMetadatas[i]->mDetectedObjectMetadatas.push_back(detData);
+        objectMetadatas[i]->addDetectedObject(detData);
     }
   }
 }
@@ -548,7 +549,7 @@ void Yolov5PostProcess::postProcessCPU(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = bbox.x;
       detData->mBox.mY = bbox.y;
       detData->mBox.mWidth = bbox.width;
@@ -568,7 +569,7 @@ void Yolov5PostProcess::postProcessCPU(
           detData->mBox.mHeight > context->m_min_det &&
           detData->mBox.mWidth < context->m_max_det &&
           detData->mBox.mHeight < context->m_max_det)
-        obj->mDetectedObjectMetadatas.push_back(detData);
+        obj->addDetectedObject(detData);
     }
     ++idx;
   }
@@ -110,6 +110,7 @@ common::ErrorCode Yolov7::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     mContext->min_dim =
         mContext->bmNetwork->outputTensor(0)->get_shape()->num_dims;
     if (mContext->output_num == 3) {
@@ -230,6 +231,9 @@ common::ErrorCode Yolov7::initInternal(const std::string& json) {
 
     mContext->deviceId = getDeviceId();
     initContext(configure.dump());
+    setDetectionSchedule(
+        common::DetectionScheduler::parseConfig(configure),
+        configure.value(CONFIG_INTERNAL_MODEL_PATH_FIELD, std::string()));
     // 前处理初始化
     mPreProcess->init(mContext);
     // 推理初始化
@@ -292,7 +296,9 @@ common::ErrorCode Yolov7::doWork(int dataPipeId) {
 
     auto objectMetadata =
         std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+    // 按检测间隔跳过的帧与被过滤的帧一样直接透传
+    if (!objectMetadata->mFilter && !skipDetection(*objectMetadata))
+      objectMetadatas.push_back(objectMetadata);
 
     pendingObjectMetadatas.push_back(objectMetadata);
 
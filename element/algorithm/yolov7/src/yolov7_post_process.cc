@@ -246,7 +246,8 @@ void Yolov7PostProcess::postProcessTPUKERNEL(
       temp_bbox.y = std::max(int(centerY - temp_bbox.height / 2), 0);
 
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(
+              objectMetadatas[i]->mArena);
       detData->mBox.mX = temp_bbox.x;
       detData->mBox.mY = temp_bbox.y;
       detData->mBox.mWidth = temp_bbox.width;
@@ -257,7 +258,7 @@ void Yolov7PostProcess::postProcessTPUKERNEL(
         detData->mBox.mX += context->roi.start_x;
         detData->mBox.mY += context->roi.start_y;
       }
-      objectMetadatas[i]->mDetectedObjectMetadatas.push_back(detData);
+      objectMetadatas[i]->addDetectedObject(detData);
     }
   }
 }
@@ -442,7 +443,7 @@ void Yolov7PostProcess::postProcessCPU(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = bbox.x;
       detData->mBox.mY = bbox.y;
       detData->mBox.mWidth = bbox.width;
@@ -470,7 +471,7 @@ void Yolov7PostProcess::postProcessCPU(
       if (context->class_thresh_valid) {
         detData->mLabelName = context->class_names[detData->mClassify];
       }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      obj->addDetectedObject(detData);
     }
     ++idx;
   }
@@ -19,11 +19,11 @@ common::ErrorCode Yolov7PreProcess::preProcess(
     std::shared_ptr<Yolov7Context> context,
     common::ObjectMetadatas& objectMetadatas) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
-  initTensors(context, objectMetadatas);
+  initBatchSlots(context, objectMetadatas);
 
   auto jsonPlanner = context->bgr2rgb ? FORMAT_RGB_PLANAR : FORMAT_BGR_PLANAR;
-  int i = 0;
-  for (auto& objMetadata : objectMetadatas) {
+  for (int i = 0; i < objectMetadatas.size(); ++i) {
+    auto& objMetadata = objectMetadatas[i];
     if (objMetadata->mFrame->mSpData == nullptr) continue;
     bm_image resized_img;
     bm_image converto_img;
@@ -139,11 +139,12 @@ common::ErrorCode Yolov7PreProcess::preProcess(
     bm_image_create(context->handle, context->net_h, context->net_w,
                     jsonPlanner, img_dtype, &converto_img);
 
-    bm_device_mem_t mem;
+    // 直接写入batch显存中属于本帧的切片
+    bm_device_mem_t mem = objMetadata->mInputBMtensors->tensors[0]->device_mem;
     int size_byte = 0;
     bm_image_get_byte_size(converto_img, &size_byte);
-    ret = bm_malloc_device_byte_heap(context->handle, &mem, STREAM_NPU_HEAP, size_byte);
-    STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
+    STREAM_CHECK(size_byte <= bm_mem_get_device_size(mem),
+                 "Batch Slot Too Small! Program Terminated.")
     bm_image_attach(converto_img, &mem);
 
     bmcv_image_convert_to(context->handle, 1, context->converto_attr,
@@ -151,12 +152,8 @@ common::ErrorCode Yolov7PreProcess::preProcess(
 
     bm_image_destroy(resized_img);
 
-    bm_image_get_device_mem(
-        converto_img,
-        &objectMetadatas[i]->mInputBMtensors->tensors[0]->device_mem);
     bm_image_detach(converto_img);
     bm_image_destroy(converto_img);
-    i++;
   }
   return common::ErrorCode::SUCCESS;
 }
@@ -63,6 +63,8 @@ class Yolov8 : public ::sophon_stream::framework::Element {
       "threshold_nms";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD =
       "bgr2rgb";
+  static constexpr const char* CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD =
+      "cpu_preprocess_ratio";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD = "mean";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_STD_FIELD = "std";
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
@@ -263,7 +263,7 @@ void Yolov8PostProcess::postProcessPose(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
 
       detData->mBox.mX = bbox.x1 - PATCH;
       detData->mBox.mY = bbox.y1 - PATCH;
@@ -284,7 +284,7 @@ void Yolov8PostProcess::postProcessPose(
       if (context->class_thresh_valid) {
         detData->mLabelName = context->class_names[detData->mClassify];
       }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      obj->addDetectedObject(detData);
       obj->mPosedObjectMetadatas.push_back(poseData);
     }
     ++idx;
@@ -421,7 +421,7 @@ void Yolov8PostProcess::postProcessDetOpt(
       float height = (yolobox_vec[i].y2 - yolobox_vec[i].y1) / ratio;
 
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = std::max(int(centerx - width / 2), 0);
       detData->mBox.mY = std::max(int(centery - height / 2), 0);
       detData->mBox.mWidth = width;
@@ -449,7 +449,7 @@ void Yolov8PostProcess::postProcessDetOpt(
       if (context->class_thresh_valid) {
         detData->mLabelName = context->class_names[detData->mClassify];
       }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      obj->addDetectedObject(detData);
     }
     ++idx;
   }
@@ -608,7 +608,7 @@ void Yolov8PostProcess::postProcessDet(
 
     for (auto bbox : yolobox_vec) {
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = std::max(int(bbox.x1), 0);
       detData->mBox.mY = std::max(int(bbox.y1), 0);
       detData->mBox.mWidth = bbox.x2 - bbox.x1;
@@ -634,7 +634,7 @@ void Yolov8PostProcess::postProcessDet(
       if (context->class_thresh_valid) {
         detData->mLabelName = context->class_names[detData->mClassify];
       }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      obj->addDetectedObject(detData);
     }
     ++idx;
   }
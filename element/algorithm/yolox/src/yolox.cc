@@ -78,6 +78,13 @@ common::ErrorCode Yolox::initContext(const std::string& json) {
     auto bgr2rgbIt = configure.find(CONFIG_INTERNAL_THRESHOLD_BGR2RGB_FIELD);
     mContext->bgr2rgb = bgr2rgbIt->get<bool>();
 
+    auto cpuRatioIt =
+        configure.find(CONFIG_INTERNAL_CPU_PREPROCESS_RATIO_FIELD);
+    if (configure.end() != cpuRatioIt && cpuRatioIt->is_number()) {
+      mContext->cpuPreprocessRatio =
+          std::min(1.f, std::max(0.f, cpuRatioIt->get<float>()));
+    }
+
     auto meanIt = configure.find(CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD);
     mContext->mean = meanIt->get<std::vector<float>>();
     assert(mContext->mean.size() == 3);
@@ -102,6 +109,7 @@ common::ErrorCode Yolox::initContext(const std::string& json) {
 
     // 3. get output
     mContext->output_num = mContext->bmNetwork->outputTensorNum();
+    initTensorMemPool(mContext);
     mContext->class_num =
         mContext->bmNetwork->outputTensor(0)->get_shape()->dims[2] - 4 - 1;  //
     if (mContext->class_thresh_valid) {
@@ -188,6 +196,9 @@ common::ErrorCode Yolox::initInternal(const std::string& json) {
 
     mContext->deviceId = getDeviceId();
     initContext(configure.dump());
+    setDetectionSchedule(
+        common::DetectionScheduler::parseConfig(configure),
+        configure.value(CONFIG_INTERNAL_MODEL_PATH_FIELD, std::string()));
 
     // 前处理初始化
     mPreProcess->init(mContext);
@@ -255,7 +266,9 @@ common::ErrorCode Yolox::doWork(int dataPipeId) {
     auto objectMetadata =
         std::static_pointer_cast<common::ObjectMetadata>(data);
 
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+    // 按检测间隔跳过的帧与被过滤的帧一样直接透传
+    if (!objectMetadata->mFilter && !skipDetection(*objectMetadata))
+      objectMetadatas.push_back(objectMetadata);
 
     pendingObjectMetadatas.push_back(objectMetadata);
 
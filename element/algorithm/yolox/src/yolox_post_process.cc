@@ -177,7 +177,7 @@ void YoloxPostProcess::postProcess(std::shared_ptr<YoloxContext> context,
     for (size_t i = 0; i < picked.size(); i++) {
       auto bbox = yolobox_vec[picked[i]];
       std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
+          common::makeInArena<common::DetectedObjectMetadata>(obj->mArena);
       detData->mBox.mX = bbox.left;
       detData->mBox.mY = bbox.top;
       detData->mBox.mWidth = bbox.width;
@@ -191,7 +191,7 @@ void YoloxPostProcess::postProcess(std::shared_ptr<YoloxContext> context,
       if (context->class_thresh_valid) {
         detData->mLabelName = context->class_names[detData->mClassify];
       }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      obj->addDetectedObject(detData);
     }
   }
 }
@@ -30,7 +30,17 @@ struct ChannelOperateRequest {
     DROP,
     KEEP,
   };
-  enum class SourceType { RTSP, RTMP, VIDEO, IMG_DIR, BASE64, GB28181,CAMERA ,UNKNOWN};
+  enum class SourceType {
+    RTSP,
+    RTMP,
+    VIDEO,
+    IMG_DIR,
+    BASE64,
+    GB28181,
+    CAMERA,
+    REPLAY,
+    UNKNOWN
+  };
   int graphId;
   int channelId;
   int loopNum;
@@ -45,6 +55,8 @@ struct ChannelOperateRequest {
   SampleStrategy sampleStrategy;
   bool roi_predefined = false;
   bmcv_rect_t roi;
+  std::string capturePath;   // 非空时把解复用后的视频包录制到该文件
+  double replaySpeed = 1.0;  // REPLAY的回放速度，0为尽可能快
 
 };
 
@@ -126,6 +126,8 @@ class ThreadWrapper : public ::sophon_stream::common::NoCopyable {
 
 struct ChannelInfo {
   int mFrameCount = 0;
+  // 上一帧的显存大小，作为下一帧准入时的预估值
+  std::size_t mFrameBytes = 0;
   std::shared_ptr<Decoder> mSpDecoder;
   std::shared_ptr<std::mutex> mMtx;
   std::shared_ptr<std::condition_variable> mCv;
@@ -143,6 +145,11 @@ class Decode : public ::sophon_stream::framework::Element {
 
   bm_handle_t getHandle() const;
 
+  /**
+   * @brief graph id在initInternal之后才设置，在这里生效显存预算并注册查询接口
+   */
+  void setGraphId(int id) override;
+
   static constexpr const char* JSON_CHANNEL_ID = "channel_id";
   static constexpr const char* JSON_SOURCE_TYPE = "source_type";
   static constexpr const char* JSON_URL = "url";
@@ -157,6 +164,15 @@ class Decode : public ::sophon_stream::framework::Element {
   static constexpr const char* JSON_TOP_FILED = "top";
   static constexpr const char* JSON_WIDTH_FILED = "width";
   static constexpr const char* JSON_HEIGHT_FILED = "height";
+  static constexpr const char* JSON_CAPTURE_PATH_FILED = "capture_path";
+  static constexpr const char* JSON_REPLAY_SPEED_FILED = "replay_speed";
+  static constexpr const char* CONFIG_INTERNAL_MEMORY_BUDGET_MB_FIELD =
+      "memory_budget_mb";
+  static constexpr const char* CONFIG_INTERNAL_DEVICE_MEMORY_BUDGET_MB_FIELD =
+      "device_memory_budget_mb";
+
+  // 超出预算时每次等待的时长，超时后重新检查线程状态
+  static constexpr int ADMISSION_TIMEOUT_MS = 10;
 
  private:
   std::map<int, std::shared_ptr<ChannelInfo>> mThreadsPool;
@@ -183,6 +199,13 @@ class Decode : public ::sophon_stream::framework::Element {
   common::ErrorCode parse_channel_task(
       std::shared_ptr<ChannelTask>& channelTask);
 
+  void getMemoryUsage(const httplib::Request& request,
+                      httplib::Response& response);
+
+  // 显存预算，0表示不限制
+  std::size_t mGraphBudgetBytes = 0;
+  std::size_t mDeviceBudgetBytes = 0;
+
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
   bm_handle_t handle_;
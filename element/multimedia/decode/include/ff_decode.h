@@ -24,6 +24,7 @@
 #include "channel.h"
 #include "libyuv.h"
 #include "opencv2/opencv.hpp"
+#include "packet_capture.h"
 extern "C" {
 #include <libavdevice/avdevice.h>
 #include <libavformat/avformat.h>
@@ -90,6 +91,18 @@ class VideoDecFFM {
    * cache queue  */
   int openDec(bm_handle_t* dec_handle, const char* input);
 
+  /* open decoder on a capture file instead of an url, packets are fed by
+   * PacketReplayer */
+  int openReplay(
+      bm_handle_t* dec_handle,
+      std::shared_ptr<const sophon_stream::element::decode::PacketCapture>
+          capture,
+      double speed, int loopNum);
+
+  /* record demuxed video packets of the next openDec into a capture file,
+   * kept across reconnections */
+  void setCapture(const std::string& path);
+
   /* grab a bm_image from the cache queue*/
   std::shared_ptr<bm_image> grab(int& frame_id, int& eof, int64_t& pts,
                                  int sampleInterval, sampleStrategy strategy);
@@ -106,6 +119,13 @@ class VideoDecFFM {
   /* set fps */
   void setFps(int f);
 
+  /* frame rate of the opened video stream, {0, 1} when unknown */
+  AVRational getFrameRate() const { return frame_rate; }
+
+  /* pts of the last grabbed frame in microseconds, AV_NOPTS_VALUE when the
+   * stream has none */
+  int64_t getPtsUs() const { return pts_us; }
+
  private:
   bool quit_flag = false;
 
@@ -127,6 +147,9 @@ class VideoDecFFM {
   int refcount;
   double fps;
   double frame_interval_time;  // ms
+  AVRational frame_rate;
+  AVRational time_base;
+  int64_t pts_us;
   struct timeval last_time;
   struct timeval current_time;
 
@@ -144,10 +167,20 @@ class VideoDecFFM {
 
   std::string inputUrl;
 
+  std::unique_ptr<sophon_stream::element::decode::PacketCaptureWriter>
+      capture_writer;
+  std::unique_ptr<sophon_stream::element::decode::PacketReplayer> replayer;
+
   int openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
                        AVFormatContext* fmt_ctx, enum AVMediaType type,
                        int sophon_idx);
 
+  int openDecoder(const AVCodecParameters* par, AVCodecContext** dec_ctx,
+                  int sophon_idx);
+
+  /* read next video packet into pkt, from ifmt_ctx or replayer */
+  int readPacket();
+
   int isNetworkError(int ret);
 
   void reConnectVideoStream();
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_PACKET_CAPTURE_H_
+#define SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_PACKET_CAPTURE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+/**
+ * @brief 录制文件格式，整数按主机字节序（x86/arm均为小端）写入：
+ * @brief
+ * 文件头：magic "SSCAP002"，int32 codec_id、width、height、format、
+ * time_base.num、time_base.den、frame_rate.num、frame_rate.den、
+ * extradata_size，extradata。SSCAP001没有frame_rate，仍可读取
+ * 之后每个视频包一条记录：int64 recv_us（相对第一个包的到达时间）、pts、dts，
+ * int32 flags、size，包数据
+ */
+class PacketCaptureWriter {
+ public:
+  ~PacketCaptureWriter();
+
+  bool open(const std::string& path);
+
+  /**
+   * @brief 写入一个解复用后的视频包，第一个关键帧之前的包被丢弃，
+   * 保证回放从关键帧开始
+   */
+  void write(const AVCodecParameters* par, AVRational timeBase,
+             AVRational frameRate, const AVPacket* pkt);
+
+  void close();
+
+ private:
+  void writeHeader(const AVCodecParameters* par, AVRational timeBase,
+                   AVRational frameRate);
+
+  FILE* mFile = nullptr;
+  std::string mPath;
+  bool mHeaderWritten = false;
+  std::chrono::steady_clock::time_point mStart;
+  int64_t mPackets = 0;
+  int64_t mBytes = 0;
+};
+
+/**
+ * @brief 加载到内存中的录制文件，只读，可以被多路回放共享
+ */
+struct PacketCapture {
+  struct Packet {
+    int64_t recvUs;
+    int64_t pts;
+    int64_t dts;
+    int flags;
+    std::size_t offset;  // 包数据在mData中的偏移
+    int size;
+  };
+
+  int codecId = 0;
+  int width = 0;
+  int height = 0;
+  int format = -1;
+  AVRational timeBase = {1, 1};
+  AVRational frameRate = {0, 1};  // 录制时码流的帧率，未知时num为0
+  std::vector<uint8_t> extradata;
+  std::vector<Packet> packets;
+  std::vector<uint8_t> data;
+
+  /**
+   * @brief 同一个文件只加载一次，所有回放该文件的码流共享同一份数据
+   * @return 文件不存在或格式错误时返回nullptr
+   */
+  static std::shared_ptr<const PacketCapture> load(const std::string& path);
+
+ private:
+  static std::mutex sCacheMutex;
+  static std::map<std::string, std::weak_ptr<const PacketCapture> > sCache;
+};
+
+/**
+ * @brief 按录制时的到达时间回放录制文件中的包
+ */
+class PacketReplayer {
+ public:
+  /**
+   * @param speed 1为录制时的速度，0为不等待、尽可能快，其他值为倍速
+   * @param loopNum 回放次数，0为无限循环
+   */
+  PacketReplayer(std::shared_ptr<const PacketCapture> capture, double speed,
+                 int loopNum);
+
+  /**
+   * @brief 构造解码器参数，调用者负责释放
+   */
+  AVCodecParameters* makeCodecParameters() const;
+
+  /**
+   * @brief 取下一个包，需要时先等待到它的回放时间
+   * @return 0成功，回放结束返回AVERROR_EOF
+   */
+  int read(AVPacket* pkt);
+
+ private:
+  std::shared_ptr<const PacketCapture> mCapture;
+  double mSpeed;
+  int mLoopsLeft;
+  std::size_t mIndex = 0;
+  // 本轮回放的起始时间
+  std::chrono::steady_clock::time_point mLoopStart;
+};
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_PACKET_CAPTURE_H_
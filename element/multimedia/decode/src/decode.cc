@@ -9,10 +9,38 @@
 
 #include "decode.h"
 
+#include <algorithm>
+
+#include "common/memory_budget.h"
+
 namespace sophon_stream {
 namespace element {
 namespace decode {
 
+namespace {
+
+std::size_t getImageBytes(const bm_image& image) {
+  int planeNum = bm_image_get_plane_num(image);
+  int planeBytes[4] = {0};
+  if (planeNum <= 0 || planeNum > 4 ||
+      BM_SUCCESS != bm_image_get_byte_size(image, planeBytes))
+    return 0;
+  std::size_t bytes = 0;
+  for (int i = 0; i < planeNum; ++i) bytes += planeBytes[i];
+  return bytes;
+}
+
+nlohmann::json memoryUsageToJson(const common::MemoryUsage& usage) {
+  nlohmann::json json;
+  json["bytes_in_flight"] = usage.mBytesInFlight;
+  json["peak_bytes"] = usage.mPeakBytes;
+  json["budget_bytes"] = usage.mBudgetBytes;
+  json["throttle_count"] = usage.mThrottleCount;
+  return json;
+}
+
+}  // namespace
+
 Decode::Decode() {}
 
 std::unordered_map<int, std::atomic<int>> Decode::mChannelCountMap;
@@ -39,6 +67,15 @@ common::ErrorCode Decode::initInternal(const std::string& json) {
     mFpsProfiler.config("fps_decode", 100);
     int dev_id = getDeviceId();
     bm_dev_request(&handle_, dev_id);
+
+    // 在途显存预算，单位MB，不配置或为0时不限制
+    auto budgetIt = configure.find(CONFIG_INTERNAL_MEMORY_BUDGET_MB_FIELD);
+    if (configure.end() != budgetIt && budgetIt->is_number_integer())
+      mGraphBudgetBytes = budgetIt->get<std::size_t>() << 20;
+    auto devBudgetIt =
+        configure.find(CONFIG_INTERNAL_DEVICE_MEMORY_BUDGET_MB_FIELD);
+    if (configure.end() != devBudgetIt && devBudgetIt->is_number_integer())
+      mDeviceBudgetBytes = devBudgetIt->get<std::size_t>() << 20;
   } while (false);
 
   return errorCode;
@@ -179,6 +216,10 @@ common::ErrorCode Decode::parse_channel_task(
       IVS_INFO("Source type is {0}", sourceType);
       channelTask->request.sourceType =
           ChannelOperateRequest::SourceType::CAMERA;
+    } else if (sourceType == "REPLAY") {
+      IVS_INFO("Source type is {0}", sourceType);
+      channelTask->request.sourceType =
+          ChannelOperateRequest::SourceType::REPLAY;
     } else {
       IVS_ERROR(
           "{0} error, please input RTSP, RTMP, VIDEO, IMG_DIR, BASE64 or "
@@ -208,7 +249,9 @@ common::ErrorCode Decode::parse_channel_task(
     if (channelTask->request.sourceType ==
             ChannelOperateRequest::SourceType::VIDEO ||
         channelTask->request.sourceType ==
-            ChannelOperateRequest::SourceType::IMG_DIR) {
+            ChannelOperateRequest::SourceType::IMG_DIR ||
+        channelTask->request.sourceType ==
+            ChannelOperateRequest::SourceType::REPLAY) {
       auto loopNumIt = configure.find(JSON_LOOP_NUM);
       if (configure.end() == loopNumIt || !channelIdIt->is_number_integer()) {
         IVS_WARN(
@@ -247,6 +290,15 @@ common::ErrorCode Decode::parse_channel_task(
               : ChannelOperateRequest::SampleStrategy::DROP;
     }
 
+    auto capturePathIt = configure.find(JSON_CAPTURE_PATH_FILED);
+    if (configure.end() != capturePathIt && capturePathIt->is_string())
+      channelTask->request.capturePath = capturePathIt->get<std::string>();
+
+    auto replaySpeedIt = configure.find(JSON_REPLAY_SPEED_FILED);
+    if (configure.end() != replaySpeedIt && replaySpeedIt->is_number())
+      channelTask->request.replaySpeed =
+          std::max(0.0, replaySpeedIt->get<double>());
+
     auto roi_it = configure.find(JSON_ROI_FILED);
     if (roi_it == configure.end()) {
       channelTask->request.roi_predefined = false;
@@ -440,9 +492,16 @@ common::ErrorCode Decode::resumeTask(
 common::ErrorCode Decode::process(
     const std::shared_ptr<ChannelTask>& channelTask,
     const std::shared_ptr<ChannelInfo>& channelInfo) {
+  int graphId = channelTask->request.graphId;
+  auto& budget = common::MemoryBudget::getInstance();
+  // 在途显存超出预算时暂不取帧，等待下游释放
+  if (!budget.waitForAdmission(graphId, getDeviceId(),
+                               channelInfo->mFrameBytes,
+                               ADMISSION_TIMEOUT_MS))
+    return common::ErrorCode::SUCCESS;
+
   std::shared_ptr<common::ObjectMetadata> objectMetadata;
   common::ErrorCode ret = channelInfo->mSpDecoder->process(objectMetadata);
-  int graphId = channelTask->request.graphId;
   mFpsProfiler.add(1);
   if (ret == common::ErrorCode::STREAM_END) {
     // end of stream , detach thread and erase in mThreadsPool,
@@ -460,6 +519,11 @@ common::ErrorCode Decode::process(
   objectMetadata->mSkipElements = skip_elements;
   objectMetadata->mFrame->mChannelId = channel_id;
   objectMetadata->mFrame->mChannelIdInternal = mChannelIdInternalMap[graphId][channel_id];
+  if (objectMetadata->mFrame->mSpData) {
+    channelInfo->mFrameBytes = getImageBytes(*objectMetadata->mFrame->mSpData);
+    objectMetadata->mFrame->mMemoryCharge =
+        budget.charge(graphId, getDeviceId(), channelInfo->mFrameBytes);
+  }
 
   // push data to next element
   if (objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
@@ -487,6 +551,39 @@ common::ErrorCode Decode::process(
   return ret;
 }
 
+void Decode::getMemoryUsage(const httplib::Request& request,
+                            httplib::Response& response) {
+  auto& budget = common::MemoryBudget::getInstance();
+  common::Response resp;
+  resp.code = 0;
+  resp.msg = "success";
+  nlohmann::json json_res = resp;
+  json_res["graph_id"] = getGraphId();
+  json_res["device_id"] = getDeviceId();
+  json_res["graph"] = memoryUsageToJson(budget.getGraphUsage(getGraphId()));
+  json_res["device"] =
+      memoryUsageToJson(budget.getDeviceUsage(getDeviceId()));
+  response.set_content(json_res.dump(), "application/json");
+  return;
+}
+
+void Decode::setGraphId(int id) {
+  ::sophon_stream::framework::Element::setGraphId(id);
+
+  auto& budget = common::MemoryBudget::getInstance();
+  if (mGraphBudgetBytes) budget.setGraphBudget(id, mGraphBudgetBytes);
+  if (mDeviceBudgetBytes)
+    budget.setDeviceBudget(getDeviceId(), mDeviceBudgetBytes);
+
+  auto listener = getListener();
+  if (listener == nullptr) return;
+  std::string memoryUsageStr = "/memory-usage/" + std::to_string(id);
+  listener->setHandler(memoryUsageStr.c_str(),
+                       sophon_stream::framework::RequestType::GET,
+                       std::bind(&Decode::getMemoryUsage, this,
+                                 std::placeholders::_1, std::placeholders::_2));
+}
+
 REGISTER_WORKER("decode", Decode)
 
 }  // namespace decode
@@ -130,12 +130,33 @@ common::ErrorCode Decoder::init(int graphId,
       IVS_DEBUG("Decoder::init, base64Port: {0}", request.base64Port);
     }
 
+    if (mSourceType == ChannelOperateRequest::SourceType::REPLAY) {
+      auto capture = PacketCapture::load(mUrl);
+      if (!capture) {
+        errorCode = common::ErrorCode::ERR_FFMPEG_INPUT_CTX_OPEN;
+        break;
+      }
+      auto ret = decoder.openReplay(&m_handle, capture, request.replaySpeed,
+                                    mLoopNum);
+      if (ret < 0) {
+        IVS_ERROR(
+            "Decoder::init error, openReplay failed, ret: {0}, channel id : "
+            "{1}",
+            ret, request.channelId);
+        errorCode = common::ErrorCode::ERR_FFMPEG_INPUT_CTX_OPEN;
+        break;
+      }
+      IVS_INFO("Decoder::init, replay {0} at speed {1}", mUrl,
+               request.replaySpeed);
+    }
+
     if (mSourceType == ChannelOperateRequest::SourceType::RTSP ||
         mSourceType == ChannelOperateRequest::SourceType::RTMP ||
         mSourceType == ChannelOperateRequest::SourceType::GB28181 ||
         mSourceType == ChannelOperateRequest::SourceType::CAMERA ||
         mSourceType == ChannelOperateRequest::SourceType::VIDEO) {
       decoder.setFps(mFps);
+      if (!request.capturePath.empty()) decoder.setCapture(request.capturePath);
       auto ret = decoder.openDec(&m_handle, mUrl.c_str());
       if (ret < 0) {
         IVS_ERROR(
@@ -157,20 +178,26 @@ common::ErrorCode Decoder::process(
 
   if (mSourceType == ChannelOperateRequest::SourceType::RTSP ||
       mSourceType == ChannelOperateRequest::SourceType::RTMP ||
-      mSourceType == ChannelOperateRequest::SourceType::GB28181) {
+      mSourceType == ChannelOperateRequest::SourceType::GB28181 ||
+      mSourceType == ChannelOperateRequest::SourceType::REPLAY) {
     int frame_id = 0;
     int eof = 0;
     std::shared_ptr<bm_image> spBmImage = nullptr;
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makePooled<common::ObjectMetadata>();
+    objectMetadata->mFrame = common::makePooled<common::Frame>();
+    objectMetadata->mArena = common::makePooled<common::FrameArena>();
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
     objectMetadata->mFrame->mSpData = spBmImage;
     objectMetadata->mFrame->mTimestamp = pts;
+    objectMetadata->mFrame->mPts = decoder.getPtsUs();
+    AVRational frameRate = decoder.getFrameRate();
+    objectMetadata->mFrame->mFrameRate =
+        common::Rational(frameRate.num, frameRate.den);
     objectMetadata->mGraphId = mGraphId;
     if (eof) {
       objectMetadata->mFrame->mEndOfStream = true;
@@ -190,13 +217,18 @@ common::ErrorCode Decoder::process(
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makePooled<common::ObjectMetadata>();
+    objectMetadata->mFrame = common::makePooled<common::Frame>();
+    objectMetadata->mArena = common::makePooled<common::FrameArena>();
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
     objectMetadata->mFrame->mSpData = spBmImage;
     objectMetadata->mFrame->mTimestamp = pts;
+    objectMetadata->mFrame->mPts = decoder.getPtsUs();
+    AVRational frameRate = decoder.getFrameRate();
+    objectMetadata->mFrame->mFrameRate =
+        common::Rational(frameRate.num, frameRate.den);
     objectMetadata->mGraphId = mGraphId;
     /* 当mLoopNum > 1，在最后一帧初始化decoder，开始下一个循环 */
     if (mLoopNum > 1 && (mImgIndex++ == mFrameCount - 1)) {
@@ -222,8 +254,9 @@ common::ErrorCode Decoder::process(
 
     spBmImage = decoder.picDec(
         m_handle, mImagePaths[mImgIndex % mImagePaths.size()].c_str());
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makePooled<common::ObjectMetadata>();
+    objectMetadata->mFrame = common::makePooled<common::Frame>();
+    objectMetadata->mArena = common::makePooled<common::FrameArena>();
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = mImgIndex;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(mImgIndex);
@@ -251,8 +284,9 @@ common::ErrorCode Decoder::process(
     std::shared_ptr<bm_image> spBmImage = nullptr;
 
     spBmImage = mgr->grab(m_handle);
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makePooled<common::ObjectMetadata>();
+    objectMetadata->mFrame = common::makePooled<common::Frame>();
+    objectMetadata->mArena = common::makePooled<common::FrameArena>();
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = mImgIndex++;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(mImgIndex);
@@ -283,13 +317,18 @@ common::ErrorCode Decoder::process(
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
    
 
-    objectMetadata = std::make_shared<common::ObjectMetadata>();
-    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata = common::makePooled<common::ObjectMetadata>();
+    objectMetadata->mFrame = common::makePooled<common::Frame>();
+    objectMetadata->mArena = common::makePooled<common::FrameArena>();
     objectMetadata->mFrame->mHandle = m_handle;
     objectMetadata->mFrame->mFrameId = frame_id;
     objectMetadata->mFrame->mSubFrameIdVec.push_back(frame_id);
     objectMetadata->mFrame->mSpData = spBmImage;
     objectMetadata->mFrame->mTimestamp = pts;
+    objectMetadata->mFrame->mPts = decoder.getPtsUs();
+    AVRational frameRate = decoder.getFrameRate();
+    objectMetadata->mFrame->mFrameRate =
+        common::Rational(frameRate.num, frameRate.den);
     objectMetadata->mGraphId = mGraphId;
 
     if (eof) {
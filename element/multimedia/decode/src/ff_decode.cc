@@ -102,6 +102,9 @@ VideoDecFFM::VideoDecFFM() {
 
   video_stream_idx = -1;
   refcount = 1;
+  frame_rate = {0, 1};
+  time_base = AV_TIME_BASE_Q;
+  pts_us = AV_NOPTS_VALUE;
 
   avdevice_register_all();
   // frame = av_frame_alloc();
@@ -512,13 +515,68 @@ void VideoDecFFM::closeDec() {
   quit_flag = false;
 }
 
+int VideoDecFFM::openReplay(
+    bm_handle_t* dec_handle,
+    std::shared_ptr<const sophon_stream::element::decode::PacketCapture>
+        capture,
+    double speed, int loopNum) {
+  pkt = av_packet_alloc();
+  gettimeofday(&last_time, NULL);
+  frame = av_frame_alloc();
+  frame_id = 0;
+  inputUrl.clear();
+  this->handle = dec_handle;
+  this->dev_id = bm_get_devid(*dec_handle);
+  // 回放按录制时的到达时间控制节奏，不再按fps控制
+  fps = -1;
+
+  replayer.reset(new sophon_stream::element::decode::PacketReplayer(
+      capture, speed, loopNum));
+  AVCodecParameters* par = replayer->makeCodecParameters();
+  int ret = openDecoder(par, &video_dec_ctx, dev_id);
+  avcodec_parameters_free(&par);
+  if (ret < 0) return ret;
+  video_stream_idx = 0;
+  time_base = capture->timeBase;
+  // 使用录制时码流的帧率；旧版本录制文件或码流没有帧率时按首尾包的pts估算
+  const auto& packets = capture->packets;
+  int64_t span = packets.back().pts - packets.front().pts;
+  if (capture->frameRate.num > 0 && capture->frameRate.den > 0)
+    frame_rate = capture->frameRate;
+  else if (packets.size() > 1 && packets.front().pts != AV_NOPTS_VALUE &&
+           packets.back().pts != AV_NOPTS_VALUE && span > 0)
+    frame_rate = av_d2q(
+        (packets.size() - 1) / (span * av_q2d(capture->timeBase)), 1001000);
+  width = video_dec_ctx->width;
+  height = video_dec_ctx->height;
+  pix_fmt = video_dec_ctx->pix_fmt;
+  return 0;
+}
+
+void VideoDecFFM::setCapture(const std::string& path) {
+  capture_writer.reset(new sophon_stream::element::decode::PacketCaptureWriter);
+  if (!capture_writer->open(path)) capture_writer.reset();
+}
+
+int VideoDecFFM::readPacket() {
+  if (replayer) {
+    int ret = replayer->read(pkt);
+    pkt->stream_index = video_stream_idx;
+    return ret;
+  }
+  int ret = av_read_frame(ifmt_ctx, pkt);
+  if (ret >= 0 && capture_writer && pkt->stream_index == video_stream_idx) {
+    AVStream* st = ifmt_ctx->streams[video_stream_idx];
+    capture_writer->write(st->codecpar, st->time_base, frame_rate, pkt);
+  }
+  return ret;
+}
+
 int VideoDecFFM::openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
                                   AVFormatContext* fmt_ctx,
                                   enum AVMediaType type, int sophon_idx) {
   int ret, stream_index;
   AVStream* st;
-  AVCodec* dec = NULL;
-  AVDictionary* opts = NULL;
 
   ret = av_find_best_stream(fmt_ctx, type, -1, -1, NULL, 0);
   if (ret < 0) {
@@ -530,15 +588,39 @@ int VideoDecFFM::openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
   stream_index = ret;
   st = fmt_ctx->streams[stream_index];
 
-  if (st->codecpar->codec_id != AV_CODEC_ID_H264 &&
-      st->codecpar->codec_id != AV_CODEC_ID_HEVC &&
-      st->codecpar->codec_id != AV_CODEC_ID_RAWVIDEO) {
+  ret = openDecoder(st->codecpar, dec_ctx, sophon_idx);
+  if (ret < 0) return ret;
+  *stream_idx = stream_index;
+
+  video_dec_par = st->codecpar;
+  frame_rate = st->avg_frame_rate.num > 0 ? st->avg_frame_rate
+                                          : st->r_frame_rate;
+  time_base = st->time_base;
+  if (fps != -1) {
+    if (is_camera == false) {
+      fps = av_q2d(st->r_frame_rate);
+    }
+    frame_interval_time = 1 / fps * 1000;
+  }
+
+  return 0;
+}
+
+int VideoDecFFM::openDecoder(const AVCodecParameters* par,
+                             AVCodecContext** dec_ctx, int sophon_idx) {
+  int ret;
+  AVCodec* dec = NULL;
+  AVDictionary* opts = NULL;
+  enum AVMediaType type = par->codec_type;
+
+  if (par->codec_id != AV_CODEC_ID_H264 && par->codec_id != AV_CODEC_ID_HEVC &&
+      par->codec_id != AV_CODEC_ID_RAWVIDEO) {
     hardware_decode = false;
     data_on_device_mem = false;
   }
 
   /* find decoder for the stream */
-  decoder = avcodec_find_decoder(st->codecpar->codec_id);
+  decoder = avcodec_find_decoder(par->codec_id);
 
   if (!decoder) {
     av_log(NULL, AV_LOG_FATAL, "Failed to find %s codec\n",
@@ -555,7 +637,7 @@ int VideoDecFFM::openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
   }
 
   /* Copy codec parameters from input stream to output codec context */
-  ret = avcodec_parameters_to_context(*dec_ctx, st->codecpar);
+  ret = avcodec_parameters_to_context(*dec_ctx, par);
   if (ret < 0) {
     av_log(NULL, AV_LOG_FATAL,
            "Failed to copy %s codec parameters to decoder context\n",
@@ -563,7 +645,6 @@ int VideoDecFFM::openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
     return ret;
   }
 
-  video_dec_par = st->codecpar;
   /* Init the decoders, with or without reference counting */
   av_dict_set(&opts, "refcounted_frames", refcount ? "1" : "0", 0);
   av_dict_set_int(&opts, "sophon_idx", sophon_idx, 0);
@@ -576,20 +657,12 @@ int VideoDecFFM::openCodecContext(int* stream_idx, AVCodecContext** dec_ctx,
                   0);  // if we use dma_buffer mode
 
   ret = avcodec_open2(*dec_ctx, dec, &opts);
+  av_dict_free(&opts);
   if (ret < 0) {
     av_log(NULL, AV_LOG_FATAL, "Failed to open %s codec\n",
            av_get_media_type_string(type));
     return ret;
   }
-  *stream_idx = stream_index;
-
-  av_dict_free(&opts);
-  if (fps != -1) {
-    if (is_camera == false) {
-      fps = av_q2d(st->r_frame_rate);
-    }
-    frame_interval_time = 1 / fps * 1000;
-  }
 
   return 0;
 }
@@ -685,7 +758,7 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
   while (1) {
     // 這裡不能有if(pkt->side_data != nullptr)
     av_packet_unref(pkt);
-    ret = av_read_frame(ifmt_ctx, pkt);
+    ret = readPacket();
     if (ret < 0) {
       if (ret == AVERROR(EAGAIN)) {
         gettimeofday(&tv2, NULL);
@@ -803,11 +876,16 @@ std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
     }
   }
   frameId = frame_id++;
+  pts_us = AV_NOPTS_VALUE;
   if (1 == eof) return spBmImage;
 
   timeval pt;
   gettimeofday(&pt, NULL);
   pts = pt.tv_sec * 1e6 + pt.tv_usec;
+  int64_t streamPts = avframe->best_effort_timestamp;
+  if (streamPts == AV_NOPTS_VALUE) streamPts = avframe->pts;
+  if (streamPts != AV_NOPTS_VALUE)
+    pts_us = av_rescale_q(streamPts, time_base, AV_TIME_BASE_Q);
 
   if ((strategy == sampleStrategy::DROP) && (frameId % sampleInterval != 0)) {
     return spBmImage;
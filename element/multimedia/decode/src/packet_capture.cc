@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "packet_capture.h"
+
+#include <cstring>
+#include <thread>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+namespace {
+
+constexpr char CAPTURE_MAGIC[8] = {'S', 'S', 'C', 'A', 'P', '0', '0', '2'};
+// 不含帧率的旧版本
+constexpr char CAPTURE_MAGIC_V1[8] = {'S', 'S', 'C', 'A', 'P', '0', '0', '1'};
+
+template <typename T>
+bool writeValue(FILE* file, T value) {
+  return fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+bool readValue(FILE* file, T& value) {
+  return fread(&value, sizeof(T), 1, file) == 1;
+}
+
+}  // namespace
+
+PacketCaptureWriter::~PacketCaptureWriter() { close(); }
+
+bool PacketCaptureWriter::open(const std::string& path) {
+  close();
+  mFile = fopen(path.c_str(), "wb");
+  if (mFile == nullptr) {
+    IVS_ERROR("Open capture file failed, path: {0}", path);
+    return false;
+  }
+  mPath = path;
+  mHeaderWritten = false;
+  mPackets = 0;
+  mBytes = 0;
+  return true;
+}
+
+void PacketCaptureWriter::writeHeader(const AVCodecParameters* par,
+                                      AVRational timeBase,
+                                      AVRational frameRate) {
+  fwrite(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC), 1, mFile);
+  writeValue<int32_t>(mFile, par->codec_id);
+  writeValue<int32_t>(mFile, par->width);
+  writeValue<int32_t>(mFile, par->height);
+  writeValue<int32_t>(mFile, par->format);
+  writeValue<int32_t>(mFile, timeBase.num);
+  writeValue<int32_t>(mFile, timeBase.den);
+  writeValue<int32_t>(mFile, frameRate.num);
+  writeValue<int32_t>(mFile, frameRate.den);
+  writeValue<int32_t>(mFile, par->extradata_size);
+  if (par->extradata_size > 0)
+    fwrite(par->extradata, par->extradata_size, 1, mFile);
+  mHeaderWritten = true;
+  mStart = std::chrono::steady_clock::now();
+}
+
+void PacketCaptureWriter::write(const AVCodecParameters* par,
+                                AVRational timeBase, AVRational frameRate,
+                                const AVPacket* pkt) {
+  if (mFile == nullptr) return;
+  if (!mHeaderWritten) {
+    if (!(pkt->flags & AV_PKT_FLAG_KEY)) return;
+    writeHeader(par, timeBase, frameRate);
+  }
+  int64_t recvUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - mStart)
+                       .count();
+  writeValue<int64_t>(mFile, recvUs);
+  writeValue<int64_t>(mFile, pkt->pts);
+  writeValue<int64_t>(mFile, pkt->dts);
+  writeValue<int32_t>(mFile, pkt->flags);
+  writeValue<int32_t>(mFile, pkt->size);
+  if (fwrite(pkt->data, pkt->size, 1, mFile) != 1 && pkt->size > 0) {
+    IVS_ERROR("Write capture file failed, stop capturing, path: {0}", mPath);
+    close();
+    return;
+  }
+  ++mPackets;
+  mBytes += pkt->size;
+}
+
+void PacketCaptureWriter::close() {
+  if (mFile == nullptr) return;
+  fclose(mFile);
+  mFile = nullptr;
+  IVS_INFO("Capture file closed, path: {0}, packets: {1}, bytes: {2}", mPath,
+           mPackets, mBytes);
+}
+
+std::mutex PacketCapture::sCacheMutex;
+std::map<std::string, std::weak_ptr<const PacketCapture> >
+    PacketCapture::sCache;
+
+std::shared_ptr<const PacketCapture> PacketCapture::load(
+    const std::string& path) {
+  std::lock_guard<std::mutex> lock(sCacheMutex);
+  auto cached = sCache[path].lock();
+  if (cached) return cached;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    IVS_ERROR("Open capture file failed, path: {0}", path);
+    return nullptr;
+  }
+  auto capture = std::make_shared<PacketCapture>();
+  bool valid = false;
+  do {
+    char magic[sizeof(CAPTURE_MAGIC)];
+    if (fread(magic, sizeof(magic), 1, file) != 1) break;
+    bool v1 = memcmp(magic, CAPTURE_MAGIC_V1, sizeof(magic)) == 0;
+    if (!v1 && memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0) break;
+    int32_t extradataSize = 0;
+    if (!readValue(file, capture->codecId) ||
+        !readValue(file, capture->width) ||
+        !readValue(file, capture->height) ||
+        !readValue(file, capture->format) ||
+        !readValue(file, capture->timeBase.num) ||
+        !readValue(file, capture->timeBase.den))
+      break;
+    if (!v1 && (!readValue(file, capture->frameRate.num) ||
+                !readValue(file, capture->frameRate.den)))
+      break;
+    if (!readValue(file, extradataSize) || extradataSize < 0) break;
+    capture->extradata.resize(extradataSize);
+    if (extradataSize > 0 &&
+        fread(capture->extradata.data(), extradataSize, 1, file) != 1)
+      break;
+
+    // 最后一条记录不完整（例如录制进程被杀）时丢弃该记录
+    while (true) {
+      Packet packet;
+      int32_t flags = 0;
+      int32_t size = 0;
+      if (!readValue(file, packet.recvUs) || !readValue(file, packet.pts) ||
+          !readValue(file, packet.dts) || !readValue(file, flags) ||
+          !readValue(file, size) || size < 0)
+        break;
+      packet.flags = flags;
+      packet.size = size;
+      packet.offset = capture->data.size();
+      capture->data.resize(packet.offset + size);
+      if (size > 0 &&
+          fread(capture->data.data() + packet.offset, size, 1, file) != 1) {
+        capture->data.resize(packet.offset);
+        break;
+      }
+      capture->packets.push_back(packet);
+    }
+    valid = !capture->packets.empty();
+  } while (false);
+  fclose(file);
+
+  if (!valid) {
+    IVS_ERROR("Invalid or empty capture file, path: {0}", path);
+    return nullptr;
+  }
+  IVS_INFO("Capture file loaded, path: {0}, packets: {1}, duration: {2} ms",
+           path, capture->packets.size(),
+           capture->packets.back().recvUs / 1000);
+  sCache[path] = capture;
+  return capture;
+}
+
+PacketReplayer::PacketReplayer(std::shared_ptr<const PacketCapture> capture,
+                               double speed, int loopNum)
+    : mCapture(capture),
+      mSpeed(speed),
+      mLoopsLeft(loopNum <= 0 ? -1 : loopNum),
+      mLoopStart(std::chrono::steady_clock::now()) {}
+
+AVCodecParameters* PacketReplayer::makeCodecParameters() const {
+  AVCodecParameters* par = avcodec_parameters_alloc();
+  par->codec_type = AVMEDIA_TYPE_VIDEO;
+  par->codec_id = (AVCodecID)mCapture->codecId;
+  par->width = mCapture->width;
+  par->height = mCapture->height;
+  par->format = mCapture->format;
+  if (!mCapture->extradata.empty()) {
+    par->extradata = (uint8_t*)av_mallocz(mCapture->extradata.size() +
+                                          AV_INPUT_BUFFER_PADDING_SIZE);
+    memcpy(par->extradata, mCapture->extradata.data(),
+           mCapture->extradata.size());
+    par->extradata_size = mCapture->extradata.size();
+  }
+  return par;
+}
+
+int PacketReplayer::read(AVPacket* pkt) {
+  if (mIndex == mCapture->packets.size()) {
+    if (mLoopsLeft > 0) --mLoopsLeft;
+    if (mLoopsLeft == 0) return AVERROR_EOF;
+    mIndex = 0;
+    // 下一轮接在本轮之后，间隔取平均包间隔，按录制时长累加避免漂移
+    const auto& packets = mCapture->packets;
+    int64_t periodUs = packets.back().recvUs;
+    if (packets.size() > 1) periodUs += periodUs / (packets.size() - 1);
+    if (mSpeed > 0)
+      mLoopStart += std::chrono::microseconds((int64_t)(periodUs / mSpeed));
+  }
+  const PacketCapture::Packet& packet = mCapture->packets[mIndex++];
+  if (mSpeed > 0) {
+    auto due = mLoopStart + std::chrono::microseconds(
+                                (int64_t)(packet.recvUs / mSpeed));
+    std::this_thread::sleep_until(due);
+  }
+
+  int ret = av_new_packet(pkt, packet.size);
+  if (ret < 0) return ret;
+  memcpy(pkt->data, mCapture->data.data() + packet.offset, packet.size);
+  pkt->pts = packet.pts;
+  pkt->dts = packet.dts;
+  pkt->flags = packet.flags;
+  return 0;
+}
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
@@ -62,6 +62,11 @@ class Encode : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 将本element注册为OSD结果的消费者
+   */
+  void setGraphId(int id) override;
+
   static constexpr const char* CONFIG_INTERNAL_ENCODE_TYPE_FIELD =
       "encode_type";
   static constexpr const char* CONFIG_INTERNAL_RTSP_PORT_FIELD = "rtsp_port";
@@ -71,6 +76,7 @@ class Encode : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_WSS_PORT_FIELD = "wss_port";
   static constexpr const char* CONFIG_INTERNAL_WSS_BACKEND = "wss_backend";
   static constexpr const char* CONFIG_INTERNAL_FPS_FIELD = "fps";
+  static constexpr const char* CONFIG_INTERNAL_OUTPUTS_FIELD = "outputs";
 
   // for customizing shape and ip
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FIELD = "width";
@@ -83,8 +89,10 @@ class Encode : public ::sophon_stream::framework::Element {
   std::map<int, std::shared_ptr<Encoder>> mEncoderMap;
   bm_handle_t m_handle;
   std::map<int, std::string> mChannelOutputPath;
-  enum class EncodeType { RTSP, RTMP, VIDEO, IMG_DIR, WS, UNKNOWN };
+  enum class EncodeType { RTSP, RTMP, VIDEO, IMG_DIR, WS, MULTI, UNKNOWN };
   EncodeType mEncodeType;
+  // 实际的输出类型；非MULTI时只有mEncodeType一种
+  std::vector<EncodeType> mOutputs;
   std::string mRtspPort;
   std::string mRtmpPort;
   std::string encFmt;
@@ -113,6 +121,10 @@ class Encode : public ::sophon_stream::framework::Element {
   // 处理RTSP、RTMP、VIDEO
   void processVideoStream(
       int dataPipeId, std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  // 生成RTSP、RTMP、VIDEO的输出地址
+  std::string makeOutputPath(EncodeType type, int graph_id, int channel_id);
+  bool hasOutput(EncodeType type) const;
+  bool hasVideoOutput() const;
   // 处理IMG_DIR
   void processImgDir(int dataPipeId,
                      std::shared_ptr<common::ObjectMetadata> objectMetadata);
@@ -122,6 +134,12 @@ class Encode : public ::sophon_stream::framework::Element {
   // WS发送停止标识
   void stopWS(int dataPipeId);
 
+  // 这一帧是否会被编码推送，供OSD判断是否需要绘制
+  bool wantsOsd(const common::ObjectMetadata& objectMetadata);
+  std::mutex mDemandMtx;
+  // {channel id : WS服务}，用于查询每一路的连接数
+  std::map<int, std::shared_ptr<WSSManager>> mChannelWSSMap;
+
   // 如果多decoder，各自连接到各自的encoder上，那么直接把encoder的profiler
   // resize成线程数会出错 所以这里使用一个unordered_map来代替
   // key: channelIdInternal
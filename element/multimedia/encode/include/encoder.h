@@ -24,6 +24,7 @@
 #include <thread>
 
 #include "common/profiler.h"
+#include "packet_sink.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -45,6 +46,10 @@ class Encoder {
   ~Encoder();
 
   void set_output_path(const std::string& output_path);
+  /**
+   * @brief 设置多个输出地址，只编码一次，码流分发给每个输出
+   */
+  void set_output_paths(const std::vector<std::string>& output_paths);
   void set_enc_params_width(int width);
   void set_enc_params_height(int height);
   void init_writer();
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_PACKET_SINK_H_
+#define SOPHON_STREAM_ELEMENT_PACKET_SINK_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+/**
+ * @brief 一路已编码码流的输出（RTSP、RTMP或本地文件），只做封装，不做编码。
+ * @brief
+ * 同一路视频编码一次后，压缩后的AVPacket分发给多个PacketSink，每个sink有
+ * 自己的队列和写线程；刚建立连接、重连或队列溢出丢包后，从下一个关键帧开始写入
+ */
+class PacketSink {
+ public:
+  PacketSink(const std::string& url, int channel_idx);
+  ~PacketSink();
+
+  /**
+   * @brief 根据url选择封装格式并创建输出上下文，还不会打开连接
+   */
+  bool prepare();
+
+  /**
+   * @brief 封装格式是否需要把SPS/PPS放在全局头里
+   */
+  bool needGlobalHeader() const;
+
+  /**
+   * @brief 拷贝编码参数，写入头部并启动写线程
+   * @param enc_ctx 已经avcodec_open2的编码器
+   */
+  void start(const AVCodecContext* enc_ctx);
+
+  /**
+   * @brief 投递一个以编码器time_base为单位的packet，队列满时丢弃
+   */
+  void push(const std::shared_ptr<AVPacket>& pkt);
+
+  /**
+   * @brief 写完队列中剩余的packet和尾部，关闭输出
+   */
+  void release();
+
+  const std::string& url() const { return url_; }
+
+ private:
+  bool open();
+  void close(bool write_trailer);
+  void writeLoop();
+  std::shared_ptr<AVPacket> pop();
+
+  static constexpr const int queueMaxSize = 50;
+  static constexpr const int reconnectIntervalMs = 5000;
+
+  std::string url_;
+  std::string format_name_;
+  int channel_idx_;
+
+  AVFormatContext* fmt_ctx_ = nullptr;
+  AVStream* stream_ = nullptr;
+  AVCodecParameters* codecpar_ = nullptr;
+  AVRational enc_time_base_;
+  bool header_written_ = false;
+
+  std::queue<std::shared_ptr<AVPacket>> queue_;
+  std::mutex queue_mtx_;
+  // 为true时丢弃非关键帧，直到下一个关键帧到达
+  bool wait_keyframe_ = true;
+  std::atomic<bool> opened_{false};
+  std::atomic<bool> running_{false};
+  std::thread writer_;
+};
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_PACKET_SINK_H_
@@ -11,6 +11,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "common/render_demand.h"
 #include "common/serialize.h"
 namespace sophon_stream {
 namespace element {
@@ -19,19 +20,19 @@ namespace encode {
 Encode::Encode() {}
 
 Encode::~Encode() {
-  if (mEncodeType == EncodeType::RTSP || mEncodeType == EncodeType::RTMP ||
-      mEncodeType == EncodeType::VIDEO) {
+  common::RenderDemand::getInstance().removeConsumer(getGraphId(), getId());
+  if (hasVideoOutput()) {
     for (auto it = mEncoderMap.begin(); it != mEncoderMap.end(); ++it) {
       it->second->release();
     }
-  } else if (mEncodeType == EncodeType::WS) {
+  }
+  if (hasOutput(EncodeType::WS)) {
     if (mWssBackend == WSSBackend::WEBSOCKETPP) {
       for(int i = 0; i < getThreadNumber(); ++i) {
         stopWS(i);
       }
     }
     for (auto& thread : mWSSThreads) thread.join();
-  } else {
   }
 }
 
@@ -54,6 +55,7 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
       if (encodeType == "VIDEO") mEncodeType = EncodeType::VIDEO;
       if (encodeType == "IMG_DIR") mEncodeType = EncodeType::IMG_DIR;
       if (encodeType == "WS") mEncodeType = EncodeType::WS;
+      if (encodeType == "MULTI") mEncodeType = EncodeType::MULTI;
       IVS_DEBUG("EncodeType is {0}", encodeType);
     } else {
       errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
@@ -64,7 +66,43 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
       break;
     }
 
-    if (mEncodeType == EncodeType::RTSP) {
+    // MULTI时编码一次，分发给outputs中的每一种输出
+    mOutputs.clear();
+    if (mEncodeType == EncodeType::MULTI) {
+      auto outputsIt = configure.find(CONFIG_INTERNAL_OUTPUTS_FIELD);
+      if (configure.end() == outputsIt || !outputsIt->is_array()) {
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        IVS_ERROR(
+            "Can not find {0} with array type in worker json configure, "
+            "json: "
+            "{1}",
+            CONFIG_INTERNAL_OUTPUTS_FIELD, json);
+        break;
+      }
+      for (auto& outputIt : *outputsIt) {
+        std::string output = outputIt.get<std::string>();
+        if (output == "RTSP") {
+          mOutputs.push_back(EncodeType::RTSP);
+        } else if (output == "RTMP") {
+          mOutputs.push_back(EncodeType::RTMP);
+        } else if (output == "VIDEO") {
+          mOutputs.push_back(EncodeType::VIDEO);
+        } else if (output == "WS") {
+          mOutputs.push_back(EncodeType::WS);
+        } else {
+          errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+          IVS_ERROR(
+              "Output {0} is not supported, please input RTSP, RTMP, VIDEO or "
+              "WS",
+              output);
+        }
+      }
+      if (common::ErrorCode::SUCCESS != errorCode) break;
+    } else {
+      mOutputs.push_back(mEncodeType);
+    }
+
+    if (hasOutput(EncodeType::RTSP)) {
       auto rtspPortIt = configure.find(CONFIG_INTERNAL_RTSP_PORT_FIELD);
       if (configure.end() != rtspPortIt) {
         mRtspPort = rtspPortIt->get<std::string>();
@@ -78,7 +116,7 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
         break;
       }
     }
-    if (mEncodeType == EncodeType::RTMP) {
+    if (hasOutput(EncodeType::RTMP)) {
       auto rtmpPortIt = configure.find(CONFIG_INTERNAL_RTMP_PORT_FIELD);
       if (configure.end() != rtmpPortIt) {
         mRtmpPort = rtmpPortIt->get<std::string>();
@@ -130,8 +168,7 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
         mWssBackend = WSSBackend::BOOST;
     }
 
-    if (mEncodeType == EncodeType::RTSP || mEncodeType == EncodeType::RTMP ||
-        mEncodeType == EncodeType::VIDEO) {
+    if (hasVideoOutput()) {
       auto encFmtIt = configure.find(CONFIG_INTERNAL_ENC_FMT_FIELD);
       if (configure.end() != encFmtIt) {
         encFmt = encFmtIt->get<std::string>();
@@ -184,7 +221,8 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
         mEncoderMap[i] =
             std::make_shared<Encoder>(dev_id, encFmt, pixFmt, mEncodeParams, i);
       }
-    } else if (mEncodeType == EncodeType::IMG_DIR) {
+    }
+    if (hasOutput(EncodeType::IMG_DIR)) {
       const char* dir_path = "./results";
       struct stat info;
       if (stat(dir_path, &info) == 0 && S_ISDIR(info.st_mode)) {
@@ -196,7 +234,8 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
           IVS_INFO("Error creating directory.");
         }
       }
-    } else if (mEncodeType == EncodeType::WS) {
+    }
+    if (hasOutput(EncodeType::WS)) {
       auto wssPortIt = configure.find(CONFIG_INTERNAL_WSS_PORT_FIELD);
       if (configure.end() != wssPortIt) {
         mWSSPort = wssPortIt->get<std::string>();
@@ -254,8 +293,7 @@ common::ErrorCode Encode::doWork(int dataPipeId) {
   }
   mFpsProfilers[curChannelIdInternal]->add(1);
   if (objectMetadata->mFrame->mEndOfStream) {
-    if (mEncodeType == EncodeType::RTSP || mEncodeType == EncodeType::RTMP ||
-        mEncodeType == EncodeType::VIDEO) {
+    if (hasVideoOutput()) {
       IVS_DEBUG("Encode receive end of stream, dataPipeId: {0}", dataPipeId);
     }
   }
@@ -264,18 +302,18 @@ common::ErrorCode Encode::doWork(int dataPipeId) {
       std::find(objectMetadata->mSkipElements.begin(),
                 objectMetadata->mSkipElements.end(),
                 getId()) == objectMetadata->mSkipElements.end()) {
-    if (mEncodeType == EncodeType::RTSP || mEncodeType == EncodeType::RTMP ||
-        mEncodeType == EncodeType::VIDEO) {
+    if (hasVideoOutput()) {
       processVideoStream(dataPipeId, objectMetadata);
-    } else if (mEncodeType == EncodeType::IMG_DIR) {
+    }
+    if (hasOutput(EncodeType::IMG_DIR)) {
       processImgDir(dataPipeId, objectMetadata);
-    } else if (mEncodeType == EncodeType::WS) {
+    }
+    if (hasOutput(EncodeType::WS)) {
       processWS(dataPipeId, objectMetadata);
-    } else {
     }
   } else {
     // WS发送停止标识
-    if (mEncodeType == EncodeType::WS &&
+    if (hasOutput(EncodeType::WS) &&
         mWssBackend == WSSBackend::WEBSOCKETPP) {
       stopWS(dataPipeId);
     }
@@ -305,40 +343,17 @@ void Encode::processVideoStream(
   if (mEncoderMap.end() != encodeIt) {
     int channel_id = objectMetadata->mFrame->mChannelId;
     if (mChannelOutputPath.find(channel_id) == mChannelOutputPath.end()) {
-      std::string output_path;
-      switch (mEncodeType) {
-        case EncodeType::RTSP:
-          output_path = "rtsp://" + ip + ":" + mRtspPort + "/live/" + prefix +
-                        std::to_string(objectMetadata->mGraphId) + "_" +
-                        std::to_string(channel_id);
-          break;
-        case EncodeType::RTMP:
-          output_path = "rtmp://" + ip + ":" + mRtmpPort + "/live/" + prefix +
-                        std::to_string(objectMetadata->mGraphId) + "_" +
-                        std::to_string(channel_id);
-          break;
-        case EncodeType::VIDEO: {
-          std::string dir_path_ = "./results/";
-          struct stat info;
-          if (stat(dir_path_.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
-            IVS_INFO("Directory already exists.");
-          } else {
-            if (mkdir(dir_path_.c_str(), 0777) == 0) {
-              IVS_INFO("Directory created successfully.");
-            } else {
-              IVS_INFO("Error creating directory.");
-            }
-          }
-          output_path = dir_path_ + prefix + std::to_string(objectMetadata->mGraphId) +
-                        "_" + std::to_string(channel_id) +
-                        (encFmt == "h265_bm" ? ".mp4" : ".avi");
-        } break;
-        default:
-          IVS_ERROR("Encode type error, please input RTSP, RTMP or VIDEO");
+      // 同一路只编码一次，有多个视频输出时码流分发给每个输出
+      std::vector<std::string> output_paths;
+      for (auto output : mOutputs) {
+        if (output == EncodeType::RTSP || output == EncodeType::RTMP ||
+            output == EncodeType::VIDEO)
+          output_paths.push_back(
+              makeOutputPath(output, objectMetadata->mGraphId, channel_id));
       }
 
-      mChannelOutputPath[channel_id] = output_path;
-      encodeIt->second->set_output_path(output_path);
+      mChannelOutputPath[channel_id] = output_paths[0];
+      encodeIt->second->set_output_paths(output_paths);
       encodeIt->second->set_enc_params_width(
           width == -1 ? objectMetadata->mFrame->mWidth : width);
       encodeIt->second->set_enc_params_height(
@@ -353,6 +368,51 @@ void Encode::processVideoStream(
   }
 }
 
+std::string Encode::makeOutputPath(EncodeType type, int graph_id,
+                                   int channel_id) {
+  std::string output_path;
+  switch (type) {
+    case EncodeType::RTSP:
+      output_path = "rtsp://" + ip + ":" + mRtspPort + "/live/" + prefix +
+                    std::to_string(graph_id) + "_" +
+                    std::to_string(channel_id);
+      break;
+    case EncodeType::RTMP:
+      output_path = "rtmp://" + ip + ":" + mRtmpPort + "/live/" + prefix +
+                    std::to_string(graph_id) + "_" +
+                    std::to_string(channel_id);
+      break;
+    case EncodeType::VIDEO: {
+      std::string dir_path_ = "./results/";
+      struct stat info;
+      if (stat(dir_path_.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+        IVS_INFO("Directory already exists.");
+      } else {
+        if (mkdir(dir_path_.c_str(), 0777) == 0) {
+          IVS_INFO("Directory created successfully.");
+        } else {
+          IVS_INFO("Error creating directory.");
+        }
+      }
+      output_path = dir_path_ + prefix + std::to_string(graph_id) + "_" +
+                    std::to_string(channel_id) +
+                    (encFmt == "h265_bm" ? ".mp4" : ".avi");
+    } break;
+    default:
+      IVS_ERROR("Encode type error, please input RTSP, RTMP or VIDEO");
+  }
+  return output_path;
+}
+
+bool Encode::hasOutput(EncodeType type) const {
+  return std::find(mOutputs.begin(), mOutputs.end(), type) != mOutputs.end();
+}
+
+bool Encode::hasVideoOutput() const {
+  return hasOutput(EncodeType::RTSP) || hasOutput(EncodeType::RTMP) ||
+         hasOutput(EncodeType::VIDEO);
+}
+
 // 处理IMG_DIR
 void Encode::processImgDir(
     int dataPipeId, std::shared_ptr<common::ObjectMetadata> objectMetadata) {
@@ -425,6 +485,8 @@ void Encode::processWS(int dataPipeId,
       mWSSMap[dataPipeId] = std::make_shared<WSSManager>(wss);
       serverIt = mWSSMap.find(dataPipeId);
     }
+    std::lock_guard<std::mutex> lk(mDemandMtx);
+    mChannelWSSMap[channel_id] = serverIt->second;
   }
 
   if (!serverIt->second->getConnectionsNum()) {
@@ -482,6 +544,28 @@ void Encode::processWS(int dataPipeId,
   serverIt->second->pushImgDataQueue(data);
 }
 
+void Encode::setGraphId(int id) {
+  ::sophon_stream::framework::Element::setGraphId(id);
+  common::RenderDemand::getInstance().addConsumer(
+      id, getId(), [this](const common::ObjectMetadata& objectMetadata) {
+        return wantsOsd(objectMetadata);
+      });
+}
+
+bool Encode::wantsOsd(const common::ObjectMetadata& objectMetadata) {
+  // 跳过本element的帧不会被编码
+  if (std::find(objectMetadata.mSkipElements.begin(),
+                objectMetadata.mSkipElements.end(),
+                getId()) != objectMetadata.mSkipElements.end())
+    return false;
+  if (mOutputs.size() != 1 || !hasOutput(EncodeType::WS)) return true;
+  // WS只在有连接时推送，服务尚未创建时按需要处理
+  std::lock_guard<std::mutex> lk(mDemandMtx);
+  auto serverIt = mChannelWSSMap.find(objectMetadata.mFrame->mChannelId);
+  return mChannelWSSMap.end() == serverIt ||
+         serverIt->second->getConnectionsNum() > 0;
+}
+
 // WS发送停止标识
 void Encode::stopWS(int dataPipeId) {
   // 从map中获取wss对象
@@ -48,6 +48,7 @@ class Encoder::Encoder_CC {
   ~Encoder_CC();
 
   void set_output_path(const std::string& output_path);
+  void set_output_paths(const std::vector<std::string>& output_paths);
   void init_writer();
   bool is_opened();
   int video_write(bm_image& image);
@@ -69,6 +70,7 @@ class Encoder::Encoder_CC {
   bool is_video_file_;
   bool is_rtsp_;
   bool is_rtmp_;
+  bool is_fanout_;
   bool opened_;
 
   int channel_idx;
@@ -90,7 +92,14 @@ class Encoder::Encoder_CC {
   AVStream* out_stream_;
   AVPacket* pkt_;
 
+  // 多输出时每个地址一个sink，共享同一个编码器
+  std::vector<std::string> output_paths_;
+  std::vector<std::shared_ptr<PacketSink>> sinks_;
+  int64_t frame_pts_;
+
   void enc_params_prase();
+  void open_codec(bool global_header);
+  void init_fanout();
   int map_bmformat_to_avformat(int bmformat);
   int bm_image_to_avframe(bm_handle_t& handle, bm_image* image, AVFrame* frame);
   int flush_encoder();
@@ -129,6 +138,10 @@ void Encoder::set_output_path(const std::string& output_path) {
   return _impl->set_output_path(output_path);
 }
 
+void Encoder::set_output_paths(const std::vector<std::string>& output_paths) {
+  return _impl->set_output_paths(output_paths);
+}
+
 void Encoder::release() { return _impl->release(); }
 void Encoder::init_writer() { return _impl->init_writer(); }
 void Encoder::set_enc_params_width(int width) {
@@ -201,12 +214,14 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
       is_rtsp_(false),
       is_rtmp_(false),
       is_video_file_(false),
+      is_fanout_(false),
       opened_(false),
       enc_ctx_(nullptr),
       enc_dict_(nullptr),
       enc_fmt_(enc_fmt),
       enc_params_(enc_params),
       pix_fmt_(AV_PIX_FMT_NONE),
+      frame_pts_(0),
       channel_idx(channel_idx) {
   bm_dev_request(&handle_, dev_id);
   enc_params_prase();
@@ -219,7 +234,70 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
   flow_control = std::thread(&Encoder::Encoder_CC::flowControlFunc, this);
 }
 
+void Encoder::Encoder_CC::open_codec(bool global_header) {
+  encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
+  if (!encoder_) {
+    IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
+    abort();
+  }
+  enc_ctx_ = avcodec_alloc_context3(encoder_);
+  if (!encoder_) {
+    IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
+    abort();
+  }
+
+  enc_ctx_->codec_id = encoder_->id;
+  enc_ctx_->pix_fmt = pix_fmt_;
+
+  enc_ctx_->width = params_map_["width"];
+  enc_ctx_->height = params_map_["height"];
+  enc_ctx_->gop_size = params_map_["gop"];
+  enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
+  enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
+  if (global_header) enc_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
+  av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
+  av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
+  // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
+
+  if (-1 == params_map_["qp"]) {
+    enc_ctx_->bit_rate_tolerance = params_map_["bitrate"] * 1000;
+    enc_ctx_->bit_rate = (int64_t)params_map_["bitrate"] * 1000;
+  } else {
+    av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
+  }
+
+  int ret = avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
+  if (ret < 0) {
+    IVS_ERROR("avcodec_open2 failed!");
+    abort();
+  }
+}
+
+void Encoder::Encoder_CC::init_fanout() {
+  is_fanout_ = true;
+  sinks_.clear();
+  // mp4、flv等封装需要全局头，任一输出需要时编码器就输出extradata
+  bool global_header = false;
+  for (auto& path : output_paths_) {
+    auto sink = std::make_shared<PacketSink>(path, channel_idx);
+    if (!sink->prepare()) continue;
+    global_header = global_header || sink->needGlobalHeader();
+    sinks_.push_back(sink);
+  }
+  open_codec(global_header);
+  // 各输出在自己的线程中连接，连接失败不影响其他输出
+  for (auto& sink : sinks_) sink->start(enc_ctx_);
+  std::lock_guard<std::mutex> lock(mIsOpenMtx);
+  opened_ = true;
+}
+
 void Encoder::Encoder_CC::init_writer() {
+  if (output_paths_.size() > 1) {
+    init_fanout();
+    return;
+  }
   if (output_path_.compare(0, 7, "rtmp://") == 0) {
     is_rtmp_ = true;
     std::string enParams =
@@ -257,37 +335,7 @@ void Encoder::Encoder_CC::init_writer() {
       // enc_format_ctx_->oformat = enc_output_fmt_;
     }
 
-    encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
-    if (!encoder_) {
-      IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
-      abort();
-    }
-    enc_ctx_ = avcodec_alloc_context3(encoder_);
-    if (!encoder_) {
-      IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
-      abort();
-    }
-
-    enc_ctx_->codec_id = encoder_->id;
-    enc_ctx_->pix_fmt = pix_fmt_;
-
-    enc_ctx_->width = params_map_["width"];
-    enc_ctx_->height = params_map_["height"];
-    enc_ctx_->gop_size = params_map_["gop"];
-    enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
-    enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
-
-    av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
-    av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
-    av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
-    // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
-
-    if (-1 == params_map_["qp"]) {
-      enc_ctx_->bit_rate_tolerance = params_map_["bitrate"] * 1000;
-      enc_ctx_->bit_rate = (int64_t)params_map_["bitrate"] * 1000;
-    } else {
-      av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
-    }
+    open_codec(false);
 
     out_stream_ = avformat_new_stream(enc_format_ctx_, encoder_);
 
@@ -295,12 +343,7 @@ void Encoder::Encoder_CC::init_writer() {
     out_stream_->avg_frame_rate = enc_ctx_->framerate;
     out_stream_->r_frame_rate = out_stream_->avg_frame_rate;
 
-    int ret = avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
-    if (ret < 0) {
-      IVS_ERROR("avcodec_open2 failed!");
-      abort();
-    }
-    ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
+    int ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
     if (ret < 0) {
       IVS_ERROR("avcodec_parameters_from_context failed");
       abort();
@@ -349,7 +392,7 @@ int Encoder::Encoder_CC::bm_image_to_avframe(bm_handle_t& handle,
   bm_image_format_info info;
   int encode_stride = ((params_map_["width"] + 31) >> 5) << 5;
 
-  if (is_rtsp_ || is_video_file_) {
+  if (is_rtsp_ || is_video_file_ || is_fanout_) {
     if (pix_fmt_ == AV_PIX_FMT_YUV420P) {
       plane = 3;
       int stride_bmi[3] = {encode_stride, encode_stride / 2, encode_stride / 2};
@@ -552,7 +595,7 @@ int Encoder::Encoder_CC::video_write(bm_image& image) {
         "push data");
     return -1;
   }
-  if (is_rtsp_ || is_video_file_) {
+  if (is_rtsp_ || is_video_file_ || is_fanout_) {
     // auto _start_time = std::chrono::high_resolution_clock::now();
 
     int ret = 0;
@@ -573,6 +616,8 @@ int Encoder::Encoder_CC::video_write(bm_image& image) {
 
     ret = bm_image_to_avframe(handle_, &image, frame_.get());
     if (ret < 0) return -1;
+    // 各输出按自己加入的时刻重新计算时间戳，这里给出连续的pts
+    if (is_fanout_) frame_->pts = frame_pts_++;
     test_enc_pkt->data = NULL;
     test_enc_pkt->size = 0;
     av_init_packet(test_enc_pkt.get());
@@ -592,6 +637,10 @@ int Encoder::Encoder_CC::video_write(bm_image& image) {
     if (got_output == 0) {
       return -1;
     }
+    if (is_fanout_) {
+      for (auto& sink : sinks_) sink->push(test_enc_pkt);
+      return ret;
+    }
     av_packet_rescale_ts(test_enc_pkt.get(), enc_ctx_->time_base,
                          out_stream_->time_base);
     pushQueue(std::static_pointer_cast<void>(test_enc_pkt));
@@ -619,6 +668,17 @@ int Encoder::Encoder_CC::flush_encoder() {
   int ret;
   int got_frame = 0;
   if (!(this->enc_ctx_->codec->capabilities & AV_CODEC_CAP_DELAY)) return 0;
+  while (is_fanout_) {
+    std::shared_ptr<AVPacket> enc_pkt(av_packet_alloc(), [](AVPacket* p) {
+      if (p != nullptr) {
+        av_packet_free(&p);
+      }
+    });
+    ret = avcodec_encode_video2(this->enc_ctx_, enc_pkt.get(), NULL,
+                                &got_frame);
+    if (ret < 0 || !got_frame) return ret;
+    for (auto& sink : sinks_) sink->push(enc_pkt);
+  }
   while (1) {
     av_log(NULL, AV_LOG_INFO, "Flushing video encoder\n");
     AVPacket temp_enc_pkt;
@@ -644,7 +704,11 @@ int Encoder::Encoder_CC::flush_encoder() {
 void Encoder::Encoder_CC::release() {
   isRunning = false;
   flow_control.join();
-  if (enc_ctx_) {
+  if (is_fanout_) {
+    if (enc_ctx_) flush_encoder();
+    for (auto& sink : sinks_) sink->release();
+    sinks_.clear();
+  } else if (enc_ctx_) {
     flush_encoder();
     av_write_trailer(enc_format_ctx_);
   }
@@ -659,6 +723,12 @@ void Encoder::Encoder_CC::set_output_path(const std::string& output_path) {
   output_path_ = output_path;
 }
 
+void Encoder::Encoder_CC::set_output_paths(
+    const std::vector<std::string>& output_paths) {
+  output_paths_ = output_paths;
+  if (!output_paths.empty()) output_path_ = output_paths[0];
+}
+
 void Encoder::Encoder_CC::set_enc_params_width(int width) {
   params_map_["width"] = width;
 }
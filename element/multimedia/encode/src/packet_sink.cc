@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "packet_sink.h"
+
+#include <chrono>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+PacketSink::PacketSink(const std::string& url, int channel_idx)
+    : url_(url), channel_idx_(channel_idx) {}
+
+PacketSink::~PacketSink() {
+  release();
+  if (codecpar_) avcodec_parameters_free(&codecpar_);
+}
+
+bool PacketSink::prepare() {
+  if (url_.compare(0, 7, "rtsp://") == 0) {
+    format_name_ = "rtsp";
+  } else if (url_.compare(0, 7, "rtmp://") == 0) {
+    // 已编码的码流直接封装为flv推给RTMP服务器
+    format_name_ = "flv";
+  }
+  avformat_alloc_output_context2(
+      &fmt_ctx_, NULL, format_name_.empty() ? NULL : format_name_.c_str(),
+      url_.c_str());
+  if (!fmt_ctx_) {
+    IVS_ERROR("Cannot alloc output context for {0}", url_);
+    return false;
+  }
+  return true;
+}
+
+bool PacketSink::needGlobalHeader() const {
+  return fmt_ctx_ && (fmt_ctx_->oformat->flags & AVFMT_GLOBALHEADER);
+}
+
+void PacketSink::start(const AVCodecContext* enc_ctx) {
+  codecpar_ = avcodec_parameters_alloc();
+  avcodec_parameters_from_context(codecpar_, enc_ctx);
+  enc_time_base_ = enc_ctx->time_base;
+  running_ = true;
+  writer_ = std::thread(&PacketSink::writeLoop, this);
+}
+
+bool PacketSink::open() {
+  if (!fmt_ctx_ && !prepare()) return false;
+  stream_ = avformat_new_stream(fmt_ctx_, NULL);
+  avcodec_parameters_copy(stream_->codecpar, codecpar_);
+  stream_->codecpar->codec_tag = 0;
+  stream_->time_base = enc_time_base_;
+
+  int ret = 0;
+  if (!(fmt_ctx_->oformat->flags & AVFMT_NOFILE)) {
+    ret = avio_open2(&fmt_ctx_->pb, url_.c_str(), AVIO_FLAG_WRITE, NULL, NULL);
+    if (ret < 0) {
+      IVS_ERROR("avio_open2 failed for {0}, ret: {1}", url_, ret);
+      close(false);
+      return false;
+    }
+  }
+  AVDictionary* header_options = NULL;
+  av_dict_set(&header_options, "timeout", "3000000", 0);  // 3s
+  ret = avformat_write_header(fmt_ctx_, &header_options);
+  av_dict_free(&header_options);
+  if (ret < 0) {
+    IVS_ERROR("avformat_write_header failed for {0}, ret: {1}", url_, ret);
+    close(false);
+    return false;
+  }
+  header_written_ = true;
+  IVS_INFO("Encoder {0} output {1} opened", channel_idx_, url_);
+  return true;
+}
+
+void PacketSink::close(bool write_trailer) {
+  if (!fmt_ctx_) return;
+  if (header_written_ && write_trailer) av_write_trailer(fmt_ctx_);
+  if (!(fmt_ctx_->oformat->flags & AVFMT_NOFILE) && fmt_ctx_->pb)
+    avio_closep(&fmt_ctx_->pb);
+  avformat_free_context(fmt_ctx_);
+  fmt_ctx_ = nullptr;
+  stream_ = nullptr;
+  header_written_ = false;
+}
+
+void PacketSink::push(const std::shared_ptr<AVPacket>& pkt) {
+  std::lock_guard<std::mutex> lock(queue_mtx_);
+  if (!opened_) {
+    wait_keyframe_ = true;
+    return;
+  }
+  if (wait_keyframe_) {
+    if (!(pkt->flags & AV_PKT_FLAG_KEY)) return;
+    wait_keyframe_ = false;
+  }
+  if (queue_.size() >= queueMaxSize) {
+    // 写入跟不上时丢掉整段GOP，下一个关键帧重新开始，避免花屏
+    IVS_WARN("Encoder {0} output {1} is too slow, drop {2} packets",
+             channel_idx_, url_, queue_.size());
+    std::queue<std::shared_ptr<AVPacket>>().swap(queue_);
+    wait_keyframe_ = true;
+    return;
+  }
+  queue_.push(pkt);
+}
+
+std::shared_ptr<AVPacket> PacketSink::pop() {
+  std::lock_guard<std::mutex> lock(queue_mtx_);
+  if (queue_.empty()) return nullptr;
+  auto pkt = queue_.front();
+  queue_.pop();
+  return pkt;
+}
+
+void PacketSink::writeLoop() {
+  // 每次(重新)加入码流时，时间戳从0开始
+  int64_t ts_offset = AV_NOPTS_VALUE;
+  while (true) {
+    if (!opened_) {
+      if (!running_) break;
+      if (open()) {
+        ts_offset = AV_NOPTS_VALUE;
+        opened_ = true;
+        continue;
+      }
+      for (int i = 0; running_ && i < reconnectIntervalMs / 100; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+    auto pkt = pop();
+    if (pkt == nullptr) {
+      if (!running_) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+    AVPacket* out = av_packet_clone(pkt.get());
+    if (ts_offset == AV_NOPTS_VALUE)
+      ts_offset = out->dts != AV_NOPTS_VALUE ? out->dts : out->pts;
+    if (ts_offset != AV_NOPTS_VALUE) {
+      if (out->pts != AV_NOPTS_VALUE) out->pts -= ts_offset;
+      if (out->dts != AV_NOPTS_VALUE) out->dts -= ts_offset;
+    }
+    av_packet_rescale_ts(out, enc_time_base_, stream_->time_base);
+    out->stream_index = stream_->index;
+    int ret = av_interleaved_write_frame(fmt_ctx_, out);
+    av_packet_free(&out);
+    if (ret < 0) {
+      IVS_ERROR("Encoder {0} output {1} write failed, ret: {2}, reconnecting",
+                channel_idx_, url_, ret);
+      {
+        std::lock_guard<std::mutex> lock(queue_mtx_);
+        opened_ = false;
+        std::queue<std::shared_ptr<AVPacket>>().swap(queue_);
+        wait_keyframe_ = true;
+      }
+      close(false);
+    }
+  }
+  opened_ = false;
+  close(true);
+}
+
+void PacketSink::release() {
+  running_ = false;
+  if (writer_.joinable()) writer_.join();
+  close(false);
+}
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
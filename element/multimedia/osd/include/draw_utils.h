@@ -105,13 +105,14 @@ void draw_bmcv_det_result(
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
   }
-  for (auto detObj : objData->mDetectedObjectMetadatas) {
+  auto& table = objData->getDetectionTable();
+  for (std::size_t row = 0; row < table.size(); ++row) {
     bmcv_rect_t rect;
-    rect.start_x = detObj->mBox.mX;
-    rect.start_y = detObj->mBox.mY;
-    rect.crop_w = detObj->mBox.mWidth;
-    rect.crop_h = detObj->mBox.mHeight;
-    int class_id = detObj->mClassify;
+    rect.start_x = table.mX[row];
+    rect.start_y = table.mY[row];
+    rect.crop_w = table.mWidth[row];
+    rect.crop_h = table.mHeight[row];
+    int class_id = table.mClassId[row];
     if (!rectsMap.count(class_id % colors_num)) {
       std::vector<bmcv_rect_t> rects;
       rects.push_back(rect);
@@ -128,11 +129,12 @@ void draw_bmcv_det_result(
   }
 
   if (put_text_flag) {
-    for (auto detObj : objectMetadata->mDetectedObjectMetadatas) {
-      std::string label = class_names[detObj->mClassify] + ":" +
-                          cv::format("%.2f", detObj->mScores[0]);
-      int org_x = detObj->mBox.mX;
-      int org_y = detObj->mBox.mY;
+    auto& textTable = objectMetadata->getDetectionTable();
+    for (std::size_t row = 0; row < textTable.size(); ++row) {
+      std::string label = class_names[textTable.mClassId[row]] + ":" +
+                          cv::format("%.2f", textTable.mScore[row]);
+      int org_x = textTable.mX[row];
+      int org_y = textTable.mY[row];
       if (org_y < 20) org_y += 20;
       bmcv_point_t org = {org_x, org_y};
       bmcv_color_t bmcv_color = {255, 0, 0};
@@ -153,7 +155,6 @@ void draw_bmcv_track_result(
   int track_id;
   int thickness = 2;
   float fontScale = 1;
-  int idx = 0;
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
@@ -163,13 +164,14 @@ void draw_bmcv_track_result(
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
   }
 
-  for (auto detObj : objData->mDetectedObjectMetadatas) {
+  auto& table = objData->getDetectionTable();
+  for (std::size_t row = 0; row < table.size(); ++row) {
     bmcv_rect_t rect;
-    rect.start_x = detObj->mBox.mX;
-    rect.start_y = detObj->mBox.mY;
-    rect.crop_w = detObj->mBox.mWidth;
-    rect.crop_h = detObj->mBox.mHeight;
-    int track_id = objData->mTrackedObjectMetadatas[idx]->mTrackId;
+    rect.start_x = table.mX[row];
+    rect.start_y = table.mY[row];
+    rect.crop_w = table.mWidth[row];
+    rect.crop_h = table.mHeight[row];
+    int track_id = table.mTrackId[row];
     if (!rectsMap.count(track_id % colors_num)) {
       std::vector<bmcv_rect_t> rects;
       rects.push_back(rect);
@@ -177,7 +179,6 @@ void draw_bmcv_track_result(
     } else {
       rectsMap[track_id % colors_num].push_back(rect);
     }
-    ++idx;
   }
 
   for (auto& rect : rectsMap) {
@@ -187,12 +188,10 @@ void draw_bmcv_track_result(
   }
 
   if (put_text_flag) {
-    idx = 0;
-    for (auto detObj : objData->mDetectedObjectMetadatas) {
-      std::string label =
-          std::to_string(objData->mTrackedObjectMetadatas[idx]->mTrackId);
-      int org_x = detObj->mBox.mX;
-      int org_y = detObj->mBox.mY;
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      std::string label = std::to_string(table.mTrackId[row]);
+      int org_x = table.mX[row];
+      int org_y = table.mY[row];
       if (org_y < 20) org_y += 20;
       bmcv_point_t org = {org_x, org_y};
       bmcv_color_t bmcv_color = {255, 0, 0};
@@ -200,7 +199,6 @@ void draw_bmcv_track_result(
                                             bmcv_color, fontScale, thickness)) {
         IVS_ERROR("bmcv put text error !!!");
       }
-      ++idx;
     }
   }
 }
@@ -221,27 +219,28 @@ void draw_opencv_det_result(
                   : objectMetadata;
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
   }
-  for (auto detObj : objData->mDetectedObjectMetadatas) {
-    int classId = detObj->mClassify;
+  auto& table = objData->getDetectionTable();
+  for (std::size_t row = 0; row < table.size(); ++row) {
+    int classId = table.mClassId[row];
     cv::Scalar color(colors[classId % colors_num][0],
                      colors[classId % colors_num][1],
                      colors[classId % colors_num][2]);
-    cv::rectangle(frame, cv::Point(detObj->mBox.mX, detObj->mBox.mY),
-                  cv::Point(detObj->mBox.mX + detObj->mBox.mWidth,
-                            detObj->mBox.mY + detObj->mBox.mHeight),
+    cv::rectangle(frame, cv::Point(table.mX[row], table.mY[row]),
+                  cv::Point(table.mX[row] + table.mWidth[row],
+                            table.mY[row] + table.mHeight[row]),
                   color, thickness);
 
     if (put_text_flag) {
       std::string label =
           class_names[classId] + ":" +
-          cv::format("%.2f", detObj->mScores[0]);  // Display the label at the
-                                                   // top of the bounding box
+          cv::format("%.2f", table.mScore[row]);  // Display the label at the
+                                                  // top of the bounding box
       int baseLine;
       cv::Size labelSize =
           getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
       cv::putText(frame, label,
-                  cv::Point(detObj->mBox.mX,
-                            std::max(detObj->mBox.mY, labelSize.height) - 5),
+                  cv::Point(table.mX[row],
+                            std::max(table.mY[row], labelSize.height) - 5),
                   cv::FONT_HERSHEY_SIMPLEX, fontScale, color, thickness);
     }
   }
@@ -256,7 +255,6 @@ void draw_opencv_track_result(
   int thickness = 2;
   float fontScale = 1;
   int track_id;
-  int idx = 0;
   std::shared_ptr<common::ObjectMetadata> objData;
   {
     std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
@@ -266,14 +264,15 @@ void draw_opencv_track_result(
     lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
   }
 
-  for (auto detObj : objData->mDetectedObjectMetadatas) {
-    int track_id = objData->mTrackedObjectMetadatas[idx]->mTrackId;
+  auto& table = objData->getDetectionTable();
+  for (std::size_t row = 0; row < table.size(); ++row) {
+    int track_id = table.mTrackId[row];
     cv::Scalar color(colors[track_id % colors_num][0],
                      colors[track_id % colors_num][1],
                      colors[track_id % colors_num][2]);
-    cv::rectangle(frame, cv::Point(detObj->mBox.mX, detObj->mBox.mY),
-                  cv::Point(detObj->mBox.mX + detObj->mBox.mWidth,
-                            detObj->mBox.mY + detObj->mBox.mHeight),
+    cv::rectangle(frame, cv::Point(table.mX[row], table.mY[row]),
+                  cv::Point(table.mX[row] + table.mWidth[row],
+                            table.mY[row] + table.mHeight[row]),
                   color, thickness);
 
     if (put_text_flag) {
@@ -282,11 +281,10 @@ void draw_opencv_track_result(
       cv::Size labelSize =
           getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
       cv::putText(frame, label,
-                  cv::Point(detObj->mBox.mX,
-                            std::max(detObj->mBox.mY, labelSize.height) - 5),
+                  cv::Point(table.mX[row],
+                            std::max(table.mY[row], labelSize.height) - 5),
                   cv::FONT_HERSHEY_SIMPLEX, fontScale, color, thickness);
     }
-    ++idx;
   }
 }
 
@@ -51,6 +51,8 @@ class Osd : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_R_FIELD = "r";
   static constexpr const char* CONFIG_INTERNAL_G_FIELD = "g";
   static constexpr const char* CONFIG_INTERNAL_B_FIELD = "b";
+  static constexpr const char* CONFIG_INTERNAL_DRAW_IN_PLACE_FIELD =
+      "draw_in_place";
 
  private:
   std::vector<std::string> mClassNames;
@@ -62,6 +64,8 @@ class Osd : public ::sophon_stream::framework::Element {
   DrawUtils mDrawUtils;
   bool mDrawInterval;
   bool mPutText;
+  // BMCV绘制时直接画在未被共享的原图上，省去一次整帧拷贝
+  bool mDrawInPlace;
   std::vector<bm_image> overlay_image_;
   int r, g, b;
   std::string heatmap_loss;
@@ -73,6 +77,12 @@ class Osd : public ::sophon_stream::framework::Element {
       draw_func_opencv;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
   void draw(std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  /**
+   * @brief 下游有消费者需要这一帧的OSD图像，且有内容可画时才绘制
+   */
+  bool needDraw(const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+  bool canDrawInPlace(
+      const std::shared_ptr<common::ObjectMetadata>& objectMetadata);
 };
 
 }  // namespace osd
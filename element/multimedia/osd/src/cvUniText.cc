@@ -3,13 +3,77 @@
 #include <freetype/freetype.h>
 #include <ft2build.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "utf8.h"
 
 using namespace uni_text;
 
 namespace uni_text {
+
+/// Alpha mask of one rendered glyph, rows are tightly packed
+struct Glyph {
+  std::vector<unsigned char> alpha;
+  int width = 0;  // 0 when ' '
+  int height = 0;
+  int left = 0;
+  int top = 0;
+  int advance = 0;  // advance.x in pixels
+};
+
+struct FontMetrics {
+  int ascender = 0;
+  int descender = 0;
+};
+
+/// Process-wide cache of rendered glyphs, keyed by (font, pixel size, char)
+/// and bounded by LRU. Shared by every UniText instance, so the font file is
+/// opened once and each glyph is rasterized once instead of on every frame.
+/// FreeType faces are not thread-safe, all access goes through m_mutex.
+class GlyphAtlas {
+ public:
+  static GlyphAtlas& GetInstance();
+
+  /// Open the font on first use, abort if it can not be loaded
+  int GetFont(const std::string& font_face);
+
+  FontMetrics GetMetrics(int font_id, int font_size);
+
+  /// Look up the glyphs of text, rendering the missing ones
+  void GetGlyphs(int font_id, int font_size, const std::u16string& text,
+                 std::vector<std::shared_ptr<const Glyph>>& glyphs);
+
+  static constexpr std::size_t kMaxGlyphs = 4096;
+
+ private:
+  struct Font {
+    FT_Face face;
+    int pixel_size;
+  };
+
+  GlyphAtlas();
+
+  void _setPixelSize(Font& font, int font_size);
+  std::shared_ptr<const Glyph> _render(Font& font, char16_t wc);
+
+  std::mutex m_mutex;
+  FT_Library m_library;
+  std::map<std::string, int> m_fontIds;
+  std::vector<Font> m_fonts;
+  typedef std::list<std::uint64_t> LruList;
+  LruList m_lru;  // front is the most recently used
+  std::unordered_map<std::uint64_t,
+                     std::pair<std::shared_ptr<const Glyph>, LruList::iterator>>
+      m_glyphs;
+};
+
 class Impl {
  public:
   Impl(const std::string& font_face, int font_size);
@@ -29,11 +93,13 @@ class Impl {
                              const cv::Point& org, const cv::Scalar& color,
                              bool calc_size);
 
-  double _cvPutUniChar(cv::Mat& img, char16_t wc, const cv::Point& pos,
+  double _cvPutUniChar(cv::Mat& img, const Glyph& glyph, const cv::Point& pos,
                        const cv::Scalar& color, bool calc_size);
 
-  FT_Library m_library;
-  FT_Face m_face;
+  void _blitGlyph(cv::Mat& img, const Glyph& glyph, int x, int y,
+                  const cv::Scalar& color);
+
+  int m_fontId;
   int m_fontType;
   cv::Scalar m_fontSize;
   float m_fontDiaphaneity;
@@ -61,30 +127,117 @@ bool UniText::genBitMap(bm_handle_t mHandle, const std::string& utf8_text,
   return pimpl->genBitMap(mHandle, utf8_text, overlay_image, r, g, b);
 }
 
-Impl::Impl(const std::string& font_face, int font_size) {
+// Intentionally leaked: glyphs may still be drawn while static objects are
+// destroyed at exit
+GlyphAtlas& GlyphAtlas::GetInstance() {
+  static GlyphAtlas* atlas = new GlyphAtlas();
+  return *atlas;
+}
+
+GlyphAtlas::GlyphAtlas() {
   if (FT_Init_FreeType(&m_library) != 0) {
     fprintf(stderr, "Freetype init failed!\n");
     abort();
   }
+}
+
+int GlyphAtlas::GetFont(const std::string& font_face) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_fontIds.find(font_face);
+  if (it != m_fontIds.end()) return it->second;
 
-  if (FT_New_Face(m_library, font_face.c_str(), 0, &m_face) != 0) {
+  Font font;
+  if (FT_New_Face(m_library, font_face.c_str(), 0, &font.face) != 0) {
     fprintf(stderr, "Freetype font load failed!\n");
     abort();
   }
+  font.pixel_size = 0;
+  m_fonts.push_back(font);
+  int font_id = m_fonts.size() - 1;
+  m_fontIds[font_face] = font_id;
+  return font_id;
+}
+
+void GlyphAtlas::_setPixelSize(Font& font, int font_size) {
+  if (font.pixel_size == font_size) return;
+  FT_Set_Pixel_Sizes(font.face, font_size, 0);
+  font.pixel_size = font_size;
+}
+
+FontMetrics GlyphAtlas::GetMetrics(int font_id, int font_size) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Font& font = m_fonts[font_id];
+  _setPixelSize(font, font_size);
+  FontMetrics metrics;
+  metrics.ascender = font.face->size->metrics.ascender / 64;
+  metrics.descender = font.face->size->metrics.descender / 64;
+  return metrics;
+}
+
+std::shared_ptr<const Glyph> GlyphAtlas::_render(Font& font, char16_t wc) {
+  auto glyph = std::make_shared<Glyph>();
+  FT_UInt glyph_index = FT_Get_Char_Index(font.face, wc);
+  // load bitmap font to slot, then render to 8bits
+  if (FT_Load_Glyph(font.face, glyph_index, FT_LOAD_DEFAULT) ||
+      FT_Render_Glyph(font.face->glyph, FT_RENDER_MODE_NORMAL)) {
+    IVS_ERROR("Could not load glyph");
+    return glyph;
+  }
+  FT_GlyphSlot ft_slot = font.face->glyph;
+  glyph->width = ft_slot->bitmap.width;
+  glyph->height = ft_slot->bitmap.rows;
+  glyph->left = ft_slot->bitmap_left;
+  glyph->top = ft_slot->bitmap_top;
+  glyph->advance = ft_slot->advance.x >> 6;
+  glyph->alpha.resize(glyph->width * glyph->height);
+  for (int i = 0; i < glyph->height; ++i) {
+    std::copy(ft_slot->bitmap.buffer + i * ft_slot->bitmap.pitch,
+              ft_slot->bitmap.buffer + i * ft_slot->bitmap.pitch + glyph->width,
+              glyph->alpha.begin() + i * glyph->width);
+  }
+  return glyph;
+}
+
+void GlyphAtlas::GetGlyphs(int font_id, int font_size,
+                           const std::u16string& text,
+                           std::vector<std::shared_ptr<const Glyph>>& glyphs) {
+  glyphs.clear();
+  glyphs.reserve(text.size());
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Font& font = m_fonts[font_id];
+  for (char16_t wc : text) {
+    std::uint64_t key = (static_cast<std::uint64_t>(font_id) << 48) |
+                        (static_cast<std::uint64_t>(font_size & 0xFFFF) << 32) |
+                        static_cast<std::uint64_t>(wc);
+    auto it = m_glyphs.find(key);
+    if (it != m_glyphs.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second.second);
+      glyphs.push_back(it->second.first);
+      continue;
+    }
+    _setPixelSize(font, font_size);
+    auto glyph = _render(font, wc);
+    m_lru.push_front(key);
+    m_glyphs[key] = std::make_pair(glyph, m_lru.begin());
+    if (m_glyphs.size() > kMaxGlyphs) {
+      m_glyphs.erase(m_lru.back());
+      m_lru.pop_back();
+    }
+    glyphs.push_back(glyph);
+  }
+}
+
+Impl::Impl(const std::string& font_face, int font_size) {
+  m_fontId = GlyphAtlas::GetInstance().GetFont(font_face);
 
   m_fontType = 0;
   m_fontSize[0] = font_size;  // FontSize
   m_fontSize[1] = 0.5;        // whitechar ratio, such like ' '
   m_fontSize[2] = 0.1;        // inverval ratio, for each char.
   m_fontDiaphaneity = 1;      // alpha
-
-  FT_Set_Pixel_Sizes(m_face, (int)m_fontSize[0], 0);
 }
 
-Impl::~Impl() {
-  FT_Done_Face(m_face);
-  FT_Done_FreeType(m_library);
-}
+Impl::~Impl() = default;
 
 void Impl::SetParam(int font_size, float interval_ratio, float whitespace_ratio,
                     float alpha) {
@@ -92,21 +245,11 @@ void Impl::SetParam(int font_size, float interval_ratio, float whitespace_ratio,
   m_fontSize[1] = whitespace_ratio;  // whitechar ratio, such like ' '
   m_fontSize[2] = interval_ratio;    // inverval ratio, for each char.
   m_fontDiaphaneity = alpha;         // alpha
-  FT_Set_Pixel_Sizes(m_face, (int)m_fontSize[0], 0);
 }
 
-double Impl::_cvPutUniChar(cv::Mat& img, char16_t wc, const cv::Point& pos,
-                           const cv::Scalar& color, bool calc_size) {
-  // generate font bitmap from unicode
-  FT_GlyphSlot ft_slot;
-  //    int ft_ascender;
-  int ft_bmp_height;
-  int ft_bmp_width;  // 0 when ' '
-  int ft_bmp_step;
-  int ft_bmp_left;
-  int ft_bmp_top;
-  unsigned char* ft_bmp_buffer;
-
+double Impl::_cvPutUniChar(cv::Mat& img, const Glyph& glyph,
+                           const cv::Point& pos, const cv::Scalar& color,
+                           bool calc_size) {
   double whitespace_width;
   double interval_width;
   double horizontal_offset;
@@ -142,80 +285,56 @@ double Impl::_cvPutUniChar(cv::Mat& img, char16_t wc, const cv::Point& pos,
   //               -+-
   //
 
-  // get font_id from database of char
-  //    ft_ascender = m_face->size->metrics.ascender / 64;
-
-  FT_UInt glyph_index = FT_Get_Char_Index(m_face, wc);
-  // load bitmap font to slot
-  FT_Load_Glyph(m_face, glyph_index, FT_LOAD_DEFAULT);
-  // render to 8bits
-  FT_Render_Glyph(m_face->glyph, FT_RENDER_MODE_NORMAL);
-  ft_slot = m_face->glyph;
-  ft_bmp_width = ft_slot->bitmap.width;
-  ft_bmp_height = ft_slot->bitmap.rows;
-  ft_bmp_step = ft_slot->bitmap.pitch;
-  ft_bmp_buffer = ft_slot->bitmap.buffer;
-  ft_bmp_left = ft_slot->bitmap_left;
-  ft_bmp_top = ft_slot->bitmap_top;
-
-#ifdef CVUNITEXT_DEBUG
-  if (wc < 256) {
-    printf(" %c: ", ((char*)&wc)[0]);
-  } else {
-    printf(" 0x%02x%02x: ", ((char*)&wc)[1] & 0xFF, ((char*)&wc)[0] & 0xFF);
-  }
-  printf("width %4d, height %4d, ", ft_bmp_width, ft_bmp_height);
-  printf("left %4d, ", ft_bmp_left);
-  printf("top %4d, ", ft_bmp_top);
-  printf("\n");
-#endif
-
   // calculate char width
   whitespace_width = m_fontSize[0] * m_fontSize[1];
   interval_width = m_fontSize[0] * m_fontSize[2];
-  if (ft_bmp_width != 0) {
-    horizontal_offset = ft_bmp_width + interval_width;
+  if (glyph.width != 0) {
+    horizontal_offset = glyph.width + interval_width;
   } else {
     horizontal_offset = whitespace_width;
   }
 
-  int loc_x = pos.x + ft_bmp_left;
-  int loc_y = pos.y + ft_bmp_height - ft_bmp_top;
-
-  if (calc_size) {
+  if (calc_size || glyph.width == 0) {
     return horizontal_offset;
   }
 
-  // draw font bitmap to opencv image
-  //(bmp_j,bmp_i) is freetype bitmap location
-  for (int bmp_i = 0; bmp_i < ft_bmp_height; ++bmp_i) {
-    for (int bmp_j = 0; bmp_j < ft_bmp_width; ++bmp_j) {
-      int bmp_valoff = bmp_i * ft_bmp_step + bmp_j;
-      unsigned int bmp_val = ft_bmp_buffer[bmp_valoff];
-      float bmp_valf = (float)bmp_val / 255 * m_fontDiaphaneity;
-      if (bmp_val == 0) {
-        continue;
-      }
-      //(img_x,img_y) is opencv bitmap location
-      int img_y = loc_y - (ft_bmp_height - 1 - bmp_i);
-      int img_x = loc_x + bmp_j;
-
-      // update pixel when location is valid
-      //   alpha = font_bitmap_val / 255;
-      //   pixel = alpha * color + (1 - alpha) * pixel;
-      if ((0 <= img_y) && (img_y < img.rows) && (0 <= img_x) &&
-          (img_x < img.cols)) {
-        unsigned char* data = img.ptr<unsigned char>(img_y);
-        for (int img_channel = 0; img_channel < img.channels(); img_channel++) {
-          data[img_x * img.channels() + img_channel] =
-              (1 - bmp_valf) * data[img_x * img.channels() + img_channel] +
-              bmp_valf * color[img_channel];
-        }
+  // top-left corner of the glyph bitmap in the opencv image
+  _blitGlyph(img, glyph, pos.x + glyph.left, pos.y - glyph.top + 1, color);
+
+  return horizontal_offset;
+}
+
+void Impl::_blitGlyph(cv::Mat& img, const Glyph& glyph, int x, int y,
+                      const cv::Scalar& color) {
+  // clip the glyph against the image once instead of per pixel
+  int x0 = std::max(0, -x);
+  int y0 = std::max(0, -y);
+  int x1 = std::min(glyph.width, img.cols - x);
+  int y1 = std::min(glyph.height, img.rows - y);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  int channels = img.channels();
+  int color_channels = std::min(channels, 4);
+  int color_val[4];
+  for (int c = 0; c < color_channels; ++c)
+    color_val[c] = cv::saturate_cast<unsigned char>(color[c]);
+  int opacity = cvRound(m_fontDiaphaneity * 256);
+
+  //   alpha = font_bitmap_val / 255;
+  //   pixel = alpha * color + (1 - alpha) * pixel;
+  for (int bmp_i = y0; bmp_i < y1; ++bmp_i) {
+    const unsigned char* mask = glyph.alpha.data() + bmp_i * glyph.width;
+    unsigned char* data = img.ptr<unsigned char>(y + bmp_i) + x * channels;
+    for (int bmp_j = x0; bmp_j < x1; ++bmp_j) {
+      int alpha = (mask[bmp_j] * opacity) >> 8;
+      if (alpha == 0) continue;
+      unsigned char* pixel = data + bmp_j * channels;
+      for (int c = 0; c < color_channels; ++c) {
+        pixel[c] =
+            (pixel[c] * (255 - alpha) + color_val[c] * alpha + 127) / 255;
       }
     }
   }
-
-  return horizontal_offset;
 }
 
 cv::Rect Impl::_cvPutUniTextUCS2(cv::Mat& img, const std::u16string& text,
@@ -225,17 +344,19 @@ cv::Rect Impl::_cvPutUniTextUCS2(cv::Mat& img, const std::u16string& text,
   cv::Point pt1 = org;
   double offset;
   cv::Rect rect;
-  int ascender = m_face->size->metrics.ascender / 64;
-  int descender = m_face->size->metrics.descender / 64;
+  auto& atlas = GlyphAtlas::GetInstance();
+  FontMetrics metrics = atlas.GetMetrics(m_fontId, (int)m_fontSize[0]);
+  std::vector<std::shared_ptr<const Glyph>> glyphs;
+  atlas.GetGlyphs(m_fontId, (int)m_fontSize[0], text, glyphs);
 
-  for (unsigned int i = 0; i < text.size(); i++) {
-    offset = _cvPutUniChar(img, text[i], pt1, color, calc_size);
+  for (unsigned int i = 0; i < glyphs.size(); i++) {
+    offset = _cvPutUniChar(img, *glyphs[i], pt1, color, calc_size);
     pt1.x += (int)offset;
   }
   rect.width = pt1.x - pt0.x;
-  rect.height = ascender - descender;
+  rect.height = metrics.ascender - metrics.descender;
   rect.x = pt0.x;
-  rect.y = pt0.y - ascender;
+  rect.y = pt0.y - metrics.ascender;
   return rect;
 }
 
@@ -255,69 +376,44 @@ bool Impl::genBitMap(bm_handle_t mHandle, const std::string& utf8_text,
   std::u16string dest;
   utf8::utf8to32(utf8_text.begin(), utf8_text.end(), std::back_inserter(dest));
 
-  FT_Pos total_width = 0;
-  FT_Pos max_height = 0;
-  FT_Pos base_y_offset = 0;
-
-  // 第一次遍历是为了计算总宽度和最大高度
-  for (unsigned int i = 0; i < dest.size(); i++) {
-    char16_t ch = dest[i];
-    // 注意：这里使用FT_Get_Char_Index和FT_Load_Glyph组合来支持多字节字符
-    FT_UInt glyph_index = FT_Get_Char_Index(m_face, ch);
-    if (FT_Load_Glyph(m_face, glyph_index, FT_LOAD_DEFAULT)) {
-      IVS_ERROR("Could not load glyph");
-      continue;
-    }
-    total_width += (m_face->glyph->advance.x >> 6);
-    max_height =
-        std::max(max_height, static_cast<FT_Pos>(m_face->glyph->bitmap.rows));
-    base_y_offset =
-        std::max(base_y_offset, static_cast<FT_Pos>(m_face->glyph->bitmap_top));
+  std::vector<std::shared_ptr<const Glyph>> glyphs;
+  GlyphAtlas::GetInstance().GetGlyphs(m_fontId, (int)m_fontSize[0], dest,
+                                      glyphs);
+
+  int total_width = 0;
+  int ascent = 0;
+  int descent = 0;
+
+  // 第一次遍历是为了计算总宽度和高度，高度同时容纳基线以上和以下的部分
+  for (auto& glyph : glyphs) {
+    total_width += glyph->advance;
+    ascent = std::max(ascent, glyph->top);
+    descent = std::max(descent, glyph->height - glyph->top);
   }
+  int max_height = ascent + descent;
 
   std::vector<unsigned char> finalBuffer(max_height * total_width * 4,
                                          0);  // 初始化为0
-  FT_Pos x_offset = 0;
-  // total_width=FFALIGN(total_width,16);
-  for (unsigned int i = 0; i < dest.size(); i++) {
-    char16_t ch = dest[i];
-    FT_UInt glyph_index = FT_Get_Char_Index(m_face, ch);
-    if (FT_Load_Glyph(m_face, glyph_index, FT_LOAD_RENDER)) {
-      IVS_ERROR("Could not load glyph");
-      continue;
-    }
-    FT_Bitmap* bitmap = &m_face->glyph->bitmap;
-    std::vector<unsigned char> buffer;
-    buffer.resize(bitmap->rows * bitmap->width * 4);
-    for (unsigned int i = 0; i < bitmap->rows; ++i) {
-      for (unsigned int j = 0; j < bitmap->width; ++j) {
-        // 计算buffer中的索引位置
-        size_t index = (i * bitmap->width + j) * 4;
-        unsigned char alpha = bitmap->buffer[i * bitmap->pitch + j];
-        // 设置ARGB8888像素值
-        buffer[index] = b;          // Blue
-        buffer[index + 1] = g;      // Green
-        buffer[index + 2] = r;      // Red
-        buffer[index + 3] = alpha;  // Alpha
-      }
-    }
-
-    FT_Pos y_offset_char = base_y_offset - m_face->glyph->bitmap_top;
-    for (unsigned int i = 0; i < m_face->glyph->bitmap.rows; ++i) {
-      for (unsigned int j = 0; j < m_face->glyph->bitmap.width; ++j) {
-        size_t index = (i * m_face->glyph->bitmap.width + j) * 4;
-        size_t final_index =
-            ((y_offset_char + i) * total_width + x_offset + j) * 4;
-        // 确保我们不会超出最终缓冲区的界限
-        if (final_index < finalBuffer.size()) {
-          std::copy(buffer.begin() + index, buffer.begin() + index + 4,
-                    finalBuffer.begin() + final_index);
-        }
+  int x_offset = 0;
+  for (auto& glyph : glyphs) {
+    int y_offset_char = ascent - glyph->top;
+    int width = std::min(glyph->width, total_width - x_offset);
+    for (int i = 0; i < glyph->height; ++i) {
+      const unsigned char* mask = glyph->alpha.data() + i * glyph->width;
+      unsigned char* dst =
+          finalBuffer.data() +
+          ((y_offset_char + i) * total_width + x_offset) * 4;
+      for (int j = 0; j < width; ++j) {
+        // ARGB8888像素值，字符重叠处保留较大的alpha
+        dst[j * 4] = b;                                     // Blue
+        dst[j * 4 + 1] = g;                                 // Green
+        dst[j * 4 + 2] = r;                                 // Red
+        dst[j * 4 + 3] = std::max(dst[j * 4 + 3], mask[j]);  // Alpha
       }
     }
 
     // 更新x_offset，确保下一个字符在正确的位置开始
-    x_offset += (m_face->glyph->advance.x >> 6);
+    x_offset += glyph->advance;
   }
   int overlay_height = max_height;
   int overlay_width = total_width;
@@ -17,6 +17,7 @@
 
 #include "common/common_defs.h"
 #include "common/logger.h"
+#include "common/render_demand.h"
 #include "draw_utils.h"
 #include "element_factory.h"
 
@@ -179,6 +180,12 @@ common::ErrorCode Osd::initInternal(const std::string& json) {
           "json:{1}, set default true",
           CONFIG_INTERNAL_PUT_TEXT_FIELD, json);
     }
+    mDrawInPlace = false;
+    auto drawInPlaceIt = configure.find(CONFIG_INTERNAL_DRAW_IN_PLACE_FIELD);
+    if (configure.end() != drawInPlaceIt) {
+      mDrawInPlace = drawInPlaceIt->get<bool>();
+      IVS_DEBUG("mDrawInPlace is {0}", mDrawInPlace);
+    }
     auto heatmaplossIt = configure.find(CONFIG_INTERNAL_HEATMAP_LOSS_FIELD);
     if (configure.end() != heatmaplossIt) {
       auto heatmaploss = heatmaplossIt->get<std::string>();
@@ -270,7 +277,7 @@ common::ErrorCode Osd::doWork(int dataPipeId) {
       std::find(objectMetadata->mSkipElements.begin(),
                 objectMetadata->mSkipElements.end(),
                 getId()) == objectMetadata->mSkipElements.end()) {
-    draw(objectMetadata);
+    if (needDraw(objectMetadata)) draw(objectMetadata);
     mFpsProfiler.add(1);
   }
 
@@ -289,6 +296,31 @@ common::ErrorCode Osd::doWork(int dataPipeId) {
 
   return common::ErrorCode::SUCCESS;
 }
+bool Osd::needDraw(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  // 没有WS连接、未在录像、被encode跳过等情况下，下游不会用到OSD图像
+  if (!common::RenderDemand::getInstance().isWanted(getGraphId(),
+                                                    *objectMetadata))
+    return false;
+  // 没有检测结果时没有可画的内容，下游直接使用原图；
+  // draw_interval需要逐帧更新上一帧结果，不能跳过
+  if ((mOsdType == OsdType::DET || mOsdType == OsdType::TRACK) &&
+      !mDrawInterval && objectMetadata->mDetectedObjectMetadatas.empty())
+    return false;
+  return true;
+}
+
+bool Osd::canDrawInPlace(
+    const std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
+  auto& frame = objectMetadata->mFrame;
+  // 原图只被这一帧持有，且已是编码需要的YUV420P时，可以直接画在原图上
+  return mDrawInPlace && !frame->mSpDataOsd && frame->mSpData &&
+         frame->mSpData.use_count() == 1 &&
+         frame->mSpData->image_format == FORMAT_YUV420P &&
+         frame->mSpData->width == frame->mWidth &&
+         frame->mSpData->height == frame->mHeight;
+}
+
 void Osd::draw(std::shared_ptr<common::ObjectMetadata> objectMetadata) {
   std::shared_ptr<bm_image> imageStorage;
   bm_image image;
@@ -300,12 +332,16 @@ void Osd::draw(std::shared_ptr<common::ObjectMetadata> objectMetadata) {
     // 如果没有 OSD 图像，则绘制到原图
     image = *(objectMetadata->mFrame->mSpData);
   }
-  imageStorage.reset(new bm_image, [&](bm_image* img) {
-    bm_image_destroy(*img);
-    delete img;
-    img = nullptr;
-  });
+  // 原地绘制时复用原图，只有新建的图像才需要带上释放函数
+  auto newStorage = [&]() {
+    imageStorage.reset(new bm_image, [&](bm_image* img) {
+      bm_image_destroy(*img);
+      delete img;
+      img = nullptr;
+    });
+  };
   if (mDrawUtils == DrawUtils::OPENCV) {
+    newStorage();
     cv::Mat frame_to_draw;
     cv::bmcv::toMAT(&image, frame_to_draw);
     switch (mOsdType) {
@@ -351,12 +387,17 @@ void Osd::draw(std::shared_ptr<common::ObjectMetadata> objectMetadata) {
       *imageStorage = frame;
     }
   } else if (mDrawUtils == DrawUtils::BMCV) {
-    bm_image_create(objectMetadata->mFrame->mHandle,
-                    objectMetadata->mFrame->mHeight,
-                    objectMetadata->mFrame->mWidth, FORMAT_YUV420P,
-                    image.data_type, &(*imageStorage));
-    bmcv_image_storage_convert(objectMetadata->mFrame->mHandle, 1, &image,
-                               &(*imageStorage));
+    if (canDrawInPlace(objectMetadata)) {
+      imageStorage = objectMetadata->mFrame->mSpData;
+    } else {
+      newStorage();
+      bm_image_create(objectMetadata->mFrame->mHandle,
+                      objectMetadata->mFrame->mHeight,
+                      objectMetadata->mFrame->mWidth, FORMAT_YUV420P,
+                      image.data_type, &(*imageStorage));
+      bmcv_image_storage_convert(objectMetadata->mFrame->mHandle, 1, &image,
+                                 &(*imageStorage));
+    }
     switch (mOsdType) {
       case OsdType::DET:
         draw_bmcv_det_result(objectMetadata->mFrame->mHandle, objectMetadata,
@@ -63,6 +63,14 @@ class Blend : public ::sophon_stream::framework::Element {
   struct stitch_param blend_config;
   
  private:
+  /**
+   * @brief 取第idx路转YUV420P用的中间图像，分辨率不变时在帧之间复用
+   */
+  bm_image* getConvertImage(int idx, const bm_image& src);
+
+  bm_image convert_img[2];
+  bool convert_valid[2] = {false, false};
+
   void setDispType(const httplib::Request& request,
                    httplib::Response& response);
 
@@ -9,7 +9,9 @@
 #include "common/common_defs.h"
 #if BMCV_VERSION_MAJOR > 1
 
+#include <map>
 #include <nlohmann/json.hpp>
+#include <tuple>
 
 #include "blend.h"
 #include "common/logger.h"
@@ -42,8 +44,48 @@ void bm_dem_read_bin(bm_handle_t handle, bm_device_mem_t* dmem,
 namespace sophon_stream {
 namespace element {
 namespace blend {
+
+/**
+ * @brief 读取权重图到设备内存，同一设备上同一文件只读一次，
+ * 多个blend element配置相同的权重图时共享
+ */
+static bm_device_mem_t loadWeight(bm_handle_t handle, int dev_id,
+                                  const std::string& path, unsigned int len) {
+  // 有意不析构：进程退出前权重图一直有效
+  static std::mutex* mutex = new std::mutex();
+  static auto* weights =
+      new std::map<std::tuple<int, std::string, unsigned int>,
+                   bm_device_mem_t>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto key = std::make_tuple(dev_id, path, len);
+  auto it = weights->find(key);
+  if (weights->end() != it) return it->second;
+
+  bm_device_mem_t dmem;
+  bm_dem_read_bin(handle, &dmem, path.c_str(), len);
+  (*weights)[key] = dmem;
+  return dmem;
+}
+
 Blend::Blend() {}
-Blend::~Blend() {}
+Blend::~Blend() {
+  for (int i = 0; i < 2; ++i) {
+    if (convert_valid[i]) bm_image_destroy(convert_img[i]);
+  }
+}
+
+bm_image* Blend::getConvertImage(int idx, const bm_image& src) {
+  bm_image& img = convert_img[idx];
+  if (convert_valid[idx] && img.width == src.width &&
+      img.height == src.height)
+    return &img;
+  if (convert_valid[idx]) bm_image_destroy(img);
+  bm_image_create(handle, src.height, src.width, FORMAT_YUV420P,
+                  DATA_TYPE_EXT_1N_BYTE, &img, NULL);
+  bm_image_alloc_dev_mem(img, 1);
+  convert_valid[idx] = true;
+  return &img;
+}
 
 struct RequestDistTypeConfig {
   int type;
@@ -106,6 +148,7 @@ common::ErrorCode Blend::initInternal(const std::string& json) {
   bm_status_t ret = bm_dev_request(&handle, dev_id);
 
   src_h = configure.find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
+  setInputSyncConfig(common::InputSynchronizer::parseConfig(configure));
 
   auto wgt1 = configure.find(CONFIG_INTERNAL_WGT1_FILED)->get<std::string>();
   auto wgt2 = configure.find(CONFIG_INTERNAL_WGT2_FILED)->get<std::string>();
@@ -139,8 +182,8 @@ common::ErrorCode Blend::initInternal(const std::string& json) {
   int wgtheight = src_h;
   int wgt_len = wgtwidth * wgtheight;
   for (int i = 0; i < 2; i++) {
-    bm_dem_read_bin(handle, &blend_config.wgt_phy_mem[0][i], wgt_name[i],
-                    wgt_len);
+    blend_config.wgt_phy_mem[0][i] =
+        loadWeight(handle, dev_id, wgt_name[i], wgt_len);
   }
 
   width_minus = blend_config.ovlap_attr.ovlp_rx[0] -
@@ -207,17 +250,9 @@ common::ErrorCode Blend::blend_work(
 
     bm_image blend_img[2];
     if (need_convert) {
-      bm_image_create(leftObj->mFrame->mHandle,
-                            leftObj->mFrame->mSpDataDwa->height,
-                            leftObj->mFrame->mSpDataDwa->width, FORMAT_YUV420P,
-                            DATA_TYPE_EXT_1N_BYTE, &blend_img[0], NULL);
-      bm_image_create(rightObj->mFrame->mHandle,
-                            rightObj->mFrame->mSpDataDwa->height,
-                            rightObj->mFrame->mSpDataDwa->width, FORMAT_YUV420P,
-                            DATA_TYPE_EXT_1N_BYTE, &blend_img[1], NULL);
-
-      bm_image_alloc_dev_mem(blend_img[0], 1);
-      bm_image_alloc_dev_mem(blend_img[1], 1);
+      // 转换用的中间图像由element持有，blend_work在mtx内串行执行
+      blend_img[0] = *getConvertImage(0, *leftObj->mFrame->mSpDataDwa);
+      blend_img[1] = *getConvertImage(1, *rightObj->mFrame->mSpDataDwa);
 
       bmcv_image_storage_convert(leftObj->mFrame->mHandle, 1,
                                        leftObj->mFrame->mSpDataDwa.get(),
@@ -251,15 +286,12 @@ common::ErrorCode Blend::blend_work(
     blendObj->mFrame->mSpDataDwa = blend_image;
     blendObj->mFrame->mWidth = blend_image->width;
     blendObj->mFrame->mHeight = blend_image->height;
-
-    if (need_convert) {
-      bm_image_destroy(&blend_img[0]);
-      bm_image_destroy(&blend_img[1]);
-    }
   }
 
   blendObj->mFrame->mChannelId = leftObj->mFrame->mChannelId;
   blendObj->mFrame->mFrameId = leftObj->mFrame->mFrameId;
+  blendObj->mFrame->mTimestamp = leftObj->mFrame->mTimestamp;
+  blendObj->mFrame->mPts = leftObj->mFrame->mPts;
   blendObj->mFrame->mChannelIdInternal = leftObj->mFrame->mChannelIdInternal;
   blendObj->mFrame->mHandle = leftObj->mFrame->mHandle;
 
@@ -274,30 +306,24 @@ common::ErrorCode Blend::doWork(int dataPipeId) {
     outputPort = outputPorts[0];
   }
 
+  // 按帧号或pts对齐各输入，某一路丢帧时丢弃另一路的对应帧
   common::ObjectMetadatas inputs;
-
-  for (auto inputPort : inputPorts) {
-    auto data = popInputData(inputPort, dataPipeId);
-    while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      data = popInputData(inputPort, dataPipeId);
-    }
-    if (data == nullptr) return common::ErrorCode::SUCCESS;
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    inputs.emplace_back(objectMetadata);
+  if (!popSyncedInputData(dataPipeId, inputs)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return common::ErrorCode::SUCCESS;
+  }
+  for (int i = 0; i < inputs.size(); ++i) {
     IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}",
-             inputPort, objectMetadata->mFrame->mChannelId,
-             objectMetadata->mFrame->mFrameId);
+              inputPorts[i], inputs[i]->mFrame->mChannelId,
+              inputs[i]->mFrame->mFrameId);
   }
 
   if (inputs[0]->mFrame->mSpData != nullptr &&
       inputs[1]->mFrame->mSpData != nullptr) {
     std::shared_ptr<common::ObjectMetadata> blendObj =
-        std::make_shared<common::ObjectMetadata>();
+        common::makePooled<common::ObjectMetadata>();
 
-    blendObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
+    blendObj->mFrame = common::makePooled<common::Frame>();
 
     blend_work(inputs[0], inputs[1], blendObj);
 
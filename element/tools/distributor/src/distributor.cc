@@ -14,6 +14,7 @@
 #include <nlohmann/json.hpp>
 
 #include "common/common_defs.h"
+#include "common/common_tool.h"
 #include "common/logger.h"
 #include "element_factory.h"
 
@@ -150,31 +151,16 @@ void Distributor::makeSubObjectMetadata(
     rect.crop_h = detObj->mBox.mHeight;
   }
 
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makePooled<common::Frame>();
+  subObj->mArena = obj->mArena;
 
   // crop or not
   if (detObj != nullptr) {
-    std::shared_ptr<bm_image> cropped = nullptr;
-    cropped.reset(new bm_image, [](bm_image* p) {
-      bm_image_destroy(*p);
-      delete p;
-      p = nullptr;
-    });
-    bm_status_t ret =
-        bm_image_create(obj->mFrame->mHandle, rect.crop_h, rect.crop_w,
-                        obj->mFrame->mSpData->image_format,
-                        obj->mFrame->mSpData->data_type, cropped.get());
-    // #if BMCV_VERSION_MAJOR > 1
-    //     ret = bmcv_image_vpp_convert(obj->mFrame->mHandle, 1,
-    //     *obj->mFrame->mSpData,
-    //                                  cropped.get(), &rect);
-    // #else
-    ret = bmcv_image_crop(obj->mFrame->mHandle, 1, &rect, *obj->mFrame->mSpData,
-                          cropped.get());
-    // #endif
-    // STREAM_CHECK(ret == 0, "Bmcv Crop Failed! Program Terminated.")
-
-    subObj->mFrame->mSpData = cropped;
+    std::vector<bmcv_rect_t> rects = {rect};
+    auto cropped = crop_images(obj->mFrame->mHandle, *obj->mFrame->mSpData,
+                               rects);
+    // STREAM_CHECK(!cropped.empty(), "Bmcv Crop Failed! Program Terminated.")
+    subObj->mFrame->mSpData = cropped.empty() ? nullptr : cropped[0];
   } else {
     subObj->mFrame->mSpData = obj->mFrame->mSpData;
     subObj->mFrame->mHeight = obj->mFrame->mHeight;
@@ -248,7 +234,8 @@ void Distributor::makeSubFaceObjectMetadata(
     rect.crop_w = faceObj->right - faceObj->left + 1;
     rect.crop_h = faceObj->bottom - faceObj->top + 1;
   }
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makePooled<common::Frame>();
+  subObj->mArena = obj->mArena;
   // crop or not,faceObj != nullptr
   if (faceObj != nullptr) {
     int x1 = faceObj->left;
@@ -420,7 +407,8 @@ void Distributor::makeSubOcrObjectMetadata(
     }
   }
 
-  subObj->mFrame = std::make_shared<common::Frame>();
+  subObj->mFrame = common::makePooled<common::Frame>();
+  subObj->mArena = obj->mArena;
 
   // crop or not
   if (detObj != nullptr) {
@@ -637,7 +625,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
       for (auto outPort : outputPorts) {
         if (outPort == mDefaultPort) continue;
         std::shared_ptr<common::ObjectMetadata> subObj =
-            std::make_shared<common::ObjectMetadata>();
+            common::makePooled<common::ObjectMetadata>();
         makeSubObjectMetadata(objectMetadata, nullptr, subObj, subId);
         objectMetadata->mSubObjectMetadatas.push_back(subObj);
         ++objectMetadata->numBranches;
@@ -669,7 +657,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
           int target_port = *port_it;
           // 构造SubObjectMetadata
           std::shared_ptr<common::ObjectMetadata> subObj =
-              std::make_shared<common::ObjectMetadata>();
+              common::makePooled<common::ObjectMetadata>();
           makeSubFaceObjectMetadata(objectMetadata, faceObj, subObj, subId);
           objectMetadata->mSubObjectMetadatas.push_back(subObj);
           ++objectMetadata->numBranches;
@@ -695,16 +683,18 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
       ++mSubFrameIdMap[objectMetadata->mFrame->mChannelId];
     }
 
-    for (auto detObj : objectMetadata->mDetectedObjectMetadatas) {
-      int class_id = detObj->mClassify;
+    auto& table = objectMetadata->getDetectionTable();
+    for (std::size_t row = 0; row < table.size(); ++row) {
+      int class_id = table.mClassId[row];
       std::string class_name = mClassNames[class_id];
       if (class2ports.find(class_name) != class2ports.end()) {
+        auto detObj = objectMetadata->mDetectedObjectMetadatas[row];
         for (auto port_it = class2ports[class_name].begin();
              port_it != class2ports[class_name].end(); ++port_it) {
           int target_port = *port_it;
           // 构造SubObjectMetadata
           std::shared_ptr<common::ObjectMetadata> subObj =
-              std::make_shared<common::ObjectMetadata>();
+              common::makePooled<common::ObjectMetadata>();
 
           if (class_name == "ppocr") {
             makeSubOcrObjectMetadata(objectMetadata, detObj, subObj, subId);
@@ -740,7 +730,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
            port_it != class2ports["full_frame"].end(); ++port_it) {
         // full_frame 分发，也是构造一个新的SubObjectMetadata
         std::shared_ptr<common::ObjectMetadata> subObj =
-            std::make_shared<common::ObjectMetadata>();
+            common::makePooled<common::ObjectMetadata>();
         makeSubObjectMetadata(objectMetadata, nullptr, subObj, -1);
         objectMetadata->mSubObjectMetadatas.push_back(subObj);
         ++objectMetadata->numBranches;
@@ -567,8 +567,8 @@ common::ErrorCode Dpu::doWork(int dataPipeId) {
       inputs[1]->mFrame->mSpData != nullptr &&
       inputs[0]->mFrame->mFrameId == inputs[1]->mFrame->mFrameId) {
     std::shared_ptr<common::ObjectMetadata> dpuObj =
-        std::make_shared<common::ObjectMetadata>();
-    dpuObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
+        common::makePooled<common::ObjectMetadata>();
+    dpuObj->mFrame = common::makePooled<common::Frame>();
 
     dpu_work(inputs[0], inputs[1], dpuObj);
 
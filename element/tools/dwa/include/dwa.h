@@ -10,9 +10,12 @@
 #ifndef SOPHON_STREAM_ELEMENT_DWA_H_
 #define SOPHON_STREAM_ELEMENT_DWA_H_
 #include <algorithm>
+#include <map>
+#include <tuple>
 
 #include "common/object_metadata.h"
 #include "common/profiler.h"
+#include "dwa_remap.h"
 #include "element.h"
 
 namespace sophon_stream {
@@ -40,6 +43,16 @@ class Dwa : public ::sophon_stream::framework::Element {
   common::ErrorCode fisheye_work(
       std::shared_ptr<common::ObjectMetadata> dwaObj);
 
+  /**
+   * @brief 取输入分辨率对应的处理计划，首次遇到该分辨率时生成
+   */
+  std::shared_ptr<DwaPlan> get_plan(const bm_image& src);
+  /**
+   * @brief 按plan中的网格在CPU上完成整个几何变换，输出格式为src_fmt
+   */
+  std::shared_ptr<bm_image> remap_cpu_work(bm_handle_t handle, bm_image& src,
+                                           const DwaPlan& plan);
+
   float get_aspect_scaled_ratio(int src_w, int src_h, int dst_w, int dst_h,
                                 bool* pIsAligWidth);
   static constexpr const char* CONFIG_INTERNAL_IS_GRAY_FILED = "is_gray";
@@ -57,6 +70,8 @@ class Dwa : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_RESIZE_H_FILED = "resize_h";
   static constexpr const char* CONFIG_INTERNAL_RESIZE_W_FILED = "resize_w";
   static constexpr const char* CONFIG_INTERNAL_DWA_MODE_FILED = "dwa_mode";
+  static constexpr const char* CONFIG_INTERNAL_CPU_REMAP_FILED = "cpu_remap";
+  static constexpr const char* CONFIG_INTERNAL_REMAP_FILE_FILED = "remap_file";
 
   int src_h, src_w, dst_h, dst_w, resize_h, resize_w;
 
@@ -71,12 +86,19 @@ class Dwa : public ::sophon_stream::framework::Element {
   bmcv_rot_mode rot_mode;
 
   std::string grid_name;
+  std::shared_ptr<const std::vector<char>> grid_data;
+
+  bool cpu_remap = false;
+  cv::Mat warp_x, warp_y;
 
   bmcv_gdc_attr ldc_attr = {0};
   bmcv_fisheye_attr_s fisheye_attr = {0};
 
   std::mutex dwa_lock;
 
+  std::mutex plan_lock;
+  std::map<std::tuple<int, int, int>, std::shared_ptr<DwaPlan>> plans;
+
  private:
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_DWA_REMAP_H_
+#define SOPHON_STREAM_ELEMENT_DWA_REMAP_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/common_defs.h"
+#include "opencv2/opencv.hpp"
+
+namespace sophon_stream {
+namespace element {
+namespace dwa {
+
+/**
+ * @brief dwa之前的几何变换：源图缩放到画布中的rect，其余部分补边，
+ * 之后可选旋转180度。画布大小为resize_w x resize_h
+ */
+struct PreWarp {
+  int src_w = 0;
+  int src_h = 0;
+  int canvas_w = 0;
+  int canvas_h = 0;
+  bmcv_rect_t rect = {0, 0, 0, 0};  // 源图在画布中的位置
+  bool rot180 = false;
+};
+
+/**
+ * @brief 输出坐标到源图坐标的映射表，供CPU重映射使用。
+ * @brief
+ * 由PreWarp和可选的畸变映射（输出坐标到画布坐标）组合而成，一次生成后只读，
+ * 可在多个线程间共享
+ */
+struct RemapGrid {
+  cv::Mat map_x;  // CV_32FC1，源图x坐标，-1表示补边
+  cv::Mat map_y;  // CV_32FC1
+
+  /**
+   * @param warpX,warpY 输出坐标到画布坐标的映射，为空时输出即画布
+   */
+  static std::shared_ptr<RemapGrid> build(const PreWarp& pre,
+                                          const cv::Mat& warpX,
+                                          const cv::Mat& warpY);
+};
+
+/**
+ * @brief 按网格在CPU上重映射，双线性插值，网格外的像素填充border
+ */
+void remapCpu(const cv::Mat& src, const RemapGrid& grid, cv::Mat& dst,
+              int border = 114);
+
+/**
+ * @brief 读取畸变映射文件：float32的map_x后接map_y，各w*h个，
+ * 与cv::initUndistortRectifyMap等工具导出的CV_32FC1映射一致
+ * @return 文件大小不符时返回false
+ */
+bool loadWarpMap(const std::string& path, int w, int h, cv::Mat& warpX,
+                 cv::Mat& warpY);
+
+/**
+ * @brief 读取gridinfo文件，同一文件只读一次，在多个dwa element间共享
+ */
+std::shared_ptr<const std::vector<char>> loadGridFile(const std::string& path);
+
+/**
+ * @brief 一种输入分辨率下的处理计划：前处理参数只计算一次，
+ * 中间图像（缩放、旋转后的画布）在帧之间复用
+ */
+struct DwaPlan {
+  PreWarp pre;
+  bmcv_padding_atrr_t padding_attr;
+  bmcv_rect_t crop_rect;
+
+  std::shared_ptr<RemapGrid> grid;  // 仅CPU重映射时生成
+
+  int canvasAlign = 1;  // 画布每行的字节对齐
+  int canvasHeap = 1;   // 画布所在的设备内存heap
+
+  /**
+   * @brief 取一张画布大小的中间图像，没有空闲的时新建
+   */
+  std::shared_ptr<bm_image> acquireCanvas(bm_handle_t handle,
+                                          bm_image_format_ext format,
+                                          bm_image_data_format_ext dtype);
+  void releaseCanvas(std::shared_ptr<bm_image> image);
+
+  /**
+   * @brief 取一张与src同样大小、每行按32字节对齐的图像，
+   * 用于宽度不是32整数倍的输入
+   */
+  std::shared_ptr<bm_image> acquireAlignedSource(bm_handle_t handle,
+                                                 const bm_image& src);
+  void releaseAlignedSource(std::shared_ptr<bm_image> image);
+
+ private:
+  std::mutex mutex;
+  std::vector<std::shared_ptr<bm_image>> freeCanvases;
+  std::vector<std::shared_ptr<bm_image>> freeSources;
+};
+
+}  // namespace dwa
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_DWA_REMAP_H_
@@ -50,6 +50,16 @@ bm_status_t set_gdc_default_param(bmcv_gdc_attr* gdc_attr) {
   return BM_SUCCESS;
 }
 
+/**
+ * @brief 把plan中的画布包装成输出帧的图像，下游释放最后一个引用时归还给plan
+ */
+std::shared_ptr<bm_image> share_canvas(std::shared_ptr<DwaPlan> plan,
+                                       std::shared_ptr<bm_image> canvas) {
+  bm_image* image = canvas.get();
+  return std::shared_ptr<bm_image>(
+      image, [plan, canvas](bm_image*) { plan->releaseCanvas(canvas); });
+}
+
 Dwa::Dwa() {}
 Dwa::~Dwa() {}
 
@@ -96,18 +106,9 @@ common::ErrorCode Dwa::initInternal(const std::string& json) {
     if (use_grid) {
       grid_name =
           configure.find(CONFIG_INTERNAL_GRID_NAME_FILED)->get<std::string>();
-
-      FILE* fp = fopen(grid_name.c_str(), "rb");
-      fseek(fp, 0, SEEK_END);
-      int fileSize = ftell(fp);
-      char* buffer = (char*)malloc(fileSize);
-      memset(buffer, 0, fileSize);
-
-      rewind(fp);
-      fread(buffer, fileSize, 1, fp);
-      fclose(fp);
-      ldc_attr.grid_info.u.system.system_addr = (void*)buffer;
-      ldc_attr.grid_info.size = fileSize;
+      grid_data = loadGridFile(grid_name);
+      ldc_attr.grid_info.u.system.system_addr = (void*)grid_data->data();
+      ldc_attr.grid_info.size = grid_data->size();
     }
 
   } else if (dwa_mode ==
@@ -126,20 +127,27 @@ common::ErrorCode Dwa::initInternal(const std::string& json) {
     if (use_grid) {
       grid_name =
           configure.find(CONFIG_INTERNAL_GRID_NAME_FILED)->get<std::string>();
-      FILE* fp = fopen(grid_name.c_str(), "rb");
-      fseek(fp, 0, SEEK_END);
-      int fileSize = ftell(fp);
-      char* buffer = (char*)malloc(fileSize);
-      memset(buffer, 0, fileSize);
-      rewind(fp);
-      fread(buffer, fileSize, 1, fp);
-      fclose(fp);
-      fisheye_attr.grid_info.u.system.system_addr = (void*)buffer;
-      fisheye_attr.grid_info.size = fileSize;
+      grid_data = loadGridFile(grid_name);
+      fisheye_attr.grid_info.u.system.system_addr = (void*)grid_data->data();
+      fisheye_attr.grid_info.size = grid_data->size();
       fisheye_attr.bEnable = true;
     }
   }
 
+  // CPU重映射：用于没有设备时对照golden图像检查几何变换
+  auto cpu_remap_it = configure.find(CONFIG_INTERNAL_CPU_REMAP_FILED);
+  if (cpu_remap_it != configure.end()) cpu_remap = cpu_remap_it->get<bool>();
+  auto remap_file_it = configure.find(CONFIG_INTERNAL_REMAP_FILE_FILED);
+  if (cpu_remap && remap_file_it == configure.end()) {
+    IVS_ERROR("cpu_remap requires remap_file in Config File");
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  if (cpu_remap) {
+    STREAM_CHECK(loadWarpMap(remap_file_it->get<std::string>(), dst_w, dst_h,
+                             warp_x, warp_y),
+                 "Invalid remap_file in Config File");
+  }
+
   return common::ErrorCode::SUCCESS;
 }
 
@@ -158,9 +166,103 @@ float Dwa::get_aspect_scaled_ratio(int src_w, int src_h, int dst_w, int dst_h,
   return ratio;
 }
 
+std::shared_ptr<DwaPlan> Dwa::get_plan(const bm_image& src) {
+  auto key = std::make_tuple(src.width, src.height, (int)src.image_format);
+  std::lock_guard<std::mutex> lk(plan_lock);
+  auto it = plans.find(key);
+  if (it != plans.end()) return it->second;
+
+  auto plan = std::make_shared<DwaPlan>();
+  PreWarp& pre = plan->pre;
+  pre.src_w = src.width;
+  pre.src_h = src.height;
+  pre.canvas_w = src.width;
+  pre.canvas_h = src.height;
+  pre.rect = {0, 0, (unsigned int)src.width, (unsigned int)src.height};
+  if (dwa_mode == DWA_FISHEYE_MODE) {
+    // 居中放入resize_w x resize_h的画布，不缩放
+    pre.canvas_w = resize_w;
+    pre.canvas_h = resize_h;
+    pre.rect.start_x = int(resize_w - src.width) / 2;
+    pre.rect.start_y = int(resize_h - src.height) / 2;
+    pre.rot180 = is_rot;
+  } else if (is_resize) {
+    // 按高度缩放后水平居中
+    bool isAlignWidth = false;
+    float ratio = get_aspect_scaled_ratio(src.width, src.height, resize_w,
+                                          resize_h, &isAlignWidth);
+    pre.canvas_w = resize_w;
+    pre.canvas_h = resize_h;
+    pre.rect.crop_w = (unsigned int)(src.width * ratio);
+    pre.rect.crop_h = resize_h;
+    pre.rect.start_x = (int)((resize_w - pre.rect.crop_w) / 2);
+    pre.rect.start_y = 0;
+    pre.rot180 = is_rot;
+    // 缩放、旋转后的画布作为输出帧的mSpData，dwa要求每行32字节对齐
+    plan->canvasAlign = 32;
+    plan->canvasHeap = 2;
+  }
+
+  memset(&plan->padding_attr, 0, sizeof(plan->padding_attr));
+  plan->padding_attr.dst_crop_stx = pre.rect.start_x;
+  plan->padding_attr.dst_crop_sty = pre.rect.start_y;
+  plan->padding_attr.dst_crop_w = pre.rect.crop_w;
+  plan->padding_attr.dst_crop_h = pre.rect.crop_h;
+  plan->padding_attr.padding_b = 114;
+  plan->padding_attr.padding_g = 114;
+  plan->padding_attr.padding_r = 114;
+  plan->padding_attr.if_memset = 1;
+  plan->crop_rect = {0, 0, (unsigned int)src.width, (unsigned int)src.height};
+
+  if (cpu_remap && dwa_mode == DWA_GDC_MODE && is_resize) {
+    // 缩放和旋转已在设备上完成，网格只把输出映射到画布
+    PreWarp canvas;
+    canvas.src_w = canvas.canvas_w = pre.canvas_w;
+    canvas.src_h = canvas.canvas_h = pre.canvas_h;
+    canvas.rect = {0, 0, (unsigned int)pre.canvas_w,
+                   (unsigned int)pre.canvas_h};
+    plan->grid = RemapGrid::build(canvas, warp_x, warp_y);
+  } else if (cpu_remap) {
+    plan->grid = RemapGrid::build(pre, warp_x, warp_y);
+  }
+  plans[key] = plan;
+  return plan;
+}
+
+std::shared_ptr<bm_image> Dwa::remap_cpu_work(bm_handle_t handle,
+                                              bm_image& src,
+                                              const DwaPlan& plan) {
+  cv::Mat src_mat, dst_mat;
+  cv::bmcv::toMAT(&src, src_mat, true);
+  remapCpu(src_mat, *plan.grid, dst_mat);
+
+  bm_image bgr_img;
+  cv::bmcv::toBMI(dst_mat, &bgr_img, true);
+  std::shared_ptr<bm_image> dwa_image(new bm_image, [](bm_image* p) {
+    bm_image_destroy(*p);
+    delete p;
+  });
+  bm_image_create(handle, dst_mat.rows, dst_mat.cols, src_fmt,
+                  DATA_TYPE_EXT_1N_BYTE, dwa_image.get());
+  auto ret = bm_image_alloc_dev_mem(*dwa_image, 1);
+  STREAM_CHECK(BM_SUCCESS == ret,
+               "Allocating dev mem for dwa output bm_image Failed!");
+  bmcv_image_storage_convert(handle, 1, &bgr_img, dwa_image.get());
+  bm_image_destroy(bgr_img);
+  return dwa_image;
+}
+
 common::ErrorCode Dwa::fisheye_work(
     std::shared_ptr<common::ObjectMetadata> fisheyeObj) {
   if (fisheyeObj != nullptr) {
+    bm_handle_t handle = fisheyeObj->mFrame->mHandle;
+    bm_image& src = *fisheyeObj->mFrame->mSpData;
+    auto plan = get_plan(src);
+    if (cpu_remap) {
+      fisheyeObj->mFrame->mSpDataDwa = remap_cpu_work(handle, src, *plan);
+      return common::ErrorCode::SUCCESS;
+    }
+
     std::shared_ptr<bm_image> fisheye_image = nullptr;
     fisheye_image.reset(new bm_image, [](bm_image* p) {
       bm_image_destroy(*p);
@@ -169,173 +271,80 @@ common::ErrorCode Dwa::fisheye_work(
     });
 
     bm_status_t ret =
-        bm_image_create(fisheyeObj->mFrame->mHandle, dst_h, dst_w, src_fmt,
+        bm_image_create(handle, dst_h, dst_w, src_fmt,
                         DATA_TYPE_EXT_1N_BYTE, fisheye_image.get());
     bm_image_alloc_dev_mem(*fisheye_image, 1);
 
-    std::shared_ptr<bm_image> resized_img = nullptr;
-    resized_img.reset(new bm_image, [](bm_image* p) {
-      bm_image_destroy(*p);
-      delete p;
-      p = nullptr;
-    });
-    ret = bm_image_create(fisheyeObj->mFrame->mHandle, resize_h, resize_w, src_fmt,
-                          fisheyeObj->mFrame->mSpData->data_type, resized_img.get(), NULL);
-    bm_image_alloc_dev_mem(*resized_img, 1);
-
-    
-
-    bmcv_rect_t crop_rect{0, 0,
-                          (unsigned int)fisheyeObj->mFrame->mSpData->width,
-                          (unsigned int)fisheyeObj->mFrame->mSpData->height};
-    bmcv_padding_atrr_t padding_attr;
-    memset(&padding_attr, 0, sizeof(padding_attr));
-    padding_attr.dst_crop_sty =
-        int(resize_h - (unsigned int)fisheyeObj->mFrame->mSpData->height) / 2;
-    padding_attr.dst_crop_stx =
-        int(resize_w - (unsigned int)fisheyeObj->mFrame->mSpData->width) / 2;
-    padding_attr.padding_b = 114;
-    padding_attr.padding_g = 114;
-    padding_attr.padding_r = 114;
-    padding_attr.if_memset = 1;
-    padding_attr.dst_crop_h = (unsigned int)fisheyeObj->mFrame->mSpData->height ;
-    padding_attr.dst_crop_w = (unsigned int)fisheyeObj->mFrame->mSpData->width ;
- 
-    ret = bmcv_image_vpp_convert_padding(fisheyeObj->mFrame->mHandle, 1,
-                                         *fisheyeObj->mFrame->mSpData, resized_img.get(),
-                                         &padding_attr, &crop_rect);
-    if(is_rot){
-      std::shared_ptr<bm_image> input_rot = nullptr;
-      input_rot.reset(new bm_image, [](bm_image* p) {
-        bm_image_destroy(*p);
-        delete p;
-        p = nullptr;
-      });
-      ret = bm_image_create(fisheyeObj->mFrame->mHandle, resize_h, resize_w, src_fmt,
-                          fisheyeObj->mFrame->mSpData->data_type, input_rot.get(),
-                          NULL);
-      bm_image_alloc_dev_mem(*input_rot, 1);
-      bmcv_dwa_rot(fisheyeObj->mFrame->mHandle, *resized_img, *input_rot, rot_mode);
-      resized_img=input_rot;
+    // 画布只在本帧内使用，处理完归还给plan
+    auto resized_img = plan->acquireCanvas(handle, src_fmt, src.data_type);
+    ret = bmcv_image_vpp_convert_padding(handle, 1, src, resized_img.get(),
+                                         &plan->padding_attr,
+                                         &plan->crop_rect);
+    std::shared_ptr<bm_image> input_rot = nullptr;
+    if (is_rot) {
+      input_rot = plan->acquireCanvas(handle, src_fmt, src.data_type);
+      bmcv_dwa_rot(handle, *resized_img, *input_rot, rot_mode);
     }
 
-    bmcv_dwa_fisheye(fisheyeObj->mFrame->mHandle, *resized_img, *fisheye_image,
-                     fisheye_attr);
+    bmcv_dwa_fisheye(handle, input_rot ? *input_rot : *resized_img,
+                     *fisheye_image, fisheye_attr);
 
+    plan->releaseCanvas(resized_img);
+    if (input_rot) plan->releaseCanvas(input_rot);
 
     fisheyeObj->mFrame->mSpDataDwa = fisheye_image;  // 是否需要dwa
   }
+  return common::ErrorCode::SUCCESS;
 }
 
 common::ErrorCode Dwa::dwa_gdc_work(
     std::shared_ptr<common::ObjectMetadata> dwaObj) {
   if (dwaObj != nullptr) {
+    bm_handle_t handle = dwaObj->mFrame->mHandle;
+    auto plan = get_plan(*dwaObj->mFrame->mSpData);
     // resize
     if (is_resize == true) {
-      std::shared_ptr<bm_image> resized_img = nullptr;
-      resized_img.reset(new bm_image, [](bm_image* p) {
-        bm_image_destroy(*p);
-        delete p;
-        p = nullptr;
-      });
-
-      bm_image image_aligned;
-      bool need_copy = (unsigned int)dwaObj->mFrame->mSpData->width & (32 - 1);
-      if (need_copy) {
-        int stride1[3], stride2[3];
-        bm_image_get_stride(*dwaObj->mFrame->mSpData, stride1);
-        stride2[0] = FFALIGN(stride1[0], 32);
-        stride2[1] = FFALIGN(stride1[1], 32);
-        stride2[2] = FFALIGN(stride1[2], 32);
-        bm_image_create(dwaObj->mFrame->mHandle,
-                        (unsigned int)dwaObj->mFrame->mSpData->height,
-                        (unsigned int)dwaObj->mFrame->mSpData->width, 
-                        dwaObj->mFrame->mSpData->image_format,
-                        DATA_TYPE_EXT_1N_BYTE, &image_aligned, 
-                        stride2);
-
-        bm_image_alloc_dev_mem(image_aligned, 1);
+      bm_image& src = *dwaObj->mFrame->mSpData;
+      std::shared_ptr<bm_image> image_aligned = nullptr;
+      if ((unsigned int)src.width & (32 - 1)) {
+        image_aligned = plan->acquireAlignedSource(handle, src);
         bmcv_copy_to_atrr_t copyToAttr;
         memset(&copyToAttr, 0, sizeof(copyToAttr));
         copyToAttr.start_x = 0;
         copyToAttr.start_y = 0;
         copyToAttr.if_padding = 1;
-        bmcv_image_copy_to(dwaObj->mFrame->mHandle, copyToAttr,
-                           *dwaObj->mFrame->mSpData, image_aligned);
-      } else {
-        image_aligned = *dwaObj->mFrame->mSpData;
+        bmcv_image_copy_to(handle, copyToAttr, src, *image_aligned);
       }
 
-      bool isAlignWidth = false;
-      float ratio =
-          get_aspect_scaled_ratio((unsigned int)dwaObj->mFrame->mSpData->width,
-                                  (unsigned int)dwaObj->mFrame->mSpData->height,
-                                  resize_w, resize_h, &isAlignWidth);
-
-      bmcv_rect_t crop_rect{0, 0, (unsigned int)dwaObj->mFrame->mSpData->width,
-                            (unsigned int)dwaObj->mFrame->mSpData->height};
-      bmcv_padding_atrr_t padding_attr;
-      memset(&padding_attr, 0, sizeof(padding_attr));
-      padding_attr.dst_crop_sty = 0;
-      padding_attr.dst_crop_stx = 0;
-      padding_attr.padding_b = 114;
-      padding_attr.padding_g = 114;
-      padding_attr.padding_r = 114;
-      padding_attr.if_memset = 1;
-      padding_attr.dst_crop_h = resize_h;
-      padding_attr.dst_crop_w =
-          ((unsigned int)dwaObj->mFrame->mSpData->width * ratio);
-
-      int tx1 = (int)((resize_w - padding_attr.dst_crop_w) / 2);
-      padding_attr.dst_crop_sty = 0;
-      padding_attr.dst_crop_stx = tx1;
-
-      int aligned_net_w = FFALIGN(resize_w, 32);
-      int strides[3] = {aligned_net_w, aligned_net_w, aligned_net_w};
-      bm_image_create(dwaObj->mFrame->mHandle, resize_h, resize_w, src_fmt,
-                      DATA_TYPE_EXT_1N_BYTE, resized_img.get(), strides);
-
-      bm_image_alloc_dev_mem(*resized_img, 2);
-
+      std::shared_ptr<bm_image> resized_img = share_canvas(
+          plan, plan->acquireCanvas(handle, src_fmt, DATA_TYPE_EXT_1N_BYTE));
       bm_status_t ret = bmcv_image_vpp_convert_padding(
-          dwaObj->mFrame->mHandle, 1, image_aligned,
-          resized_img.get(), &padding_attr, &crop_rect);
+          handle, 1, image_aligned ? *image_aligned : src, resized_img.get(),
+          &plan->padding_attr, &plan->crop_rect);
       assert(BM_SUCCESS == ret);
+      if (image_aligned) plan->releaseAlignedSource(image_aligned);
 
       if (is_rot == true) {
-        std::shared_ptr<bm_image> input_rot = nullptr;
-        input_rot.reset(new bm_image, [](bm_image* p) {
-          bm_image_destroy(*p);
-          delete p;
-          p = nullptr;
-        });
-
-        bm_image_create(dwaObj->mFrame->mHandle, resized_img->height,
-                        resized_img->width, src_fmt, DATA_TYPE_EXT_1N_BYTE,
-                        input_rot.get(), NULL);
-        bm_image_alloc_dev_mem(*input_rot, 2);
-
-        bmcv_dwa_rot(dwaObj->mFrame->mHandle, *resized_img, *input_rot,
-                     rot_mode);
+        std::shared_ptr<bm_image> input_rot = share_canvas(
+            plan, plan->acquireCanvas(handle, src_fmt, DATA_TYPE_EXT_1N_BYTE));
+        bmcv_dwa_rot(handle, *resized_img, *input_rot, rot_mode);
         resized_img = input_rot;
       }
 
-      // dwa doing
+      // dwa doing，CPU重映射的输入为设备上缩放、旋转后的画布
       std::shared_ptr<bm_image> dwa_image = nullptr;
-      dwa_image.reset(new bm_image, [](bm_image* p) {
-        bm_image_destroy(*p);
-        delete p;
-        p = nullptr;
-      });
-
-      ret = bm_image_create(dwaObj->mFrame->mHandle, dst_h,
-                            dst_w, src_fmt, DATA_TYPE_EXT_1N_BYTE,
-                            dwa_image.get());
-      bm_image_alloc_dev_mem(*dwa_image, 2);
-
-      {
-        bmcv_dwa_gdc(dwaObj->mFrame->mHandle, *resized_img, *dwa_image,
-                     ldc_attr);
+      if (cpu_remap) {
+        dwa_image = remap_cpu_work(handle, *resized_img, *plan);
+      } else {
+        dwa_image.reset(new bm_image, [](bm_image* p) {
+          bm_image_destroy(*p);
+          delete p;
+          p = nullptr;
+        });
+        ret = bm_image_create(handle, dst_h, dst_w, src_fmt,
+                              DATA_TYPE_EXT_1N_BYTE, dwa_image.get());
+        bm_image_alloc_dev_mem(*dwa_image, 2);
+        bmcv_dwa_gdc(handle, *resized_img, *dwa_image, ldc_attr);
       }
 
       dwaObj->mFrame->mSpData = resized_img;
@@ -343,8 +352,9 @@ common::ErrorCode Dwa::dwa_gdc_work(
       dwaObj->mFrame->mWidth = resized_img->width;
       dwaObj->mFrame->mHeight = resized_img->height;
 
-      if (need_copy) bm_image_destroy(image_aligned);
-
+    } else if (cpu_remap) {
+      dwaObj->mFrame->mSpDataDwa =
+          remap_cpu_work(handle, *dwaObj->mFrame->mSpData, *plan);
     } else {  // dont need resize
       std::shared_ptr<bm_image> dwa_image = nullptr;
       dwa_image.reset(new bm_image, [](bm_image* p) {
@@ -352,32 +362,26 @@ common::ErrorCode Dwa::dwa_gdc_work(
         delete p;
         p = nullptr;
       });
-      bm_status_t ret = bm_image_create(dwaObj->mFrame->mHandle,
-                                        dst_h, dst_w, src_fmt,
+      bm_status_t ret = bm_image_create(handle, dst_h, dst_w, src_fmt,
                                         DATA_TYPE_EXT_1N_BYTE, dwa_image.get());
       ret = bm_image_alloc_dev_mem(*dwa_image, 1);
       STREAM_CHECK(BM_SUCCESS == ret, "Allocating dev mem for dwa output bm_image Failed!");
-      bm_image input;
       if(dwaObj->mFrame->mSpData->image_format != src_fmt){
-        ret = bm_image_create(dwaObj->mFrame->mHandle,
-                              dwaObj->mFrame->mSpData->height,
-                              dwaObj->mFrame->mSpData->width, 
-                              src_fmt,
-                              dwaObj->mFrame->mSpData->data_type, &input, NULL);
-        ret = bm_image_alloc_dev_mem(input, 1);
-        STREAM_CHECK(BM_SUCCESS == ret, "Allocating dev mem for dwa input bm_image failed!");
-        ret = bmcv_image_storage_convert(dwaObj->mFrame->mHandle, 1,
-                                        dwaObj->mFrame->mSpData.get(), &input);
-        ret = bmcv_dwa_gdc(dwaObj->mFrame->mHandle, input, *dwa_image, ldc_attr);
+        // 格式转换的中间图像在帧之间复用
+        auto input = plan->acquireCanvas(handle, src_fmt,
+                                         dwaObj->mFrame->mSpData->data_type);
+        ret = bmcv_image_storage_convert(handle, 1,
+                                         dwaObj->mFrame->mSpData.get(),
+                                         input.get());
+        ret = bmcv_dwa_gdc(handle, *input, *dwa_image, ldc_attr);
+        plan->releaseCanvas(input);
         STREAM_CHECK(BM_SUCCESS == ret, "bmvc_dwa_gdc failed!");
       }else{
-        ret = bmcv_dwa_gdc(dwaObj->mFrame->mHandle, *dwaObj->mFrame->mSpData, *dwa_image, ldc_attr);
+        ret = bmcv_dwa_gdc(handle, *dwaObj->mFrame->mSpData, *dwa_image, ldc_attr);
         STREAM_CHECK(BM_SUCCESS == ret, "bmvc_dwa_gdc failed!");
       }
 
       dwaObj->mFrame->mSpDataDwa = dwa_image;  // dwa
-
-      bm_image_destroy(input);
     }
   }
 
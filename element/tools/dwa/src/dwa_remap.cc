@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "dwa_remap.h"
+
+#include <fstream>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace dwa {
+
+std::shared_ptr<RemapGrid> RemapGrid::build(const PreWarp& pre,
+                                            const cv::Mat& warpX,
+                                            const cv::Mat& warpY) {
+  bool useWarp = !warpX.empty() && !warpY.empty();
+  int out_w = useWarp ? warpX.cols : pre.canvas_w;
+  int out_h = useWarp ? warpX.rows : pre.canvas_h;
+
+  auto grid = std::make_shared<RemapGrid>();
+  grid->map_x.create(out_h, out_w, CV_32FC1);
+  grid->map_y.create(out_h, out_w, CV_32FC1);
+
+  // 画布坐标到源图坐标：按像素中心对齐的缩放
+  float sx = (float)pre.src_w / pre.rect.crop_w;
+  float sy = (float)pre.src_h / pre.rect.crop_h;
+  for (int y = 0; y < out_h; ++y) {
+    float* mx = grid->map_x.ptr<float>(y);
+    float* my = grid->map_y.ptr<float>(y);
+    const float* wx = useWarp ? warpX.ptr<float>(y) : nullptr;
+    const float* wy = useWarp ? warpY.ptr<float>(y) : nullptr;
+    for (int x = 0; x < out_w; ++x) {
+      float u = useWarp ? wx[x] : x;
+      float v = useWarp ? wy[x] : y;
+      if (pre.rot180) {
+        u = pre.canvas_w - 1 - u;
+        v = pre.canvas_h - 1 - v;
+      }
+      float lx = u - pre.rect.start_x;
+      float ly = v - pre.rect.start_y;
+      if (lx < -0.5f || ly < -0.5f || lx > pre.rect.crop_w - 0.5f ||
+          ly > pre.rect.crop_h - 0.5f) {
+        mx[x] = -1.f;
+        my[x] = -1.f;
+        continue;
+      }
+      mx[x] = (lx + 0.5f) * sx - 0.5f;
+      my[x] = (ly + 0.5f) * sy - 0.5f;
+    }
+  }
+  return grid;
+}
+
+void remapCpu(const cv::Mat& src, const RemapGrid& grid, cv::Mat& dst,
+              int border) {
+  cv::remap(src, dst, grid.map_x, grid.map_y, cv::INTER_LINEAR,
+            cv::BORDER_CONSTANT, cv::Scalar::all(border));
+}
+
+bool loadWarpMap(const std::string& path, int w, int h, cv::Mat& warpX,
+                 cv::Mat& warpY) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    IVS_ERROR("dwa: cannot open remap file {0}", path);
+    return false;
+  }
+  size_t planeBytes = (size_t)w * h * sizeof(float);
+  if ((size_t)file.tellg() != planeBytes * 2) {
+    IVS_ERROR("dwa: remap file {0} should hold two {1}x{2} float maps", path,
+              w, h);
+    return false;
+  }
+  file.seekg(0);
+  warpX.create(h, w, CV_32FC1);
+  warpY.create(h, w, CV_32FC1);
+  file.read((char*)warpX.data, planeBytes);
+  file.read((char*)warpY.data, planeBytes);
+  return file.good();
+}
+
+std::shared_ptr<const std::vector<char>> loadGridFile(const std::string& path) {
+  // 有意不析构：element析构时dwa属性中仍引用网格内存
+  static std::mutex* mutex = new std::mutex();
+  static auto* grids =
+      new std::map<std::string, std::shared_ptr<const std::vector<char>>>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto it = grids->find(path);
+  if (grids->end() != it) return it->second;
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  STREAM_CHECK(file.is_open(), "Cannot open grid file: ", path);
+  auto grid = std::make_shared<std::vector<char>>(file.tellg());
+  file.seekg(0);
+  file.read(grid->data(), grid->size());
+  (*grids)[path] = grid;
+  return grid;
+}
+
+std::shared_ptr<bm_image> DwaPlan::acquireCanvas(
+    bm_handle_t handle, bm_image_format_ext format,
+    bm_image_data_format_ext dtype) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeCanvases.empty()) {
+      auto image = freeCanvases.back();
+      freeCanvases.pop_back();
+      return image;
+    }
+  }
+  std::shared_ptr<bm_image> image(new bm_image, [](bm_image* p) {
+    bm_image_destroy(*p);
+    delete p;
+  });
+  int stride = (pre.canvas_w + canvasAlign - 1) / canvasAlign * canvasAlign;
+  int strides[3] = {stride, stride, stride};
+  bm_image_create(handle, pre.canvas_h, pre.canvas_w, format, dtype,
+                  image.get(), canvasAlign > 1 ? strides : NULL);
+  auto ret = bm_image_alloc_dev_mem(*image, canvasHeap);
+  STREAM_CHECK(BM_SUCCESS == ret, "Allocating dev mem for dwa canvas failed!");
+  return image;
+}
+
+void DwaPlan::releaseCanvas(std::shared_ptr<bm_image> image) {
+  std::lock_guard<std::mutex> lock(mutex);
+  freeCanvases.push_back(image);
+}
+
+std::shared_ptr<bm_image> DwaPlan::acquireAlignedSource(bm_handle_t handle,
+                                                        const bm_image& src) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeSources.empty()) {
+      auto image = freeSources.back();
+      freeSources.pop_back();
+      return image;
+    }
+  }
+  std::shared_ptr<bm_image> image(new bm_image, [](bm_image* p) {
+    bm_image_destroy(*p);
+    delete p;
+  });
+  int strides[3] = {0, 0, 0};
+  bm_image_get_stride(src, strides);
+  for (int& stride : strides) stride = (stride + 31) / 32 * 32;
+  bm_image_create(handle, src.height, src.width, src.image_format,
+                  DATA_TYPE_EXT_1N_BYTE, image.get(), strides);
+  auto ret = bm_image_alloc_dev_mem(*image, 1);
+  STREAM_CHECK(BM_SUCCESS == ret,
+               "Allocating dev mem for dwa aligned input failed!");
+  return image;
+}
+
+void DwaPlan::releaseAlignedSource(std::shared_ptr<bm_image> image) {
+  std::lock_guard<std::mutex> lock(mutex);
+  freeSources.push_back(image);
+}
+
+}  // namespace dwa
+}  // namespace element
+}  // namespace sophon_stream
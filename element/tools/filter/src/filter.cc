@@ -312,16 +312,19 @@ bool Filter_Imp::isinclasses(
   std::vector<std::shared_ptr<common::TrackedObjectMetadata>>
       new_mTrackedObjectMetadatas;
 
+  auto& table = objectMetadata->mutableDetectionTable();
+  std::vector<bool> keep(table.size(), false);
   for (int j = 0; j < objectMetadata->mDetectedObjectMetadatas.size(); j++) {
     bool flag = false;
 
     for (int i = 0; i < classes.size(); i++) {
-      int name = objectMetadata->mDetectedObjectMetadatas[j]->mClassify;
+      int name = table.mClassId[j];
 
       flag |= name == classes[i];
       if (flag) break;
     }
     if (flag) {
+      keep[j] = true;
       new_mDetectedObjectMetadatas.push_back(
           objectMetadata->mDetectedObjectMetadatas[j]);
       if (type == 0) {
@@ -336,6 +339,7 @@ bool Filter_Imp::isinclasses(
 
     flag_tot |= flag;
   }
+  table.keepRows(keep);
 
   if (flag_tot) {
     objectMetadata->mDetectedObjectMetadatas.clear();
@@ -369,12 +373,15 @@ bool Filter_Imp::isInPolygon(
   std::vector<std::shared_ptr<common::TrackedObjectMetadata>>
       new_mTrackedObjectMetadatas;
 
+  auto& table = objectMetadata->mutableDetectionTable();
+  std::vector<bool> keep(table.size(), false);
   for (int j = 0; j < objectMetadata->mDetectedObjectMetadatas.size(); j++) {
     bool flag = false;
-    int top = objectMetadata->mDetectedObjectMetadatas[j]->mBox.top();
-    int bottom = objectMetadata->mDetectedObjectMetadatas[j]->mBox.bottom();
-    int left = objectMetadata->mDetectedObjectMetadatas[j]->mBox.left();
-    int right = objectMetadata->mDetectedObjectMetadatas[j]->mBox.right();
+    common::Rectangle<int> box = table.box(j);
+    int top = box.top();
+    int bottom = box.bottom();
+    int left = box.left();
+    int right = box.right();
     std::vector<common::Point<int>> rectangle = {
         common::Point<int>(top, left), common::Point<int>(top, right),
         common::Point<int>(bottom, right), common::Point<int>(bottom, left)};
@@ -386,6 +393,7 @@ bool Filter_Imp::isInPolygon(
       }
     }     
     if (flag) {
+      keep[j] = true;
       new_mDetectedObjectMetadatas.push_back(
           objectMetadata->mDetectedObjectMetadatas[j]);
       if (type == 0) {
@@ -400,6 +408,7 @@ bool Filter_Imp::isInPolygon(
 
     flag_tot |= flag;
   }
+  table.keepRows(keep);
   if (flag_tot) {
     objectMetadata->mDetectedObjectMetadatas.clear();
     objectMetadata->mDetectedObjectMetadatas = new_mDetectedObjectMetadatas;
@@ -430,12 +439,14 @@ bool Filter_Imp::isInDirection(
   bool flag = false;
   if(frame_count % trajectory_interval == 0){
     //记录轨迹
-    for (int i = 0; i < objectMetadata->mDetectedObjectMetadatas.size(); i++) {
+    auto& table = objectMetadata->getDetectionTable();
+    for (int i = 0; i < table.size(); i++) {
       std::string name = std::to_string(objectMetadata->mTrackedObjectMetadatas[i]->mTrackId);
-      int top = objectMetadata->mDetectedObjectMetadatas[i]->mBox.top();
-      int left = objectMetadata->mDetectedObjectMetadatas[i]->mBox.left();
-      int bottom = objectMetadata->mDetectedObjectMetadatas[i]->mBox.bottom();
-      int right = objectMetadata->mDetectedObjectMetadatas[i]->mBox.right();
+      common::Rectangle<int> box = table.box(i);
+      int top = box.top();
+      int left = box.left();
+      int bottom = box.bottom();
+      int right = box.right();
       common::Point<int> trajectory((left + right) / 2, (top + bottom) / 2);
       if(trajectories_pre.find(name) == trajectories_pre.end()) {
         trajectories_pre[name] = trajectory;
@@ -486,6 +497,8 @@ bool Filter_Imp::istrack(
       new_mTrackedObjectMetadatas;
 
   if (objectMetadata->mDetectedObjectMetadatas.size()) {
+    auto& table = objectMetadata->mutableDetectionTable();
+    std::vector<bool> keep(table.size(), false);
     for (int i = 0; i < objectMetadata->mDetectedObjectMetadatas.size(); i++) {
       std::string name;
       if (type == 0) {
@@ -497,6 +510,7 @@ bool Filter_Imp::istrack(
             objectMetadata->mTrackedObjectMetadatas[i]->mTrackId);
       }
       if (up_list.find(name) != up_list.end()) {
+        keep[i] = true;
         new_mDetectedObjectMetadatas.push_back(
             objectMetadata->mDetectedObjectMetadatas[i]);
         if (type == 0) {
@@ -509,6 +523,7 @@ bool Filter_Imp::istrack(
         }
       }
     }
+    table.keepRows(keep);
     objectMetadata->mDetectedObjectMetadatas.clear();
     objectMetadata->mDetectedObjectMetadatas = new_mDetectedObjectMetadatas;
     if (type == 0) {
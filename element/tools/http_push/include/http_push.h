@@ -66,6 +66,11 @@ class HttpPush : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 注册为OSD结果的消费者，每一帧都需要OSD图像
+   */
+  void setGraphId(int id) override;
+
   static constexpr const char* CONFIG_INTERNAL_IP_FILED = "ip";
   static constexpr const char* CONFIG_INTERNAL_PORT_FILED = "port";
   static constexpr const char* CONFIG_INTERNAL_PATH_FILED = "path";
@@ -11,6 +11,7 @@
 
 #include "common/common_defs.h"
 #include "common/logger.h"
+#include "common/render_demand.h"
 #include "common/serialize.h"
 #include "element_factory.h"
 
@@ -19,6 +20,7 @@ namespace element {
 namespace http_push {
 HttpPush::HttpPush() {}
 HttpPush::~HttpPush() {
+  common::RenderDemand::getInstance().removeConsumer(getGraphId(), getId());
   for (auto [k, v] : mapImpl_) {
     v->release();
   }
@@ -223,6 +225,11 @@ common::ErrorCode HttpPush::doWork(int dataPipeId) {
   return common::ErrorCode::SUCCESS;
 }
 
+void HttpPush::setGraphId(int id) {
+  ::sophon_stream::framework::Element::setGraphId(id);
+  common::RenderDemand::getInstance().addConsumer(id, getId());
+}
+
 REGISTER_WORKER("http_push", HttpPush)
 }  // namespace http_push
 }  // namespace element
@@ -23,6 +23,11 @@ class QtDisplay : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 注册为OSD结果的消费者，每一帧都需要OSD图像
+   */
+  void setGraphId(int id) override;
+
   static constexpr const char* CONFIG_INTERNAL_SCREEN_WIDTH = "width";
   static constexpr const char* CONFIG_INTERNAL_SCREEN_HEIGHT = "height";
 
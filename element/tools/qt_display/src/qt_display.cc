@@ -12,6 +12,7 @@
 #include <QScreen>
 
 #include "common/logger.h"
+#include "common/render_demand.h"
 #include "element_factory.h"
 
 namespace sophon_stream {
@@ -20,6 +21,7 @@ namespace qt_display {
 
 QtDisplay::QtDisplay() {}
 QtDisplay::~QtDisplay() {
+  common::RenderDemand::getInstance().removeConsumer(getGraphId(), getId());
   qt_thread.join();
   for (auto& [k, v] : mFpsProfilers) {
     delete v;
@@ -134,6 +136,11 @@ common::ErrorCode QtDisplay::doWork(int dataPipeId) {
   return common::ErrorCode::SUCCESS;
 }
 
+void QtDisplay::setGraphId(int id) {
+  ::sophon_stream::framework::Element::setGraphId(id);
+  common::RenderDemand::getInstance().addConsumer(id, getId());
+}
+
 REGISTER_WORKER("qt_display", QtDisplay)
 
 }  // namespace qt_display
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_SAVE_VIDEO_FRAME_ENCODER_H_
+#define SOPHON_STREAM_ELEMENT_SAVE_VIDEO_FRAME_ENCODER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common_defs.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+/**
+ * @brief 单路的硬件编码器（h264_bm/h265_bm），bm_image直接以设备内存送入VPU，
+ * 输出的packet时间基为1/fps
+ */
+class FrameEncoder {
+ public:
+  FrameEncoder(int dev_id, const std::string& enc_fmt, int width, int height,
+               int fps, int bitrate_kbps, int gop);
+  ~FrameEncoder();
+
+  bool open();
+
+  /**
+   * @brief 编码一帧，尺寸与编码器不同时先缩放；得到的packet追加到pkts
+   */
+  bool encode(bm_handle_t handle, const bm_image& image,
+              std::vector<std::shared_ptr<AVPacket>>& pkts);
+
+  const AVCodecContext* context() const { return enc_ctx_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+ private:
+  bool toAVFrame(bm_handle_t handle, const bm_image& image, AVFrame* frame);
+
+  int dev_id_;
+  std::string enc_fmt_;
+  int width_;
+  int height_;
+  int fps_;
+  int bitrate_kbps_;
+  int gop_;
+  int64_t next_pts_ = 0;
+  AVCodecContext* enc_ctx_ = nullptr;
+};
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_SAVE_VIDEO_FRAME_ENCODER_H_
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_SAVE_VIDEO_IO_WORKER_POOL_H_
+#define SOPHON_STREAM_ELEMENT_SAVE_VIDEO_IO_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+/**
+ * @brief save_video的异步写盘/上报线程池。
+ * @brief
+ * 同一通道的任务固定交给同一个线程，按提交顺序执行（快照、逐帧写入、
+ * 关闭片段、上报不会乱序）；每个线程的队列有上限，满时submit阻塞。
+ * 任务中通过markDirty登记写完的文件，线程空闲或攒够一批时统一fsync
+ */
+class IoWorkerPool {
+ public:
+  IoWorkerPool(int threads, int queue_size, bool fsync);
+  /**
+   * @brief 执行完已提交的任务后退出
+   */
+  ~IoWorkerPool();
+
+  void submit(int channel, std::function<void()> task);
+
+  /**
+   * @brief 在任务中调用，登记需要落盘的文件
+   */
+  static void markDirty(const std::string& path);
+
+  static constexpr int SYNC_BATCH = 16;
+
+ private:
+  struct Worker {
+    std::mutex mtx;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::string> dirty;
+    std::thread thread;
+  };
+
+  void run(Worker& worker);
+  void syncDirty(Worker& worker);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::size_t queue_size_;
+  bool fsync_;
+  std::atomic<bool> stop_{false};
+};
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_SAVE_VIDEO_IO_WORKER_POOL_H_
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_SAVE_VIDEO_PACKET_RING_H_
+#define SOPHON_STREAM_ELEMENT_SAVE_VIDEO_PACKET_RING_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+/**
+ * @brief 单路最近一段时间的已编码packet，总是从关键帧开始。
+ * @brief
+ * 超出时长或字节上限时按整个GOP从头部丢弃，至少保留最新的一个GOP；
+ * 单个GOP就超过字节上限时清空，等待下一个关键帧
+ */
+class PacketRing {
+ public:
+  /**
+   * @param max_duration 时长上限，单位为packet的时间基
+   * @param max_bytes 字节上限
+   */
+  PacketRing(int64_t max_duration, std::size_t max_bytes)
+      : max_duration_(max_duration), max_bytes_(max_bytes) {}
+
+  void push(const std::shared_ptr<AVPacket>& pkt);
+
+  /**
+   * @brief 当前缓存的全部packet，第一个为关键帧
+   */
+  std::vector<std::shared_ptr<AVPacket>> snapshot() const;
+
+  void clear();
+
+  std::size_t bytes() const { return bytes_; }
+
+ private:
+  void popFront();
+  void trim();
+
+  std::deque<std::shared_ptr<AVPacket>> packets_;
+  int64_t max_duration_;
+  std::size_t max_bytes_;
+  std::size_t bytes_ = 0;
+  int keyframes_ = 0;
+};
+
+/**
+ * @brief 把已编码的packet直接封装为mp4片段，不重新编码
+ */
+class ClipWriter {
+ public:
+  ClipWriter() = default;
+  ~ClipWriter();
+
+  bool open(const std::string& path, const AVCodecContext* enc_ctx);
+  /**
+   * @brief 写入一个以编码器时间基为单位的packet，片段的时间戳从0开始
+   */
+  bool write(const std::shared_ptr<AVPacket>& pkt);
+  void close();
+
+ private:
+  AVFormatContext* fmt_ctx_ = nullptr;
+  AVStream* stream_ = nullptr;
+  AVRational enc_time_base_;
+  int64_t ts_offset_ = AV_NOPTS_VALUE;
+};
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_SAVE_VIDEO_PACKET_RING_H_
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_SAVE_VIDEO_RECORDING_INDEX_H_
+#define SOPHON_STREAM_ELEMENT_SAVE_VIDEO_RECORDING_INDEX_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+/**
+ * @brief save_dir下已写完的录像和快照的内存索引，按修改时间排序。
+ * @brief
+ * 启动时扫描一次目录，之后由写盘线程在文件写完时登记；cleanupLoop据此
+ * 按天数或总容量删除最旧的文件，不再每次遍历整个目录树。
+ * 正在写入的片段不在索引中，不会被清理
+ */
+class RecordingIndex {
+ public:
+  using FileTime = std::filesystem::file_time_type;
+
+  void scan(const std::string& dir);
+  void add(const std::string& path);
+  void remove(const std::string& path);
+
+  /**
+   * @brief 删除修改时间早于cutoff的文件，返回删除的个数
+   */
+  int removeOlderThan(FileTime cutoff);
+  /**
+   * @brief 从最旧的文件开始删除，直到总大小不超过max_bytes，返回删除的个数
+   */
+  int shrinkTo(std::uintmax_t max_bytes);
+
+  std::uintmax_t totalBytes();
+
+  static bool isRecordingFile(const std::filesystem::path& path);
+
+ private:
+  using Entry = std::pair<std::string, std::uintmax_t>;  // 路径，大小
+
+  void addLocked(const std::string& path, FileTime time, std::uintmax_t size);
+  int removeFiles(const std::multimap<FileTime, Entry>& victims);
+
+  std::mutex mtx_;
+  std::multimap<FileTime, Entry> by_time_;
+  std::unordered_map<std::string, std::multimap<FileTime, Entry>::iterator>
+      by_path_;
+  std::uintmax_t total_bytes_ = 0;
+};
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_SAVE_VIDEO_RECORDING_INDEX_H_
@@ -29,8 +29,12 @@
 #include "common/object_metadata.h"
 #include "element.h"
 #include "element_factory.h"
+#include "frame_encoder.h"
 #include "httplib.h"
+#include "io_worker_pool.h"
 #include "opencv2/opencv.hpp"
+#include "packet_ring.h"
+#include "recording_index.h"
 
 namespace sophon_stream {
 namespace element {
@@ -48,11 +52,17 @@ struct ChannelState {
   // 录制控制
   bool recording = false;
   std::chrono::steady_clock::time_point record_end_tp;
-  std::unique_ptr<cv::VideoWriter> writer;  // BM OpenCV 增强版
-  int fps = 25;
+  // BM OpenCV 增强版；写盘线程中的任务也持有，关闭后才真正析构
+  std::shared_ptr<cv::VideoWriter> writer;
+  int fps = 0;  // 0表示尚未确定，取第一帧的码流帧率
   int width = 0;
   int height = 0;
 
+  // 预录模式：每帧硬件编码一次，packet进入环形缓存；录像时直接封装，不重新编码
+  std::unique_ptr<FrameEncoder> encoder;
+  std::unique_ptr<PacketRing> ring;
+  std::shared_ptr<ClipWriter> clip;
+
   // 当前录像段共享视频路径
   std::string pending_video_path;
   // 新增：连续命中计数
@@ -76,6 +86,8 @@ class SaveVideo : public ::sophon_stream::framework::Element {
 
   common::ErrorCode initInternal(const std::string& json) override;
   common::ErrorCode doWork(int dataPipeId) override;
+  // 注册为OSD结果的消费者
+  void setGraphId(int id) override;
 
   // 配置字段
   static constexpr const char* CONFIG_SERVER_URL = "server_url";         // 完整URL
@@ -84,11 +96,22 @@ class SaveVideo : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_RECORD_SECONDS = "record_seconds"; // 默认10
   static constexpr const char* CONFIG_TRIGGER_CLASSES = "trigger_classes";   // 为空则任意目标
 
+  // 预录
+  static constexpr const char* CONFIG_PRE_RECORD_SECONDS = "pre_record_seconds";  // 事件前保留的秒数，0表示不预录
+  static constexpr const char* CONFIG_PRE_RECORD_MAX_MB = "pre_record_max_mb";    // 每路预录缓存上限(MB)，默认32
+  static constexpr const char* CONFIG_ENC_FMT = "enc_fmt";                        // "h264_bm" 或 "h265_bm"
+  static constexpr const char* CONFIG_BITRATE = "bitrate";                        // kbps，默认2000
+
   // 存储清理
   static constexpr const char* CONFIG_RETENTION_DAYS = "retention_days";                // 超过天数删除，0表示不按天清理
   static constexpr const char* CONFIG_RETENTION_MAX_GB = "retention_max_gb";            // 超过总容量(GB)删除最旧，0表示不按容量清理
   static constexpr const char* CONFIG_CLEANUP_INTERVAL_SECONDS = "cleanup_interval_seconds"; // 清理轮询间隔，默认300秒
 
+  // 异步写盘
+  static constexpr const char* CONFIG_IO_THREADS = "io_threads";        // 写盘/上报线程数，默认2
+  static constexpr const char* CONFIG_IO_QUEUE_SIZE = "io_queue_size";  // 每个线程的队列上限，默认64
+  static constexpr const char* CONFIG_IO_FSYNC = "io_fsync";            // 写完的文件是否批量fsync，默认true
+
   // 上报字段（固定协议）
   static constexpr const char* CONFIG_DEVICE_ID = "deviceId";
   static constexpr const char* CONFIG_DEVICE_IP = "deviceIp";
@@ -103,10 +126,21 @@ class SaveVideo : public ::sophon_stream::framework::Element {
   static std::optional<ServerEndpoint> parseUrl(const std::string& url);
   // 写图像
   static bool saveSnapshot(const common::Frame& frame, const std::string& filepath);
+  // 码流帧率，解码未给出时按25
+  static int frameRateOf(const common::Frame& frame);
   // 打开录像
   bool startRecording(int channel, const common::Frame& frame, const std::string& filepath);
-  // 追加一帧
-  void appendFrame(int channel, const common::Frame& frame);
+  // 在写盘线程中保存快照并登记到索引
+  void saveSnapshotAsync(int channel, const std::shared_ptr<common::Frame>& frame, const std::string& filepath);
+  // 追加一帧（写盘线程中完成下载和编码）
+  void appendFrame(int channel, const std::shared_ptr<common::Frame>& frame);
+  // 预录模式下编码一帧，写入环形缓存，录像中时同时写入片段
+  void encodeFrame(int channel, const common::Frame& frame);
+  bool usePacketRing() const { return pre_record_seconds_ > 0; }
+  bool useRetention() const {
+    return (retention_days_ > 0 || retention_max_gb_ > 0.0) &&
+           !save_dir_.empty();
+  }
   // 结束录像
   void stopRecording(int channel);
   // 构造可访问URL
@@ -122,11 +156,22 @@ class SaveVideo : public ::sophon_stream::framework::Element {
   int record_seconds_ = 10;
   std::unordered_set<int> trigger_classes_;
 
+  // 预录配置
+  int pre_record_seconds_ = 0;
+  int pre_record_max_mb_ = 32;
+  std::string enc_fmt_ = "h264_bm";
+  int bitrate_kbps_ = 2000;
+
   // 存储清理配置
   int retention_days_ = 0;
   double retention_max_gb_ = 0.0;
   int cleanup_interval_seconds_ = 300;
 
+  // 异步写盘配置
+  int io_threads_ = 2;
+  int io_queue_size_ = 64;
+  bool io_fsync_ = true;
+
   // 上报固定字段
   std::string device_id_ = "";
   std::string device_ip_ = "";
@@ -148,10 +193,25 @@ class SaveVideo : public ::sophon_stream::framework::Element {
 
   // 统一解析本次事件的 type
   int resolveType(const std::vector<std::shared_ptr<common::DetectedObjectMetadata>>& dets) const;
+  // 是否检测到目标（若 trigger_classes_ 非空，则类别需匹配）
+  bool matchesTrigger(const common::ObjectMetadata& obj) const;
+  // 这一帧是否会写入录像或快照，供 OSD 判断是否需要绘制
+  bool wantsOsd(const common::ObjectMetadata& obj);
 
   // 状态
   std::mutex mtx_;
   std::unordered_map<int, ChannelState> channels_;
+  // 正在录像的通道，OSD 线程会读取
+  std::mutex demand_mtx_;
+  std::unordered_set<int> recording_channels_;
+  // 命中触发条件后仍需绘制OSD的截止时间
+  std::unordered_map<int, std::chrono::steady_clock::time_point>
+      osd_hold_until_;
+
+  // 已写完的录像和快照，供清理线程使用
+  RecordingIndex index_;
+  // 快照、录像写入和上报都在这里执行，不阻塞doWork
+  std::unique_ptr<IoWorkerPool> io_pool_;
 
   // 清理线程
   std::atomic<bool> cleanup_running_{false};
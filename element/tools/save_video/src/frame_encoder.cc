@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frame_encoder.h"
+
+#include "common/logger.h"
+
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+namespace {
+
+// 送入编码器的YUV图像，随AVFrame的第一个buffer一起释放
+struct EncodeSurface {
+  bm_image image;
+  uint8_t* host;
+};
+
+void freeSurface(void* opaque, uint8_t* data) {
+  auto surface = static_cast<EncodeSurface*>(opaque);
+  bm_image_destroy(surface->image);
+  av_free(surface->host);
+  delete surface;
+}
+
+void freeNothing(void* opaque, uint8_t* data) {}
+
+}  // namespace
+
+FrameEncoder::FrameEncoder(int dev_id, const std::string& enc_fmt, int width,
+                           int height, int fps, int bitrate_kbps, int gop)
+    : dev_id_(dev_id),
+      enc_fmt_(enc_fmt),
+      width_(width),
+      height_(height),
+      fps_(fps),
+      bitrate_kbps_(bitrate_kbps),
+      gop_(gop) {}
+
+FrameEncoder::~FrameEncoder() {
+  if (enc_ctx_) avcodec_free_context(&enc_ctx_);
+}
+
+bool FrameEncoder::open() {
+  const AVCodec* codec = avcodec_find_encoder_by_name(enc_fmt_.c_str());
+  if (!codec) {
+    IVS_ERROR("save_video: cannot find encoder named {0}", enc_fmt_);
+    return false;
+  }
+  enc_ctx_ = avcodec_alloc_context3(codec);
+  if (!enc_ctx_) return false;
+  enc_ctx_->codec_id = codec->id;
+  enc_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
+  enc_ctx_->width = width_;
+  enc_ctx_->height = height_;
+  enc_ctx_->gop_size = gop_;
+  enc_ctx_->time_base = (AVRational){1, fps_};
+  enc_ctx_->framerate = (AVRational){fps_, 1};
+  enc_ctx_->bit_rate = (int64_t)bitrate_kbps_ * 1000;
+  enc_ctx_->bit_rate_tolerance = bitrate_kbps_ * 1000;
+  // 片段封装为mp4，需要全局头
+  enc_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+  AVDictionary* dict = nullptr;
+  av_dict_set_int(&dict, "sophon_idx", dev_id_, 0);
+  av_dict_set_int(&dict, "gop_preset", 3, 0);
+  av_dict_set_int(&dict, "is_dma_buffer", 1, 0);
+  int ret = avcodec_open2(enc_ctx_, codec, &dict);
+  av_dict_free(&dict);
+  if (ret < 0) {
+    IVS_ERROR("save_video: avcodec_open2 failed, ret: {0}", ret);
+    avcodec_free_context(&enc_ctx_);
+    return false;
+  }
+  return true;
+}
+
+bool FrameEncoder::toAVFrame(bm_handle_t handle, const bm_image& image,
+                             AVFrame* frame) {
+  auto surface = new EncodeSurface();
+  int stride = ((width_ + 31) >> 5) << 5;
+  int stride_bmi[3] = {stride, stride / 2, stride / 2};
+  bm_image_create(handle, height_, width_, FORMAT_YUV420P,
+                  DATA_TYPE_EXT_1N_BYTE, &surface->image, stride_bmi);
+  auto ret = bm_image_alloc_dev_mem_heap_mask(surface->image,
+                                              STREAM_VPP_HEAP_MASK);
+  if (ret != BM_SUCCESS) {
+    bm_image_destroy(surface->image);
+    delete surface;
+    return false;
+  }
+  bm_image src = image;
+  bmcv_rect_t crop_rect = {0, 0, image.width, image.height};
+  ret = bmcv_image_vpp_convert(handle, 1, src, &surface->image, &crop_rect);
+  if (ret != BM_SUCCESS && image.width == width_ && image.height == height_)
+    ret = bmcv_image_storage_convert(handle, 1, &src, &surface->image);
+  if (ret != BM_SUCCESS) {
+    bm_image_destroy(surface->image);
+    delete surface;
+    return false;
+  }
+
+  // 编码器通过data[4..6]读取设备内存，data[0..2]仍需指向有效的主机内存
+  surface->host = (uint8_t*)av_malloc(width_ * height_ * 3 / 2);
+  frame->buf[0] = av_buffer_create(surface->host, width_ * height_,
+                                   freeSurface, surface,
+                                   AV_BUFFER_FLAG_READONLY);
+  frame->buf[1] =
+      av_buffer_create(surface->host + width_ * height_, width_ * height_ / 4,
+                       freeNothing, nullptr, AV_BUFFER_FLAG_READONLY);
+  frame->buf[2] = av_buffer_create(surface->host + width_ * height_ * 5 / 4,
+                                   width_ * height_ / 4, freeNothing, nullptr,
+                                   AV_BUFFER_FLAG_READONLY);
+  frame->data[0] = surface->host;
+  frame->data[1] = surface->host;
+  frame->data[2] = surface->host;
+  frame->format = AV_PIX_FMT_YUV420P;
+  frame->width = width_;
+  frame->height = height_;
+
+  bm_device_mem_t mems[3];
+  bm_image_get_device_mem(surface->image, mems);
+  bm_image_format_info info;
+  bm_image_get_format_info(&surface->image, &info);
+  for (int idx = 0; idx < 3; idx++) {
+    frame->data[4 + idx] = (uint8_t*)mems[idx].u.device.device_addr;
+    frame->linesize[idx] = info.stride[idx];
+    frame->linesize[4 + idx] = info.stride[idx];
+  }
+  return true;
+}
+
+bool FrameEncoder::encode(bm_handle_t handle, const bm_image& image,
+                          std::vector<std::shared_ptr<AVPacket>>& pkts) {
+  if (!enc_ctx_) return false;
+  std::shared_ptr<AVFrame> frame(av_frame_alloc(), [](AVFrame* p) {
+    if (p != nullptr) av_frame_free(&p);
+  });
+  if (!toAVFrame(handle, image, frame.get())) return false;
+  frame->pts = next_pts_++;
+
+  std::shared_ptr<AVPacket> pkt(av_packet_alloc(), [](AVPacket* p) {
+    if (p != nullptr) av_packet_free(&p);
+  });
+  int got_output = 0;
+  int ret = avcodec_encode_video2(enc_ctx_, pkt.get(), frame.get(),
+                                  &got_output);
+  if (ret < 0) {
+    IVS_ERROR("save_video: encode failed, ret: {0}", ret);
+    return false;
+  }
+  if (got_output) pkts.push_back(pkt);
+  return true;
+}
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "io_worker_pool.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+namespace {
+
+// 当前线程所属的worker，供markDirty使用
+thread_local std::vector<std::string>* tls_dirty = nullptr;
+
+}  // namespace
+
+IoWorkerPool::IoWorkerPool(int threads, int queue_size, bool fsync)
+    : queue_size_(std::max(1, queue_size)), fsync_(fsync) {
+  threads = std::max(1, threads);
+  for (int i = 0; i < threads; ++i) {
+    workers_.emplace_back(new Worker());
+    Worker& worker = *workers_.back();
+    worker.thread = std::thread(&IoWorkerPool::run, this, std::ref(worker));
+  }
+}
+
+IoWorkerPool::~IoWorkerPool() {
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> lock(worker->mtx);
+    stop_ = true;
+    worker->not_empty.notify_all();
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) worker->thread.join();
+  }
+}
+
+void IoWorkerPool::submit(int channel, std::function<void()> task) {
+  Worker& worker = *workers_[channel % workers_.size()];
+  std::unique_lock<std::mutex> lock(worker.mtx);
+  // 队列满时阻塞，磁盘长时间跟不上时由这里向上游形成背压
+  worker.not_full.wait(lock,
+                       [&]() { return worker.tasks.size() < queue_size_; });
+  worker.tasks.push_back(std::move(task));
+  worker.not_empty.notify_one();
+}
+
+void IoWorkerPool::markDirty(const std::string& path) {
+  if (tls_dirty) tls_dirty->push_back(path);
+}
+
+void IoWorkerPool::syncDirty(Worker& worker) {
+  if (fsync_) {
+    for (auto& path : worker.dirty) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) continue;
+      ::fsync(fd);
+      ::close(fd);
+    }
+  }
+  worker.dirty.clear();
+}
+
+void IoWorkerPool::run(Worker& worker) {
+  tls_dirty = &worker.dirty;
+  while (true) {
+    std::function<void()> task;
+    bool idle = false;
+    {
+      std::unique_lock<std::mutex> lock(worker.mtx);
+      worker.not_empty.wait(
+          lock, [&]() { return stop_ || !worker.tasks.empty(); });
+      if (worker.tasks.empty()) break;
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      idle = worker.tasks.empty();
+      worker.not_full.notify_one();
+    }
+    try {
+      task();
+    } catch (const std::exception& e) {
+      IVS_ERROR("save_video io task error: {0}", e.what());
+    }
+    if (idle || worker.dirty.size() >= SYNC_BATCH) syncDirty(worker);
+  }
+  syncDirty(worker);
+  tls_dirty = nullptr;
+}
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "packet_ring.h"
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+void PacketRing::push(const std::shared_ptr<AVPacket>& pkt) {
+  bool key = pkt->flags & AV_PKT_FLAG_KEY;
+  // 保证缓存总是从关键帧开始
+  if (packets_.empty() && !key) return;
+  packets_.push_back(pkt);
+  bytes_ += pkt->size;
+  if (key) keyframes_++;
+  trim();
+}
+
+void PacketRing::popFront() {
+  auto& pkt = packets_.front();
+  bytes_ -= pkt->size;
+  if (pkt->flags & AV_PKT_FLAG_KEY) keyframes_--;
+  packets_.pop_front();
+}
+
+void PacketRing::trim() {
+  auto overLimit = [this]() {
+    return bytes_ > max_bytes_ ||
+           packets_.back()->pts - packets_.front()->pts > max_duration_;
+  };
+  // 丢弃最旧的整个GOP，直到满足上限或只剩一个GOP
+  while (keyframes_ > 1 && overLimit()) {
+    popFront();
+    while (!packets_.empty() &&
+           !(packets_.front()->flags & AV_PKT_FLAG_KEY))
+      popFront();
+  }
+  if (bytes_ > max_bytes_) clear();
+}
+
+std::vector<std::shared_ptr<AVPacket>> PacketRing::snapshot() const {
+  return std::vector<std::shared_ptr<AVPacket>>(packets_.begin(),
+                                                packets_.end());
+}
+
+void PacketRing::clear() {
+  packets_.clear();
+  bytes_ = 0;
+  keyframes_ = 0;
+}
+
+ClipWriter::~ClipWriter() { close(); }
+
+bool ClipWriter::open(const std::string& path,
+                      const AVCodecContext* enc_ctx) {
+  avformat_alloc_output_context2(&fmt_ctx_, NULL, NULL, path.c_str());
+  if (!fmt_ctx_) {
+    IVS_ERROR("save_video: cannot alloc output context for {0}", path);
+    return false;
+  }
+  stream_ = avformat_new_stream(fmt_ctx_, NULL);
+  avcodec_parameters_from_context(stream_->codecpar, enc_ctx);
+  stream_->codecpar->codec_tag = 0;
+  stream_->time_base = enc_ctx->time_base;
+  enc_time_base_ = enc_ctx->time_base;
+  ts_offset_ = AV_NOPTS_VALUE;
+
+  int ret = avio_open2(&fmt_ctx_->pb, path.c_str(), AVIO_FLAG_WRITE, NULL,
+                       NULL);
+  if (ret >= 0) ret = avformat_write_header(fmt_ctx_, NULL);
+  if (ret < 0) {
+    IVS_ERROR("save_video: open clip {0} failed, ret: {1}", path, ret);
+    if (fmt_ctx_->pb) avio_closep(&fmt_ctx_->pb);
+    avformat_free_context(fmt_ctx_);
+    fmt_ctx_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool ClipWriter::write(const std::shared_ptr<AVPacket>& pkt) {
+  if (!fmt_ctx_) return false;
+  AVPacket* out = av_packet_clone(pkt.get());
+  if (ts_offset_ == AV_NOPTS_VALUE)
+    ts_offset_ = out->dts != AV_NOPTS_VALUE ? out->dts : out->pts;
+  if (out->pts != AV_NOPTS_VALUE) out->pts -= ts_offset_;
+  if (out->dts != AV_NOPTS_VALUE) out->dts -= ts_offset_;
+  av_packet_rescale_ts(out, enc_time_base_, stream_->time_base);
+  out->stream_index = stream_->index;
+  int ret = av_interleaved_write_frame(fmt_ctx_, out);
+  av_packet_free(&out);
+  return ret >= 0;
+}
+
+void ClipWriter::close() {
+  if (!fmt_ctx_) return;
+  av_write_trailer(fmt_ctx_);
+  avio_closep(&fmt_ctx_->pb);
+  avformat_free_context(fmt_ctx_);
+  fmt_ctx_ = nullptr;
+  stream_ = nullptr;
+}
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
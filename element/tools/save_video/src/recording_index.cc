@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2025 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "recording_index.h"
+
+#include "common/logger.h"
+
+namespace fs = std::filesystem;
+
+namespace sophon_stream {
+namespace element {
+namespace save_video {
+
+bool RecordingIndex::isRecordingFile(const fs::path& path) {
+  auto ext = path.extension().string();
+  return ext == ".mp4" || ext == ".jpg" || ext == ".jpeg";
+}
+
+void RecordingIndex::scan(const std::string& dir) {
+  std::error_code ec;
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (auto it = fs::recursive_directory_iterator(dir, ec);
+       !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (!it->is_regular_file() || !isRecordingFile(it->path())) continue;
+    std::error_code fec;
+    auto size = fs::file_size(it->path(), fec);
+    if (fec) continue;
+    auto time = fs::last_write_time(it->path(), fec);
+    if (fec) continue;
+    addLocked(it->path().string(), time, size);
+  }
+  IVS_INFO("save_video: indexed {0} files, {1} bytes under {2}",
+           by_path_.size(), total_bytes_, dir);
+}
+
+void RecordingIndex::addLocked(const std::string& path, FileTime time,
+                               std::uintmax_t size) {
+  auto old = by_path_.find(path);
+  if (old != by_path_.end()) {
+    total_bytes_ -= old->second->second.second;
+    by_time_.erase(old->second);
+    by_path_.erase(old);
+  }
+  by_path_[path] = by_time_.emplace(time, Entry(path, size));
+  total_bytes_ += size;
+}
+
+void RecordingIndex::add(const std::string& path) {
+  std::error_code ec;
+  auto size = fs::file_size(path, ec);
+  if (ec) return;
+  auto time = fs::last_write_time(path, ec);
+  if (ec) return;
+  std::lock_guard<std::mutex> lock(mtx_);
+  addLocked(path, time, size);
+}
+
+void RecordingIndex::remove(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = by_path_.find(path);
+  if (it == by_path_.end()) return;
+  total_bytes_ -= it->second->second.second;
+  by_time_.erase(it->second);
+  by_path_.erase(it);
+}
+
+int RecordingIndex::removeFiles(const std::multimap<FileTime, Entry>& victims) {
+  // 在锁外删除文件，避免阻塞写盘线程登记新文件
+  int removed = 0;
+  for (auto& victim : victims) {
+    std::error_code ec;
+    fs::remove(victim.second.first, ec);
+    if (!ec) ++removed;
+  }
+  return removed;
+}
+
+int RecordingIndex::removeOlderThan(FileTime cutoff) {
+  std::multimap<FileTime, Entry> victims;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto end = by_time_.lower_bound(cutoff);
+    for (auto it = by_time_.begin(); it != end; ++it) {
+      total_bytes_ -= it->second.second;
+      by_path_.erase(it->second.first);
+    }
+    victims.insert(by_time_.begin(), end);
+    by_time_.erase(by_time_.begin(), end);
+  }
+  return removeFiles(victims);
+}
+
+int RecordingIndex::shrinkTo(std::uintmax_t max_bytes) {
+  std::multimap<FileTime, Entry> victims;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    while (total_bytes_ > max_bytes && !by_time_.empty()) {
+      auto it = by_time_.begin();
+      total_bytes_ -= it->second.second;
+      by_path_.erase(it->second.first);
+      victims.insert(*it);
+      by_time_.erase(it);
+    }
+  }
+  return removeFiles(victims);
+}
+
+std::uintmax_t RecordingIndex::totalBytes() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return total_bytes_;
+}
+
+}  // namespace save_video
+}  // namespace element
+}  // namespace sophon_stream
@@ -9,6 +9,7 @@
 
 #include "save_video.h"
 
+#include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <regex>
@@ -17,6 +18,7 @@
 #include "common/common_defs.h"
 #include <unordered_set>
 #include "common/logger.h"
+#include "common/render_demand.h"
 #include "element_factory.h"
 
 namespace fs = std::filesystem;
@@ -29,8 +31,11 @@ using namespace std::chrono;
 
 SaveVideo::SaveVideo() {}
 SaveVideo::~SaveVideo() {
+  common::RenderDemand::getInstance().removeConsumer(getGraphId(), getId());
   cleanup_running_ = false;
   if (cleanup_thread_.joinable()) cleanup_thread_.join();
+  // 写完已提交的快照、录像和上报
+  io_pool_.reset();
 }
 
 static std::string now_datetime_str() {
@@ -81,20 +86,47 @@ bool SaveVideo::saveSnapshot(const common::Frame& frame, const std::string& file
   }
 }
 
+int SaveVideo::frameRateOf(const common::Frame& frame) {
+  const auto& rate = frame.mFrameRate;
+  if (rate.mNumber <= 0 || rate.mDenominator <= 0) return 25;
+  return std::max(1, (int)std::lround((double)rate.mNumber / rate.mDenominator));
+}
+
 bool SaveVideo::startRecording(int channel, const common::Frame& frame, const std::string& filepath) {
   auto& st = channels_[channel];
   try {
     fs::create_directories(fs::path(filepath).parent_path());
-    int fps = st.fps > 0 ? st.fps : (frame.mFrameRate.mDenominator != 0 ? std::max(1, frame.mFrameRate.mNumber / std::max(1, frame.mFrameRate.mDenominator)) : 25);
+    int fps = st.fps > 0 ? st.fps : frameRateOf(frame);
     int w = frame.mWidth;
     int h = frame.mHeight;
     if (w <= 0 || h <= 0) return false;
     st.width = w;
     st.height = h;
     st.fps = fps;
-  // （预录功能已移除，不再计算预录缓存大小）
 
-    st.writer = std::make_unique<cv::VideoWriter>();
+    if (usePacketRing()) {
+      // 先写入事件前缓存的packet，之后由encodeFrame续写
+      if (!st.encoder) return false;
+      st.clip = std::make_unique<ClipWriter>();
+      if (!st.clip->open(filepath, st.encoder->context())) {
+        st.clip.reset();
+        return false;
+      }
+      auto preroll = st.ring->snapshot();
+      auto clip = st.clip;
+      io_pool_->submit(channel, [clip, preroll]() {
+        for (auto& pkt : preroll) clip->write(pkt);
+      });
+      IVS_INFO("save_video: pre-record {0} packets ({1} bytes) into {2}",
+               preroll.size(), st.ring->bytes(), filepath);
+      st.recording = true;
+      st.record_end_tp = steady_clock::now() + seconds(record_seconds_);
+      std::lock_guard<std::mutex> lk(demand_mtx_);
+      recording_channels_.insert(channel);
+      return true;
+    }
+
+    st.writer = std::make_shared<cv::VideoWriter>();
   // MP4 容器更推荐使用 'avc1' FourCC，避免 OpenCV/FFmpeg 警告并保持 H.264 编码
   int fourcc = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
     bool ok = st.writer->open(filepath, fourcc, fps, cv::Size(w, h));
@@ -105,6 +137,10 @@ bool SaveVideo::startRecording(int channel, const common::Frame& frame, const st
     }
     st.recording = true;
     st.record_end_tp = steady_clock::now() + seconds(record_seconds_);
+    {
+      std::lock_guard<std::mutex> lk(demand_mtx_);
+      recording_channels_.insert(channel);
+    }
     return true;
   } catch (const std::exception& e) {
     IVS_ERROR("startRecording error: {0}", e.what());
@@ -112,28 +148,74 @@ bool SaveVideo::startRecording(int channel, const common::Frame& frame, const st
   }
 }
 
-void SaveVideo::appendFrame(int channel, const common::Frame& frame) {
+void SaveVideo::saveSnapshotAsync(int channel, const std::shared_ptr<common::Frame>& frame, const std::string& filepath) {
+  // 任务持有frame，图像在写完之前不会释放
+  io_pool_->submit(channel, [this, frame, filepath]() {
+    if (saveSnapshot(*frame, filepath)) {
+      IoWorkerPool::markDirty(filepath);
+      if (useRetention()) index_.add(filepath);
+    }
+  });
+}
+
+void SaveVideo::appendFrame(int channel, const std::shared_ptr<common::Frame>& frame) {
   auto it = channels_.find(channel);
   if (it == channels_.end()) return;
   auto& st = it->second;
+  // 预录模式下该帧已在encodeFrame中写入
   if (!st.recording || !st.writer) return;
-  cv::Mat img;
-  // 优先写入 OSD 后的图像
-  if (frame.mSpDataOsd) {
-    cv::bmcv::toMAT(frame.mSpDataOsd.get(), img, true);
-  } else if (frame.mSpData) {
-    cv::bmcv::toMAT(frame.mSpData.get(), img, true);
-  } else if (!frame.mMat.empty()) {
-    img = frame.mMat;
-  } else {
-    return;
+  auto writer = st.writer;
+  int width = st.width;
+  int height = st.height;
+  io_pool_->submit(channel, [writer, frame, width, height]() {
+    cv::Mat img;
+    // 优先写入 OSD 后的图像
+    if (frame->mSpDataOsd) {
+      cv::bmcv::toMAT(frame->mSpDataOsd.get(), img, true);
+    } else if (frame->mSpData) {
+      cv::bmcv::toMAT(frame->mSpData.get(), img, true);
+    } else if (!frame->mMat.empty()) {
+      img = frame->mMat;
+    } else {
+      return;
+    }
+    if (img.cols != width || img.rows != height) {
+      cv::Mat resized;
+      cv::resize(img, resized, cv::Size(width, height));
+      writer->write(resized);
+    } else {
+      writer->write(img);
+    }
+  });
+}
+
+void SaveVideo::encodeFrame(int channel, const common::Frame& frame) {
+  auto& st = channels_[channel];
+  std::shared_ptr<bm_image> image =
+      frame.mSpDataOsd ? frame.mSpDataOsd : frame.mSpData;
+  if (!image) return;
+  if (!st.encoder) {
+    int w = frame.mWidth;
+    int h = frame.mHeight;
+    if (w <= 0 || h <= 0) return;
+    if (st.fps <= 0) st.fps = frameRateOf(frame);
+    // GOP取1秒，预录按整秒对齐到关键帧
+    auto encoder = std::make_unique<FrameEncoder>(
+        getDeviceId(), enc_fmt_, w, h, st.fps, bitrate_kbps_, st.fps);
+    if (!encoder->open()) return;
+    st.encoder = std::move(encoder);
+    st.ring = std::make_unique<PacketRing>(
+        (int64_t)pre_record_seconds_ * st.fps,
+        (std::size_t)pre_record_max_mb_ << 20);
   }
-  if (img.cols != st.width || img.rows != st.height) {
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(st.width, st.height));
-    st.writer->write(resized);
-  } else {
-    st.writer->write(img);
+  std::vector<std::shared_ptr<AVPacket>> pkts;
+  if (!st.encoder->encode(frame.mHandle, *image, pkts)) return;
+  for (auto& pkt : pkts) {
+    st.ring->push(pkt);
+    if (st.recording && st.clip) {
+      auto clip = st.clip;
+      io_pool_->submit(channel, [clip, pkt]() { clip->write(pkt); });
+    }
   }
 }
 
@@ -141,11 +223,59 @@ void SaveVideo::stopRecording(int channel) {
   auto it = channels_.find(channel);
   if (it == channels_.end()) return;
   auto& st = it->second;
-  if (st.writer) {
-    st.writer->release();
+  // 排在本通道已提交的写入之后关闭
+  auto writer = std::move(st.writer);
+  auto clip = std::move(st.clip);
+  if (writer || clip) {
+    io_pool_->submit(channel, [writer, clip]() {
+      if (writer) writer->release();
+      if (clip) clip->close();
+    });
   }
-  st.writer.reset();
   st.recording = false;
+  std::lock_guard<std::mutex> lk(demand_mtx_);
+  recording_channels_.erase(channel);
+}
+
+bool SaveVideo::matchesTrigger(const common::ObjectMetadata& obj) const {
+  if (!trigger_classes_.empty()) {
+    for (auto& det : obj.mDetectedObjectMetadatas) {
+      if (det && trigger_classes_.count(det->mClassify)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  return !obj.mDetectedObjectMetadatas.empty();
+}
+
+bool SaveVideo::wantsOsd(const common::ObjectMetadata& obj) {
+  // 预录模式每帧都进入缓存；录像中的通道每帧都要写入；
+  // 否则只有检测到目标的帧可能触发快照
+  if (!obj.mFrame) return false;
+  if (usePacketRing()) return true;
+  int channel = obj.mFrame->mChannelIdInternal;
+  auto now = steady_clock::now();
+  std::lock_guard<std::mutex> lk(demand_mtx_);
+  if (recording_channels_.count(channel)) return true;
+  // 触发判断在OSD之后进行，录像开始时已经越过OSD的帧也会写入片段，
+  // 所以命中触发条件后该通道继续绘制一段时间
+  if (matchesTrigger(obj)) {
+    osd_hold_until_[channel] = now + seconds(record_seconds_);
+    return true;
+  }
+  auto holdIt = osd_hold_until_.find(channel);
+  if (holdIt == osd_hold_until_.end()) return false;
+  if (now < holdIt->second) return true;
+  osd_hold_until_.erase(holdIt);
+  return false;
+}
+
+void SaveVideo::setGraphId(int id) {
+  ::sophon_stream::framework::Element::setGraphId(id);
+  common::RenderDemand::getInstance().addConsumer(
+      id, getId(),
+      [this](const common::ObjectMetadata& obj) { return wantsOsd(obj); });
 }
 
 std::string SaveVideo::makeUrl(const std::string& file_abs_path) const {
@@ -218,6 +348,14 @@ common::ErrorCode SaveVideo::initInternal(const std::string& json) {
   save_dir_ = cfg[CONFIG_SAVE_DIR].get<std::string>();
   if (cfg.contains(CONFIG_BASE_FILE_URL)) base_file_url_ = cfg[CONFIG_BASE_FILE_URL].get<std::string>();
   if (cfg.contains(CONFIG_RECORD_SECONDS)) record_seconds_ = std::max(1, cfg[CONFIG_RECORD_SECONDS].get<int>());
+  if (cfg.contains(CONFIG_PRE_RECORD_SECONDS)) pre_record_seconds_ = std::max(0, cfg[CONFIG_PRE_RECORD_SECONDS].get<int>());
+  if (cfg.contains(CONFIG_PRE_RECORD_MAX_MB)) pre_record_max_mb_ = std::max(1, cfg[CONFIG_PRE_RECORD_MAX_MB].get<int>());
+  if (cfg.contains(CONFIG_ENC_FMT)) enc_fmt_ = cfg[CONFIG_ENC_FMT].get<std::string>();
+  if (cfg.contains(CONFIG_BITRATE)) bitrate_kbps_ = std::max(1, cfg[CONFIG_BITRATE].get<int>());
+  if (usePacketRing()) {
+    IVS_INFO("save_video: pre-record {0}s, max {1}MB per channel, {2}",
+             pre_record_seconds_, pre_record_max_mb_, enc_fmt_);
+  }
 
   if (cfg.contains(CONFIG_TRIGGER_CLASSES)) {
     trigger_classes_.clear();
@@ -270,6 +408,12 @@ common::ErrorCode SaveVideo::initInternal(const std::string& json) {
   if (cfg.contains(CONFIG_RETENTION_MAX_GB)) retention_max_gb_ = std::max(0.0, cfg[CONFIG_RETENTION_MAX_GB].get<double>());
   if (cfg.contains(CONFIG_CLEANUP_INTERVAL_SECONDS)) cleanup_interval_seconds_ = std::max(30, cfg[CONFIG_CLEANUP_INTERVAL_SECONDS].get<int>());
 
+  // 异步写盘
+  if (cfg.contains(CONFIG_IO_THREADS)) io_threads_ = std::max(1, cfg[CONFIG_IO_THREADS].get<int>());
+  if (cfg.contains(CONFIG_IO_QUEUE_SIZE)) io_queue_size_ = std::max(1, cfg[CONFIG_IO_QUEUE_SIZE].get<int>());
+  if (cfg.contains(CONFIG_IO_FSYNC)) io_fsync_ = cfg[CONFIG_IO_FSYNC].get<bool>();
+  io_pool_ = std::make_unique<IoWorkerPool>(io_threads_, io_queue_size_, io_fsync_);
+
   // 协议字段
   if (cfg.contains(CONFIG_DEVICE_ID)) device_id_ = cfg[CONFIG_DEVICE_ID].get<std::string>();
   if (cfg.contains(CONFIG_DEVICE_IP)) device_ip_ = cfg[CONFIG_DEVICE_IP].get<std::string>();
@@ -332,7 +476,9 @@ common::ErrorCode SaveVideo::initInternal(const std::string& json) {
 
   try { fs::create_directories(save_dir_); } catch (...) {}
   // 启动清理线程（若配置了任一条件）
-  if ((retention_days_ > 0 || retention_max_gb_ > 0.0) && !save_dir_.empty()) {
+  if (useRetention()) {
+    // 只在启动时扫描一次目录，之后由写盘线程维护索引
+    index_.scan(save_dir_);
     cleanup_running_ = true;
     cleanup_thread_ = std::thread(&SaveVideo::cleanupLoop, this);
   }
@@ -370,21 +516,11 @@ common::ErrorCode SaveVideo::doWork(int dataPipeId) {
   // 这是有效帧，确保不被统计逻辑过滤
   obj->mFilter = false;
 
-  // （预录功能已移除，不再维护回溯帧缓存）
+  // 预录：每帧编码进入环形缓存，触发录像时从缓存开始写
+  if (usePacketRing()) encodeFrame(ch, *obj->mFrame);
 
   // 条件：检测到目标（若 trigger_classes_ 非空，则类别需匹配）
-  auto hasTarget = [&]() {
-    if (!trigger_classes_.empty()) {
-      for (auto& det : obj->mDetectedObjectMetadatas) {
-        if (det && trigger_classes_.count(det->mClassify)) {
-          return true;
-        }
-      }
-      return false;
-    } else {
-      return !obj->mDetectedObjectMetadatas.empty();
-    }
-  }();
+  bool hasTarget = matchesTrigger(*obj);
 
   auto now_tp = steady_clock::now();
   // 冷却机制已移除
@@ -492,12 +628,16 @@ common::ErrorCode SaveVideo::doWork(int dataPipeId) {
       if (!record_ok) {
         // 录像失败：按类别直接上报（共享一张主图片）
         std::string mainImg = base + ".jpg";
-        saveSnapshot(*obj->mFrame, mainImg);
+        saveSnapshotAsync(ch, obj->mFrame, mainImg);
         char dtbuf[32]; std::strftime(dtbuf, sizeof(dtbuf), "%Y-%m-%d %H:%M:%S", &tm);
+        std::vector<ChannelState::PendingEvent> events;
         for (int cid : classes_to_add) {
-          ChannelState::PendingEvent ev{cid, resolved_type, mainImg, dtbuf};
-          postAlarm(ch, ev.img_path, "", ev.datetime_str, ev.type);
+          events.push_back(ChannelState::PendingEvent{cid, resolved_type, mainImg, dtbuf});
         }
+        // 在快照写完之后上报
+        io_pool_->submit(ch, [this, ch, events]() {
+          for (auto &ev : events) postAlarm(ch, ev.img_path, "", ev.datetime_str, ev.type);
+        });
   // 无录像句柄，无需后续段结束批量上报
       } else {
         // 成功开始录像：为每个类别生成快照
@@ -518,7 +658,7 @@ common::ErrorCode SaveVideo::doWork(int dataPipeId) {
             // 统一命名以 type 结尾：时间 + _cls<cid>_type<type>.jpg
             imgPath = (fs::path(save_dir_) / ("ch_" + std::to_string(ch)) / (timestr + "_cls" + std::to_string(cid) + "_type" + std::to_string(resolved_type) + ".jpg")).string();
           }
-          saveSnapshot(*obj->mFrame, imgPath);
+          saveSnapshotAsync(ch, obj->mFrame, imgPath);
           char dtbuf[32]; std::strftime(dtbuf, sizeof(dtbuf), "%Y-%m-%d %H:%M:%S", &tm);
           ChannelState::PendingEvent ev{cid, resolved_type, imgPath, dtbuf};
           st.pending_events.push_back(std::move(ev));
@@ -533,7 +673,7 @@ common::ErrorCode SaveVideo::doWork(int dataPipeId) {
         std::string imgPath;
         // 统一命名以 type 结尾：时间 + _cls<cid>_type<type>.jpg
         imgPath = (fs::path(save_dir_) / ("ch_" + std::to_string(ch)) / (timestr + "_cls" + std::to_string(cid) + "_type" + std::to_string(resolved_type) + ".jpg")).string();
-        saveSnapshot(*obj->mFrame, imgPath);
+        saveSnapshotAsync(ch, obj->mFrame, imgPath);
         char dtbuf[32]; std::strftime(dtbuf, sizeof(dtbuf), "%Y-%m-%d %H:%M:%S", &tm);
         ChannelState::PendingEvent ev{cid, resolved_type, imgPath, dtbuf};
         st.pending_events.push_back(std::move(ev));
@@ -547,39 +687,47 @@ common::ErrorCode SaveVideo::doWork(int dataPipeId) {
 
   // 录像续写与结束
   if (st.recording) {
-    appendFrame(ch, *obj->mFrame);
+    appendFrame(ch, obj->mFrame);
     if (now_tp >= st.record_end_tp) {
       stopRecording(ch);
-      // 结束时批量上报本段的所有事件（共享视频路径）
-      if (st.pending_events.empty()) {
-        // 无事件：删除空段视频，避免产生“无告警视频”与后续 HTTP 数量难以对齐
-        if (!st.pending_video_path.empty()) {
-          std::error_code ec_rm;
-          std::filesystem::remove(st.pending_video_path, ec_rm);
-          if (!ec_rm) {
-            IVS_INFO("save_video: segment end (no events) removed video={0}", st.pending_video_path);
-          } else {
-            IVS_WARN("save_video: segment end (no events) remove failed video={0}", st.pending_video_path);
+      // 结束时批量上报本段的所有事件（共享视频路径）；
+      // 排在片段关闭之后，在写盘线程中执行
+      std::string video_path = st.pending_video_path;
+      auto events = st.pending_events;
+      io_pool_->submit(ch, [this, ch, video_path, events]() {
+        if (events.empty()) {
+          // 无事件：删除空段视频，避免产生“无告警视频”与后续 HTTP 数量难以对齐
+          if (!video_path.empty()) {
+            std::error_code ec_rm;
+            std::filesystem::remove(video_path, ec_rm);
+            if (!ec_rm) {
+              IVS_INFO("save_video: segment end (no events) removed video={0}", video_path);
+            } else {
+              IVS_WARN("save_video: segment end (no events) remove failed video={0}", video_path);
+            }
           }
+          return;
         }
-      } else {
+        IoWorkerPool::markDirty(video_path);
+        // 索引只供清理线程使用，未开启清理时不登记，避免长时间运行时无限增长
+        if (useRetention()) index_.add(video_path);
         // 汇总日志（在逐条上报之前打印）
         {
           std::stringstream ss;
-          ss << "save_video: segment end video=" << st.pending_video_path << " events=" << st.pending_events.size() << " [";
+          ss << "save_video: segment end video=" << video_path << " events=" << events.size() << " [";
           bool first=true;
-          for (auto &ev: st.pending_events) {
+          for (auto &ev: events) {
             if (!first) ss << ","; first=false;
             ss << "{cls=" << ev.class_id << ",type=" << ev.type << "}";
           }
           ss << "]";
           IVS_INFO("{0}", ss.str());
         }
-        for (auto &ev : st.pending_events) {
-          postAlarm(ch, ev.img_path, st.pending_video_path, ev.datetime_str, ev.type);
+        for (auto &ev : events) {
+          postAlarm(ch, ev.img_path, video_path, ev.datetime_str, ev.type);
           IVS_INFO("save_video: posted event cls={0} type={1} img={2}", ev.class_id, ev.type, ev.img_path);
         }
-      }
+      });
       st.pending_events.clear();
       st.suppressed_classes.clear();
     }
@@ -660,61 +808,22 @@ namespace element {
 namespace save_video {
 
 void SaveVideo::cleanupLoop() {
-  using fs_entry = std::pair<fs::path, std::filesystem::file_time_type>;
   while (cleanup_running_) {
     try {
       // 1) 按天清理
       if (retention_days_ > 0) {
-        auto cutoff = std::chrono::system_clock::now() - std::chrono::hours(24 * retention_days_);
-        auto cutoff_fs = std::chrono::time_point_cast<std::filesystem::file_time_type::duration>(
-            std::filesystem::file_time_type::clock::now() + (cutoff - std::chrono::system_clock::now()));
-
-        for (auto& dir_entry : fs::recursive_directory_iterator(save_dir_)) {
-          if (!dir_entry.is_regular_file()) continue;
-          auto p = dir_entry.path();
-          auto ext = p.extension().string();
-          if (!(ext == ".mp4" || ext == ".jpg" || ext == ".jpeg")) continue;
-          std::error_code ec;
-          auto ft = fs::last_write_time(p, ec);
-          if (ec) continue;
-          if (ft < cutoff_fs) {
-            fs::remove(p, ec);
-          }
-        }
+        auto cutoff = std::chrono::time_point_cast<RecordingIndex::FileTime::duration>(
+            RecordingIndex::FileTime::clock::now() - std::chrono::hours(24 * retention_days_));
+        int removed = index_.removeOlderThan(cutoff);
+        if (removed > 0) IVS_INFO("save_video: removed {0} expired files", removed);
       }
 
       // 2) 容量清理（删除最旧文件直到低于阈值）
       if (retention_max_gb_ > 0.0) {
-        uintmax_t total_bytes = 0;
-        std::vector<fs_entry> files;
-        for (auto& dir_entry : fs::recursive_directory_iterator(save_dir_)) {
-          if (!dir_entry.is_regular_file()) continue;
-          auto p = dir_entry.path();
-          auto ext = p.extension().string();
-          if (!(ext == ".mp4" || ext == ".jpg" || ext == ".jpeg")) continue;
-          std::error_code ec;
-          auto sz = fs::file_size(p, ec);
-          if (ec) continue;
-          total_bytes += sz;
-          auto ft = fs::last_write_time(p, ec);
-          if (ec) continue;
-          files.emplace_back(p, ft);
-        }
-        const double total_gb = (double)total_bytes / (1024.0 * 1024.0 * 1024.0);
-        if (total_gb > retention_max_gb_) {
-          std::sort(files.begin(), files.end(), [](const fs_entry& a, const fs_entry& b) {
-            return a.second < b.second;  // old first
-          });
-          std::error_code ec;
-          for (auto& f : files) {
-            auto sz = fs::file_size(f.first, ec);
-            fs::remove(f.first, ec);
-            if (!ec && sz > 0) {
-              total_bytes = (sz > total_bytes) ? 0 : (total_bytes - sz);
-            }
-            double gb = (double)total_bytes / (1024.0 * 1024.0 * 1024.0);
-            if (gb <= retention_max_gb_) break;
-          }
+        auto max_bytes = static_cast<std::uintmax_t>(retention_max_gb_ * 1024.0 * 1024.0 * 1024.0);
+        int removed = index_.shrinkTo(max_bytes);
+        if (removed > 0) {
+          IVS_INFO("save_video: removed {0} oldest files, {1} bytes left", removed, index_.totalBytes());
         }
       }
     } catch (...) {
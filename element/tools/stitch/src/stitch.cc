@@ -27,6 +27,7 @@ common::ErrorCode Stitch::initInternal(const std::string& json) {
   }
   mFpsProfiler.config("stitch fps:", 100);
   stitch_mode = configure.find(CONFIG_INTERNAL_STITCH_MODE_FILED)->get<std::string>();
+  setInputSyncConfig(common::InputSynchronizer::parseConfig(configure));
   
 
   return common::ErrorCode::SUCCESS;
@@ -89,6 +90,8 @@ common::ErrorCode Stitch::stitch_work(std::shared_ptr<common::ObjectMetadata> le
   stitchObj->mFrame->mHeight = stitchObj->mFrame->mSpData->height;
   stitchObj->mFrame->mChannelId = leftObj->mFrame->mChannelId;
   stitchObj->mFrame->mFrameId = leftObj->mFrame->mFrameId;
+  stitchObj->mFrame->mTimestamp = leftObj->mFrame->mTimestamp;
+  stitchObj->mFrame->mPts = leftObj->mFrame->mPts;
 
 
   return common::ErrorCode::SUCCESS;
@@ -102,30 +105,23 @@ common::ErrorCode Stitch::doWork(int dataPipeId) {
     outputPort = outputPorts[0];
   }
 
+  // 按帧号或pts对齐各输入，某一路丢帧时丢弃另一路的对应帧
   common::ObjectMetadatas inputs;
-
-  for (auto inputPort : inputPorts) {
-    auto data = popInputData(inputPort, dataPipeId);
-    while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      data = popInputData(inputPort, dataPipeId);
-    }
-    if (data == nullptr) return common::ErrorCode::SUCCESS;
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    inputs.emplace_back(objectMetadata);
+  if (!popSyncedInputData(dataPipeId, inputs)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return common::ErrorCode::SUCCESS;
+  }
+  for (int i = 0; i < inputs.size(); ++i) {
     IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}",
-              inputPort, objectMetadata->mFrame->mChannelId,
-              objectMetadata->mFrame->mFrameId);
+              inputPorts[i], inputs[i]->mFrame->mChannelId,
+              inputs[i]->mFrame->mFrameId);
   }
 
   if (inputs[0]->mFrame->mSpData != nullptr &&
-      inputs[1]->mFrame->mSpData != nullptr &&
-      inputs[0]->mFrame->mFrameId == inputs[1]->mFrame->mFrameId) {
+      inputs[1]->mFrame->mSpData != nullptr) {
     std::shared_ptr<common::ObjectMetadata> stitchObj =
-        std::make_shared<common::ObjectMetadata>();
-    stitchObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
+        common::makePooled<common::ObjectMetadata>();
+    stitchObj->mFrame = common::makePooled<common::Frame>();
 
     stitch_work(inputs[0], inputs[1], stitchObj);
 
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <map>
+
+#include "bmlib_runtime.h"
+#include "common/device_backend.h"
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+class BmDeviceBackend : public DeviceBackend {
+ public:
+  ~BmDeviceBackend() override {
+    for (auto& handle : mHandles) bm_dev_free(handle.second);
+  }
+
+  int getDeviceCount() override {
+    int count = 0;
+    if (BM_SUCCESS != bm_dev_getcount(&count)) return 0;
+    return count;
+  }
+
+  bool queryStatus(int devId, DeviceStatus& status) override {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto handleIt = mHandles.find(devId);
+    if (mHandles.end() == handleIt) {
+      bm_handle_t handle;
+      if (BM_SUCCESS != bm_dev_request(&handle, devId)) {
+        IVS_ERROR("Request device {0} failed", devId);
+        return false;
+      }
+      handleIt = mHandles.emplace(devId, handle).first;
+    }
+
+    bm_dev_stat_t stat;
+    if (BM_SUCCESS != bm_get_stat(handleIt->second, &stat)) return false;
+    status.mDeviceId = devId;
+    status.mUtilization = stat.tpu_util / 100.f;
+    // bm_get_stat的内存单位为MB
+    status.mMemUsedBytes = (std::size_t)stat.mem_used << 20;
+    status.mMemTotalBytes = (std::size_t)stat.mem_total << 20;
+    return true;
+  }
+
+ private:
+  std::mutex mMutex;
+  std::map<int /* device id */, bm_handle_t> mHandles;
+};
+
+std::shared_ptr<DeviceBackend> makeBmDeviceBackend() {
+  return std::make_shared<BmDeviceBackend>();
+}
+
+std::shared_ptr<DeviceBackend> makeDeviceBackend(const std::string& name,
+                                                 int deviceCount) {
+  if ("bm" == name) return makeBmDeviceBackend();
+  if ("mock" == name) return std::make_shared<MockDeviceBackend>(deviceCount);
+  return nullptr;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -95,6 +95,7 @@ inline std::string concatArgs(const T& arg, const Args&... args) {
     std::string msg = concatArgs(__VA_ARGS__);                                \
     std::string error_msg =                                                   \
         "Expected " #cond " to be true, but got false. " + (msg);             \
+    Logger::drain();                                                          \
     std::cerr << "\033[0;31m" << "[STREAM_CHECK_ERROR] " << "\033[0m" << "\t" \
               << __FILE__ << ": " << __LINE__ << std::endl;                   \
     std::cerr << "\033[0;31m" << "[STREAM_CHECK_MESSAGE] " << "\033[0m"       \
@@ -206,4 +206,31 @@ int save_frame_to_yuv(bm_handle_t& handle, AVFrame* frame, const char* filename,
 
   fclose(file);
   return 0;
-}
\ No newline at end of file
+}
+
+std::vector<std::shared_ptr<bm_image>> crop_images(
+    bm_handle_t handle, bm_image& src, const std::vector<bmcv_rect_t>& rects) {
+  std::vector<std::shared_ptr<bm_image>> cropped;
+  if (rects.empty()) return cropped;
+  std::vector<bm_image> outputs(rects.size());
+  for (size_t i = 0; i < rects.size(); ++i) {
+    bm_image_create(handle, rects[i].crop_h, rects[i].crop_w,
+                    src.image_format, src.data_type, &outputs[i]);
+  }
+  // bmcv接口的参数不是const，但不会修改裁剪区域
+  bm_status_t ret = bmcv_image_crop(
+      handle, rects.size(), const_cast<bmcv_rect_t*>(rects.data()), src,
+      outputs.data());
+  for (auto& output : outputs) {
+    cropped.emplace_back(new bm_image(output), [](bm_image* p) {
+      bm_image_destroy(*p);
+      delete p;
+      p = nullptr;
+    });
+  }
+  if (BM_SUCCESS != ret) {
+    IVS_ERROR("Bmcv crop {0} rects failed, ret = {1}", rects.size(), ret);
+    cropped.clear();
+  }
+  return cropped;
+}
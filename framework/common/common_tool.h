@@ -11,10 +11,21 @@
 #ifndef SOPHON_STREAM_COMMON_TOOL_H_
 #define SOPHON_STREAM_COMMON_TOOL_H_
 
+#include <memory>
+#include <vector>
+
 #include "common/common_defs.h"
 #include "opencv2/opencv.hpp"
 
 int save_frame_to_yuv(bm_handle_t& handle, AVFrame* frame, const char* filename,
                       bool data_on_device_mem = true);
 
+/**
+ * @brief 一次bmcv调用从src裁剪出多个区域，输出的格式、数据类型与src相同
+ * @param rects 裁剪区域，需要在src范围内
+ * @return 与rects一一对应的图像，裁剪失败时返回空vector
+ */
+std::vector<std::shared_ptr<bm_image>> crop_images(
+    bm_handle_t handle, bm_image& src, const std::vector<bmcv_rect_t>& rects);
+
 #endif  // SOPHON_STREAM_COMMON_TOOL_H_
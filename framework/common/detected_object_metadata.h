@@ -43,7 +43,8 @@ struct PointMetadata {
 };
 
 struct DetectedObjectMetadata {
-  DetectedObjectMetadata() : mClassify(-1), mTrackIouThreshold(0.f) {}
+  DetectedObjectMetadata()
+      : mClassify(-1), mTrackIouThreshold(0.f), mDepth(-1.f) {}
 
   int getLabel() const {
     if (mTopKLabels.empty()) {
@@ -73,6 +74,9 @@ struct DetectedObjectMetadata {
   std::string mClassifyName;
   float mTrackIouThreshold;
   std::vector<std::shared_ptr<PointMetadata> > mKeyPoints;
+  // 框内的中值深度，由立体匹配element填写（未配置depth_scale时为视差，
+  // 单位像素），未计算时为-1
+  float mDepth;
 };
 
 }  // namespace common
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/detection_scheduler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+DetectionScheduler::Config DetectionScheduler::parseConfig(
+    const nlohmann::json& configure) {
+  Config config;
+  auto intervalIt = configure.find(CONFIG_INTERNAL_DETECT_INTERVAL_FIELD);
+  if (configure.end() != intervalIt && intervalIt->is_number_integer())
+    config.interval = std::max(1, intervalIt->get<int>());
+  auto motionIt = configure.find(CONFIG_INTERNAL_MOTION_THRESHOLD_FIELD);
+  if (configure.end() != motionIt && motionIt->is_number())
+    config.motionThreshold = std::max(0.f, motionIt->get<float>());
+  return config;
+}
+
+DetectionScheduler::DetectionScheduler(const Config& config)
+    : mConfig(config) {}
+
+DetectionScheduler::~DetectionScheduler() {
+  for (auto& channel : mChannels) {
+    if (channel.second.thumbValid) bm_image_destroy(channel.second.thumb);
+  }
+}
+
+bool DetectionScheduler::shouldDetect(const ObjectMetadata& objectMetadata) {
+  if (!enabled()) return true;
+  const Frame& frame = *objectMetadata.mFrame;
+  if (frame.mEndOfStream || frame.mSpData == nullptr) return true;
+
+  // 同一channel固定由一个线程处理，只有查找状态需要加锁
+  ChannelState* state = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    state = &mChannels[frame.mChannelIdInternal];
+  }
+
+  // 首帧或帧号回退（重连、循环播放）时立即检测
+  bool detect = state->lastFrameId < 0 || frame.mFrameId <= state->lastFrameId;
+  if (detect) state->reference.clear();
+  state->lastFrameId = frame.mFrameId;
+  if (state->sinceDetect + 1 >= mConfig.interval) detect = true;
+
+  if (mConfig.motionThreshold > 0.f) {
+    float score = motionScore(frame, *state);
+    if (score > mConfig.motionThreshold) detect = true;
+    if (detect) state->reference.swap(state->current);
+  }
+  state->sinceDetect = detect ? 0 : state->sinceDetect + 1;
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++(detect ? mDetected : mSkipped);
+  if ((mDetected + mSkipped) % REPORT_INTERVAL == 0) {
+    IVS_INFO("DetectionScheduler: detected {0}, skipped {1}", mDetected,
+             mSkipped);
+  }
+  return detect;
+}
+
+float DetectionScheduler::motionScore(const Frame& frame,
+                                      ChannelState& state) {
+  if (!state.thumbValid) {
+    bm_image_create(frame.mHandle, THUMB_H, THUMB_W, FORMAT_GRAY,
+                    DATA_TYPE_EXT_1N_BYTE, &state.thumb);
+    auto ret = bm_image_alloc_dev_mem_heap_mask(state.thumb,
+                                                STREAM_VPP_HEAP_MASK);
+    STREAM_CHECK(BM_SUCCESS == ret, "Alloc Device Memory Failed!");
+    state.thumbValid = true;
+  }
+  // 缩略图只用于比较画面变化，失败时按画面变化处理，立即检测
+  if (BM_SUCCESS !=
+      bmcv_image_vpp_convert(frame.mHandle, 1, *frame.mSpData, &state.thumb))
+    return FLT_MAX;
+  state.current.resize(THUMB_W * THUMB_H);
+  void* buffers[1] = {state.current.data()};
+  if (BM_SUCCESS != bm_image_copy_device_to_host(state.thumb, buffers))
+    return FLT_MAX;
+
+  if (state.reference.size() != state.current.size()) return FLT_MAX;
+  int sum = 0;
+  for (size_t i = 0; i < state.current.size(); ++i)
+    sum += std::abs(state.current[i] - state.reference[i]);
+  return (float)sum / state.current.size();
+}
+
+}  // namespace common
+}  // namespace sophon_stream
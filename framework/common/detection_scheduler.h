@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DETECTION_SCHEDULER_H_
+#define SOPHON_STREAM_COMMON_DETECTION_SCHEDULER_H_
+
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "no_copyable.h"
+#include "object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 检测调度：每个channel每隔若干帧运行一次检测，
+ * 画面变化明显（运动或切换场景）时提前检测。
+ * @brief
+ * 跳过检测的帧由检测element直接透传并置mDetectionSkipped，
+ * 跟踪element在这些帧上用运动模型外推已有轨迹。线程安全
+ */
+class DetectionScheduler : public ::sophon_stream::common::NoCopyable {
+ public:
+  struct Config {
+    int interval = 1;             // 每interval帧检测一次，1为每帧检测
+    float motionThreshold = 0.f;  // 缩略图平均灰度差超过该值时检测，0为不检测
+  };
+
+  static constexpr const char* CONFIG_INTERNAL_DETECT_INTERVAL_FIELD =
+      "detect_interval";
+  static constexpr const char* CONFIG_INTERNAL_MOTION_THRESHOLD_FIELD =
+      "motion_threshold";
+
+  /**
+   * @brief 从element的configure中读取detect_interval、motion_threshold，
+   * 都不配置时每帧检测，与旧行为一致
+   */
+  static Config parseConfig(const nlohmann::json& configure);
+
+  explicit DetectionScheduler(const Config& config);
+  ~DetectionScheduler();
+
+  bool enabled() const { return mConfig.interval > 1; }
+
+  /**
+   * @brief 该帧是否需要运行检测，每帧调用且只调用一次
+   */
+  bool shouldDetect(const ObjectMetadata& objectMetadata);
+
+ private:
+  struct ChannelState {
+    int sinceDetect = 0;         // 距上次检测的帧数
+    std::int64_t lastFrameId = -1;
+    bm_image thumb;              // 灰度缩略图，设备内存在帧之间复用
+    bool thumbValid = false;
+    std::vector<uint8_t> reference;  // 上次检测时的缩略图
+    std::vector<uint8_t> current;
+  };
+
+  /**
+   * @brief 计算当前帧缩略图与上次检测时的平均灰度差
+   */
+  float motionScore(const Frame& frame, ChannelState& state);
+
+  static constexpr const int THUMB_W = 64;
+  static constexpr const int THUMB_H = 36;
+  static constexpr const uint64_t REPORT_INTERVAL = 1000;
+
+  Config mConfig;
+  std::mutex mMutex;
+  std::map<int /* channelIdInternal */, ChannelState> mChannels;
+  uint64_t mDetected = 0;
+  uint64_t mSkipped = 0;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DETECTION_SCHEDULER_H_
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
+#define SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detected_object_metadata.h"
+#include "graphics.h"
+#include "tracked_object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 按列连续存放一帧检测结果的表（structure of arrays），第i行对应
+ * mDetectedObjectMetadatas[i]
+ * @brief 跟踪、过滤等只关心框/分数/类别的element顺序扫描各列即可，
+ * 不需要逐个访问DetectedObjectMetadata
+ */
+struct DetectionTable {
+  std::size_t size() const { return mScore.size(); }
+  bool empty() const { return mScore.empty(); }
+
+  void reserve(std::size_t rows) {
+    mX.reserve(rows);
+    mY.reserve(rows);
+    mWidth.reserve(rows);
+    mHeight.reserve(rows);
+    mScore.reserve(rows);
+    mClassId.reserve(rows);
+    mTrackId.reserve(rows);
+  }
+
+  /**
+   * @brief 清空所有行，保留各列已申请的容量
+   */
+  void clear() {
+    mX.clear();
+    mY.clear();
+    mWidth.clear();
+    mHeight.clear();
+    mScore.clear();
+    mClassId.clear();
+    mTrackId.clear();
+    for (auto& attribute : mAttributes) attribute.second.clear();
+  }
+
+  /**
+   * @brief 追加一行，返回行号；属性列补0
+   */
+  std::size_t addRow(const Rectangle<int>& box, float score, int classId,
+                     long long trackId = -1) {
+    mX.push_back(box.mX);
+    mY.push_back(box.mY);
+    mWidth.push_back(box.mWidth);
+    mHeight.push_back(box.mHeight);
+    mScore.push_back(score);
+    mClassId.push_back(classId);
+    mTrackId.push_back(trackId);
+    for (auto& attribute : mAttributes) attribute.second.resize(size(), 0.f);
+    return size() - 1;
+  }
+
+  Rectangle<int> box(std::size_t row) const {
+    return Rectangle<int>(mX[row], mY[row], mWidth[row], mHeight[row]);
+  }
+
+  /**
+   * @brief 只保留keep[i]为true的行，各列原地压缩
+   */
+  void keepRows(const std::vector<bool>& keep) {
+    std::size_t dst = 0;
+    for (std::size_t src = 0; src < size(); ++src) {
+      if (!keep[src]) continue;
+      mX[dst] = mX[src];
+      mY[dst] = mY[src];
+      mWidth[dst] = mWidth[src];
+      mHeight[dst] = mHeight[src];
+      mScore[dst] = mScore[src];
+      mClassId[dst] = mClassId[src];
+      mTrackId[dst] = mTrackId[src];
+      for (auto& attribute : mAttributes)
+        attribute.second[dst] = attribute.second[src];
+      ++dst;
+    }
+    mX.resize(dst);
+    mY.resize(dst);
+    mWidth.resize(dst);
+    mHeight.resize(dst);
+    mScore.resize(dst);
+    mClassId.resize(dst);
+    mTrackId.resize(dst);
+    for (auto& attribute : mAttributes) attribute.second.resize(dst);
+  }
+
+  /**
+   * @brief 由旧接口的检测、跟踪结果重建整张表，trackeds可以为空
+   */
+  void assign(
+      const std::vector<std::shared_ptr<DetectedObjectMetadata>>& detecteds,
+      const std::vector<std::shared_ptr<TrackedObjectMetadata>>& trackeds) {
+    clear();
+    reserve(detecteds.size());
+    bool hasTrack = trackeds.size() == detecteds.size();
+    for (std::size_t i = 0; i < detecteds.size(); ++i) {
+      float score =
+          detecteds[i]->mScores.empty() ? 0.f : detecteds[i]->mScores[0];
+      addRow(detecteds[i]->mBox, score, detecteds[i]->mClassify,
+             hasTrack ? trackeds[i]->mTrackId : -1);
+    }
+  }
+
+  std::vector<int> mX;
+  std::vector<int> mY;
+  std::vector<int> mWidth;
+  std::vector<int> mHeight;
+  std::vector<float> mScore;
+  std::vector<int> mClassId;
+  std::vector<long long> mTrackId;  // 未跟踪时为-1
+  std::map<std::string, std::vector<float>> mAttributes;  // 自定义属性列
+  std::uint64_t mVersion = 0;  // 对应ObjectMetadata::mDetectionVersion
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DETECTION_TABLE_H_
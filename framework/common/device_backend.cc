@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/device_backend.h"
+
+namespace sophon_stream {
+namespace common {
+
+MockDeviceBackend::MockDeviceBackend(int deviceCount) {
+  for (int i = 0; i < deviceCount; ++i) {
+    DeviceStatus status;
+    status.mDeviceId = i;
+    mStatus.push_back(status);
+  }
+}
+
+int MockDeviceBackend::getDeviceCount() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStatus.size();
+}
+
+bool MockDeviceBackend::queryStatus(int devId, DeviceStatus& status) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (devId < 0 || devId >= (int)mStatus.size()) return false;
+  status = mStatus[devId];
+  return true;
+}
+
+void MockDeviceBackend::setStatus(const DeviceStatus& status) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (status.mDeviceId < 0 || status.mDeviceId >= (int)mStatus.size()) return;
+  mStatus[status.mDeviceId] = status;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
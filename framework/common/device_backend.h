@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DEVICE_BACKEND_H_
+#define SOPHON_STREAM_COMMON_DEVICE_BACKEND_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+struct DeviceStatus {
+  int mDeviceId = -1;
+  float mUtilization = 0.f;  // TPU占用率，0~1
+  std::size_t mMemUsedBytes = 0;
+  std::size_t mMemTotalBytes = 0;
+};
+
+/**
+ * @brief 查询设备数量和设备状态，供DeviceScheduler做码流放置。
+ * @brief 实现需要线程安全
+ */
+class DeviceBackend : public ::sophon_stream::common::NoCopyable {
+ public:
+  virtual ~DeviceBackend() = default;
+
+  virtual int getDeviceCount() = 0;
+
+  /**
+   * @return 设备不存在或查询失败时返回false
+   */
+  virtual bool queryStatus(int devId, DeviceStatus& status) = 0;
+};
+
+/**
+ * @brief 模拟设备，状态由调用者注入，用于在没有TPU的主机上验证放置和再均衡逻辑
+ */
+class MockDeviceBackend : public DeviceBackend {
+ public:
+  explicit MockDeviceBackend(int deviceCount);
+
+  int getDeviceCount() override;
+  bool queryStatus(int devId, DeviceStatus& status) override;
+
+  /**
+   * @brief 设置status.mDeviceId对应设备的状态
+   */
+  void setStatus(const DeviceStatus& status);
+
+ private:
+  std::mutex mMutex;
+  std::vector<DeviceStatus> mStatus;
+};
+
+/**
+ * @brief 通过bmlib查询TPU占用率和设备内存
+ */
+std::shared_ptr<DeviceBackend> makeBmDeviceBackend();
+
+/**
+ * @brief 按名字创建设备后端："bm"或"mock"，其他名字返回nullptr
+ * @param deviceCount mock后端的设备数
+ */
+std::shared_ptr<DeviceBackend> makeDeviceBackend(const std::string& name,
+                                                 int deviceCount);
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DEVICE_BACKEND_H_
@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/device_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+DeviceScheduler::Config DeviceScheduler::parseConfig(
+    const nlohmann::json& configure) {
+  Config config;
+  if (!configure.is_object()) return config;
+  auto backlogIt = configure.find(CONFIG_INTERNAL_BACKLOG_THRESHOLD_FIELD);
+  if (configure.end() != backlogIt && backlogIt->is_number_integer())
+    config.backlogThreshold = std::max(1, backlogIt->get<int>());
+  auto utilIt = configure.find(CONFIG_INTERNAL_UTILIZATION_THRESHOLD_FIELD);
+  if (configure.end() != utilIt && utilIt->is_number())
+    config.utilizationThreshold = std::max(0.f, utilIt->get<float>());
+  auto samplesIt = configure.find(CONFIG_INTERNAL_BEHIND_SAMPLES_FIELD);
+  if (configure.end() != samplesIt && samplesIt->is_number_integer())
+    config.behindSamples = std::max(1, samplesIt->get<int>());
+  auto intervalIt = configure.find(CONFIG_INTERNAL_SAMPLE_INTERVAL_FIELD);
+  if (configure.end() != intervalIt && intervalIt->is_number_integer())
+    config.sampleIntervalMs = std::max(10, intervalIt->get<int>());
+  return config;
+}
+
+DeviceScheduler::DeviceScheduler(const Config& config,
+                                 std::shared_ptr<DeviceBackend> backend)
+    : mConfig(config), mBackend(backend) {}
+
+void DeviceScheduler::addReplica(int graphId, int devId, BacklogProbe probe) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Replica replica;
+  replica.status.mGraphId = graphId;
+  replica.status.mDeviceId = devId;
+  replica.probe = probe;
+  mReplicas.push_back(replica);
+}
+
+void DeviceScheduler::sample() {
+  // 探针和设备查询可能较慢，不在锁内调用
+  std::vector<Replica> replicas;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    replicas = mReplicas;
+  }
+  std::vector<int> backlogs;
+  std::map<int /* device id */, DeviceStatus> devices;
+  for (auto& replica : replicas) {
+    backlogs.push_back(replica.probe ? replica.probe() : 0);
+    int devId = replica.status.mDeviceId;
+    DeviceStatus status;
+    if (devices.end() == devices.find(devId) && mBackend &&
+        mBackend->queryStatus(devId, status))
+      devices[devId] = status;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (std::size_t i = 0; i < backlogs.size(); ++i) {
+    Replica& replica = mReplicas[i];
+    ReplicaStatus& status = replica.status;
+    auto deviceIt = devices.find(status.mDeviceId);
+    if (devices.end() != deviceIt) {
+      float utilization = deviceIt->second.mUtilization;
+      status.mUtilization = status.mUtilization < 0.f
+                                ? utilization
+                                : 0.5f * (status.mUtilization + utilization);
+      status.mMemUsedBytes = deviceIt->second.mMemUsedBytes;
+      status.mMemTotalBytes = deviceIt->second.mMemTotalBytes;
+    } else {
+      status.mUtilization = -1.f;
+    }
+    status.mBacklog = backlogs[i];
+    replica.pending = 0;
+
+    bool over = status.mBacklog >= mConfig.backlogThreshold ||
+                status.mUtilization >= mConfig.utilizationThreshold;
+    if (over) {
+      if (++replica.overSamples >= mConfig.behindSamples && !status.mBehind) {
+        status.mBehind = true;
+        IVS_WARN(
+            "Graph {0} on device {1} falls behind, backlog {2}, utilization "
+            "{3:.2f}, new channels go to other devices",
+            status.mGraphId, status.mDeviceId, status.mBacklog,
+            status.mUtilization);
+      }
+      continue;
+    }
+    replica.overSamples = 0;
+    // 积压降到阈值一半以下、占用率明显回落后才恢复，避免来回切换
+    if (status.mBehind && status.mBacklog <= mConfig.backlogThreshold / 2 &&
+        status.mUtilization < mConfig.utilizationThreshold - 0.1f) {
+      status.mBehind = false;
+      IVS_INFO("Graph {0} on device {1} caught up, accepting new channels",
+               status.mGraphId, status.mDeviceId);
+    }
+  }
+}
+
+float DeviceScheduler::estimateLoad(const Replica& replica,
+                                    float perChannel) const {
+  float utilization = std::max(0.f, replica.status.mUtilization);
+  int measured = replica.status.mChannels - replica.pending;
+  if (measured > 0 && utilization > 0.f) perChannel = utilization / measured;
+  return utilization + perChannel * replica.pending;
+}
+
+int DeviceScheduler::assign(int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mReplicas.empty()) return -1;
+  auto channelIt = mChannels.find(channelId);
+  if (mChannels.end() != channelIt)
+    return mReplicas[channelIt->second].status.mGraphId;
+
+  // 已采样到的每路码流平均占用率，估计还没有采样数据的副本上新码流的负载
+  float utilizationSum = 0.f;
+  int channelSum = 0;
+  for (auto& replica : mReplicas) {
+    int measured = replica.status.mChannels - replica.pending;
+    if (replica.status.mUtilization > 0.f && measured > 0) {
+      utilizationSum += replica.status.mUtilization;
+      channelSum += measured;
+    }
+  }
+  float perChannel = channelSum > 0 ? utilizationSum / channelSum : 0.f;
+
+  bool allBehind = std::all_of(
+      mReplicas.begin(), mReplicas.end(),
+      [](const Replica& replica) { return replica.status.mBehind; });
+  int best = -1;
+  float bestLoad = 0.f;
+  for (int i = 0; i < (int)mReplicas.size(); ++i) {
+    const Replica& replica = mReplicas[i];
+    if (replica.status.mBehind && !allBehind) continue;
+    float load = estimateLoad(replica, perChannel);
+    if (best >= 0) {
+      const ReplicaStatus& bestStatus = mReplicas[best].status;
+      if (load > bestLoad + LOAD_EPSILON) continue;
+      if (std::fabs(load - bestLoad) <= LOAD_EPSILON &&
+          (replica.status.mChannels > bestStatus.mChannels ||
+           (replica.status.mChannels == bestStatus.mChannels &&
+            replica.status.mBacklog >= bestStatus.mBacklog)))
+        continue;
+    }
+    best = i;
+    bestLoad = load;
+  }
+
+  Replica& replica = mReplicas[best];
+  replica.status.mChannels++;
+  replica.pending++;
+  mChannels[channelId] = best;
+  if (allBehind) {
+    IVS_WARN("All replicas are behind, channel {0} goes to graph {1}",
+             channelId, replica.status.mGraphId);
+  }
+  IVS_INFO("Assign channel {0} to graph {1} on device {2}, load {3:.2f}",
+           channelId, replica.status.mGraphId, replica.status.mDeviceId,
+           bestLoad);
+  return replica.status.mGraphId;
+}
+
+int DeviceScheduler::release(int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (mChannels.end() == channelIt) return -1;
+  Replica& replica = mReplicas[channelIt->second];
+  replica.status.mChannels--;
+  replica.pending = std::min(replica.pending, replica.status.mChannels);
+  mChannels.erase(channelIt);
+  return replica.status.mGraphId;
+}
+
+std::vector<DeviceScheduler::ReplicaStatus> DeviceScheduler::getStatus() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::vector<ReplicaStatus> status;
+  for (auto& replica : mReplicas) status.push_back(replica.status);
+  return status;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DEVICE_SCHEDULER_H_
+#define SOPHON_STREAM_COMMON_DEVICE_SCHEDULER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "device_backend.h"
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 一个graph按device_ids复制到多张卡上后，为码流选择副本。
+ * @brief
+ * 周期采样各设备的TPU占用率和各副本输入队列的积压，新码流放到估计负载最低的
+ * 副本上。副本连续若干次采样积压或占用率超过阈值时视为跟不上，之后的新码流
+ * 改放到其他设备，已有码流不迁移。线程安全
+ */
+class DeviceScheduler : public ::sophon_stream::common::NoCopyable {
+ public:
+  struct Config {
+    int backlogThreshold = 20;           // 副本输入队列积压的数据条数阈值
+    float utilizationThreshold = 0.95f;  // TPU占用率阈值
+    int behindSamples = 3;               // 连续超过阈值的采样次数
+    int sampleIntervalMs = 1000;         // 采样周期
+  };
+
+  struct ReplicaStatus {
+    int mGraphId = -1;
+    int mDeviceId = -1;
+    float mUtilization = -1.f;  // 滑动平均的TPU占用率，查询失败为-1
+    std::size_t mMemUsedBytes = 0;
+    std::size_t mMemTotalBytes = 0;
+    int mBacklog = 0;   // 输入队列中积压的数据条数
+    int mChannels = 0;  // 分配到该副本的码流数
+    bool mBehind = false;
+  };
+
+  /**
+   * @brief 返回副本当前积压的数据条数
+   */
+  using BacklogProbe = std::function<int()>;
+
+  static constexpr const char* CONFIG_INTERNAL_BACKLOG_THRESHOLD_FIELD =
+      "backlog_threshold";
+  static constexpr const char* CONFIG_INTERNAL_UTILIZATION_THRESHOLD_FIELD =
+      "utilization_threshold";
+  static constexpr const char* CONFIG_INTERNAL_BEHIND_SAMPLES_FIELD =
+      "behind_samples";
+  static constexpr const char* CONFIG_INTERNAL_SAMPLE_INTERVAL_FIELD =
+      "sample_interval_ms";
+
+  /**
+   * @brief 从graph配置的sharding字段读取阈值，未配置的项取默认值
+   */
+  static Config parseConfig(const nlohmann::json& configure);
+
+  DeviceScheduler(const Config& config,
+                  std::shared_ptr<DeviceBackend> backend);
+
+  const Config& getConfig() const { return mConfig; }
+
+  void addReplica(int graphId, int devId, BacklogProbe probe);
+
+  /**
+   * @brief 采样设备状态和副本积压，更新落后标记
+   */
+  void sample();
+
+  /**
+   * @brief 为码流选择副本，返回副本的graph id；已分配的码流返回原副本
+   */
+  int assign(int channelId);
+
+  /**
+   * @brief 码流停止时调用，返回其所在副本的graph id，未分配时返回-1
+   */
+  int release(int channelId);
+
+  std::vector<ReplicaStatus> getStatus();
+
+ private:
+  struct Replica {
+    ReplicaStatus status;
+    BacklogProbe probe;
+    int overSamples = 0;  // 连续超过阈值的采样次数
+    int pending = 0;      // 上次采样之后新分配的码流，占用率中还未体现
+  };
+
+  /**
+   * @brief 占用率加上新分配码流的估计负载
+   */
+  float estimateLoad(const Replica& replica, float perChannel) const;
+
+  // 估计负载相差在该值以内时视为相同，按码流数和积压分配
+  static constexpr const float LOAD_EPSILON = 0.02f;
+
+  Config mConfig;
+  std::shared_ptr<DeviceBackend> mBackend;
+  std::mutex mMutex;
+  std::vector<Replica> mReplicas;
+  std::map<int /* channel id */, int /* replica index */> mChannels;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DEVICE_SCHEDULER_H_
@@ -15,6 +15,8 @@
 #include <memory>
 
 #include "bmcv_api_ext.h"
+#include "memory_budget.h"
+#include "preprocess_cache.h"
 #include "opencv2/opencv.hpp"
 // #include "bmlib_runtime.h"
 
@@ -38,6 +40,7 @@ struct Frame {
         mFormatType(FORMAT_YUV420P),
         mDataType(DATA_TYPE_EXT_1N_BYTE),
         mTimestamp(0),
+        mPts(NO_PTS),
         mEndOfStream(false),
         mChannel(0),
         mChannelStep(0),
@@ -47,6 +50,8 @@ struct Frame {
         mHeightStep(0),
         mDataSize(0) {}
 
+  static constexpr std::int64_t NO_PTS = INT64_MIN;
+
   bool empty() const {
     return 0 == mChannel || 0 == mChannelStep || 0 == mWidth ||
            0 == mWidthStep || 0 == mHeight || 0 == mHeightStep ||
@@ -62,6 +67,8 @@ struct Frame {
   bm_image_data_format_ext mDataType;
   Rational mFrameRate;
   std::int64_t mTimestamp;
+  // 码流中的显示时间戳，按流的time_base换算为微秒；图片等没有时间戳时为NO_PTS
+  std::int64_t mPts;
   bool mEndOfStream;
 
   std::string mSide;
@@ -78,6 +85,10 @@ struct Frame {
   std::shared_ptr<bm_image> mSpDataOsd;
   std::shared_ptr<bm_image> mSpDataDwa;
   std::shared_ptr<bm_image> mSpDataDpu;
+  // 帧在MemoryBudget中的记账，Frame析构时归还
+  std::shared_ptr<MemoryCharge> mMemoryCharge;
+  // 多个模型共用的前处理结果
+  PreprocessCache mPreprocessCache;
   cv::Mat mMat; //When a bm_image is generated by toBMI, you should store the source mat in mMat, because the device memory of bm_image will be released along with the deconstruction of source mat.
 };
 
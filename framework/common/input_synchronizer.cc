@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/input_synchronizer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+InputSynchronizer::Config InputSynchronizer::parseConfig(
+    const nlohmann::json& configure) {
+  Config config;
+  auto syncByIt = configure.find(CONFIG_INTERNAL_SYNC_BY_FIELD);
+  if (configure.end() != syncByIt && syncByIt->is_string()) {
+    std::string syncBy = syncByIt->get<std::string>();
+    if ("pts" == syncBy) {
+      config.by = SyncBy::PTS;
+    } else if ("frame_id" != syncBy) {
+      IVS_WARN("Unknown sync_by: {0}, use frame_id", syncBy);
+    }
+  }
+  auto toleranceIt = configure.find(CONFIG_INTERNAL_SYNC_TOLERANCE_MS_FIELD);
+  if (configure.end() != toleranceIt && toleranceIt->is_number()) {
+    double toleranceMs = std::max(0.0, toleranceIt->get<double>());
+    config.tolerance = SyncBy::PTS == config.by
+                           ? static_cast<int64_t>(toleranceMs * 1000)
+                           : 0;
+  } else if (SyncBy::PTS == config.by) {
+    config.tolerance = 20 * 1000;
+  }
+  auto windowIt = configure.find(CONFIG_INTERNAL_SYNC_WINDOW_FIELD);
+  if (configure.end() != windowIt && windowIt->is_number_integer()) {
+    config.window = std::max(1, windowIt->get<int>());
+  }
+  return config;
+}
+
+InputSynchronizer::InputSynchronizer(int portNum, const Config& config,
+                                     const std::string& name)
+    : mConfig(config),
+      mName(name),
+      mQueues(portNum),
+      mLastKeys(portNum, std::numeric_limits<int64_t>::min()) {
+  mStats.dropped.resize(portNum, 0);
+}
+
+int64_t InputSynchronizer::keyOf(const ObjectMetadata& objectMetadata) const {
+  // 结束帧排在最后：其他输入中更早的帧照常对齐，之后的帧不会再有匹配
+  if (objectMetadata.mFrame->mEndOfStream)
+    return std::numeric_limits<int64_t>::max();
+  const Frame& frame = *objectMetadata.mFrame;
+  if (SyncBy::PTS != mConfig.by) return frame.mFrameId;
+  return Frame::NO_PTS != frame.mPts ? frame.mPts : frame.mTimestamp;
+}
+
+bool InputSynchronizer::full(int port) const {
+  return mQueues[port].size() >= static_cast<size_t>(mConfig.window);
+}
+
+void InputSynchronizer::push(int port,
+                             std::shared_ptr<ObjectMetadata> objectMetadata) {
+  if (objectMetadata->mFrame->mSpData == nullptr &&
+      !objectMetadata->mFrame->mEndOfStream)
+    return;
+  int64_t key = keyOf(*objectMetadata);
+
+  // 时间戳或帧号回退（重连、循环播放），窗口中的数据已无法对齐，重新开始
+  if (mLastKeys[port] != std::numeric_limits<int64_t>::min() &&
+      key < mLastKeys[port] - mConfig.tolerance) {
+    IVS_WARN("{0}: input {1} went back from {2} to {3}, reset sync window",
+             mName, port, mLastKeys[port], key);
+    for (int i = 0; i < mQueues.size(); ++i) {
+      while (!mQueues[i].empty()) drop(i);
+    }
+    std::fill(mLastKeys.begin(), mLastKeys.end(),
+              std::numeric_limits<int64_t>::min());
+  }
+  mLastKeys[port] = std::max(mLastKeys[port], key);
+
+  // 通常按顺序到达，从队尾向前找插入位置
+  auto& queue = mQueues[port];
+  auto it = queue.end();
+  while (it != queue.begin() && keyOf(**(it - 1)) > key) --it;
+  queue.insert(it, objectMetadata);
+  while (queue.size() > static_cast<size_t>(mConfig.window)) drop(port);
+}
+
+bool InputSynchronizer::pop(ObjectMetadatas& inputs) {
+  while (true) {
+    int64_t newest = std::numeric_limits<int64_t>::min();
+    for (auto& queue : mQueues) {
+      if (queue.empty()) return false;
+      newest = std::max(newest, keyOf(*queue.front()));
+    }
+
+    // 队首比最新的队首早出容差以上：该帧不会再有匹配，丢弃
+    bool dropped = false;
+    for (int i = 0; i < mQueues.size(); ++i) {
+      while (!mQueues[i].empty() &&
+             keyOf(*mQueues[i].front()) < newest - mConfig.tolerance) {
+        drop(i);
+        dropped = true;
+      }
+    }
+    if (dropped) continue;
+
+    int64_t oldest = newest;
+    inputs.clear();
+    for (auto& queue : mQueues) {
+      oldest = std::min(oldest, keyOf(*queue.front()));
+      inputs.push_back(queue.front());
+      queue.pop_front();
+    }
+
+    if (std::numeric_limits<int64_t>::max() == oldest) return true;
+    int64_t skew = newest - oldest;
+    ++mStats.matched;
+    mStats.lastSkew = skew;
+    mStats.maxSkew = std::max(mStats.maxSkew, skew);
+    mStats.avgSkew += (skew - mStats.avgSkew) / mStats.matched;
+    if (mStats.matched % REPORT_INTERVAL == 0) report();
+    return true;
+  }
+}
+
+void InputSynchronizer::drop(int port) {
+  IVS_DEBUG("{0}: drop unmatched frame on input {1}, frame_id = {2}", mName,
+            port, mQueues[port].front()->mFrame->mFrameId);
+  mQueues[port].pop_front();
+  ++mStats.dropped[port];
+}
+
+void InputSynchronizer::report() const {
+  std::string dropped;
+  for (auto num : mStats.dropped) {
+    if (!dropped.empty()) dropped += ", ";
+    dropped += std::to_string(num);
+  }
+  IVS_INFO("{0}: matched {1}, skew avg {2:.1f} max {3} {4}, dropped [{5}]",
+           mName, mStats.matched, mStats.avgSkew, mStats.maxSkew,
+           SyncBy::PTS == mConfig.by ? "us" : "frames", dropped);
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
+#define SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
+
+#include <deque>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "no_copyable.h"
+#include "object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 多输入element（stitch、blend、lightstereo左右目等）的输入对齐。
+ * @brief
+ * 每个输入口缓存一个按时间排序的小窗口，各口队首的差不超过容差时组成一组输出；
+ * 明显落后于其他输入的帧直接丢弃，因此某一路丢帧或跳帧后不会永久错位。
+ * @brief 不是线程安全的，每个dataPipe使用一个实例
+ */
+class InputSynchronizer : public ::sophon_stream::common::NoCopyable {
+ public:
+  enum class SyncBy {
+    FRAME_ID,   // 按mFrameId对齐，适用于各路帧号一致的文件源
+    // 按码流pts（mPts，微秒）对齐，各路pts需来自同一时钟；
+    // 没有pts的帧退回按解码时的系统时间mTimestamp对齐
+    PTS,
+  };
+
+  struct Config {
+    SyncBy by = SyncBy::FRAME_ID;
+    int64_t tolerance = 0;  // FRAME_ID时单位为帧，PTS时单位为微秒
+    int window = 8;         // 每个输入口最多缓存的帧数
+  };
+
+  struct Stats {
+    uint64_t matched = 0;
+    std::vector<uint64_t> dropped;  // 每个输入口丢弃的帧数
+    int64_t lastSkew = 0;           // 最近一组的最大时间差
+    int64_t maxSkew = 0;
+    double avgSkew = 0.0;
+  };
+
+  static constexpr const char* CONFIG_INTERNAL_SYNC_BY_FIELD = "sync_by";
+  static constexpr const char* CONFIG_INTERNAL_SYNC_TOLERANCE_MS_FIELD =
+      "sync_tolerance_ms";
+  static constexpr const char* CONFIG_INTERNAL_SYNC_WINDOW_FIELD =
+      "sync_window";
+
+  /**
+   * @brief 从element的configure中读取sync_by、sync_tolerance_ms、sync_window，
+   * 都不配置时按帧号严格对齐，与旧行为一致
+   */
+  static Config parseConfig(const nlohmann::json& configure);
+
+  /**
+   * @param name 日志中使用的名字
+   */
+  InputSynchronizer(int portNum, const Config& config,
+                    const std::string& name);
+
+  /**
+   * @brief 该输入口的窗口已满，应暂停从该口取数据
+   */
+  bool full(int port) const;
+
+  /**
+   * @brief 放入一帧，没有图像的跳帧不参与对齐；
+   * 各输入的结束帧彼此对齐，作为最后一组输出
+   */
+  void push(int port, std::shared_ptr<ObjectMetadata> objectMetadata);
+
+  /**
+   * @brief 取出对齐的一组，inputs按输入口顺序排列；暂时无法对齐时返回false
+   */
+  bool pop(ObjectMetadatas& inputs);
+
+  const Stats& getStats() const { return mStats; }
+
+ private:
+  int64_t keyOf(const ObjectMetadata& objectMetadata) const;
+  void drop(int port);
+  void report() const;
+
+  static constexpr const uint64_t REPORT_INTERVAL = 1000;
+
+  Config mConfig;
+  std::string mName;
+  std::vector<std::deque<std::shared_ptr<ObjectMetadata>>> mQueues;
+  std::vector<int64_t> mLastKeys;
+  Stats mStats;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_INPUT_SYNCHRONIZER_H_
@@ -1,7 +1,60 @@
 #include "common/logger.h"
 
 #include <unistd.h>
+
+#include <condition_variable>
+#include <mutex>
+
 const char* LoggerName = "engine";
+constexpr size_t ASYNC_QUEUE_SIZE = 8192;
+
+/**
+ * 异步logger的最后一个sink，在后台线程中调用：warn以上的消息写出后刷新其他sink
+ * （代替flush_on，这样flush只来自drain），每处理完一次flush请求通知drain
+ */
+class LogDrainSink : public spdlog::sinks::sink {
+ public:
+  explicit LogDrainSink(std::vector<spdlog::sink_ptr> sinks)
+      : mSinks(std::move(sinks)) {}
+
+  void log(const spdlog::details::log_msg& msg) override {
+    if (msg.level < spdlog::level::warn) return;
+    for (auto& sink : mSinks) sink->flush();
+  }
+
+  void flush() override {
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mFlushed;
+    mCond.notify_all();
+  }
+
+  void set_pattern(const std::string&) override {}
+  void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+  /**
+   * 在调用logger->flush()之前取号，flush请求按取号顺序排在之前的消息之后
+   */
+  uint64_t request() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return ++mRequested;
+  }
+
+  /**
+   * 等待号为ticket的flush处理完，后台线程异常时最多等待1秒
+   */
+  void wait(uint64_t ticket) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait_for(lock, std::chrono::seconds(1),
+                   [this, ticket]() { return mFlushed >= ticket; });
+  }
+
+ private:
+  std::vector<spdlog::sink_ptr> mSinks;
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  uint64_t mRequested = 0;
+  uint64_t mFlushed = 0;
+};
 
 Logger::Logger(const std::string& path) {
   auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
@@ -17,23 +70,58 @@ Logger::Logger(const std::string& path) {
   }
 
   // Use sinks to create logger instance
-  auto logger =
+  mSyncLogger =
       std::make_shared<spdlog::logger>(LoggerName, sinks.begin(), sinks.end());
-  logger->set_level(spdlog::level::info);
+  mSyncLogger->set_level(spdlog::level::info);
 
-  mLogger = logger;
+#ifdef STREAM_LOG_ASYNC
+  // 一个后台线程负责格式化和写出；队列满时调用线程等待，不丢日志
+  mThreadPool = std::make_shared<spdlog::details::thread_pool>(
+      ASYNC_QUEUE_SIZE, 1);
+  mDrainSink = std::make_shared<LogDrainSink>(sinks);
+  std::vector<spdlog::sink_ptr> asyncSinks = sinks;
+  asyncSinks.push_back(mDrainSink);
+  mLogger = std::make_shared<spdlog::async_logger>(
+      LoggerName, asyncSinks.begin(), asyncSinks.end(), mThreadPool,
+      spdlog::async_overflow_policy::block);
+  mLogger->set_level(spdlog::level::info);
+#else
+  mLogger = mSyncLogger;
+#endif
 }
 
-Logger::~Logger() { mLogger.reset(); }
+// 先释放logger，线程池析构时写完队列中剩余的消息
+Logger::~Logger() {
+  mLogger.reset();
+  mSyncLogger.reset();
+  mThreadPool.reset();
+}
 
 std::shared_ptr<spdlog::logger>& Logger::getInstance() { return mLogger; }
 
-std::shared_ptr<spdlog::logger>& Logger::getLogger(const std::string& path) {
+static Logger& loggerInstance(const std::string& path) {
   static Logger logger(path);
-  return logger.getInstance();
+  return logger;
+}
+
+std::shared_ptr<spdlog::logger>& Logger::getLogger(const std::string& path) {
+  return loggerInstance(path).getInstance();
+}
+
+std::shared_ptr<spdlog::logger>& Logger::getSyncLogger() {
+  return loggerInstance("").mSyncLogger;
+}
+
+void Logger::drain() {
+  Logger& logger = loggerInstance("");
+  if (logger.mDrainSink == nullptr || logger.mLogger == nullptr) return;
+  uint64_t ticket = logger.mDrainSink->request();
+  logger.mLogger->flush();
+  logger.mDrainSink->wait(ticket);
 }
 
 void logInit(const std::string& name, const std::string& path) {
   auto logger = Logger::getLogger(path);
   logger->set_level(spdlog::level::from_str(name));
+  Logger::getSyncLogger()->set_level(spdlog::level::from_str(name));
 };
@@ -1,14 +1,35 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 
+#include "spdlog/async.h"
 #include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
 
+/**
+ * 编译期日志级别，低于该级别的IVS_*调用不生成代码，取值同spdlog::level：
+ * 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 critical, 6 off
+ */
+#ifndef STREAM_LOG_ACTIVE_LEVEL
+#define STREAM_LOG_ACTIVE_LEVEL 0
+#endif
+
+class LogDrainSink;
+
+/**
+ * 定义STREAM_LOG_ASYNC时，trace~warn由后台线程格式化并写入终端和文件，
+ * 调用线程只把消息放入队列；error、critical先等队列中已有的消息写完再同步写出，
+ * 保证顺序，并在进程异常退出前可见
+ */
 class Logger {
  private:
+  std::shared_ptr<spdlog::details::thread_pool> mThreadPool = nullptr;
   std::shared_ptr<spdlog::logger> mLogger = nullptr;
+  std::shared_ptr<spdlog::logger> mSyncLogger = nullptr;
+  std::shared_ptr<LogDrainSink> mDrainSink = nullptr;
 
  public:
   Logger(const std::string& path = nullptr);
@@ -24,6 +45,16 @@ class Logger {
   static std::shared_ptr<spdlog::logger>& getLogger(
       const std::string& path = "");
 
+  /**
+   * 与getLogger共用sink的同步logger，用于error、critical
+   */
+  static std::shared_ptr<spdlog::logger>& getSyncLogger();
+
+  /**
+   * 等待调用前放入异步队列的消息写出并刷新，未定义STREAM_LOG_ASYNC时直接返回
+   */
+  static void drain();
+
  private:
   Logger(const Logger&) = delete;
   Logger& operator=(const Logger&) = delete;
@@ -41,39 +72,158 @@ void logInit(const std::string& name = "info", const std::string& path = "");
 
 #define IVSLOG_FMT(fmt) "[" IVSLOG_FILE ":" IVSLOG_STR_HELP(__LINE__) "] " fmt
 
+// 被编译期级别去掉的调用仍做语法检查，但不会执行
+#define IVSLOG_STRIPPED(func, fmt, ...)  \
+  do {                                   \
+    if (false) func(fmt, ##__VA_ARGS__); \
+  } while (0)
+
 template <typename... Args>
 inline void trace(const char* fmt, const Args&... args) {
   return Logger::getLogger()->trace(fmt, args...);
 }
 
+#if STREAM_LOG_ACTIVE_LEVEL <= 0
 #define IVS_TRACE(fmt, ...) ::trace(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_TRACE(fmt, ...) IVSLOG_STRIPPED(::trace, fmt, ##__VA_ARGS__)
+#endif
 
 template <typename... Args>
 inline void debug(const char* fmt, const Args&... args) {
   return Logger::getLogger()->debug(fmt, args...);
 }
+#if STREAM_LOG_ACTIVE_LEVEL <= 1
 #define IVS_DEBUG(fmt, ...) ::debug(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_DEBUG(fmt, ...) IVSLOG_STRIPPED(::debug, fmt, ##__VA_ARGS__)
+#endif
 
 template <typename... Args>
 inline void info(const char* fmt, const Args&... args) {
   return Logger::getLogger()->info(fmt, args...);
 }
+#if STREAM_LOG_ACTIVE_LEVEL <= 2
 #define IVS_INFO(fmt, ...) ::info(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_INFO(fmt, ...) IVSLOG_STRIPPED(::info, fmt, ##__VA_ARGS__)
+#endif
 
 template <typename... Args>
 inline void warn(const char* fmt, const Args&... args) {
   return Logger::getLogger()->warn(fmt, args...);
 }
+#if STREAM_LOG_ACTIVE_LEVEL <= 3
 #define IVS_WARN(fmt, ...) ::warn(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_WARN(fmt, ...) IVSLOG_STRIPPED(::warn, fmt, ##__VA_ARGS__)
+#endif
 
 template <typename... Args>
 inline void error(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->error(fmt, args...);
+  Logger::drain();
+  return Logger::getSyncLogger()->error(fmt, args...);
 }
+#if STREAM_LOG_ACTIVE_LEVEL <= 4
 #define IVS_ERROR(fmt, ...) ::error(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_ERROR(fmt, ...) IVSLOG_STRIPPED(::error, fmt, ##__VA_ARGS__)
+#endif
 
 template <typename... Args>
 inline void critical(const char* fmt, const Args&... args) {
-  return Logger::getLogger()->critical(fmt, args...);
+  Logger::drain();
+  return Logger::getSyncLogger()->critical(fmt, args...);
 }
+#if STREAM_LOG_ACTIVE_LEVEL <= 5
 #define IVS_CRITICAL(fmt, ...) ::critical(IVSLOG_FMT(fmt), ##__VA_ARGS__)
+#else
+#define IVS_CRITICAL(fmt, ...) IVSLOG_STRIPPED(::critical, fmt, ##__VA_ARGS__)
+#endif
+
+/**
+ * 按调用点限频：interval内只输出第一条，之后输出时附带期间被丢弃的条数。
+ * 无锁，可在多个线程中共用
+ */
+class LogRateLimiter {
+ public:
+  explicit LogRateLimiter(int64_t intervalMs)
+      : mIntervalNs(intervalMs * 1000000) {}
+
+  /**
+   * @param suppressed 允许输出时返回上次输出后被丢弃的条数
+   */
+  bool allow(uint64_t& suppressed) {
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    int64_t next = mNextNs.load(std::memory_order_relaxed);
+    if (now < next ||
+        !mNextNs.compare_exchange_strong(next, now + mIntervalNs,
+                                         std::memory_order_relaxed)) {
+      mSuppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    suppressed = mSuppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+  }
+
+ private:
+  const int64_t mIntervalNs;
+  std::atomic<int64_t> mNextNs{0};
+  std::atomic<uint64_t> mSuppressed{0};
+};
+
+template <typename... Args>
+inline void logEvery(spdlog::level::level_enum level, LogRateLimiter& limiter,
+                     const char* fmt, const Args&... args) {
+  auto& logger = level >= spdlog::level::err ? Logger::getSyncLogger()
+                                             : Logger::getLogger();
+  if (!logger->should_log(level)) return;
+  uint64_t suppressed = 0;
+  if (!limiter.allow(suppressed)) return;
+  if (level >= spdlog::level::err) Logger::drain();
+  if (suppressed == 0)
+    logger->log(level, fmt, args...);
+  else
+    logger->log(level, "{} (suppressed {} times)", fmt::format(fmt, args...),
+                suppressed);
+}
+
+#define IVSLOG_EVERY_MS(level, ms, fmt, ...)                          \
+  do {                                                                \
+    static LogRateLimiter ivsLogLimiter(ms);                          \
+    ::logEvery(level, ivsLogLimiter, IVSLOG_FMT(fmt), ##__VA_ARGS__); \
+  } while (0)
+
+/**
+ * 每帧都可能触发的日志（队列满、丢帧等）使用，每个调用点每ms毫秒最多输出一条
+ */
+#if STREAM_LOG_ACTIVE_LEVEL <= 1
+#define IVS_DEBUG_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_EVERY_MS(spdlog::level::debug, ms, fmt, ##__VA_ARGS__)
+#else
+#define IVS_DEBUG_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_STRIPPED(::debug, fmt, ##__VA_ARGS__)
+#endif
+#if STREAM_LOG_ACTIVE_LEVEL <= 2
+#define IVS_INFO_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_EVERY_MS(spdlog::level::info, ms, fmt, ##__VA_ARGS__)
+#else
+#define IVS_INFO_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_STRIPPED(::info, fmt, ##__VA_ARGS__)
+#endif
+#if STREAM_LOG_ACTIVE_LEVEL <= 3
+#define IVS_WARN_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_EVERY_MS(spdlog::level::warn, ms, fmt, ##__VA_ARGS__)
+#else
+#define IVS_WARN_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_STRIPPED(::warn, fmt, ##__VA_ARGS__)
+#endif
+#if STREAM_LOG_ACTIVE_LEVEL <= 4
+#define IVS_ERROR_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_EVERY_MS(spdlog::level::err, ms, fmt, ##__VA_ARGS__)
+#else
+#define IVS_ERROR_EVERY_MS(ms, fmt, ...) \
+  IVSLOG_STRIPPED(::error, fmt, ##__VA_ARGS__)
+#endif
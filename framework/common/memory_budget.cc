@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/memory_budget.h"
+
+#include <chrono>
+
+namespace sophon_stream {
+namespace common {
+
+namespace {
+
+thread_local int sThreadGraph = -1;
+
+void addBytes(MemoryUsage& usage, std::size_t bytes) {
+  usage.mBytesInFlight += bytes;
+  if (usage.mBytesInFlight > usage.mPeakBytes)
+    usage.mPeakBytes = usage.mBytesInFlight;
+}
+
+void subBytes(MemoryUsage& usage, std::size_t bytes) {
+  usage.mBytesInFlight =
+      usage.mBytesInFlight > bytes ? usage.mBytesInFlight - bytes : 0;
+}
+
+bool withinBudget(const MemoryUsage& usage, std::size_t bytes) {
+  return usage.mBudgetBytes == 0 ||
+         usage.mBytesInFlight + bytes <= usage.mBudgetBytes;
+}
+
+}  // namespace
+
+MemoryCharge::~MemoryCharge() {
+  MemoryBudget::getInstance().sub(mGraphId, mDevId, mBytes);
+}
+
+// 有意不析构：进程退出时仍可能有帧持有MemoryCharge
+MemoryBudget& MemoryBudget::getInstance() {
+  static MemoryBudget* budget = new MemoryBudget();
+  return *budget;
+}
+
+void MemoryBudget::setGraphBudget(int graphId, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mGraphUsage[graphId].mBudgetBytes = bytes;
+  mCv.notify_all();
+}
+
+void MemoryBudget::setDeviceBudget(int devId, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDeviceUsage[devId].mBudgetBytes = bytes;
+  mCv.notify_all();
+}
+
+std::shared_ptr<MemoryCharge> MemoryBudget::charge(int graphId, int devId,
+                                                   std::size_t bytes) {
+  add(graphId, devId, bytes);
+  return std::make_shared<MemoryCharge>(graphId, devId, bytes);
+}
+
+void MemoryBudget::add(int graphId, int devId, std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (graphId >= 0) addBytes(mGraphUsage[graphId], bytes);
+  if (devId >= 0) addBytes(mDeviceUsage[devId], bytes);
+}
+
+void MemoryBudget::sub(int graphId, int devId, std::size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (graphId >= 0) subBytes(mGraphUsage[graphId], bytes);
+    if (devId >= 0) subBytes(mDeviceUsage[devId], bytes);
+  }
+  mCv.notify_all();
+}
+
+bool MemoryBudget::admissible(int graphId, int devId, std::size_t bytes) {
+  auto& graphUsage = mGraphUsage[graphId];
+  if (graphUsage.mBytesInFlight == 0) return true;
+  return withinBudget(graphUsage, bytes) &&
+         withinBudget(mDeviceUsage[devId], bytes);
+}
+
+bool MemoryBudget::waitForAdmission(int graphId, int devId, std::size_t bytes,
+                                    int timeoutMs) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (admissible(graphId, devId, bytes)) return true;
+  mGraphUsage[graphId].mThrottleCount++;
+  mDeviceUsage[devId].mThrottleCount++;
+  return mCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+    return admissible(graphId, devId, bytes);
+  });
+}
+
+MemoryUsage MemoryBudget::getGraphUsage(int graphId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mGraphUsage[graphId];
+}
+
+MemoryUsage MemoryBudget::getDeviceUsage(int devId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mDeviceUsage[devId];
+}
+
+void MemoryBudget::setThreadGraph(int graphId) { sThreadGraph = graphId; }
+
+int MemoryBudget::getThreadGraph() { return sThreadGraph; }
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_MEMORY_BUDGET_H_
+#define SOPHON_STREAM_COMMON_MEMORY_BUDGET_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+struct MemoryUsage {
+  std::size_t mBytesInFlight = 0;  // 当前占用
+  std::size_t mPeakBytes = 0;      // mBytesInFlight的高水位
+  std::size_t mBudgetBytes = 0;    // 预算，0表示不限制
+  std::size_t mThrottleCount = 0;  // 因超出预算被拒绝准入的次数
+};
+
+/**
+ * @brief 一次记账的凭证，析构时自动归还对应的字节数
+ */
+class MemoryCharge : public ::sophon_stream::common::NoCopyable {
+ public:
+  MemoryCharge(int graphId, int devId, std::size_t bytes)
+      : mGraphId(graphId), mDevId(devId), mBytes(bytes) {}
+  ~MemoryCharge();
+
+  std::size_t getBytes() const { return mBytes; }
+
+ private:
+  int mGraphId;
+  int mDevId;
+  std::size_t mBytes;
+};
+
+/**
+ * @brief 按graph和device统计在途的帧与tensor显存，并在解码端做准入控制。
+ * @brief
+ * decode为每一帧记账，帧离开pipeline时归还；TensorMemPool借出的显存计入设备，
+ * 以及借出时所在线程所属的graph。
+ * 在途字节数超过预算时，waitForAdmission阻塞解码线程，形成基于显存占用而不是
+ * DataPipe条数的背压
+ */
+class MemoryBudget : public ::sophon_stream::common::NoCopyable {
+ public:
+  static MemoryBudget& getInstance();
+
+  /**
+   * @brief 设置预算，bytes为0表示不限制
+   */
+  void setGraphBudget(int graphId, std::size_t bytes);
+  void setDeviceBudget(int devId, std::size_t bytes);
+
+  /**
+   * @brief 记账bytes并返回凭证，凭证析构时归还；graphId为-1时只计入设备
+   */
+  std::shared_ptr<MemoryCharge> charge(int graphId, int devId,
+                                       std::size_t bytes);
+
+  void add(int graphId, int devId, std::size_t bytes);
+  void sub(int graphId, int devId, std::size_t bytes);
+
+  /**
+   * @brief 等待直到再占用bytes不会超出graph和device的预算，超时返回false。
+   * @brief graph没有在途数据时总是准入，避免单帧超出预算时死锁
+   */
+  bool waitForAdmission(int graphId, int devId, std::size_t bytes,
+                        int timeoutMs);
+
+  MemoryUsage getGraphUsage(int graphId);
+  MemoryUsage getDeviceUsage(int devId);
+
+  /**
+   * @brief 设置当前线程所属的graph，element工作线程启动时调用；
+   * 未设置的线程为-1，在其上借出的tensor显存只计入设备
+   */
+  static void setThreadGraph(int graphId);
+  static int getThreadGraph();
+
+ private:
+  MemoryBudget() = default;
+
+  bool admissible(int graphId, int devId, std::size_t bytes);
+
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  std::map<int /* graph id */, MemoryUsage> mGraphUsage;
+  std::map<int /* device id */, MemoryUsage> mDeviceUsage;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_MEMORY_BUDGET_H_
@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_COMMON_OBJECT_METADATA_H_
 #define SOPHON_STREAM_COMMON_OBJECT_METADATA_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -17,6 +18,7 @@
 
 #include "common_defs.h"
 #include "detected_object_metadata.h"
+#include "detection_table.h"
 #include "error_code.h"
 #include "face_object_metadata.h"
 #include "frame.h"
@@ -26,6 +28,7 @@
 #include "segmented_object_metadata.h"
 #include "tracked_object_metadata.h"
 #include "obb_object_metadata.h"
+#include "object_pool.h"
 
 namespace sophon_stream {
 namespace common {
@@ -55,6 +58,10 @@ typedef struct bmTensors_ {
   bm_handle_t handle;
   // cpu data is used to sync dev mem and host mem
   std::vector<float*> cpu_data;
+  // 非空时表示本结构是batch中第batch_slot帧的视图，device_mem指向batch显存
+  // 中的切片，不归本结构所有；batch的显存在所有视图释放后才回收
+  std::shared_ptr<bmTensors_> batch;
+  int batch_slot = -1;
 } bmTensors;
 
 typedef struct bmSubTensors_ {
@@ -66,6 +73,7 @@ struct ObjectMetadata {
   ObjectMetadata()
       : mErrorCode(common::ErrorCode::SUCCESS),
         mFilter(false),
+        mDetectionSkipped(false),
         is_main(false),
         numBranches(0) {}
 
@@ -105,6 +113,12 @@ struct ObjectMetadata {
 
   std::shared_ptr<common::Frame> mFrame;
 
+  /**
+   * @brief 本帧结果对象（检测框等）使用的arena，通过makeInArena分配，
+   * 随ObjectMetadata及其结果对象一起释放
+   */
+  std::shared_ptr<FrameArena> mArena;
+
   bool mFilter;
 
   /**
@@ -113,6 +127,17 @@ struct ObjectMetadata {
    */
   std::vector<int> mSkipElements;
 
+  /**
+   * @brief 检测element按检测间隔跳过了本帧（结果为空不代表没有目标），
+   * 跟踪element在这些帧上外推已有轨迹
+   */
+  bool mDetectionSkipped;
+  /**
+   * @brief 做出mDetectionSkipped判断的检测模型（model_path的hash），
+   * 只有同一模型的各阶段沿用该判断
+   */
+  std::size_t mDetectionDecider = 0;
+
   std::shared_ptr<bmTensors> mInputBMtensors;
   std::shared_ptr<bmTensors> mOutputBMtensors;
 
@@ -145,6 +170,83 @@ struct ObjectMetadata {
    */
   std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
       mDetectedObjectMetadatas;
+  /**
+   * @brief 检测结果的列式表，第i行对应mDetectedObjectMetadatas[i]
+   * @brief 表只在写入侧维护：检测element的后处理通过addDetectedObject同时
+   * 写入两者；增删行的element通过mutableDetectionTable同步修改表（如
+   * keepRows）；原地修改框、类别、跟踪id或直接增删vector的element需要调用
+   * detectionsChanged立即重建。读取侧只通过const的getDetectionTable访问
+   */
+  std::shared_ptr<DetectionTable> mDetectionTable;
+  /**
+   * @brief 检测结果的版本号，与mDetectionTable->mVersion一致时表是最新的
+   */
+  std::uint64_t mDetectionVersion = 0;
+
+  /**
+   * @brief 读取侧访问检测表，不做重建，多个下游element可以并发读取
+   * @brief 表与mDetectedObjectMetadatas不一致说明上游修改了检测结果而没有
+   * 调用detectionsChanged，属于程序错误，直接报错退出
+   */
+  const DetectionTable& getDetectionTable() const {
+    static const DetectionTable kEmptyTable;
+    if (mDetectionTable == nullptr) {
+      STREAM_CHECK(mDetectedObjectMetadatas.empty(),
+                   "Detection table missing for ",
+                   std::to_string(mDetectedObjectMetadatas.size()),
+                   " detections, call detectionsChanged() after modifying "
+                   "mDetectedObjectMetadatas");
+      return kEmptyTable;
+    }
+    STREAM_CHECK(mDetectionTable->mVersion == mDetectionVersion &&
+                     mDetectionTable->size() ==
+                         mDetectedObjectMetadatas.size(),
+                 "Detection table is stale: ",
+                 std::to_string(mDetectionTable->size()), " rows of version ",
+                 std::to_string(mDetectionTable->mVersion), " for ",
+                 std::to_string(mDetectedObjectMetadatas.size()),
+                 " detections of version ", std::to_string(mDetectionVersion),
+                 ", call detectionsChanged() after modifying "
+                 "mDetectedObjectMetadatas");
+    return *mDetectionTable;
+  }
+
+  /**
+   * @brief 写入侧访问检测表，用于增删行后与vector保持同步，表不是最新时先重建
+   */
+  DetectionTable& mutableDetectionTable() {
+    if (mDetectionTable == nullptr)
+      mDetectionTable = makePooled<DetectionTable>();
+    if (mDetectionTable->mVersion != mDetectionVersion ||
+        mDetectionTable->size() != mDetectedObjectMetadatas.size()) {
+      mDetectionTable->assign(mDetectedObjectMetadatas,
+                              mTrackedObjectMetadatas);
+      mDetectionTable->mVersion = mDetectionVersion;
+    }
+    return *mDetectionTable;
+  }
+
+  /**
+   * @brief 追加一个检测结果，同时写入mDetectedObjectMetadatas和检测表
+   */
+  void addDetectedObject(
+      const std::shared_ptr<DetectedObjectMetadata>& detData) {
+    float score = detData->mScores.empty() ? 0.f : detData->mScores[0];
+    mutableDetectionTable().addRow(detData->mBox, score, detData->mClassify);
+    mDetectedObjectMetadatas.push_back(detData);
+  }
+
+  /**
+   * @brief 原地修改或直接增删了mDetectedObjectMetadatas、
+   * mTrackedObjectMetadatas后调用，立即按vector重建检测表
+   */
+  void detectionsChanged() {
+    ++mDetectionVersion;
+    if (mDetectionTable == nullptr)
+      mDetectionTable = makePooled<DetectionTable>();
+    mDetectionTable->assign(mDetectedObjectMetadatas, mTrackedObjectMetadatas);
+    mDetectionTable->mVersion = mDetectionVersion;
+  }
   /**
    * @brief 姿态结果的vector，一个目标对应一个PosedObjectMetadata
    */
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/object_pool.h"
+
+#include <cstdint>
+#include <new>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+namespace {
+
+std::size_t sizeClass(std::size_t bytes) {
+  return (bytes + 7) & ~std::size_t(7);
+}
+
+}  // namespace
+
+// 有意不析构：进程退出时仍可能有对象归还内存
+ObjectPool& ObjectPool::getInstance() {
+  static ObjectPool* pool = new ObjectPool();
+  return *pool;
+}
+
+ObjectPool::Bucket& ObjectPool::getBucket(std::size_t classBytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& bucket = mBuckets[classBytes];
+  if (!bucket) bucket.reset(new Bucket());
+  return *bucket;
+}
+
+void* ObjectPool::allocate(std::size_t bytes) {
+  std::size_t classBytes = sizeClass(bytes);
+  mAllocCount++;
+  mBytesInUse += classBytes;
+  auto& bucket = getBucket(classBytes);
+  {
+    std::lock_guard<std::mutex> lock(bucket.mMutex);
+    if (!bucket.mFreeList.empty()) {
+      void* ptr = bucket.mFreeList.back();
+      bucket.mFreeList.pop_back();
+      mReuseCount++;
+      mBytesCached -= classBytes;
+      return ptr;
+    }
+  }
+  mSystemAllocs++;
+  return ::operator new(classBytes);
+}
+
+void ObjectPool::deallocate(void* ptr, std::size_t bytes) {
+  if (ptr == nullptr) return;
+  std::size_t classBytes = sizeClass(bytes);
+  mBytesInUse -= classBytes;
+  if (mBytesCached + classBytes > mMaxCachedBytes) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto& bucket = getBucket(classBytes);
+  std::lock_guard<std::mutex> lock(bucket.mMutex);
+  bucket.mFreeList.push_back(ptr);
+  mBytesCached += classBytes;
+}
+
+void ObjectPool::trim() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (auto& bucket : mBuckets) {
+    std::lock_guard<std::mutex> bucketLock(bucket.second->mMutex);
+    for (auto ptr : bucket.second->mFreeList) {
+      ::operator delete(ptr);
+      mBytesCached -= bucket.first;
+    }
+    bucket.second->mFreeList.clear();
+  }
+}
+
+void ObjectPool::setMaxCachedBytes(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMaxCachedBytes = bytes;
+}
+
+ObjectPoolStats ObjectPool::getStats() {
+  ObjectPoolStats stats;
+  stats.mAllocCount = mAllocCount;
+  stats.mReuseCount = mReuseCount;
+  stats.mSystemAllocs = mSystemAllocs;
+  stats.mBytesInUse = mBytesInUse;
+  stats.mBytesCached = mBytesCached;
+  stats.mArenaCount = mArenaCount;
+  stats.mArenaObjects = mArenaObjects;
+  stats.mArenaBlocks = mArenaBlocks;
+  return stats;
+}
+
+void ObjectPool::dumpStats() {
+  auto stats = getStats();
+  IVS_INFO(
+      "Object pool: alloc {0}, reuse {1}, system alloc {2}, in use {3} bytes, "
+      "cached {4} bytes, arena {5}, arena objects {6}, arena blocks {7}",
+      stats.mAllocCount, stats.mReuseCount, stats.mSystemAllocs,
+      stats.mBytesInUse, stats.mBytesCached, stats.mArenaCount,
+      stats.mArenaObjects, stats.mArenaBlocks);
+}
+
+FrameArena::FrameArena() : mCursor(nullptr), mLeft(0) {
+  ObjectPool::getInstance().countArena();
+}
+
+FrameArena::~FrameArena() {
+  auto& pool = ObjectPool::getInstance();
+  for (auto& block : mBlocks) pool.deallocate(block.first, block.second);
+}
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t align) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::size_t padding =
+      (align - reinterpret_cast<std::uintptr_t>(mCursor) % align) % align;
+  if (mCursor == nullptr || padding + bytes > mLeft) {
+    // 超过BLOCK_BYTES的对象单独占用一块
+    std::size_t blockBytes =
+        bytes + align > BLOCK_BYTES ? bytes + align : BLOCK_BYTES;
+    void* block = ObjectPool::getInstance().allocate(blockBytes);
+    ObjectPool::getInstance().countArenaBlock();
+    mBlocks.emplace_back(block, blockBytes);
+    mCursor = static_cast<char*>(block);
+    mLeft = blockBytes;
+    padding =
+        (align - reinterpret_cast<std::uintptr_t>(mCursor) % align) % align;
+  }
+  void* ptr = mCursor + padding;
+  mCursor += padding + bytes;
+  mLeft -= padding + bytes;
+  return ptr;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_OBJECT_POOL_H_
+#define SOPHON_STREAM_COMMON_OBJECT_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+struct ObjectPoolStats {
+  std::size_t mAllocCount = 0;      // allocate调用次数
+  std::size_t mReuseCount = 0;      // 从空闲链表复用的次数
+  std::size_t mSystemAllocs = 0;    // 调用operator new的次数
+  std::size_t mBytesInUse = 0;      // 已借出的内存
+  std::size_t mBytesCached = 0;     // 空闲链表中的内存
+  std::size_t mArenaCount = 0;      // 创建过的FrameArena个数
+  std::size_t mArenaObjects = 0;    // 在FrameArena中构造的对象个数
+  std::size_t mArenaBlocks = 0;     // FrameArena申请的内存块个数
+};
+
+/**
+ * @brief 进程内共享的内存块池，按8字节对齐后的大小分桶缓存释放的内存。
+ * @brief
+ * ObjectMetadata、Frame等每帧都会创建的对象通过makePooled从这里分配，
+ * 对象析构后内存挂回空闲链表，下一帧直接复用
+ */
+class ObjectPool : public ::sophon_stream::common::NoCopyable {
+ public:
+  static ObjectPool& getInstance();
+
+  void* allocate(std::size_t bytes);
+  void deallocate(void* ptr, std::size_t bytes);
+
+  /**
+   * @brief 将所有空闲内存还给系统
+   */
+  void trim();
+
+  void setMaxCachedBytes(std::size_t bytes);
+
+  ObjectPoolStats getStats();
+
+  void dumpStats();
+
+  void countArena() { mArenaCount++; }
+  void countArenaObject() { mArenaObjects++; }
+  void countArenaBlock() { mArenaBlocks++; }
+
+  static constexpr std::size_t DEFAULT_MAX_CACHED_BYTES = 64UL << 20;
+
+ private:
+  ObjectPool() = default;
+
+  struct Bucket {
+    std::mutex mMutex;
+    std::vector<void*> mFreeList;
+  };
+
+  Bucket& getBucket(std::size_t classBytes);
+
+  std::mutex mMutex;
+  std::map<std::size_t /* size class */, std::unique_ptr<Bucket>> mBuckets;
+  std::size_t mMaxCachedBytes = DEFAULT_MAX_CACHED_BYTES;
+
+  std::atomic<std::size_t> mAllocCount{0};
+  std::atomic<std::size_t> mReuseCount{0};
+  std::atomic<std::size_t> mSystemAllocs{0};
+  std::atomic<std::size_t> mBytesInUse{0};
+  std::atomic<std::size_t> mBytesCached{0};
+  std::atomic<std::size_t> mArenaCount{0};
+  std::atomic<std::size_t> mArenaObjects{0};
+  std::atomic<std::size_t> mArenaBlocks{0};
+};
+
+/**
+ * @brief 从ObjectPool分配内存的allocator，用于std::allocate_shared
+ */
+template <typename T>
+struct PoolAllocator {
+  typedef T value_type;
+
+  PoolAllocator() = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(ObjectPool::getInstance().allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, std::size_t n) {
+    ObjectPool::getInstance().deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const {
+    return false;
+  }
+};
+
+/**
+ * @brief 与std::make_shared相同，但对象和控制块的内存来自ObjectPool
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args) {
+  return std::allocate_shared<T>(PoolAllocator<T>(),
+                                 std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 一帧的结果对象（检测框、关键点等）使用的线性分配器。
+ * @brief
+ * 对象只做指针递增分配，释放时不归还；arena被所有在其中构造的对象引用，
+ * 当帧离开pipeline、最后一个结果对象析构后，arena的内存块整体归还ObjectPool
+ */
+class FrameArena : public ::sophon_stream::common::NoCopyable {
+ public:
+  FrameArena();
+  ~FrameArena();
+
+  void* allocate(std::size_t bytes, std::size_t align);
+
+  static constexpr std::size_t BLOCK_BYTES = 16 * 1024;
+
+ private:
+  std::mutex mMutex;
+  std::vector<std::pair<void*, std::size_t>> mBlocks;
+  char* mCursor;
+  std::size_t mLeft;
+};
+
+/**
+ * @brief 在FrameArena中分配内存的allocator，持有arena的引用
+ */
+template <typename T>
+struct ArenaAllocator {
+  typedef T value_type;
+
+  explicit ArenaAllocator(std::shared_ptr<FrameArena> arena)
+      : mArena(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.mArena) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, std::size_t n) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return mArena == other.mArena;
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return mArena != other.mArena;
+  }
+
+  std::shared_ptr<FrameArena> mArena;
+};
+
+/**
+ * @brief 在arena中构造结果对象，arena为空时退化为makePooled
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> makeInArena(const std::shared_ptr<FrameArena>& arena,
+                               Args&&... args) {
+  if (arena == nullptr) return makePooled<T>(std::forward<Args>(args)...);
+  ObjectPool::getInstance().countArenaObject();
+  return std::allocate_shared<T>(ArenaAllocator<T>(arena),
+                                 std::forward<Args>(args)...);
+}
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_OBJECT_POOL_H_
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/preprocess_cache.h"
+
+#include <tuple>
+
+namespace sophon_stream {
+namespace common {
+
+bool PreprocessKey::operator<(const PreprocessKey& rhs) const {
+  auto tie = [](const PreprocessKey& k) {
+    return std::tie(k.mDevId, k.mNetW, k.mNetH, k.mFormat, k.mDataType,
+                    k.mCenter, k.mPadding, k.mAlpha[0], k.mAlpha[1],
+                    k.mAlpha[2], k.mBeta[0], k.mBeta[1], k.mBeta[2],
+                    k.mCrop[0], k.mCrop[1], k.mCrop[2], k.mCrop[3]);
+  };
+  return tie(*this) < tie(rhs);
+}
+
+void PreprocessCache::put(const PreprocessKey& key, const void* source,
+                          std::shared_ptr<bm_device_mem_t> mem, int uses) {
+  if (uses <= 0) return;
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEntries.emplace(key, Entry{source, mem, uses});
+}
+
+std::shared_ptr<bm_device_mem_t> PreprocessCache::take(
+    const PreprocessKey& key, const void* source) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mEntries.find(key);
+  if (mEntries.end() == it || it->second.mSource != source) return nullptr;
+  auto mem = it->second.mMem;
+  if (--it->second.mUses <= 0) mEntries.erase(it);
+  return mem;
+}
+
+// 有意不析构：前处理对象析构时仍会调用removeConsumer
+PreprocessDemand& PreprocessDemand::getInstance() {
+  static PreprocessDemand* demand = new PreprocessDemand();
+  return *demand;
+}
+
+void PreprocessDemand::addConsumer(int graphId, const void* consumer,
+                                   const PreprocessKey& key) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mConsumers[graphId][consumer] = key;
+}
+
+void PreprocessDemand::removeConsumer(const void* consumer) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (auto it = mConsumers.begin(); it != mConsumers.end();) {
+    it->second.erase(consumer);
+    if (it->second.empty())
+      it = mConsumers.erase(it);
+    else
+      ++it;
+  }
+}
+
+int PreprocessDemand::getConsumerNum(int graphId, const PreprocessKey& key) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto graphIt = mConsumers.find(graphId);
+  if (mConsumers.end() == graphIt) return 0;
+  int num = 0;
+  for (auto& consumer : graphIt->second) {
+    if (!(consumer.second < key) && !(key < consumer.second)) ++num;
+  }
+  return num;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
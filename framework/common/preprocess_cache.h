@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_PREPROCESS_CACHE_H_
+#define SOPHON_STREAM_COMMON_PREPROCESS_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "bmlib_runtime.h"
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 前处理结果的标识：同一帧上key相同的前处理，输出的tensor完全一致
+ */
+struct PreprocessKey {
+  int mDevId = -1;
+  int mNetW = 0;
+  int mNetH = 0;
+  int mFormat = 0;     // bm_image_format_ext
+  int mDataType = 0;   // bm_image_data_format_ext
+  bool mCenter = true;  // 缩放后的图像是否居中
+  int mPadding = 0;
+  float mAlpha[3] = {0.f, 0.f, 0.f};
+  float mBeta[3] = {0.f, 0.f, 0.f};
+  int mCrop[4] = {0, 0, 0, 0};  // 全0表示整幅图像
+
+  bool operator<(const PreprocessKey& rhs) const;
+};
+
+/**
+ * @brief 挂在Frame上的前处理结果缓存。
+ * @brief
+ * 同一graph中多个模型的前处理相同时（例如检测+分类、A/B对比），第一个element
+ * 把结果放入缓存，后续element直接拷贝，不再重复缩放和归一化。每条缓存记录还需要
+ * 被取用的次数，取完即释放；没取完的随Frame一起释放
+ */
+class PreprocessCache : public ::sophon_stream::common::NoCopyable {
+ public:
+  /**
+   * @brief 放入一条结果，已有相同key时忽略
+   * @param source 生成结果时使用的图像，取用时图像已被替换则视为未命中
+   * @param uses 还会被取用的次数
+   */
+  void put(const PreprocessKey& key, const void* source,
+           std::shared_ptr<bm_device_mem_t> mem, int uses);
+
+  /**
+   * @brief 取出一条结果并减少其剩余次数，未命中返回nullptr
+   */
+  std::shared_ptr<bm_device_mem_t> take(const PreprocessKey& key,
+                                        const void* source);
+
+ private:
+  struct Entry {
+    const void* mSource;
+    std::shared_ptr<bm_device_mem_t> mMem;
+    int mUses;
+  };
+
+  std::mutex mMutex;
+  std::map<PreprocessKey, Entry> mEntries;
+};
+
+/**
+ * @brief 记录每个graph中各前处理的使用者，只有同一个key有多个使用者时才值得缓存
+ */
+class PreprocessDemand : public ::sophon_stream::common::NoCopyable {
+ public:
+  static PreprocessDemand& getInstance();
+
+  /**
+   * @brief 注册使用者，consumer通常是前处理对象本身
+   */
+  void addConsumer(int graphId, const void* consumer,
+                   const PreprocessKey& key);
+  void removeConsumer(const void* consumer);
+
+  /**
+   * @brief graph中使用该key的前处理的个数
+   */
+  int getConsumerNum(int graphId, const PreprocessKey& key);
+
+ private:
+  PreprocessDemand() = default;
+
+  std::mutex mMutex;
+  std::map<int /* graph id */, std::map<const void*, PreprocessKey>>
+      mConsumers;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_PREPROCESS_CACHE_H_
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/render_demand.h"
+
+namespace sophon_stream {
+namespace common {
+
+// 有意不析构：element析构时仍会调用removeConsumer
+RenderDemand& RenderDemand::getInstance() {
+  static RenderDemand* demand = new RenderDemand();
+  return *demand;
+}
+
+void RenderDemand::addConsumer(int graphId, int elementId, DemandFunc func) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mConsumers[graphId][elementId] = func;
+}
+
+void RenderDemand::removeConsumer(int graphId, int elementId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto graphIt = mConsumers.find(graphId);
+  if (mConsumers.end() == graphIt) return;
+  graphIt->second.erase(elementId);
+  if (graphIt->second.empty()) mConsumers.erase(graphIt);
+}
+
+bool RenderDemand::isWanted(int graphId,
+                            const ObjectMetadata& objectMetadata) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto graphIt = mConsumers.find(graphId);
+  if (mConsumers.end() == graphIt) return true;
+  for (auto& consumer : graphIt->second) {
+    if (!consumer.second || consumer.second(objectMetadata)) return true;
+  }
+  return false;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_RENDER_DEMAND_H_
+#define SOPHON_STREAM_COMMON_RENDER_DEMAND_H_
+
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "no_copyable.h"
+#include "object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 记录每个graph中OSD结果的消费者（encode、save_video等），
+ * OSD绘制前询问是否有消费者会用到这一帧的OSD图像。
+ * @brief
+ * 消费者以element id注册一个判断函数，例如WS推流在没有连接时返回false；
+ * 一个graph中没有任何消费者注册时视为需要绘制，与旧行为一致
+ */
+class RenderDemand : public ::sophon_stream::common::NoCopyable {
+ public:
+  using DemandFunc = std::function<bool(const ObjectMetadata&)>;
+
+  static RenderDemand& getInstance();
+
+  /**
+   * @brief 注册消费者，func为空表示每一帧都需要OSD图像
+   */
+  void addConsumer(int graphId, int elementId, DemandFunc func = nullptr);
+  void removeConsumer(int graphId, int elementId);
+
+  /**
+   * @brief 是否有消费者需要这一帧的OSD图像
+   */
+  bool isWanted(int graphId, const ObjectMetadata& objectMetadata);
+
+ private:
+  RenderDemand() = default;
+
+  std::mutex mMutex;
+  std::map<int /* graph id */, std::map<int /* element id */, DemandFunc>>
+      mConsumers;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_RENDER_DEMAND_H_
@@ -219,7 +219,8 @@ NLOHMANN_JSONIFY_ALL_THINGS(TrackedObjectMetadata, mTrackId)
 
 NLOHMANN_JSONIFY_ALL_THINGS(Rectangle<int>, mX, mY, mWidth, mHeight)
 
-NLOHMANN_JSONIFY_ALL_THINGS(DetectedObjectMetadata, mBox, mScores, mClassify)
+NLOHMANN_JSONIFY_ALL_THINGS(DetectedObjectMetadata, mBox, mScores, mClassify,
+                            mDepth)
 
 NLOHMANN_JSONIFY_ALL_THINGS(PosedObjectMetadata, keypoints)
 
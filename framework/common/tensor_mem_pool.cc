@@ -0,0 +1,282 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/tensor_mem_pool.h"
+
+#include <cstdlib>
+
+#include "common/logger.h"
+#include "common/memory_budget.h"
+
+namespace sophon_stream {
+namespace common {
+
+BMDeviceMemAllocator::BMDeviceMemAllocator(int devId)
+    : mHandle(nullptr), mOwnsHandle(true) {
+  auto ret = bm_dev_request(&mHandle, devId);
+  if (BM_SUCCESS != ret) {
+    IVS_ERROR("Request device failed, device id: {0}", devId);
+    mHandle = nullptr;
+  }
+}
+
+BMDeviceMemAllocator::BMDeviceMemAllocator(bm_handle_t handle)
+    : mHandle(handle), mOwnsHandle(false) {}
+
+BMDeviceMemAllocator::~BMDeviceMemAllocator() {
+  if (mHandle && mOwnsHandle) bm_dev_free(mHandle);
+}
+
+bm_status_t BMDeviceMemAllocator::allocate(bm_device_mem_t* mem, int heapId,
+                                           unsigned int bytes) {
+  if (!mHandle) return BM_ERR_DEVNOTREADY;
+  return bm_malloc_device_byte_heap(mHandle, mem, heapId, bytes);
+}
+
+void BMDeviceMemAllocator::free(bm_device_mem_t& mem) {
+  if (mHandle) bm_free_device(mHandle, mem);
+}
+
+bm_status_t HostMemAllocator::allocate(bm_device_mem_t* mem, int heapId,
+                                       unsigned int bytes) {
+  void* ptr = std::malloc(bytes);
+  if (!ptr) return BM_ERR_NOMEM;
+  *mem = bm_mem_from_device(reinterpret_cast<unsigned long long>(ptr), bytes);
+  return BM_SUCCESS;
+}
+
+void HostMemAllocator::free(bm_device_mem_t& mem) {
+  std::free(reinterpret_cast<void*>(bm_mem_get_device_addr(mem)));
+}
+
+TensorMemPool::TensorMemPool(std::shared_ptr<DeviceMemAllocator> allocator,
+                             int heapId, std::size_t maxCachedBytes)
+    : mAllocator(allocator), mHeapId(heapId), mMaxCachedBytes(maxCachedBytes) {}
+
+TensorMemPool::~TensorMemPool() { trim(); }
+
+unsigned int TensorMemPool::sizeClass(unsigned int bytes) {
+  constexpr unsigned int kPage = 4096;
+  constexpr unsigned int kLinearLimit = 64 * 1024;
+  unsigned int aligned = (bytes + kPage - 1) & ~(kPage - 1);
+  if (aligned == 0) aligned = kPage;
+  if (aligned <= kLinearLimit) return aligned;
+  // 64KB以上：在[2^k, 2^(k+1))区间内按2^(k-3)对齐，浪费不超过12.5%
+  unsigned int highBit = 31 - __builtin_clz(aligned);
+  unsigned int step = 1u << (highBit - 3);
+  return (aligned + step - 1) & ~(step - 1);
+}
+
+bm_status_t TensorMemPool::allocateFromDriver(unsigned int classBytes,
+                                              bm_device_mem_t* mem) {
+  auto ret = mAllocator->allocate(mem, mHeapId, classBytes);
+  if (BM_SUCCESS == ret) mStats.mDriverAllocs++;
+  return ret;
+}
+
+void TensorMemPool::updatePeak() {
+  if (mStats.mBytesInUse > mStats.mPeakBytesInUse)
+    mStats.mPeakBytesInUse = mStats.mBytesInUse;
+  std::size_t total = mStats.mBytesInUse + mStats.mBytesCached;
+  if (total > mStats.mPeakBytesTotal) mStats.mPeakBytesTotal = total;
+}
+
+bm_status_t TensorMemPool::acquire(unsigned int bytes, bm_device_mem_t* mem) {
+  unsigned int classBytes = sizeClass(bytes);
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStats.mAcquireCount++;
+
+  auto freeIt = mFreeLists.find(classBytes);
+  if (mFreeLists.end() != freeIt && !freeIt->second.empty()) {
+    *mem = freeIt->second.back();
+    freeIt->second.pop_back();
+    mStats.mHitCount++;
+    mStats.mBytesCached -= classBytes;
+  } else {
+    auto ret = allocateFromDriver(classBytes, mem);
+    if (BM_SUCCESS != ret) {
+      // 显存不足时先把空闲显存还给驱动再重试一次
+      for (auto& freeList : mFreeLists) {
+        for (auto& cached : freeList.second) {
+          mAllocator->free(cached);
+          mStats.mDriverFrees++;
+        }
+        freeList.second.clear();
+      }
+      mStats.mBytesCached = 0;
+      ret = allocateFromDriver(classBytes, mem);
+      if (BM_SUCCESS != ret) {
+        IVS_ERROR("Tensor mem pool alloc failed, heap: {0}, bytes: {1}",
+                  mHeapId, classBytes);
+        return ret;
+      }
+    }
+  }
+
+  int graphId = mDevId >= 0 ? MemoryBudget::getThreadGraph() : -1;
+  mInUse[bm_mem_get_device_addr(*mem)] = {classBytes, graphId};
+  mStats.mBytesInUse += classBytes;
+  updatePeak();
+  if (mDevId >= 0)
+    MemoryBudget::getInstance().add(graphId, mDevId, classBytes);
+  return BM_SUCCESS;
+}
+
+bool TensorMemPool::release(const bm_device_mem_t& mem) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto inUseIt = mInUse.find(bm_mem_get_device_addr(mem));
+  if (mInUse.end() == inUseIt) return false;
+
+  // 归还可能发生在下游element的线程上，按借出时记账的graph归还
+  unsigned int classBytes = inUseIt->second.classBytes;
+  int graphId = inUseIt->second.graphId;
+  mInUse.erase(inUseIt);
+  mStats.mBytesInUse -= classBytes;
+  if (mDevId >= 0)
+    MemoryBudget::getInstance().sub(graphId, mDevId, classBytes);
+
+  // 恢复成acquire时的描述，调用者可能改写过size
+  bm_device_mem_t cached =
+      bm_mem_from_device(bm_mem_get_device_addr(mem), classBytes);
+  if (mStats.mBytesCached + classBytes > mMaxCachedBytes) {
+    mAllocator->free(cached);
+    mStats.mDriverFrees++;
+    return true;
+  }
+  mFreeLists[classBytes].push_back(cached);
+  mStats.mBytesCached += classBytes;
+  return true;
+}
+
+void TensorMemPool::reserve(unsigned int bytes, int count) {
+  unsigned int classBytes = sizeClass(bytes);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& freeList = mFreeLists[classBytes];
+  while (static_cast<int>(freeList.size()) < count &&
+         mStats.mBytesCached + classBytes <= mMaxCachedBytes) {
+    bm_device_mem_t mem;
+    if (BM_SUCCESS != allocateFromDriver(classBytes, &mem)) {
+      IVS_WARN("Tensor mem pool reserve failed, heap: {0}, bytes: {1}",
+               mHeapId, classBytes);
+      break;
+    }
+    freeList.push_back(mem);
+    mStats.mBytesCached += classBytes;
+  }
+  updatePeak();
+}
+
+void TensorMemPool::trim() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (auto& freeList : mFreeLists) {
+    for (auto& mem : freeList.second) {
+      mAllocator->free(mem);
+      mStats.mDriverFrees++;
+    }
+  }
+  mFreeLists.clear();
+  mStats.mBytesCached = 0;
+}
+
+void TensorMemPool::setMaxCachedBytes(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMaxCachedBytes = bytes;
+}
+
+TensorMemPoolStats TensorMemPool::getStats() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+void TensorMemPool::dumpStats() {
+  auto stats = getStats();
+  IVS_INFO(
+      "Tensor mem pool device {0} heap {1}: acquire {2}, hit {3}, driver "
+      "alloc {4}, driver free {5}, in use {6} bytes, cached {7} bytes, peak "
+      "in use {8} bytes, peak total {9} bytes",
+      mDevId, mHeapId, stats.mAcquireCount, stats.mHitCount, stats.mDriverAllocs,
+      stats.mDriverFrees, stats.mBytesInUse, stats.mBytesCached,
+      stats.mPeakBytesInUse, stats.mPeakBytesTotal);
+}
+
+namespace {
+
+struct TensorMemPoolRegistry {
+  std::mutex mMutex;
+  std::map<std::pair<int /* devId */, int /* heapId */>,
+           std::shared_ptr<TensorMemPool>>
+      mPools;
+  TensorMemPool::AllocatorFactory mAllocatorFactory;
+};
+
+// 有意不析构：进程退出时仍可能有ObjectMetadata持有池内显存
+TensorMemPoolRegistry& getRegistry() {
+  static TensorMemPoolRegistry* registry = new TensorMemPoolRegistry();
+  return *registry;
+}
+
+}  // namespace
+
+std::shared_ptr<TensorMemPool> TensorMemPool::getInstance(int devId,
+                                                          int heapId) {
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  auto& pool = registry.mPools[std::make_pair(devId, heapId)];
+  if (!pool) {
+    std::shared_ptr<DeviceMemAllocator> allocator =
+        registry.mAllocatorFactory
+            ? registry.mAllocatorFactory(devId)
+            : std::make_shared<BMDeviceMemAllocator>(devId);
+    pool = std::make_shared<TensorMemPool>(allocator, heapId);
+    pool->setDeviceId(devId);
+    IVS_INFO("Tensor mem pool created, device id: {0}, heap: {1}", devId,
+             heapId);
+  }
+  return pool;
+}
+
+void TensorMemPool::recycle(bm_handle_t handle, bm_device_mem_t& mem) {
+  BMDeviceMemAllocator fallback(handle);
+  recycle(bm_get_devid(handle), mem, fallback);
+}
+
+void TensorMemPool::recycle(int devId, bm_device_mem_t& mem,
+                            DeviceMemAllocator& fallback) {
+  std::vector<std::shared_ptr<TensorMemPool>> pools;
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    for (auto& pool : registry.mPools) {
+      if (pool.first.first == devId) pools.push_back(pool.second);
+    }
+  }
+  for (auto& pool : pools) {
+    if (pool->release(mem)) return;
+  }
+  fallback.free(mem);
+}
+
+void TensorMemPool::setAllocatorFactory(AllocatorFactory factory) {
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mMutex);
+  registry.mAllocatorFactory = factory;
+}
+
+void TensorMemPool::dumpAllStats() {
+  std::vector<std::shared_ptr<TensorMemPool>> pools;
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mMutex);
+    for (auto& pool : registry.mPools) pools.push_back(pool.second);
+  }
+  for (auto& pool : pools) pool->dumpStats();
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,195 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_TENSOR_MEM_POOL_H_
+#define SOPHON_STREAM_COMMON_TENSOR_MEM_POOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "bmlib_runtime.h"
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 显存分配器接口，TensorMemPool通过它向驱动申请/释放显存
+ */
+class DeviceMemAllocator {
+ public:
+  virtual ~DeviceMemAllocator() = default;
+
+  virtual bm_status_t allocate(bm_device_mem_t* mem, int heapId,
+                               unsigned int bytes) = 0;
+  virtual void free(bm_device_mem_t& mem) = 0;
+};
+
+/**
+ * @brief 基于bmlib的显存分配器
+ */
+class BMDeviceMemAllocator : public DeviceMemAllocator {
+ public:
+  /**
+   * @brief 申请并持有独立的bm_handle_t
+   */
+  explicit BMDeviceMemAllocator(int devId);
+
+  /**
+   * @brief 使用调用者的handle，不负责释放
+   */
+  explicit BMDeviceMemAllocator(bm_handle_t handle);
+
+  ~BMDeviceMemAllocator() override;
+
+  bm_status_t allocate(bm_device_mem_t* mem, int heapId,
+                       unsigned int bytes) override;
+  void free(bm_device_mem_t& mem) override;
+
+ private:
+  bm_handle_t mHandle;
+  bool mOwnsHandle;
+};
+
+/**
+ * @brief 使用host内存模拟显存的分配器，device_addr即malloc得到的地址，
+ * 用于在没有设备的环境下验证显存池行为
+ */
+class HostMemAllocator : public DeviceMemAllocator {
+ public:
+  bm_status_t allocate(bm_device_mem_t* mem, int heapId,
+                       unsigned int bytes) override;
+  void free(bm_device_mem_t& mem) override;
+};
+
+struct TensorMemPoolStats {
+  std::size_t mAcquireCount = 0;   // acquire调用次数
+  std::size_t mHitCount = 0;       // 命中缓存的次数
+  std::size_t mDriverAllocs = 0;   // 向驱动申请显存的次数
+  std::size_t mDriverFrees = 0;    // 向驱动释放显存的次数
+  std::size_t mBytesInUse = 0;     // 已借出的显存
+  std::size_t mBytesCached = 0;    // 空闲链表中的显存
+  std::size_t mPeakBytesInUse = 0;  // mBytesInUse的高水位
+  std::size_t mPeakBytesTotal = 0;  // mBytesInUse + mBytesCached的高水位
+};
+
+/**
+ * @brief 按size class缓存显存的内存池。
+ * @brief 释放的显存不会还给驱动，而是挂回对应size
+ * class的空闲链表，下一帧直接复用，避免逐帧调用bm_malloc_device_byte_heap/bm_free_device
+ */
+class TensorMemPool : public ::sophon_stream::common::NoCopyable {
+ public:
+  TensorMemPool(std::shared_ptr<DeviceMemAllocator> allocator, int heapId,
+                std::size_t maxCachedBytes = DEFAULT_MAX_CACHED_BYTES);
+  ~TensorMemPool();
+
+  /**
+   * @brief 获取一块不小于bytes的显存，优先从空闲链表中取
+   * @return 与bm_malloc_device_byte_heap一致，成功返回BM_SUCCESS
+   */
+  bm_status_t acquire(unsigned int bytes, bm_device_mem_t* mem);
+
+  /**
+   * @brief 归还显存
+   * @return 若mem不是从本池中获取的，返回false，调用者需要自行释放
+   */
+  bool release(const bm_device_mem_t& mem);
+
+  /**
+   * @brief 预热，保证bytes对应的size class中至少有count块空闲显存
+   */
+  void reserve(unsigned int bytes, int count);
+
+  /**
+   * @brief 将所有空闲显存还给驱动
+   */
+  void trim();
+
+  void setMaxCachedBytes(std::size_t bytes);
+
+  TensorMemPoolStats getStats();
+
+  void dumpStats();
+
+  int getHeapId() const { return mHeapId; }
+
+  /**
+   * @brief 设置所属设备，设置后借出的显存计入MemoryBudget的设备占用；
+   * 借出时线程设置了MemoryBudget::setThreadGraph的，同时计入该graph
+   */
+  void setDeviceId(int devId) { mDevId = devId; }
+
+  /**
+   * @brief 计算bytes所属的size class：4KB对齐，64KB以上按每个2的幂区间8等分
+   */
+  static unsigned int sizeClass(unsigned int bytes);
+
+  /**
+   * @brief 获取设备devId上heapId对应的显存池，不存在时创建
+   */
+  static std::shared_ptr<TensorMemPool> getInstance(int devId, int heapId);
+
+  /**
+   * @brief 将显存还给其所属的显存池，若不属于任何显存池则调用bm_free_device
+   */
+  static void recycle(bm_handle_t handle, bm_device_mem_t& mem);
+
+  /**
+   * @brief 打印所有显存池的统计信息，显存池由进程级注册表持有、不会析构，
+   * 在Graph::stop时调用
+   */
+  static void dumpAllStats();
+
+  /**
+   * @brief 同上，不属于设备devId上任何显存池的显存由fallback释放
+   */
+  static void recycle(int devId, bm_device_mem_t& mem,
+                      DeviceMemAllocator& fallback);
+
+  using AllocatorFactory =
+      std::function<std::shared_ptr<DeviceMemAllocator>(int devId)>;
+
+  /**
+   * @brief 设置getInstance新建显存池时使用的分配器，为空时使用
+   * BMDeviceMemAllocator，已创建的显存池不受影响
+   */
+  static void setAllocatorFactory(AllocatorFactory factory);
+
+  static constexpr std::size_t DEFAULT_MAX_CACHED_BYTES = 512UL << 20;
+
+ private:
+  bm_status_t allocateFromDriver(unsigned int classBytes, bm_device_mem_t* mem);
+  void updatePeak();
+
+  std::shared_ptr<DeviceMemAllocator> mAllocator;
+  int mHeapId;
+  int mDevId = -1;
+  std::size_t mMaxCachedBytes;
+
+  std::mutex mMutex;
+  std::map<unsigned int /* size class */, std::vector<bm_device_mem_t>>
+      mFreeLists;
+  struct Lent {
+    unsigned int classBytes;
+    int graphId;  // 记账的graph，-1表示只计入设备
+  };
+  std::unordered_map<unsigned long long /* device addr */, Lent> mInUse;
+  TensorMemPoolStats mStats;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_TENSOR_MEM_POOL_H_
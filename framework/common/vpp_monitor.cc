@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/vpp_monitor.h"
+
+#include <map>
+#include <memory>
+
+namespace sophon_stream {
+namespace common {
+
+// 有意不析构：element的工作线程退出前仍可能调用
+VppMonitor& VppMonitor::getInstance(int devId) {
+  static std::mutex* mutex = new std::mutex();
+  static auto* monitors = new std::map<int, std::unique_ptr<VppMonitor>>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  auto& monitor = (*monitors)[devId];
+  if (!monitor) monitor.reset(new VppMonitor());
+  return *monitor;
+}
+
+bool VppMonitor::begin() { return mInflight++ == 0; }
+
+void VppMonitor::end(int images, double elapsedUs, bool idle) {
+  --mInflight;
+  if (images <= 0) return;
+  double perImage = elapsedUs / images;
+  std::lock_guard<std::mutex> lock(mMutex);
+  mLatencyUs =
+      mLatencyUs == 0.0 ? perImage : 0.9 * mLatencyUs + 0.1 * perImage;
+  if (!idle) return;
+  // 滑动窗口最小值：新样本之前耗时不小于它的样本不会再成为最小值
+  auto now = std::chrono::steady_clock::now();
+  while (!mIdleSamples.empty() && mIdleSamples.back().second >= perImage)
+    mIdleSamples.pop_back();
+  mIdleSamples.emplace_back(now, perImage);
+  auto expire = now - std::chrono::seconds(BASELINE_WINDOW_SECONDS);
+  while (mIdleSamples.front().first < expire) mIdleSamples.pop_front();
+  mBaselineUs = mIdleSamples.front().second;
+}
+
+bool VppMonitor::isSaturated() {
+  if (mInflight >= MAX_INFLIGHT) return true;
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mBaselineUs <= 0.0) return false;
+  if (mLatencyUs > LATENCY_FACTOR * mBaselineUs)
+    mSaturated = true;
+  else if (mLatencyUs < RECOVER_FACTOR * mBaselineUs)
+    mSaturated = false;
+  return mSaturated;
+}
+
+double VppMonitor::getLatencyUs() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLatencyUs;
+}
+
+double VppMonitor::getBaselineUs() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mBaselineUs;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_VPP_MONITOR_H_
+#define SOPHON_STREAM_COMMON_VPP_MONITOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 按设备统计前处理提交给VPP的任务：在途任务数和每幅图像的耗时。
+ * @brief
+ * 在途任务达到上限，或单幅图像耗时的滑动平均明显高于基线时认为VPP已饱和，
+ * 前处理据此把一部分帧分给CPU。
+ * @brief 基线取最近一段时间内空闲提交（提交时没有其他在途任务）的最小耗时，
+ * 排队中的样本不参与，基线不会随负载升高
+ * @brief 耗时超过基线的LATENCY_FACTOR倍进入饱和，降到RECOVER_FACTOR倍以下才
+ * 退出，耗时在两者之间波动时保持原状态，分流不会逐帧来回切换
+ */
+class VppMonitor : public ::sophon_stream::common::NoCopyable {
+ public:
+  static VppMonitor& getInstance(int devId);
+
+  /**
+   * @brief 提交VPP任务前调用
+   * @return 提交时没有其他在途任务返回true，需要传给end
+   */
+  bool begin();
+
+  /**
+   * @brief VPP任务完成后调用
+   * @param images 本次处理的图像数
+   * @param elapsedUs 本次耗时，单位微秒
+   * @param idle begin的返回值
+   */
+  void end(int images, double elapsedUs, bool idle);
+
+  bool isSaturated();
+
+  int getInflight() const { return mInflight; }
+  double getLatencyUs();
+  double getBaselineUs();
+
+ private:
+  VppMonitor() = default;
+
+  static constexpr const int MAX_INFLIGHT = 2;
+  static constexpr const double LATENCY_FACTOR = 2.0;
+  static constexpr const double RECOVER_FACTOR = 1.5;
+  static constexpr const int BASELINE_WINDOW_SECONDS = 60;
+
+  std::atomic<int> mInflight{0};
+  std::mutex mMutex;
+  double mLatencyUs = 0.0;   // 单幅图像耗时的滑动平均
+  double mBaselineUs = 0.0;  // 窗口内空闲样本的最小值
+  bool mSaturated = false;   // 按耗时判断的饱和状态
+  // 最近BASELINE_WINDOW_SECONDS秒内空闲提交的单幅图像耗时，按耗时单调递增，
+  // 队首即窗口最小值；分辨率变化后旧样本过期，基线随之更新
+  std::deque<std::pair<std::chrono::steady_clock::time_point, double>>
+      mIdleSamples;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_VPP_MONITOR_H_
@@ -26,8 +26,10 @@
 #include <thread>
 #include <vector>
 
+#include "common/detection_scheduler.h"
 #include "common/error_code.h"
 #include "common/http_defs.h"
+#include "common/input_synchronizer.h"
 // #include "common/logger.h"
 #include "common/no_copyable.h"
 #include "connector.h"
@@ -221,6 +223,36 @@ class Element : public ::sophon_stream::common::NoCopyable {
    */
   int getInputConnectorCapacity(int inputPort);
 
+  /**
+   * @brief 设置多输入对齐的参数，需要在doWork之前调用
+   */
+  void setInputSyncConfig(const common::InputSynchronizer::Config& config) {
+    mInputSyncConfig = config;
+  }
+
+  /**
+   * @brief 多输入element取一组对齐的数据：各输入口的数据先放入该dataPipe的对齐
+   * 窗口（窗口满的口暂不取，保留反压），再取出对齐的一组
+   * @param[out] inputs 按getInputPorts()的顺序排列
+   * @return 暂时无法对齐时返回false
+   */
+  bool popSyncedInputData(int dataPipeId, common::ObjectMetadatas& inputs);
+
+  /**
+   * @brief 设置检测调度参数，需要在doWork之前调用；
+   * 分阶段部署时只需配置在做前处理的element上
+   * @param modelPath 检测模型，同一模型分阶段部署的各element据此共用判断
+   */
+  void setDetectionSchedule(const common::DetectionScheduler::Config& config,
+                            const std::string& modelPath);
+
+  /**
+   * @brief 检测element在组batch时调用：channel配置了skip_element或
+   * 检测调度不需要检测时返回true，该帧直接透传，并置mDetectionSkipped。
+   * 同一模型的前面阶段已经判断过的帧直接沿用，其他模型的判断不影响本模型
+   */
+  bool skipDetection(common::ObjectMetadata& objectMetadata);
+
  private:
   int mId;
 
@@ -234,6 +266,14 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   std::vector<std::shared_ptr<std::thread>> mThreads;
 
+  common::InputSynchronizer::Config mInputSyncConfig;
+  std::mutex mInputSyncMutex;
+  std::map<int /* dataPipeId */, std::unique_ptr<common::InputSynchronizer>>
+      mInputSynchronizers;
+
+  std::unique_ptr<common::DetectionScheduler> mDetectionScheduler;
+  std::size_t mDetectionModel = 0;
+
   std::atomic<ThreadStatus> mThreadStatus;
 
   /**
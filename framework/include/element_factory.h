@@ -45,6 +45,18 @@ class ElementFactory : public ::sophon_stream::common::NoCopyable {
    */
   std::shared_ptr<framework::Element> make(const std::string& elementName);
 
+  /**
+   * @brief 添加静态链接进可执行文件的element，由编译期注册调用。
+   * 与addElementMaker添加的不同，graph析构时不会被清除
+   */
+  static common::ErrorCode addStaticElementMaker(const std::string& elementName,
+                                                 ElementMaker elementMaker);
+
+  /**
+   * @brief elementName是否已静态链接，是则不需要再dlopen其shared_object
+   */
+  static bool isStaticElement(const std::string& elementName);
+
   friend class common::Singleton<ElementFactory>;
 
   ElementFactory();
@@ -52,10 +64,31 @@ class ElementFactory : public ::sophon_stream::common::NoCopyable {
   std::map<std::string, ElementMaker> mElementMakerMap;
 
   ~ElementFactory();
+
+ private:
+  /**
+   * @brief 静态element的注册表。静态对象初始化顺序不确定，用局部静态变量保证
+   * 注册时已构造
+   */
+  static std::map<std::string, ElementMaker>& staticElementMakerMap();
 };
 
 using SingletonElementFactory = common::Singleton<ElementFactory>;
 
+/**
+ * @brief 以STREAM_STATIC_ELEMENT编译的element静态链接进可执行文件，
+ * 注册为静态element；否则作为shared_object由graph dlopen后注册
+ */
+#ifdef STREAM_STATIC_ELEMENT
+#define STREAM_ADD_ELEMENT_MAKER(elementFactory, elementName, elementMaker) \
+  (void)elementFactory;                                                     \
+  ::sophon_stream::framework::ElementFactory::addStaticElementMaker(        \
+      elementName, elementMaker)
+#else
+#define STREAM_ADD_ELEMENT_MAKER(elementFactory, elementName, elementMaker) \
+  elementFactory.addElementMaker(elementName, elementMaker)
+#endif
+
 /**
  * @brief 向工厂中注册element
  */
@@ -65,8 +98,9 @@ using SingletonElementFactory = common::Singleton<ElementFactory>;
       auto& elementFactory =                                                  \
           ::sophon_stream::framework::SingletonElementFactory::getInstance(); \
       std::cout << elementName << std::endl;                                  \
-      elementFactory.addElementMaker(                                         \
-          elementName, []() { return std::make_shared<ElementClass>(); });    \
+      STREAM_ADD_ELEMENT_MAKER(                                               \
+          elementFactory, elementName,                                        \
+          []() { return std::make_shared<ElementClass>(); });                 \
     }                                                                         \
   };                                                                          \
   static ElementClass##Register g##ElementClass##Register;
@@ -77,8 +111,9 @@ using SingletonElementFactory = common::Singleton<ElementFactory>;
       auto& elementFactory =                                                  \
           ::sophon_stream::framework::SingletonElementFactory::getInstance(); \
       std::cout << elementName << std::endl;                                  \
-      elementFactory.addElementMaker(                                         \
-          elementName, []() { return std::make_shared<GroupElement>(); });    \
+      STREAM_ADD_ELEMENT_MAKER(                                               \
+          elementFactory, elementName,                                        \
+          []() { return std::make_shared<GroupElement>(); });                 \
     }                                                                         \
   };                                                                          \
   static Group##ElementClass##Register g##Group##ElementClass##Register;
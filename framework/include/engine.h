@@ -11,10 +11,15 @@
 #define SOPHON_STREAM_FRAMEWORK_ELEMENT_ENGINE_H_
 
 #include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <nlohmann/json.hpp>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "common/device_scheduler.h"
 #include "common/error_code.h"
 #include "common/logger.h"
 #include "common/no_copyable.h"
@@ -37,7 +42,10 @@ class Engine : public ::sophon_stream::common::NoCopyable {
   common::ErrorCode resume(int graphId);
 
   /**
-   * @brief 从配置文件初始化一个有向无环图，并将线程状态设置为RUN
+   * @brief 从配置文件初始化一个有向无环图，并将线程状态设置为RUN。
+   * @brief
+   * 配置中有device_ids时，按列表在每个设备上复制一份graph，第i个副本的graph id
+   * 为graph_id + i * REPLICA_GRAPH_ID_STRIDE，码流通过assignChannel分配到副本
    */
   common::ErrorCode addGraph(const std::string& json);
 
@@ -61,6 +69,24 @@ class Engine : public ::sophon_stream::common::NoCopyable {
 
   std::pair<std::string, int> getSideAndDeviceId(int graphId, int elementId);
 
+  /**
+   * @brief 为一路码流选择graph副本，返回启动任务应推入的graph id。
+   * graph没有按设备复制时返回graphId本身
+   */
+  int assignChannel(int graphId, int channelId);
+
+  /**
+   * @brief 码流停止时调用，返回停止任务应推入的graph id
+   */
+  int releaseChannel(int graphId, int channelId);
+
+  /**
+   * @brief 按设备复制的graph的各副本状态：设备占用率、积压和码流数
+   */
+  std::map<int /* graphId */,
+           std::vector<common::DeviceScheduler::ReplicaStatus> >
+  getDeviceStatus();
+
   std::vector<int> getGraphIds();
 
   inline ListenThread* getListener() { return listenThreadPtr; }
@@ -68,6 +94,10 @@ class Engine : public ::sophon_stream::common::NoCopyable {
   inline void setListener(ListenThread* p) { listenThreadPtr = p; }
 
   static constexpr const char* JSON_GRAPH_ID_FIELD = "graph_id";
+  static constexpr const char* JSON_DEVICE_IDS_FIELD = "device_ids";
+  static constexpr const char* JSON_SHARDING_FIELD = "sharding";
+  static constexpr const char* JSON_DEVICE_BACKEND_FIELD = "device_backend";
+  static constexpr const int REPLICA_GRAPH_ID_STRIDE = 1000;
 
  private:
   friend class common::Singleton<Engine>;
@@ -76,11 +106,41 @@ class Engine : public ::sophon_stream::common::NoCopyable {
 
   ~Engine();
 
+  /**
+   * @brief 初始化并启动一个graph，成功后加入mGraphMap，调用者持有mGraphMapLock
+   * @return graph id已被其他graph或按设备复制的graph使用时返回
+   * REPEATED_GRAPH_ID
+   */
+  common::ErrorCode createGraph(const std::string& json,
+                                std::shared_ptr<framework::Graph>& graph);
+
+  common::ErrorCode addShardedGraph(nlohmann::json& configure);
+
+  /**
+   * @brief graphId对应的所有graph：按设备复制时为各副本，否则为graph本身。
+   * 调用者持有mGraphMapLock
+   */
+  common::ErrorCode findGraphs(
+      int graphId, std::vector<std::shared_ptr<framework::Graph> >& graphs);
+
+  /**
+   * @brief 周期采样各调度器，第一个按设备复制的graph加入时启动
+   */
+  void sampleLoop();
+
   std::map<int /* graphId */, std::shared_ptr<framework::Graph> > mGraphMap;
   std::mutex mGraphMapLock;
 
   std::vector<int> mGraphIds;
 
+  std::map<int /* graphId */, std::shared_ptr<common::DeviceScheduler> >
+      mSchedulers;
+
+  std::thread mSampleThread;
+  std::mutex mSampleMutex;
+  std::condition_variable mSampleCv;
+  bool mSampleStop = false;
+
   ListenThread* listenThreadPtr;
 };
 
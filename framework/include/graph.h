@@ -64,6 +64,11 @@ class Graph : public ::sophon_stream::common::NoCopyable {
 
   std::pair<std::string, int> getSideAndDeviceId(int elementId);
 
+  /**
+   * @brief 所有element输入队列中积压的数据条数，用于判断graph是否跟得上输入
+   */
+  int getBacklog();
+
   int getId() const;
 
   inline ListenThread* getListener() { return listenThreadPtr; }
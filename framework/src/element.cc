@@ -1,5 +1,9 @@
 #include "element.h"
 
+#include <algorithm>
+
+#include "common/memory_budget.h"
+
 namespace sophon_stream {
 namespace framework {
 
@@ -168,6 +172,8 @@ common::ErrorCode Element::resume() {
 }
 
 void Element::run(int dataPipeId) {
+  // 本线程借出的tensor显存计入所属graph的预算
+  common::MemoryBudget::setThreadGraph(mGraphId);
   onStart();
   prctl(PR_SET_NAME, std::to_string(mId).c_str());
   while (ThreadStatus::RUN == mThreadStatus) {
@@ -193,7 +199,7 @@ common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
   while (mInputConnectorMap[inputPort]->pushData(dataPipeId, data) !=
          common::ErrorCode::SUCCESS) {
     listenThreadPtr->report_status(common::ErrorCode::DECODE_CHANNEL_PIPE_FULL);
-    IVS_DEBUG("Input DataPipe is full, now sleeping...");
+    IVS_DEBUG_EVERY_MS(1000, "Input DataPipe is full, now sleeping...");
     std::this_thread::sleep_for(std::chrono::milliseconds(5));
   }
   return common::ErrorCode::SUCCESS;
@@ -206,6 +212,55 @@ std::shared_ptr<void> Element::popInputData(int inputPort, int dataPipeId) {
   return mInputConnectorMap[inputPort]->popData(dataPipeId);
 }
 
+bool Element::popSyncedInputData(int dataPipeId,
+                                 common::ObjectMetadatas& inputs) {
+  std::vector<int> inputPorts = getInputPorts();
+  common::InputSynchronizer* synchronizer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mInputSyncMutex);
+    auto& ptr = mInputSynchronizers[dataPipeId];
+    if (!ptr)
+      ptr = std::make_unique<common::InputSynchronizer>(
+          inputPorts.size(), mInputSyncConfig,
+          "element " + std::to_string(mId) + " datapipe " +
+              std::to_string(dataPipeId));
+    synchronizer = ptr.get();
+  }
+
+  for (int i = 0; i < inputPorts.size(); ++i) {
+    while (!synchronizer->full(i)) {
+      auto data = popInputData(inputPorts[i], dataPipeId);
+      if (!data) break;
+      synchronizer->push(i,
+                         std::static_pointer_cast<common::ObjectMetadata>(data));
+    }
+  }
+  return synchronizer->pop(inputs);
+}
+
+void Element::setDetectionSchedule(
+    const common::DetectionScheduler::Config& config,
+    const std::string& modelPath) {
+  mDetectionModel = std::hash<std::string>()(modelPath);
+  mDetectionScheduler = std::make_unique<common::DetectionScheduler>(config);
+  if (!mDetectionScheduler->enabled()) mDetectionScheduler.reset();
+}
+
+bool Element::skipDetection(common::ObjectMetadata& objectMetadata) {
+  if (objectMetadata.mFrame->mEndOfStream) return false;
+  // 检测调度每帧只能判断一次，推理、后处理阶段不再重复计算运动缩略图
+  if (objectMetadata.mDetectionDecider == mDetectionModel)
+    return objectMetadata.mDetectionSkipped;
+  objectMetadata.mDetectionDecider = mDetectionModel;
+  objectMetadata.mDetectionSkipped =
+      std::find(objectMetadata.mSkipElements.begin(),
+                objectMetadata.mSkipElements.end(),
+                mId) != objectMetadata.mSkipElements.end() ||
+      (mDetectionScheduler != nullptr &&
+       !mDetectionScheduler->shouldDetect(objectMetadata));
+  return objectMetadata.mDetectionSkipped;
+}
+
 void Element::setSinkHandler(int outputPort, SinkHandler dataHandler) {
   IVS_INFO("Set data handler, element id: {0:d}, output port: {1:d}", mId,
            outputPort);
@@ -229,7 +284,8 @@ common::ErrorCode Element::pushOutputData(int outputPort, int dataPipeId,
   while (mOutputConnectorMap[outputPort].lock()->pushData(dataPipeId, data) !=
          common::ErrorCode::SUCCESS && mThreadStatus != ThreadStatus::STOP) {
     listenThreadPtr->report_status(common::ErrorCode::DATA_PIPE_FULL);
-    IVS_DEBUG(
+    IVS_DEBUG_EVERY_MS(
+        1000,
         "DataPipe is full, now sleeping. ElementID is {0}, outputPort is {1}, "
         "dataPipeId is {2}",
         mId, outputPort, dataPipeId);
@@ -37,6 +37,10 @@ common::ErrorCode ElementFactory::addElementMaker(
 
 std::shared_ptr<framework::Element> ElementFactory::make(
     const std::string& elementName) {
+  auto& staticMakerMap = staticElementMakerMap();
+  auto staticMakerIt = staticMakerMap.find(elementName);
+  if (staticMakerMap.end() != staticMakerIt) return staticMakerIt->second();
+
   auto elementMakerIt = mElementMakerMap.find(elementName);
   if (mElementMakerMap.end() != elementMakerIt && elementMakerIt->second) {
     return elementMakerIt->second();
@@ -46,6 +50,28 @@ std::shared_ptr<framework::Element> ElementFactory::make(
   }
 }
 
+common::ErrorCode ElementFactory::addStaticElementMaker(
+    const std::string& elementName, ElementMaker elementMaker) {
+  auto& staticMakerMap = staticElementMakerMap();
+  if (staticMakerMap.end() != staticMakerMap.find(elementName)) {
+    IVS_ERROR("Repeated static element name, name: {0}", elementName);
+    return common::ErrorCode::REPEATED_WORKER_NAME;
+  }
+  staticMakerMap[elementName] = elementMaker;
+  return common::ErrorCode::SUCCESS;
+}
+
+bool ElementFactory::isStaticElement(const std::string& elementName) {
+  auto& staticMakerMap = staticElementMakerMap();
+  return staticMakerMap.end() != staticMakerMap.find(elementName);
+}
+
+std::map<std::string, ElementFactory::ElementMaker>&
+ElementFactory::staticElementMakerMap() {
+  static std::map<std::string, ElementMaker> staticMakerMap;
+  return staticMakerMap;
+}
+
 ElementFactory::ElementFactory() {}
 
 ElementFactory::~ElementFactory() {
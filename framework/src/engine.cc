@@ -1,6 +1,8 @@
 
 #include "engine.h"
 
+#include <algorithm>
+
 #include "common/logger.h"
 
 namespace sophon_stream {
@@ -8,85 +10,77 @@ namespace framework {
 
 Engine::Engine() {}
 
-Engine::~Engine() {}
+Engine::~Engine() {
+  {
+    std::lock_guard<std::mutex> lk(mSampleMutex);
+    mSampleStop = true;
+  }
+  mSampleCv.notify_all();
+  if (mSampleThread.joinable()) mSampleThread.join();
+}
 
 common::ErrorCode Engine::start(int graphId) {
   IVS_INFO("Engine start graph thread start, graph id: {0:d}", graphId);
+
   std::lock_guard<std::mutex> lk(mGraphMapLock);
-  auto graphIt = mGraphMap.find(graphId);
-  if (mGraphMap.end() == graphIt) {
-    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
-    return common::ErrorCode::NO_SUCH_GRAPH_ID;
-  }
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  common::ErrorCode errorCode = findGraphs(graphId, graphs);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
 
-  auto graph = graphIt->second;
-  if (!graph) {
-    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
-    return common::ErrorCode::UNKNOWN;
+  for (auto& graph : graphs) {
+    errorCode = graph->start();
+    if (common::ErrorCode::SUCCESS != errorCode) break;
   }
-
   IVS_INFO("Engine start graph thread finish, graph id: {0:d}", graphId);
-  return graph->start();
+  return errorCode;
 }
 
 common::ErrorCode Engine::stop(int graphId) {
   IVS_INFO("Engine stop graph thread start, graph id: {0:d}", graphId);
 
   std::lock_guard<std::mutex> lk(mGraphMapLock);
-  auto graphIt = mGraphMap.find(graphId);
-  if (mGraphMap.end() == graphIt) {
-    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
-    return common::ErrorCode::NO_SUCH_GRAPH_ID;
-  }
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  common::ErrorCode errorCode = findGraphs(graphId, graphs);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
 
-  auto graph = graphIt->second;
-  if (!graph) {
-    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
-    return common::ErrorCode::UNKNOWN;
+  for (auto& graph : graphs) {
+    errorCode = graph->stop();
+    if (common::ErrorCode::SUCCESS != errorCode) break;
   }
-
   IVS_INFO("Engine stop graph thread finish, graph id: {0:d}", graphId);
-  return graph->stop();
+  return errorCode;
 }
 
 common::ErrorCode Engine::pause(int graphId) {
   IVS_INFO("Engine pause graph thread start, graph id: {0:d}", graphId);
 
   std::lock_guard<std::mutex> lk(mGraphMapLock);
-  auto graphIt = mGraphMap.find(graphId);
-  if (mGraphMap.end() == graphIt) {
-    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
-    return common::ErrorCode::NO_SUCH_GRAPH_ID;
-  }
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  common::ErrorCode errorCode = findGraphs(graphId, graphs);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
 
-  auto graph = graphIt->second;
-  if (!graph) {
-    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
-    return common::ErrorCode::UNKNOWN;
+  for (auto& graph : graphs) {
+    errorCode = graph->pause();
+    if (common::ErrorCode::SUCCESS != errorCode) break;
   }
-
   IVS_INFO("Engine pause graph thread finish, graph id: {0:d}", graphId);
-  return graph->pause();
+  return errorCode;
 }
 
 common::ErrorCode Engine::resume(int graphId) {
   IVS_INFO("Engine resume graph thread start, graph id: {0:d}", graphId);
 
   std::lock_guard<std::mutex> lk(mGraphMapLock);
-  auto graphIt = mGraphMap.find(graphId);
-  if (mGraphMap.end() == graphIt) {
-    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
-    return common::ErrorCode::NO_SUCH_GRAPH_ID;
-  }
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  common::ErrorCode errorCode = findGraphs(graphId, graphs);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
 
-  auto graph = graphIt->second;
-  if (!graph) {
-    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
-    return common::ErrorCode::UNKNOWN;
+  for (auto& graph : graphs) {
+    errorCode = graph->resume();
+    if (common::ErrorCode::SUCCESS != errorCode) break;
   }
-
   IVS_INFO("Engine resume graph thread finish, graph id: {0:d}", graphId);
-  return graph->resume();
+  return errorCode;
 }
 
 common::ErrorCode Engine::addGraph(const std::string& json) {
@@ -97,35 +91,192 @@ common::ErrorCode Engine::addGraph(const std::string& json) {
   do {
     std::lock_guard<std::mutex> lk(mGraphMapLock);
 
-    auto graph = std::make_shared<framework::Graph>();
-    graph->setListener(listenThreadPtr);
-    errorCode = graph->init(json);
-    listenThreadPtr->report_status(errorCode);
-    if (common::ErrorCode::SUCCESS != errorCode) {
-      IVS_ERROR("Graph init fail, json: {0}", json);
-      return errorCode;
+    auto configure = nlohmann::json::parse(json, nullptr, false);
+    if (configure.is_object() && configure.contains(JSON_DEVICE_IDS_FIELD)) {
+      errorCode = addShardedGraph(configure);
+      if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+      break;
     }
 
-    errorCode = graph->start();
-    listenThreadPtr->report_status(errorCode);
+    std::shared_ptr<framework::Graph> graph;
+    errorCode = createGraph(json, graph);
+    if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+    mGraphIds.push_back(graph->getId());
+
+  } while (false);
+
+  IVS_INFO("Add graph finish, json: {0}", json);
+  return errorCode;
+}
 
-    if (common::ErrorCode::SUCCESS != errorCode) {
-      IVS_ERROR("Graph start fail");
-      return errorCode;
+common::ErrorCode Engine::createGraph(
+    const std::string& json, std::shared_ptr<framework::Graph>& graph) {
+  // 在初始化element之前检查，重复的graph id不加载模型、不覆盖已有的graph
+  auto configure = nlohmann::json::parse(json, nullptr, false);
+  if (configure.is_object()) {
+    auto graphIdIt = configure.find(JSON_GRAPH_ID_FIELD);
+    if (configure.end() != graphIdIt && graphIdIt->is_number_integer()) {
+      int graphId = graphIdIt->get<int>();
+      if (mGraphMap.end() != mGraphMap.find(graphId) ||
+          mSchedulers.end() != mSchedulers.find(graphId)) {
+        IVS_ERROR("Repeated graph id: {0:d}", graphId);
+        listenThreadPtr->report_status(common::ErrorCode::REPEATED_GRAPH_ID);
+        return common::ErrorCode::REPEATED_GRAPH_ID;
+      }
     }
+  }
 
-    mGraphMap[graph->getId()] = graph;
-    IVS_INFO("Add graph finish, json: {0}", json);
-    mGraphIds.push_back(graph->getId());
+  graph = std::make_shared<framework::Graph>();
+  graph->setListener(listenThreadPtr);
+  common::ErrorCode errorCode = graph->init(json);
+  listenThreadPtr->report_status(errorCode);
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_ERROR("Graph init fail, json: {0}", json);
+    return errorCode;
+  }
 
-  } while (false);
+  errorCode = graph->start();
+  listenThreadPtr->report_status(errorCode);
+
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_ERROR("Graph start fail");
+    return errorCode;
+  }
 
+  mGraphMap[graph->getId()] = graph;
   return errorCode;
 }
 
+common::ErrorCode Engine::addShardedGraph(nlohmann::json& configure) {
+  auto graphIdIt = configure.find(JSON_GRAPH_ID_FIELD);
+  auto deviceIdsIt = configure.find(JSON_DEVICE_IDS_FIELD);
+  if (configure.end() == graphIdIt || !graphIdIt->is_number_integer() ||
+      !deviceIdsIt->is_array() || deviceIdsIt->empty()) {
+    IVS_ERROR("Sharded graph needs integer {0} and non-empty array {1}",
+              JSON_GRAPH_ID_FIELD, JSON_DEVICE_IDS_FIELD);
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  std::vector<int> deviceIds;
+  for (auto& deviceId : *deviceIdsIt) {
+    if (!deviceId.is_number_integer() || deviceId.get<int>() < 0) {
+      IVS_ERROR("Invalid device id in {0}: {1}", JSON_DEVICE_IDS_FIELD,
+                deviceIdsIt->dump());
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+    deviceIds.push_back(deviceId.get<int>());
+  }
+  int graphId = graphIdIt->get<int>();
+  if (mSchedulers.end() != mSchedulers.find(graphId)) {
+    IVS_ERROR("Repeated graph id: {0:d}", graphId);
+    return common::ErrorCode::REPEATED_GRAPH_ID;
+  }
+
+  nlohmann::json sharding = nlohmann::json::object();
+  auto shardingIt = configure.find(JSON_SHARDING_FIELD);
+  if (configure.end() != shardingIt && shardingIt->is_object())
+    sharding = *shardingIt;
+  std::string backendName = "bm";
+  auto backendIt = sharding.find(JSON_DEVICE_BACKEND_FIELD);
+  if (sharding.end() != backendIt && backendIt->is_string())
+    backendName = backendIt->get<std::string>();
+  auto backend = common::makeDeviceBackend(
+      backendName, *std::max_element(deviceIds.begin(), deviceIds.end()) + 1);
+  if (!backend) {
+    IVS_ERROR("Unknown device backend: {0}", backendName);
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  int deviceCount = backend->getDeviceCount();
+  for (int deviceId : deviceIds) {
+    if (deviceId >= deviceCount) {
+      IVS_ERROR("Device {0:d} not found, {1:d} devices available", deviceId,
+                deviceCount);
+      return common::ErrorCode::PARAMETER_ERROR;
+    }
+  }
+
+  auto scheduler = std::make_shared<common::DeviceScheduler>(
+      common::DeviceScheduler::parseConfig(sharding), backend);
+  configure.erase(JSON_DEVICE_IDS_FIELD);
+  configure.erase(JSON_SHARDING_FIELD);
+
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  std::vector<std::shared_ptr<framework::Graph> > replicas;
+  for (int i = 0; i < (int)deviceIds.size(); ++i) {
+    int replicaId = graphId + i * REPLICA_GRAPH_ID_STRIDE;
+    if (mGraphMap.end() != mGraphMap.find(replicaId)) {
+      IVS_ERROR("Replica graph id {0:d} is already used", replicaId);
+      errorCode = common::ErrorCode::REPEATED_GRAPH_ID;
+      break;
+    }
+    nlohmann::json replica = configure;
+    replica[JSON_GRAPH_ID_FIELD] = replicaId;
+    auto elementsIt = replica.find(framework::Graph::JSON_WORKERS_FIELD);
+    if (replica.end() != elementsIt && elementsIt->is_array()) {
+      for (auto& element : *elementsIt)
+        element[framework::Element::JSON_DEVICE_ID_FIELD] = deviceIds[i];
+    }
+
+    std::shared_ptr<framework::Graph> graph;
+    errorCode = createGraph(replica.dump(), graph);
+    if (common::ErrorCode::SUCCESS != errorCode) break;
+    replicas.push_back(graph);
+    std::weak_ptr<framework::Graph> weakGraph = graph;
+    scheduler->addReplica(replicaId, deviceIds[i], [weakGraph]() {
+      auto graph = weakGraph.lock();
+      return graph ? graph->getBacklog() : 0;
+    });
+  }
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    for (auto& graph : replicas) {
+      graph->stop();
+      mGraphMap.erase(graph->getId());
+    }
+    return errorCode;
+  }
+
+  mSchedulers[graphId] = scheduler;
+  mGraphIds.push_back(graphId);
+  if (!mSampleThread.joinable())
+    mSampleThread = std::thread(&Engine::sampleLoop, this);
+  IVS_INFO("Graph {0:d} replicated on {1:d} devices, device backend: {2}",
+           graphId, deviceIds.size(), backendName);
+  return errorCode;
+}
+
+common::ErrorCode Engine::findGraphs(
+    int graphId, std::vector<std::shared_ptr<framework::Graph> >& graphs) {
+  std::vector<int> graphIds{graphId};
+  auto schedulerIt = mSchedulers.find(graphId);
+  if (mSchedulers.end() != schedulerIt) {
+    graphIds.clear();
+    for (auto& status : schedulerIt->second->getStatus())
+      graphIds.push_back(status.mGraphId);
+  }
+
+  for (int id : graphIds) {
+    auto graphIt = mGraphMap.find(id);
+    if (mGraphMap.end() == graphIt) {
+      IVS_ERROR("Can not find graph, graph id: {0:d}", id);
+      return common::ErrorCode::NO_SUCH_GRAPH_ID;
+    }
+    if (!graphIt->second) {
+      IVS_ERROR("Graph is null, graph id: {0:d}", id);
+      return common::ErrorCode::UNKNOWN;
+    }
+    graphs.push_back(graphIt->second);
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
 void Engine::removeGraph(int graphId) {
   std::lock_guard<std::mutex> lk(mGraphMapLock);
   IVS_INFO("Remove graph start, graph id: {0:d}", graphId);
+  auto schedulerIt = mSchedulers.find(graphId);
+  if (mSchedulers.end() != schedulerIt) {
+    for (auto& status : schedulerIt->second->getStatus())
+      mGraphMap.erase(status.mGraphId);
+    mSchedulers.erase(schedulerIt);
+  }
   mGraphMap.erase(graphId);
   IVS_INFO("Remove graph finish, graph id: {0:d}", graphId);
 }
@@ -146,19 +297,12 @@ void Engine::setSinkHandler(int graphId, int elementId, int outputPort,
       "{2:d}",
       graphId, elementId, outputPort);
 
-  auto graphIt = mGraphMap.find(graphId);
-  if (mGraphMap.end() == graphIt) {
-    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
-    return;
-  }
-
-  auto graph = graphIt->second;
-  if (!graph) {
-    IVS_ERROR("Graph is null, graph id: {0:d}", graphId);
-    return;
-  }
+  std::lock_guard<std::mutex> lk(mGraphMapLock);
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  if (common::ErrorCode::SUCCESS != findGraphs(graphId, graphs)) return;
 
-  graph->setSinkHandler(elementId, outputPort, sinkHandler);
+  for (auto& graph : graphs)
+    graph->setSinkHandler(elementId, outputPort, sinkHandler);
 }
 
 common::ErrorCode Engine::pushSourceData(int graphId, int elementId,
@@ -206,5 +350,57 @@ std::pair<std::string, int> Engine::getSideAndDeviceId(int graphId,
 
 std::vector<int> Engine::getGraphIds() { return mGraphIds; }
 
+int Engine::assignChannel(int graphId, int channelId) {
+  std::shared_ptr<common::DeviceScheduler> scheduler;
+  {
+    std::lock_guard<std::mutex> lk(mGraphMapLock);
+    auto schedulerIt = mSchedulers.find(graphId);
+    if (mSchedulers.end() == schedulerIt) return graphId;
+    scheduler = schedulerIt->second;
+  }
+  return scheduler->assign(channelId);
+}
+
+int Engine::releaseChannel(int graphId, int channelId) {
+  std::shared_ptr<common::DeviceScheduler> scheduler;
+  {
+    std::lock_guard<std::mutex> lk(mGraphMapLock);
+    auto schedulerIt = mSchedulers.find(graphId);
+    if (mSchedulers.end() == schedulerIt) return graphId;
+    scheduler = schedulerIt->second;
+  }
+  int replicaId = scheduler->release(channelId);
+  return replicaId < 0 ? graphId : replicaId;
+}
+
+std::map<int, std::vector<common::DeviceScheduler::ReplicaStatus> >
+Engine::getDeviceStatus() {
+  std::lock_guard<std::mutex> lk(mGraphMapLock);
+  std::map<int, std::vector<common::DeviceScheduler::ReplicaStatus> > status;
+  for (auto& pair : mSchedulers) status[pair.first] = pair.second->getStatus();
+  return status;
+}
+
+void Engine::sampleLoop() {
+  while (true) {
+    std::vector<std::shared_ptr<common::DeviceScheduler> > schedulers;
+    int intervalMs = common::DeviceScheduler::Config().sampleIntervalMs;
+    {
+      std::lock_guard<std::mutex> lk(mGraphMapLock);
+      for (auto& pair : mSchedulers) {
+        schedulers.push_back(pair.second);
+        intervalMs =
+            std::min(intervalMs, pair.second->getConfig().sampleIntervalMs);
+      }
+    }
+    for (auto& scheduler : schedulers) scheduler->sample();
+
+    std::unique_lock<std::mutex> lk(mSampleMutex);
+    if (mSampleCv.wait_for(lk, std::chrono::milliseconds(intervalMs),
+                           [this]() { return mSampleStop; }))
+      break;
+  }
+}
+
 }  // namespace framework
 }  // namespace sophon_stream
@@ -16,6 +16,8 @@
 #include <string>
 
 #include "common/logger.h"
+#include "common/object_pool.h"
+#include "common/tensor_mem_pool.h"
 #include "element_factory.h"
 
 namespace sophon_stream {
@@ -137,6 +139,8 @@ common::ErrorCode Graph::stop() {
   }
 
   mThreadStatus = ThreadStatus::STOP;
+  common::ObjectPool::getInstance().dumpStats();
+  common::TensorMemPool::dumpAllStats();
 
   IVS_INFO("Stop graph thread finish, graph id: {0:d}", mId);
   return common::ErrorCode::SUCCESS;
@@ -194,6 +198,7 @@ common::ErrorCode Graph::resume() {
 
 common::ErrorCode Graph::initElements(const std::string& json) {
   IVS_INFO("Init elements start, graph id: {0:d}, json: {1}", mId, json);
+  auto start = std::chrono::steady_clock::now();
 
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
 
@@ -208,6 +213,7 @@ common::ErrorCode Graph::initElements(const std::string& json) {
     }
 
     int numElements = elementsConfigure.size();
+    int numStatic = 0;
     for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
       auto& elementConfigure = elementsConfigure[elementIndex];
       std::cout << elementConfigure.dump() << "\n";
@@ -219,10 +225,23 @@ common::ErrorCode Graph::initElements(const std::string& json) {
         break;
       }
 
+      auto nameIt = elementConfigure.find(JSON_WORKER_NAME_FIELD);
+      if (elementConfigure.end() == nameIt || !nameIt->is_string()) {
+        IVS_ERROR(
+            "Can not find {0} with string type in element json configure, "
+            "graph id: {1:d}, json: {2}",
+            JSON_WORKER_NAME_FIELD, mId, elementConfigure.dump());
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        break;
+      }
+
+      // 静态链接的element已在编译期注册，忽略配置中的shared_object
       auto sharedObjectIt =
           elementConfigure.find(JSON_MODEL_SHARED_OBJECT_FIELD);
-      if (elementConfigure.end() != sharedObjectIt &&
-          sharedObjectIt->is_string() && !sharedObjectIt->empty()) {
+      if (ElementFactory::isStaticElement(nameIt->get<std::string>())) {
+        ++numStatic;
+      } else if (elementConfigure.end() != sharedObjectIt &&
+                 sharedObjectIt->is_string() && !sharedObjectIt->empty()) {
         const auto& sharedObject = sharedObjectIt->get<std::string>();
         void* sharedObjectHandle =
             dlopen(sharedObject.c_str(), RTLD_NOW | RTLD_GLOBAL);
@@ -240,16 +259,6 @@ common::ErrorCode Graph::initElements(const std::string& json) {
             [](void* sharedObjectHandle) { dlclose(sharedObjectHandle); }));
       }
 
-      auto nameIt = elementConfigure.find(JSON_WORKER_NAME_FIELD);
-      if (elementConfigure.end() == nameIt || !nameIt->is_string()) {
-        IVS_ERROR(
-            "Can not find {0} with string type in element json configure, "
-            "graph id: {1:d}, json: {2}",
-            JSON_WORKER_NAME_FIELD, mId, elementConfigure.dump());
-        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
-        break;
-      }
-
       auto& elementFactory = framework::SingletonElementFactory::getInstance();
       auto element = elementFactory.make(nameIt->get<std::string>());
       if (!element) {
@@ -287,6 +296,14 @@ common::ErrorCode Graph::initElements(const std::string& json) {
       break;
     }
 
+    IVS_INFO(
+        "Init {0:d} elements cost {1} ms, graph id: {2:d}, static elements: "
+        "{3:d}, shared objects loaded: {4:d}",
+        numElements,
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count(),
+        mId, numStatic, (int)mSharedObjectHandles.size());
   } while (false);
 
   IVS_INFO("Init elements finish, graph id: {0:d}, json: {1}", mId, json);
@@ -486,6 +503,23 @@ std::pair<std::string, int> Graph::getSideAndDeviceId(int elementId) {
   return std::make_pair(element->getSide(), element->getId());
 }
 
+int Graph::getBacklog() {
+  int backlog = 0;
+  // group element与其前处理element共用输入Connector，只统计一次
+  std::set<framework::Connector*> counted;
+  for (auto& pair : mElementMap) {
+    auto element = pair.second;
+    if (!element) continue;
+    for (auto& connectorPair : element->getInputConnectorMap()) {
+      auto connector = connectorPair.second;
+      if (!connector || !counted.insert(connector.get()).second) continue;
+      for (int i = 0; i < connector->getCapacity(); ++i)
+        backlog += connector->getDataPipe(i)->getSize();
+    }
+  }
+  return backlog;
+}
+
 int Graph::getId() const { return mId; }
 }  // namespace framework
 }  // namespace sophon_stream
@@ -16,6 +16,8 @@
 
 constexpr const char* JSON_CONFIG_GRAPH_ID_FILED = "graph_id";
 constexpr const char* JSON_CONFIG_DEVICE_ID_FILED = "device_id";
+constexpr const char* JSON_CONFIG_DEVICE_IDS_FILED = "device_ids";
+constexpr const char* JSON_CONFIG_SHARDING_FILED = "sharding";
 constexpr const char* JSON_CONFIG_ELEMENTS_FILED = "elements";
 constexpr const char* JSON_CONFIG_CONNECTION_FILED = "connections";
 constexpr const char* JSON_CONFIG_ELEMENT_CONFIG_FILED = "element_config";
@@ -124,7 +126,18 @@ void init_engine(
 
     int graph_id = graph_it.find(JSON_CONFIG_GRAPH_ID_FILED)->get<int>();
     graphConfigure["graph_id"] = graph_id;
-    int device_id = graph_it.find(JSON_CONFIG_DEVICE_ID_FILED)->get<int>();
+    // 配置了device_ids时，engine把graph复制到每张卡上，码流按负载分配到副本
+    auto device_ids_it = graph_it.find(JSON_CONFIG_DEVICE_IDS_FILED);
+    int device_id = 0;
+    if (graph_it.end() == device_ids_it) {
+      device_id = graph_it.find(JSON_CONFIG_DEVICE_ID_FILED)->get<int>();
+    } else {
+      device_id = device_ids_it->at(0).get<int>();
+      graphConfigure[JSON_CONFIG_DEVICE_IDS_FILED] = *device_ids_it;
+      auto sharding_it = graph_it.find(JSON_CONFIG_SHARDING_FILED);
+      if (graph_it.end() != sharding_it)
+        graphConfigure[JSON_CONFIG_SHARDING_FILED] = *sharding_it;
+    }
     auto elements_it = graph_it.find(JSON_CONFIG_ELEMENTS_FILED);
     parse_element_json(elements_it, elementsConfigure, device_id, src_id_port,
                        sink_id_port);
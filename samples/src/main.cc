@@ -6,6 +6,7 @@
 // third-party components.
 //
 //===----------------------------------------------------------------------===//
+#include <algorithm>
 #include <functional>
 
 #include "draw_funcs.h"
@@ -45,6 +46,11 @@ constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SKIP_ELEMENT_FILED =
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_STRATEGY_FILED =
     "sample_strategy";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_ROI_FILED = "roi";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_CAPTURE_PATH_FILED =
+    "capture_path";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_REPLAY_SPEED_FILED =
+    "replay_speed";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_CLONE_NUM_FILED = "clone_num";
 
 constexpr const char* JSON_CONFIG_DRAW_FUNC_NAME_FILED = "draw_func_name";
 constexpr const char* JSON_CONFIG_CAR_ATTRIBUTES_FILED = "car_attributes";
@@ -63,6 +69,7 @@ std::vector<std::shared_ptr<sophon_stream::common::FpsProfiler>> fpsProfilers;
 std::map<int, std::vector<std::pair<int, int>>> graph_src_id_port_map;
 const std::string addChannelPath = "/stream/addChannel";
 const std::string stopChannelPath = "/stream/stopChannel";
+const std::string deviceStatusPath = "/stream/deviceStatus";
 
 demo_config parse_demo_json(std::string& json_path) {
   std::ifstream istream;
@@ -213,7 +220,37 @@ demo_config parse_demo_json(std::string& json_path) {
       channel_json["decode_id"] = decode_idx_it->get<int>();
     }
 
-    config.channel_configs.push_back(channel_json);
+    auto capture_path_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_CAPTURE_PATH_FILED);
+    if (channel_it.end() != capture_path_it)
+      channel_json["capture_path"] = capture_path_it->get<std::string>();
+
+    auto replay_speed_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_REPLAY_SPEED_FILED);
+    if (channel_it.end() != replay_speed_it)
+      channel_json["replay_speed"] = replay_speed_it->get<double>();
+
+    // clone_num > 1时按相同配置复制多路码流，channel_id依次加1，
+    // 用于从一份录制文件回放出多路负载
+    int clone_num = 1;
+    auto clone_num_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_CLONE_NUM_FILED);
+    if (channel_it.end() != clone_num_it)
+      clone_num = std::max(1, clone_num_it->get<int>());
+    int channel_id = channel_json["channel_id"];
+    for (int i = 0; i < clone_num; ++i) {
+      channel_json["channel_id"] = channel_id + i;
+      config.channel_configs.push_back(channel_json);
+      // 多路同时写同一个录制文件会互相覆盖，只有第一路录制
+      if (i == 0 && clone_num > 1 && channel_json.contains("capture_path")) {
+        IVS_WARN(
+            "capture_path is only kept for channel {0}, clones {1}-{2} do not "
+            "capture",
+            channel_id, channel_id + 1, channel_id + clone_num - 1);
+        channel_json.erase("capture_path");
+      }
+    }
+    if (channel_id_it == channel_it.end()) channel_id_config += clone_num - 1;
   }
   if (demo_json.contains(JSON_CONFIG_HTTP_REPORT_CONFIG_FILED)) {
     auto http_report_it = demo_json.find(JSON_CONFIG_HTTP_REPORT_CONFIG_FILED);
@@ -335,6 +372,9 @@ void addChannel(const httplib::Request& request, httplib::Response& response) {
   channelTask->request.operation = sophon_stream::element::decode::
       ChannelOperateRequest::ChannelOperate::START;
   channelTask->request.channelId = rac.channel_id;
+  // graph复制到多张卡上时，由engine选择负载最低的副本
+  int replica_id = engine.assignChannel(graph_id, rac.channel_id);
+  channelTask->request.graphId = replica_id;
   nlohmann::json j;
   to_json(j, rac);
   channelTask->request.json = j.dump();
@@ -345,12 +385,13 @@ void addChannel(const httplib::Request& request, httplib::Response& response) {
     if ((decode_id == -1 && src_id_port_vec.size() == 1) ||
         src_id_port.first == decode_id) {
       sophon_stream::common::ErrorCode errorCode =
-          engine.pushSourceData(graph_id, src_id_port.first, src_id_port.second,
+          engine.pushSourceData(replica_id, src_id_port.first,
+                                src_id_port.second,
                                 std::static_pointer_cast<void>(channelTask));
       IVS_DEBUG(
           "Push Source Data, GraphId = {0}, ElementId = {1}, ElementPort = "
           "{2}, ChannelId = {3}",
-          graph_id, src_id_port.first, src_id_port.second,
+          replica_id, src_id_port.first, src_id_port.second,
           channelTask->request.channelId);
     }
   }
@@ -388,6 +429,8 @@ void stopChannel(const httplib::Request& request, httplib::Response& response) {
   channelTask->request.operation = sophon_stream::element::decode::
       ChannelOperateRequest::ChannelOperate::STOP;
   channelTask->request.channelId = rsc.channel_id;
+  int replica_id = engine.releaseChannel(graph_id, rsc.channel_id);
+  channelTask->request.graphId = replica_id;
   nlohmann::json j;
   to_json(j, rsc);
   channelTask->request.json = j.dump();
@@ -398,12 +441,13 @@ void stopChannel(const httplib::Request& request, httplib::Response& response) {
     if ((decode_id == -1 && src_id_port_vec.size() == 1) ||
         src_id_port.first == decode_id) {
       sophon_stream::common::ErrorCode errorCode =
-          engine.pushSourceData(graph_id, src_id_port.first, src_id_port.second,
+          engine.pushSourceData(replica_id, src_id_port.first,
+                                src_id_port.second,
                                 std::static_pointer_cast<void>(channelTask));
       IVS_DEBUG(
           "Push Source Data, GraphId = {0}, ElementId = {1}, ElementPort = "
           "{2}, ChannelId = {3}",
-          graph_id, src_id_port.first, src_id_port.second,
+          replica_id, src_id_port.first, src_id_port.second,
           channelTask->request.channelId);
     }
   }
@@ -415,6 +459,32 @@ void stopChannel(const httplib::Request& request, httplib::Response& response) {
   return;
 }
 
+/**
+ * @brief 查询按device_ids复制的graph各副本的设备占用率、积压和码流数
+ */
+void deviceStatus(const httplib::Request& request,
+                  httplib::Response& response) {
+  auto& engine = sophon_stream::framework::SingletonEngine::getInstance();
+  nlohmann::json json_res = nlohmann::json::object();
+  for (auto& graph_status : engine.getDeviceStatus()) {
+    nlohmann::json replicas = nlohmann::json::array();
+    for (auto& status : graph_status.second) {
+      nlohmann::json replica;
+      replica["graph_id"] = status.mGraphId;
+      replica["device_id"] = status.mDeviceId;
+      replica["utilization"] = status.mUtilization;
+      replica["mem_used_bytes"] = status.mMemUsedBytes;
+      replica["mem_total_bytes"] = status.mMemTotalBytes;
+      replica["backlog"] = status.mBacklog;
+      replica["channels"] = status.mChannels;
+      replica["behind"] = status.mBehind;
+      replicas.push_back(replica);
+    }
+    json_res[std::to_string(graph_status.first)] = replicas;
+  }
+  response.set_content(json_res.dump(), "application/json");
+}
+
 std::mutex mtx;
 std::condition_variable stop_cv;
 
@@ -501,6 +571,9 @@ int main(int argc, char* argv[]) {
   listenthread->setHandler(
       stopChannelPath, sophon_stream::framework::RequestType::POST,
       std::bind(stopChannel, std::placeholders::_1, std::placeholders::_2));
+  listenthread->setHandler(
+      deviceStatusPath, sophon_stream::framework::RequestType::GET,
+      std::bind(deviceStatus, std::placeholders::_1, std::placeholders::_2));
 
   init_engine(engine, engine_json, sinkHandler, graph_src_id_port_map);
 
@@ -511,7 +584,9 @@ int main(int argc, char* argv[]) {
     channelTask->request.operation = sophon_stream::element::decode::
         ChannelOperateRequest::ChannelOperate::START;
     channelTask->request.channelId = channel_config["channel_id"];
-    channelTask->request.graphId = graph_id;
+    int replica_id =
+        engine.assignChannel(graph_id, channelTask->request.channelId);
+    channelTask->request.graphId = replica_id;
     channelTask->request.json = channel_config.dump();
     int decode_id = channel_config["decode_id"];
 
@@ -522,12 +597,12 @@ int main(int argc, char* argv[]) {
       if ((decode_id == -1 && src_id_port_vec.size() == 1) ||
           src_id_port.first == decode_id) {
         sophon_stream::common::ErrorCode errorCode = engine.pushSourceData(
-            graph_id, src_id_port.first, src_id_port.second,
+            replica_id, src_id_port.first, src_id_port.second,
             std::static_pointer_cast<void>(channelTask));
         IVS_DEBUG(
             "Push Source Data, GraphId = {0}, ElementId = {1}, ElementPort = "
             "{2}, ChannelId = {3}",
-            graph_id, src_id_port.first, src_id_port.second,
+            replica_id, src_id_port.first, src_id_port.second,
             channelTask->request.channelId);
       }
     }
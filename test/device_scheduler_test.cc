@@ -0,0 +1,219 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/device_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+/**
+ * @brief 三张模拟卡，卡i上是graph 10+i的副本；占用率通过MockDeviceBackend
+ * 注入，积压由测试直接设置
+ */
+class DeviceSchedulerTest : public ::testing::Test {
+ protected:
+  static constexpr int DEVICES = 3;
+
+  void SetUp() override { reset(DeviceScheduler::Config()); }
+
+  void reset(const DeviceScheduler::Config& config) {
+    mBackend = std::make_shared<MockDeviceBackend>(DEVICES);
+    mScheduler = std::make_unique<DeviceScheduler>(config, mBackend);
+    mBacklogs.assign(DEVICES, 0);
+    for (int i = 0; i < DEVICES; ++i)
+      mScheduler->addReplica(10 + i, i, [this, i]() { return mBacklogs[i]; });
+  }
+
+  void setUtilization(int devId, float utilization) {
+    DeviceStatus status;
+    status.mDeviceId = devId;
+    status.mUtilization = utilization;
+    mBackend->setStatus(status);
+  }
+
+  DeviceScheduler::ReplicaStatus status(int index) {
+    return mScheduler->getStatus()[index];
+  }
+
+  std::shared_ptr<MockDeviceBackend> mBackend;
+  std::unique_ptr<DeviceScheduler> mScheduler;
+  std::vector<int> mBacklogs;
+};
+
+TEST_F(DeviceSchedulerTest, BehindAfterConsecutiveSamples) {
+  for (int i = 0; i < DEVICES; ++i) setUtilization(i, 0.5f);
+  mBacklogs[0] = 25;
+  mScheduler->sample();
+  mScheduler->sample();
+  EXPECT_FALSE(status(0).mBehind);
+
+  // 中间有一次未超过阈值，重新计数
+  mBacklogs[0] = 5;
+  mScheduler->sample();
+  mBacklogs[0] = 25;
+  mScheduler->sample();
+  mScheduler->sample();
+  EXPECT_FALSE(status(0).mBehind);
+  mScheduler->sample();
+  EXPECT_TRUE(status(0).mBehind);
+  EXPECT_EQ(status(0).mBacklog, 25);
+
+  // 落后的副本不再接收新码流
+  for (int channel = 0; channel < 4; ++channel)
+    EXPECT_NE(mScheduler->assign(channel), 10);
+  EXPECT_EQ(status(0).mChannels, 0);
+}
+
+TEST_F(DeviceSchedulerTest, RecoverWithHysteresis) {
+  for (int i = 0; i < DEVICES; ++i) setUtilization(i, 0.5f);
+  mBacklogs[0] = 20;
+  for (int i = 0; i < 3; ++i) mScheduler->sample();
+  ASSERT_TRUE(status(0).mBehind);
+
+  // 积压低于阈值但高于阈值一半，保持落后
+  mBacklogs[0] = 11;
+  for (int i = 0; i < 5; ++i) {
+    mScheduler->sample();
+    EXPECT_TRUE(status(0).mBehind);
+  }
+  mBacklogs[0] = 10;
+  mScheduler->sample();
+  EXPECT_FALSE(status(0).mBehind);
+
+  // 占用率同样需要回落到阈值减0.1以下
+  // 滑动平均从0.5升到0.95以上需要4次采样，之后再连续3次才落后
+  setUtilization(0, 1.f);
+  for (int i = 0; i < 5; ++i) mScheduler->sample();
+  EXPECT_FALSE(status(0).mBehind);
+  mScheduler->sample();
+  ASSERT_TRUE(status(0).mBehind);
+  setUtilization(0, 0.9f);
+  for (int i = 0; i < 10; ++i) mScheduler->sample();
+  EXPECT_NEAR(status(0).mUtilization, 0.9f, 1e-3);
+  EXPECT_TRUE(status(0).mBehind);
+  setUtilization(0, 0.8f);
+  // 滑动平均逐次减半逼近0.8，低于0.85后恢复
+  mScheduler->sample();
+  EXPECT_TRUE(status(0).mBehind);
+  mScheduler->sample();
+  EXPECT_FALSE(status(0).mBehind);
+}
+
+TEST_F(DeviceSchedulerTest, AllBehindFallsBackToLeastLoaded) {
+  setUtilization(0, 0.99f);
+  setUtilization(1, 0.96f);
+  setUtilization(2, 1.f);
+  mBacklogs = {30, 40, 30};
+  for (int i = 0; i < 3; ++i) mScheduler->sample();
+  for (int i = 0; i < DEVICES; ++i) ASSERT_TRUE(status(i).mBehind);
+
+  EXPECT_EQ(mScheduler->assign(0), 11);
+  EXPECT_EQ(status(1).mChannels, 1);
+}
+
+TEST_F(DeviceSchedulerTest, PendingChannelsSpreadBeforeSample) {
+  // 没有采样数据时按码流数轮流分配
+  EXPECT_EQ(mScheduler->assign(0), 10);
+  EXPECT_EQ(mScheduler->assign(1), 11);
+  EXPECT_EQ(mScheduler->assign(2), 12);
+
+  setUtilization(0, 0.6f);
+  setUtilization(1, 0.3f);
+  setUtilization(2, 0.3f);
+  mScheduler->sample();
+
+  // 采样之后新分配的码流按所在副本已有码流的平均占用率计入负载，两次采样
+  // 之间连续到来的码流不会都放到同一个副本
+  EXPECT_EQ(mScheduler->assign(3), 11);  // 0.6 0.3 0.3
+  EXPECT_EQ(mScheduler->assign(4), 12);  // 0.6 0.6 0.3
+  EXPECT_EQ(mScheduler->assign(5), 10);  // 0.6 0.6 0.6，码流最少
+  EXPECT_EQ(mScheduler->assign(6), 11);  // 1.2 0.6 0.6
+  EXPECT_EQ(status(0).mChannels, 2);
+  EXPECT_EQ(status(1).mChannels, 3);
+  EXPECT_EQ(status(2).mChannels, 2);
+}
+
+TEST_F(DeviceSchedulerTest, PendingEstimateUsesMeasuredAverage) {
+  EXPECT_EQ(mScheduler->assign(0), 10);
+  EXPECT_EQ(mScheduler->assign(1), 11);
+  EXPECT_EQ(mScheduler->assign(2), 12);
+  EXPECT_EQ(mScheduler->release(1), 11);
+  EXPECT_EQ(mScheduler->release(2), 12);
+  // 卡1被其他进程占用，卡2空闲
+  setUtilization(0, 0.2f);
+  setUtilization(1, 0.5f);
+  setUtilization(2, 0.f);
+  mScheduler->sample();
+
+  // 卡2上没有码流，新码流按卡0测得的每路0.2估计，不会全部放到卡2
+  EXPECT_EQ(mScheduler->assign(3), 12);  // 0.2 0.5 0
+  EXPECT_EQ(mScheduler->assign(4), 10);  // 0.2 0.5 0.2，按顺序
+  EXPECT_EQ(mScheduler->assign(5), 12);  // 0.4 0.5 0.2
+  EXPECT_EQ(mScheduler->assign(6), 10);  // 0.4 0.5 0.4
+  EXPECT_EQ(status(1).mChannels, 0);
+}
+
+TEST_F(DeviceSchedulerTest, AssignIsStickyAndReleaseFrees) {
+  int graphId = mScheduler->assign(7);
+  EXPECT_EQ(mScheduler->assign(7), graphId);
+  EXPECT_EQ(status(graphId - 10).mChannels, 1);
+
+  EXPECT_EQ(mScheduler->release(7), graphId);
+  EXPECT_EQ(status(graphId - 10).mChannels, 0);
+  EXPECT_EQ(mScheduler->release(7), -1);
+  EXPECT_EQ(mScheduler->release(8), -1);
+}
+
+TEST_F(DeviceSchedulerTest, MissingDeviceStatus) {
+  auto backend = std::make_shared<MockDeviceBackend>(1);
+  DeviceScheduler scheduler(DeviceScheduler::Config(), backend);
+  scheduler.addReplica(20, 5, nullptr);
+  scheduler.sample();
+  auto status = scheduler.getStatus();
+  ASSERT_EQ(status.size(), 1u);
+  EXPECT_EQ(status[0].mUtilization, -1.f);
+  EXPECT_EQ(status[0].mBacklog, 0);
+  EXPECT_FALSE(status[0].mBehind);
+  EXPECT_EQ(scheduler.assign(0), 20);
+
+  DeviceScheduler empty(DeviceScheduler::Config(), backend);
+  EXPECT_EQ(empty.assign(0), -1);
+}
+
+TEST_F(DeviceSchedulerTest, ParseConfig) {
+  auto config = DeviceScheduler::parseConfig(nlohmann::json::parse(
+      R"({"backlog_threshold": 8, "utilization_threshold": 0.8,
+          "behind_samples": 0, "sample_interval_ms": 1})"));
+  EXPECT_EQ(config.backlogThreshold, 8);
+  EXPECT_FLOAT_EQ(config.utilizationThreshold, 0.8f);
+  EXPECT_EQ(config.behindSamples, 1);
+  EXPECT_EQ(config.sampleIntervalMs, 10);
+
+  auto defaults = DeviceScheduler::parseConfig(nlohmann::json());
+  EXPECT_EQ(defaults.backlogThreshold, 20);
+  EXPECT_EQ(defaults.behindSamples, 3);
+  EXPECT_EQ(defaults.sampleIntervalMs, 1000);
+
+  // 按配置的阈值判断落后
+  reset(config);
+  mBacklogs[2] = 8;
+  mScheduler->sample();
+  EXPECT_TRUE(status(2).mBehind);
+  EXPECT_FALSE(status(1).mBehind);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "dwa_remap.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace dwa {
+namespace {
+
+// data/dwa下的数据：
+// src_64x48.bgr     源图像，BGR packed
+// warp_40x30.bin    输出40x30到画布80x60的桶形畸变映射，float32的map_x后接map_y
+// golden_40x30.bgr  源图像缩放到画布(10,5,60,50)、旋转180度、按映射重映射的结果，
+//                   由OpenCV的remap(INTER_LINEAR, BORDER_CONSTANT 114)生成
+const std::string kDataDir = "data/dwa/";
+constexpr int kSrcW = 64, kSrcH = 48;
+constexpr int kOutW = 40, kOutH = 30;
+
+std::vector<unsigned char> readFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::vector<unsigned char>(std::istreambuf_iterator<char>(file),
+                                    std::istreambuf_iterator<char>());
+}
+
+PreWarp fixturePreWarp() {
+  PreWarp pre;
+  pre.src_w = kSrcW;
+  pre.src_h = kSrcH;
+  pre.canvas_w = 80;
+  pre.canvas_h = 60;
+  pre.rect = {10, 5, 60, 50};
+  pre.rot180 = true;
+  return pre;
+}
+
+TEST(DwaRemapTest, RemapMatchesGolden) {
+  cv::Mat warpX, warpY;
+  ASSERT_TRUE(
+      loadWarpMap(kDataDir + "warp_40x30.bin", kOutW, kOutH, warpX, warpY));
+  auto grid = RemapGrid::build(fixturePreWarp(), warpX, warpY);
+  ASSERT_EQ(grid->map_x.cols, kOutW);
+  ASSERT_EQ(grid->map_x.rows, kOutH);
+
+  auto pixels = readFile(kDataDir + "src_64x48.bgr");
+  ASSERT_EQ(pixels.size(), (size_t)kSrcW * kSrcH * 3);
+  cv::Mat src(kSrcH, kSrcW, CV_8UC3, pixels.data());
+  cv::Mat dst;
+  remapCpu(src, *grid, dst);
+  ASSERT_EQ(dst.cols, kOutW);
+  ASSERT_EQ(dst.rows, kOutH);
+
+  // 不同版本OpenCV的定点舍入可能差1
+  auto golden = readFile(kDataDir + "golden_40x30.bgr");
+  ASSERT_EQ(golden.size(), (size_t)kOutW * kOutH * 3);
+  int max_diff = 0, border = 0;
+  for (int y = 0; y < kOutH; ++y) {
+    const unsigned char* row = dst.ptr<unsigned char>(y);
+    for (int i = 0; i < kOutW * 3; ++i) {
+      int expected = golden[y * kOutW * 3 + i];
+      max_diff = std::max(max_diff, std::abs(row[i] - expected));
+    }
+    for (int x = 0; x < kOutW; ++x) border += grid->map_x.ptr<float>(y)[x] < 0;
+  }
+  EXPECT_LE(max_diff, 1);
+  // 畸变后四角落在源图之外，按补边处理
+  EXPECT_GT(border, 0);
+  EXPECT_EQ(dst.ptr<unsigned char>(0)[0], 114);
+}
+
+TEST(DwaRemapTest, GridWithoutWarpCoversCanvas) {
+  PreWarp pre = fixturePreWarp();
+  pre.rot180 = false;
+  auto grid = RemapGrid::build(pre, cv::Mat(), cv::Mat());
+  ASSERT_EQ(grid->map_x.cols, pre.canvas_w);
+  ASSERT_EQ(grid->map_x.rows, pre.canvas_h);
+  // rect之外补边，rect左上角的像素中心映射到源图按比例缩放后的位置
+  EXPECT_EQ(grid->map_x.ptr<float>(0)[0], -1.f);
+  float sx = (float)kSrcW / pre.rect.crop_w;
+  EXPECT_FLOAT_EQ(grid->map_x.ptr<float>(pre.rect.start_y)[pre.rect.start_x],
+                  0.5f * sx - 0.5f);
+  EXPECT_EQ(grid->map_x.ptr<float>(pre.rect.start_y)[pre.rect.start_x - 1],
+            -1.f);
+}
+
+TEST(DwaRemapTest, LoadWarpMapRejectsWrongSize) {
+  cv::Mat warpX, warpY;
+  EXPECT_FALSE(
+      loadWarpMap(kDataDir + "warp_40x30.bin", kOutW, kOutH + 1, warpX, warpY));
+  EXPECT_FALSE(loadWarpMap(kDataDir + "missing.bin", kOutW, kOutH, warpX,
+                           warpY));
+}
+
+TEST(DwaRemapTest, GridFileIsReadOnce) {
+  auto first = loadGridFile(kDataDir + "warp_40x30.bin");
+  auto second = loadGridFile(kDataDir + "warp_40x30.bin");
+  EXPECT_EQ(first.get(), second.get());
+  auto bytes = readFile(kDataDir + "warp_40x30.bin");
+  ASSERT_EQ(first->size(), bytes.size());
+  EXPECT_TRUE(std::equal(bytes.begin(), bytes.end(), first->begin(),
+                         [](unsigned char a, char b) {
+                           return a == (unsigned char)b;
+                         }));
+}
+
+}  // namespace
+}  // namespace dwa
+}  // namespace element
+}  // namespace sophon_stream
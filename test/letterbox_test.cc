@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "letterbox_host.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace {
+
+std::vector<uint8_t> randomImage(int w, int h, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> image(w * h * 3);
+  for (auto& value : image) value = rng() & 0xff;
+  return image;
+}
+
+LetterboxParam makeParam(int net_w, int net_h, bm_image_format_ext format) {
+  LetterboxParam param;
+  param.net_w = net_w;
+  param.net_h = net_h;
+  param.format = format;
+  memset(&param.converto_attr, 0, sizeof(param.converto_attr));
+  param.converto_attr.alpha_0 = 1.f;
+  param.converto_attr.alpha_1 = 1.f;
+  param.converto_attr.alpha_2 = 1.f;
+  return param;
+}
+
+/**
+ * @brief 浮点的双线性插值参考实现，与letterboxAxis相同的坐标映射，权重不量化
+ */
+double referencePixel(const std::vector<uint8_t>& image, int w,
+                      const bmcv_rect_t& crop, int dst_w, int dst_h, int x,
+                      int y, int c) {
+  auto axis = [](int src_len, int dst_len, int d, int& s0, int& s1,
+                 double& frac) {
+    double pos = (d + 0.5) * ((double)src_len / dst_len) - 0.5;
+    s0 = (int)std::floor(pos);
+    frac = pos - s0;
+    if (s0 < 0) {
+      s0 = 0;
+      frac = 0.0;
+    }
+    if (s0 >= src_len - 1) {
+      s0 = src_len - 1;
+      frac = 0.0;
+    }
+    s1 = std::min(s0 + 1, src_len - 1);
+  };
+  int x0, x1, y0, y1;
+  double fx, fy;
+  axis(crop.crop_w, dst_w, x, x0, x1, fx);
+  axis(crop.crop_h, dst_h, y, y0, y1, fy);
+  auto at = [&](int sx, int sy) {
+    return (double)image[((crop.start_y + sy) * w + crop.start_x + sx) * 3 +
+                         c];
+  };
+  double top = at(x0, y0) * (1 - fx) + at(x1, y0) * fx;
+  double bottom = at(x0, y1) * (1 - fx) + at(x1, y1) * fx;
+  return top * (1 - fy) + bottom * fy;
+}
+
+TEST(LetterboxTest, ResizeMatchesFloatReference) {
+  const int w = 97, h = 61;
+  auto image = randomImage(w, h, 1);
+  bmcv_rect_t crop = {5, 3, 80, 50};
+  auto param = makeParam(64, 48, FORMAT_BGR_PLANAR);
+  const int stride = 64;
+  std::vector<uint8_t> planar(3 * param.net_h * stride);
+  letterboxResize(image.data(), w * 3, crop, param, stride, planar.data());
+
+  // 80x50缩放到64x40，上下各填充4行
+  auto padding = letterboxPadding(crop.crop_w, crop.crop_h, param);
+  ASSERT_EQ(padding.dst_crop_w, 64);
+  ASSERT_EQ(padding.dst_crop_h, 40);
+  ASSERT_EQ(padding.dst_crop_sty, 4);
+  int max_diff = 0;
+  for (int c = 0; c < 3; ++c) {
+    for (int y = 0; y < param.net_h; ++y) {
+      for (int x = 0; x < param.net_w; ++x) {
+        int value = planar[(c * param.net_h + y) * stride + x];
+        int dy = y - padding.dst_crop_sty;
+        if (dy < 0 || dy >= padding.dst_crop_h) {
+          ASSERT_EQ(value, param.padding);
+          continue;
+        }
+        double expected = referencePixel(image, w, crop, padding.dst_crop_w,
+                                         padding.dst_crop_h, x, dy, c);
+        max_diff = std::max(max_diff,
+                            std::abs(value - (int)std::lround(expected)));
+      }
+    }
+  }
+  EXPECT_LE(max_diff, LETTERBOX_VPP_TOLERANCE);
+}
+
+TEST(LetterboxTest, SameSizeIsExact) {
+  const int w = 32, h = 16;
+  auto image = randomImage(w, h, 2);
+  bmcv_rect_t crop = {0, 0, w, h};
+  auto param = makeParam(w, h, FORMAT_RGB_PLANAR);
+  std::vector<uint8_t> planar(3 * w * h);
+  letterboxResize(image.data(), w * 3, crop, param, w, planar.data());
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      // RGB planar：第0个平面是R
+      for (int c = 0; c < 3; ++c)
+        ASSERT_EQ(planar[(c * h + y) * w + x], image[(y * w + x) * 3 + 2 - c]);
+    }
+  }
+}
+
+TEST(LetterboxTest, LeftAlignedPaddingAndGray) {
+  const int w = 20, h = 40;
+  std::vector<uint8_t> image(w * h * 3);
+  for (int i = 0; i < w * h; ++i) {
+    image[3 * i] = 10;       // B
+    image[3 * i + 1] = 200;  // G
+    image[3 * i + 2] = 50;   // R
+  }
+  bmcv_rect_t crop = {0, 0, w, h};
+  auto param = makeParam(16, 16, FORMAT_GRAY);
+  param.center = false;
+  param.padding = 7;
+  std::vector<uint8_t> planar(16 * 16);
+  letterboxResize(image.data(), w * 3, crop, param, 16, planar.data());
+  // 20x40缩放到8x16，贴左边，右侧填充
+  int gray = (int)std::lround(0.299 * 50 + 0.587 * 200 + 0.114 * 10);
+  for (int y = 0; y < 16; ++y) {
+    for (int x = 0; x < 16; ++x) {
+      if (x < 8)
+        ASSERT_NEAR(planar[y * 16 + x], gray, 1);
+      else
+        ASSERT_EQ(planar[y * 16 + x], 7);
+    }
+  }
+}
+
+TEST(LetterboxTest, HalfRoundsToNearestEven) {
+  EXPECT_EQ(letterboxHalf(0.f), 0x0000);
+  EXPECT_EQ(letterboxHalf(-0.f), 0x8000);
+  EXPECT_EQ(letterboxHalf(1.f), 0x3c00);
+  EXPECT_EQ(letterboxHalf(-2.f), 0xc000);
+  EXPECT_EQ(letterboxHalf(0.1f), 0x2e66);
+  EXPECT_EQ(letterboxHalf(65504.f), 0x7bff);
+  EXPECT_EQ(letterboxHalf(65520.f), 0x7c00);
+  EXPECT_EQ(letterboxHalf(INFINITY), 0x7c00);
+  // 1 + 2^-11恰好在两个半精度数中间，舍入到偶数
+  EXPECT_EQ(letterboxHalf(1.f + std::ldexp(1.f, -11)), 0x3c00);
+  EXPECT_EQ(letterboxHalf(1.f + 3 * std::ldexp(1.f, -11)), 0x3c02);
+  // 非规格化数
+  EXPECT_EQ(letterboxHalf(std::ldexp(1.f, -24)), 0x0001);
+  EXPECT_EQ(letterboxHalf(std::ldexp(1.f, -25)), 0x0000);
+  EXPECT_EQ(letterboxHalf(std::ldexp(3.f, -25)), 0x0002);
+  EXPECT_EQ(letterboxHalf(std::ldexp(1.f, -14)), 0x0400);
+}
+
+TEST(LetterboxTest, NormalizeMatchesConvertTo) {
+  const int net_w = 4, net_h = 1;
+  std::vector<uint8_t> planar = {0, 1, 2, 255, 3, 4, 5, 6, 7, 8, 9, 10};
+  auto param = makeParam(net_w, net_h, FORMAT_BGR_PLANAR);
+  auto& attr = param.converto_attr;
+  attr.alpha_0 = 0.5f;
+  attr.beta_0 = -0.5f;
+  attr.alpha_1 = 1.f / 255;
+  attr.beta_1 = 0.f;
+  attr.alpha_2 = 100.f;
+  attr.beta_2 = -600.f;
+
+  param.dtype = DATA_TYPE_EXT_FLOAT32;
+  std::vector<float> f32(3 * net_w);
+  letterboxNormalize(planar.data(), net_w, param, f32.data());
+  EXPECT_FLOAT_EQ(f32[3], 0.5f * 255 - 0.5f);
+  EXPECT_FLOAT_EQ(f32[5], 4.f / 255);
+  EXPECT_FLOAT_EQ(f32[11], 400.f);
+
+  param.dtype = DATA_TYPE_EXT_1N_BYTE_SIGNED;
+  std::vector<int8_t> i8(3 * net_w);
+  letterboxNormalize(planar.data(), net_w, param, i8.data());
+  // 0.5*1-0.5=0，0.5*2-0.5=0.5舍入到0，0.5*255-0.5=127
+  EXPECT_EQ(i8[0], 0);
+  EXPECT_EQ(i8[1], 0);
+  EXPECT_EQ(i8[2], 0);
+  EXPECT_EQ(i8[3], 127);
+  // 100*7-600=100，100*8-600=200饱和到127，100*3-600饱和到-128
+  EXPECT_EQ(i8[8], 100);
+  EXPECT_EQ(i8[9], 127);
+  attr.beta_2 = -1000.f;
+  letterboxNormalize(planar.data(), net_w, param, i8.data());
+  EXPECT_EQ(i8[8], -128);
+
+  param.dtype = DATA_TYPE_EXT_FP16;
+  std::vector<uint16_t> f16(3 * net_w);
+  letterboxNormalize(planar.data(), net_w, param, f16.data());
+  for (int i = 0; i < 3 * net_w; ++i) {
+    const float alpha[3] = {attr.alpha_0, attr.alpha_1, attr.alpha_2};
+    const float beta[3] = {attr.beta_0, attr.beta_1, attr.beta_2};
+    int c = i / net_w;
+    EXPECT_EQ(f16[i], letterboxHalf(alpha[c] * planar[i] + beta[c]));
+  }
+}
+
+TEST(LetterboxTest, TensorComposesResizeAndNormalize) {
+  const int w = 50, h = 30;
+  auto image = randomImage(w, h, 3);
+  bmcv_rect_t crop = {10, 5, 40, 25};
+  auto param = makeParam(32, 32, FORMAT_BGR_PLANAR);
+  param.converto_attr.alpha_0 = 1.f / 255;
+  param.converto_attr.alpha_1 = 1.f / 255;
+  param.converto_attr.alpha_2 = 1.f / 255;
+
+  std::vector<uint8_t> planar(3 * 32 * 32);
+  letterboxResize(image.data(), w * 3, crop, param, 32, planar.data());
+  std::vector<float> tensor(3 * 32 * 32);
+  letterboxTensor(image.data(), w * 3, crop, param, tensor.data());
+  for (size_t i = 0; i < tensor.size(); ++i)
+    ASSERT_FLOAT_EQ(tensor[i], planar[i] / 255.f);
+}
+
+}  // namespace
+}  // namespace element
+}  // namespace sophon_stream
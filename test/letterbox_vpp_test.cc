@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "letterbox.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace {
+
+/**
+ * @brief 同一幅图像分别走VPP和CPU路径，比较letterboxBatch的输出；
+ * 没有设备时跳过
+ */
+class LetterboxVppTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (bm_dev_request(&mHandle, 0) != BM_SUCCESS) mHandle = nullptr;
+  }
+
+  void TearDown() override {
+    if (mHandle != nullptr) bm_dev_free(mHandle);
+  }
+
+  /**
+   * @brief 对BGR packed的源图像做一次letterboxBatch，返回网络输入
+   * @param cpu 为true时先让当前线程的缓冲进入VPP退避期，全部帧走CPU路径
+   */
+  std::vector<float> run(const std::vector<uint8_t>& bgr, int w, int h,
+                         bmcv_rect_t crop, const LetterboxParam& param,
+                         bool cpu) {
+    std::vector<bm_image> srcs(1);
+    bm_image_create(mHandle, h, w, FORMAT_BGR_PACKED, DATA_TYPE_EXT_1N_BYTE,
+                    &srcs[0]);
+    EXPECT_EQ(bm_image_alloc_dev_mem(srcs[0]), BM_SUCCESS);
+    void* buffers[1] = {const_cast<uint8_t*>(bgr.data())};
+    EXPECT_EQ(bm_image_copy_host_to_device(srcs[0], buffers), BM_SUCCESS);
+
+    size_t bytes = (size_t)3 * param.net_h * param.net_w * sizeof(float);
+    std::vector<bm_device_mem_t> dsts(1);
+    EXPECT_EQ(bm_malloc_device_byte(mHandle, &dsts[0], bytes), BM_SUCCESS);
+    if (cpu) LetterboxBuffers::local(mHandle, param).vppFailed();
+    std::vector<bmcv_rect_t> crops = {crop};
+    auto failed = letterboxBatch(mHandle, srcs, crops, dsts, param);
+    EXPECT_TRUE(failed.empty());
+
+    std::vector<float> tensor(bytes / sizeof(float));
+    bm_memcpy_d2s_partial(mHandle, tensor.data(), dsts[0], bytes);
+    bm_free_device(mHandle, dsts[0]);
+    bm_image_destroy(srcs[0]);
+    return tensor;
+  }
+
+  bm_handle_t mHandle = nullptr;
+};
+
+TEST_F(LetterboxVppTest, CpuPathMatchesVpp) {
+  if (mHandle == nullptr) {
+    std::cout << "no device, skipped" << std::endl;
+    return;
+  }
+  const int w = 320, h = 200;
+  std::mt19937 rng(1);
+  std::vector<uint8_t> bgr(w * h * 3);
+  // 平滑的渐变加少量噪声，接近真实图像
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      for (int c = 0; c < 3; ++c)
+        bgr[(y * w + x) * 3 + c] = (x * (c + 1) + y * 2 + rng() % 16) & 0xff;
+
+  LetterboxParam param;
+  param.net_w = 128;
+  param.net_h = 128;
+  param.format = FORMAT_RGB_PLANAR;
+  param.dtype = DATA_TYPE_EXT_FLOAT32;
+  memset(&param.converto_attr, 0, sizeof(param.converto_attr));
+  param.converto_attr.alpha_0 = 1.f;
+  param.converto_attr.alpha_1 = 1.f;
+  param.converto_attr.alpha_2 = 1.f;
+  bmcv_rect_t crop = {16, 8, 288, 180};
+
+  auto vpp = run(bgr, w, h, crop, param, false);
+  auto cpu = run(bgr, w, h, crop, param, true);
+
+  // CPU路径的结果与主机上直接计算的一致
+  std::vector<float> host(cpu.size());
+  letterboxTensor(bgr.data(), w * 3, crop, param, host.data());
+  EXPECT_EQ(cpu, host);
+
+  float max_diff = 0.f;
+  for (size_t i = 0; i < vpp.size(); ++i)
+    max_diff = std::max(max_diff, std::fabs(vpp[i] - cpu[i]));
+  EXPECT_LE(max_diff, LETTERBOX_VPP_TOLERANCE);
+}
+
+}  // namespace
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/object_metadata.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+std::shared_ptr<DetectedObjectMetadata> makeDetection(int x, int classId,
+                                                      float score) {
+  auto det = std::make_shared<DetectedObjectMetadata>();
+  det->mBox.mX = x;
+  det->mBox.mY = 2 * x;
+  det->mBox.mWidth = 16;
+  det->mBox.mHeight = 32;
+  det->mClassify = classId;
+  det->mScores.push_back(score);
+  return det;
+}
+
+TEST(ObjectMetadataTest, EmptyMetadataHasEmptyTable) {
+  const ObjectMetadata obj;
+  EXPECT_EQ(obj.getDetectionTable().size(), 0u);
+}
+
+TEST(ObjectMetadataTest, AddDetectedObjectKeepsTableInSync) {
+  ObjectMetadata obj;
+  obj.addDetectedObject(makeDetection(10, 1, 0.5f));
+  obj.addDetectedObject(makeDetection(20, 2, 0.75f));
+
+  const ObjectMetadata& reader = obj;
+  const DetectionTable& table = reader.getDetectionTable();
+  ASSERT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.mX[1], 20);
+  EXPECT_EQ(table.mY[1], 40);
+  EXPECT_EQ(table.mClassId[0], 1);
+  EXPECT_FLOAT_EQ(table.mScore[1], 0.75f);
+  EXPECT_EQ(table.mTrackId[0], -1);
+}
+
+TEST(ObjectMetadataTest, DetectionsChangedRebuildsEagerly) {
+  ObjectMetadata obj;
+  obj.addDetectedObject(makeDetection(10, 1, 0.5f));
+  obj.addDetectedObject(makeDetection(20, 2, 0.75f));
+  const DetectionTable* before = &obj.getDetectionTable();
+
+  // 原地修改并删除一行，跟踪结果按行对齐
+  obj.mDetectedObjectMetadatas[1]->mBox.mX = 30;
+  obj.mDetectedObjectMetadatas.erase(obj.mDetectedObjectMetadatas.begin());
+  auto track = std::make_shared<TrackedObjectMetadata>();
+  track->mTrackId = 7;
+  obj.mTrackedObjectMetadatas.push_back(track);
+  obj.detectionsChanged();
+
+  const DetectionTable& table = obj.getDetectionTable();
+  EXPECT_EQ(&table, before);
+  ASSERT_EQ(table.size(), 1u);
+  EXPECT_EQ(table.mX[0], 30);
+  EXPECT_EQ(table.mClassId[0], 2);
+  EXPECT_EQ(table.mTrackId[0], 7);
+}
+
+TEST(ObjectMetadataTest, MutableTableFollowsKeepRows) {
+  ObjectMetadata obj;
+  for (int i = 0; i < 4; ++i) obj.addDetectedObject(makeDetection(i, i, 0.f));
+
+  std::vector<bool> keep = {true, false, true, false};
+  obj.mutableDetectionTable().keepRows(keep);
+  obj.mDetectedObjectMetadatas = {obj.mDetectedObjectMetadatas[0],
+                                  obj.mDetectedObjectMetadatas[2]};
+
+  const DetectionTable& table = obj.getDetectionTable();
+  ASSERT_EQ(table.size(), 2u);
+  EXPECT_EQ(table.mClassId[1], 2);
+}
+
+TEST(ObjectMetadataDeathTest, StaleTableIsABug) {
+  ObjectMetadata obj;
+  obj.addDetectedObject(makeDetection(10, 1, 0.5f));
+  obj.mDetectedObjectMetadatas.push_back(makeDetection(20, 2, 0.75f));
+  EXPECT_EXIT(obj.getDetectionTable(), ::testing::ExitedWithCode(1),
+              "Detection table is stale");
+
+  ObjectMetadata untracked;
+  untracked.mDetectedObjectMetadatas.push_back(makeDetection(10, 1, 0.5f));
+  EXPECT_EXIT(untracked.getDetectionTable(), ::testing::ExitedWithCode(1),
+              "Detection table missing");
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
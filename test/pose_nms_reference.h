@@ -0,0 +1,548 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TEST_POSE_NMS_REFERENCE_H_
+#define SOPHON_STREAM_TEST_POSE_NMS_REFERENCE_H_
+
+// fastpose姿态NMS的旧实现和合成场景，pose_nms_test和tools/pose_nms_bench共用
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "fastpose_pose_nms.h"
+
+namespace pose_nms_reference {
+
+using namespace sophon_stream;
+using element::fastpose::PoseNMSParams;
+using Detections = std::vector<std::shared_ptr<common::DetectedObjectMetadata>>;
+using Poses = std::vector<std::shared_ptr<common::PosedObjectMetadata>>;
+
+// 逐候选全量计算的旧实现，取自fastpose_post_process.cc，作为结果基准
+class ReferenceNMS {
+ public:
+  std::shared_ptr<PoseNMSParams> pose_nms_params;
+
+  void poseNMS(Detections& det_data, int num_samples, int num_joints,
+               float areaThres, Poses& body_keypoints,
+               std::vector<int>& pick_ids);
+
+ private:
+  void poseNMSBody(Detections& det_data, int num_samples, int num_joints,
+                   float areaThres, Poses& body_keypoints,
+                   std::vector<int>& pick_ids);
+  void getParametricDistance(Poses& body_keypoints, std::vector<float>& dist,
+                             std::vector<int>& dist_indx, int pick_id,
+                             int num_joints, bool use_dist_mask,
+                             float* final_dist);
+  void PCKMatch(std::vector<float>& dist, int num_joints, float ref_dist,
+                int* num_match_keypoints);
+  void PCKMatchFullBody(std::vector<float>& dist, Poses& body_keypoints,
+                        int pick_id, int num_joints, float ref_dist,
+                        int* num_match_keypoints);
+  void pMergeFast(Poses& body_keypoints, std::vector<int>& merge_ids,
+                  std::vector<float>& dist, std::vector<int>& dist_indx,
+                  int pick_id, int num_joints, float ref_dist);
+  void poseNMSFullBody(Detections& det_data, int num_samples, int num_joints,
+                       float areaThres, Poses& body_keypoints,
+                       std::vector<int>& pick_ids);
+};
+
+inline void ReferenceNMS::poseNMS(
+    std::vector<std::shared_ptr<common::DetectedObjectMetadata>>& det_data,
+    int num_samples, int num_joints, float area_thresh,
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<int>& pick_ids) {
+  if (num_joints == 136 || num_joints == 133)
+    poseNMSFullBody(det_data, num_samples, num_joints, area_thresh,
+                    body_keypoints, pick_ids);
+  else
+    poseNMSBody(det_data, num_samples, num_joints, area_thresh, body_keypoints,
+                pick_ids);
+}
+
+inline void ReferenceNMS::poseNMSBody(
+    std::vector<std::shared_ptr<common::DetectedObjectMetadata>>& det_data,
+    int num_samples, int num_joints, float area_thresh,
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<int>& pick_ids) {
+  float* ref_dists = new float[num_samples];
+  float* human_scores = new float[num_samples];
+  bool* mask = new bool[num_samples];
+  int num_valid_samples = num_samples;
+  for (int i = 0; i < num_samples; i++) {
+    float width = det_data[i]->mBox.mWidth, height = det_data[i]->mBox.mHeight;
+    ref_dists[i] = pose_nms_params->alpha * std::max(width, height);
+    float joints_score_sum = 0;
+    for (int j = 0; j < num_joints; j++) {
+      joints_score_sum += body_keypoints[i]->scores[j];
+    }
+    human_scores[i] = joints_score_sum / num_joints;
+    mask[i] = true;
+  }
+
+  while (num_valid_samples > 0) {
+    int pick_id;
+    for (int i = 0; i < num_samples; i++) {
+      if (mask[i]) {
+        pick_id = i;
+        break;
+      }
+    }
+    int relative_pick_id = 0;
+    for (int i = pick_id + 1; i < num_samples; i++) {
+      if (mask[i] && human_scores[i] > human_scores[pick_id]) {
+        pick_id = i;
+      }
+    }
+
+    // find overlap index
+    std::vector<float> dist;
+    std::vector<int> dist_indx;
+    for (int i = 0; i < num_samples; i++) {
+      if (i == pick_id) relative_pick_id = dist.size() / num_joints;
+      if (mask[i]) {
+        for (int j = 0; j < num_joints; j++) {
+          dist.push_back(
+              sqrt(pow(body_keypoints[i]->keypoints[j * 2] -
+                           body_keypoints[pick_id]->keypoints[j * 2],
+                       2) +
+                   pow(body_keypoints[i]->keypoints[j * 2 + 1] -
+                           body_keypoints[pick_id]->keypoints[j * 2 + 1],
+                       2)));
+          dist_indx.push_back(i * num_joints + j);
+        }
+      }
+    }
+
+    int keep_num = dist.size() / num_joints;
+    float* final_dist = new float[keep_num];
+    int* num_match_keypoints = new int[keep_num];
+    getParametricDistance(body_keypoints, dist, dist_indx, pick_id, num_joints,
+                          false, final_dist);
+    PCKMatch(dist, num_joints, ref_dists[pick_id], num_match_keypoints);
+    std::vector<int> delete_ids;
+    for (int i = 0; i < keep_num; i++) {
+      if (final_dist[i] > pose_nms_params->gamma ||
+          num_match_keypoints[i] >= pose_nms_params->matchThreds) {
+        int delete_id = dist_indx[i * num_joints] / num_joints;
+        delete_ids.push_back(i);
+        mask[delete_id] = false;
+        num_valid_samples -= 1;
+      }
+    }
+    delete[] final_dist;
+    delete[] num_match_keypoints;
+    if (delete_ids.size() == 0) {
+      delete_ids.push_back(relative_pick_id);
+      mask[pick_id] = false;
+      num_valid_samples -= 1;
+    }
+
+    float pick_max_score = 0;
+    for (int j = 0; j < num_joints; j++)
+      if (body_keypoints[pick_id]->scores[j] > pick_max_score)
+        pick_max_score = body_keypoints[pick_id]->scores[j];
+    if (pick_max_score < pose_nms_params->scoreThreds) continue;
+    pMergeFast(body_keypoints, delete_ids, dist, dist_indx, pick_id, num_joints,
+               ref_dists[pick_id]);
+    float merge_max_score = 0;
+    for (int j = 0; j < num_joints; j++)
+      if (body_keypoints[pick_id]->scores[j] > merge_max_score)
+        merge_max_score = body_keypoints[pick_id]->scores[j];
+    if (merge_max_score < pose_nms_params->scoreThreds) continue;
+    float xmax = body_keypoints[pick_id]->keypoints[0];
+    float xmin = xmax;
+    float ymax = body_keypoints[pick_id]->keypoints[1];
+    float ymin = ymax;
+    for (int j = 1; j < num_joints; j++) {
+      float cur_x = body_keypoints[pick_id]->keypoints[j * 2];
+      float cur_y = body_keypoints[pick_id]->keypoints[j * 2 + 1];
+      if (cur_x > xmax) xmax = cur_x;
+      if (cur_x < xmin) xmin = cur_x;
+      if (cur_y > ymax) ymax = cur_y;
+      if (cur_y < ymin) ymin = cur_y;
+    }
+    if (1.5 * 1.5 * (xmax - xmin) * (ymax - ymin) < area_thresh) continue;
+    pick_ids.push_back(pick_id);
+  }
+
+  delete[] ref_dists;
+  delete[] human_scores;
+  delete[] mask;
+}
+
+inline void ReferenceNMS::getParametricDistance(
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<float>& dist, std::vector<int>& dist_indx, int pick_id,
+    int num_joints, bool use_dist_mask, float* final_dist) {
+  for (int i = 0; i < dist.size(); i++) {
+    int joint_idx = i % num_joints;
+    if (joint_idx == 0) final_dist[i / num_joints] = 0;
+
+    bool mask = dist[i] <= 1;
+    bool dist_mask;
+    if (use_dist_mask) {
+      dist_mask = body_keypoints[dist_indx[i] / num_joints]
+                      ->scores[dist_indx[i] % num_joints] <
+                  pose_nms_params->scoreThreds;
+      mask &= dist_mask;
+    }
+
+    float score_dist = 0;
+    if (mask)
+      score_dist = tanh(body_keypoints[pick_id]->scores[joint_idx] /
+                        pose_nms_params->delta1) *
+                   tanh(body_keypoints[dist_indx[i] / num_joints]
+                            ->scores[dist_indx[i] % num_joints] /
+                        pose_nms_params->delta1);
+
+    if (use_dist_mask) {
+      float point_dist;
+      if (joint_idx < num_joints - 110) {
+        point_dist = exp((-1) * dist[i] / pose_nms_params->delta2);
+        final_dist[i / num_joints] +=
+            ((dist_mask ? score_dist
+                        : (score_dist + pose_nms_params->mu * point_dist)) /
+             (num_joints - 110));
+      } else if (joint_idx < num_joints - 42) {
+        point_dist =
+            exp((-1) * dist[i] /
+                (pose_nms_params->delta2 * pose_nms_params->face_factor));
+        final_dist[i / num_joints] +=
+            ((dist_mask ? score_dist * pose_nms_params->face_weight_score
+                        : (score_dist * pose_nms_params->face_weight_score +
+                           pose_nms_params->mu * point_dist *
+                               pose_nms_params->face_weight_dist)) /
+             68);
+      } else {
+        point_dist =
+            exp((-1) * dist[i] /
+                (pose_nms_params->delta2 * pose_nms_params->hand_factor));
+        final_dist[i / num_joints] +=
+            ((dist_mask ? score_dist * pose_nms_params->hand_weight_score
+                        : (score_dist * pose_nms_params->hand_weight_score +
+                           pose_nms_params->mu * point_dist *
+                               pose_nms_params->hand_weight_dist)) /
+             42);
+      }
+    } else {
+      float point_dist = exp((-1) * dist[i] / pose_nms_params->delta2);
+      final_dist[i / num_joints] +=
+          (score_dist + pose_nms_params->mu * point_dist);
+    }
+  }
+}
+
+inline void ReferenceNMS::PCKMatch(std::vector<float>& dist, int num_joints,
+                                   float ref_dist, int* num_match_keypoints) {
+  ref_dist = std::min(ref_dist, 7.f);
+  for (int i = 0; i < dist.size(); i++) {
+    int joint_idx = i % num_joints;
+    if (joint_idx == 0) num_match_keypoints[i / num_joints] = 0;
+
+    if (dist[i] / ref_dist <= 1) num_match_keypoints[i / num_joints] += 1;
+  }
+}
+
+inline void ReferenceNMS::PCKMatchFullBody(
+    std::vector<float>& dist,
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    int pick_id, int num_joints, float ref_dist, int* num_match_keypoints) {
+  int mask_num = 0;
+  int valid_num = dist.size() / num_joints;
+  for (int j = 0; j < num_joints; j++)
+    if (body_keypoints[pick_id]->scores[j] > pose_nms_params->scoreThreds / 2)
+      mask_num++;
+  if (mask_num * 2 * valid_num < 2) {
+    for (int i = 0; i < valid_num; i++) num_match_keypoints[i] = 0;
+    return;
+  }
+
+  int add_num = 1 / mask_num / 2 * num_joints;
+  ref_dist = std::min(ref_dist, 7.f);
+  for (int i = 0; i < dist.size(); i++) {
+    int joint_idx = i % num_joints;
+    if (joint_idx == 0) num_match_keypoints[i / num_joints] = 0;
+
+    if (joint_idx < 26 && dist[i] / ref_dist <= 1)
+      num_match_keypoints[i / num_joints] += add_num;
+    else if (26 <= joint_idx && joint_idx < 94 &&
+             dist[i] / ref_dist <= pose_nms_params->face_factor)
+      num_match_keypoints[i / num_joints] += add_num;
+    else if (94 <= joint_idx &&
+             dist[i] / ref_dist <= pose_nms_params->hand_factor)
+      num_match_keypoints[i / num_joints] += add_num;
+  }
+}
+
+inline void ReferenceNMS::pMergeFast(
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<int>& merge_ids, std::vector<float>& dist,
+    std::vector<int>& dist_indx, int pick_id, int num_joints, float ref_dist) {
+  ref_dist = std::min(ref_dist, 15.f);
+  float* normed_scores = new float[merge_ids.size() * num_joints];
+  float* sum_score = new float[num_joints];
+  for (int j = 0; j < num_joints; j++) sum_score[j] = 0;
+  for (int i = 0; i < merge_ids.size(); i++) {
+    for (int j = 0; j < num_joints; j++) {
+      if (dist[merge_ids[i] * num_joints + j] <= ref_dist) {
+        int offset = dist_indx[merge_ids[i] * num_joints + j];
+        normed_scores[i * num_joints + j] =
+            body_keypoints[offset / num_joints]->scores[offset % num_joints];
+        sum_score[j] += normed_scores[i * num_joints + j];
+      } else
+        normed_scores[i * num_joints + j] = 0;
+    }
+  }
+
+  for (int i = 0; i < merge_ids.size(); i++) {
+    for (int j = 0; j < num_joints; j++) {
+      normed_scores[i * num_joints + j] /= sum_score[j];
+    }
+  }
+
+  for (int j = 0; j < num_joints; j++) {
+    float final_pose1 = 0, final_pose2 = 0, final_score = 0;
+    for (int i = 0; i < merge_ids.size(); i++) {
+      final_pose1 +=
+          (body_keypoints[dist_indx[merge_ids[i] * num_joints + j] / num_joints]
+               ->keypoints[j * 2] *
+           normed_scores[i * num_joints + j]);
+      final_pose2 +=
+          (body_keypoints[dist_indx[merge_ids[i] * num_joints + j] / num_joints]
+               ->keypoints[j * 2 + 1] *
+           normed_scores[i * num_joints + j]);
+      final_score += (pow(normed_scores[i * num_joints + j], 2) * sum_score[j]);
+    }
+    body_keypoints[pick_id]->keypoints[j * 2] = final_pose1;
+    body_keypoints[pick_id]->keypoints[j * 2 + 1] = final_pose2;
+    body_keypoints[pick_id]->scores[j] = final_score;
+  }
+  delete[] normed_scores;
+  delete[] sum_score;
+}
+
+inline void ReferenceNMS::poseNMSFullBody(
+    std::vector<std::shared_ptr<common::DetectedObjectMetadata>>& det_data,
+    int num_samples, int num_joints, float area_thresh,
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& body_keypoints,
+    std::vector<int>& pick_ids) {
+  float* ref_dists = new float[num_samples];
+  float* human_scores = new float[num_samples];
+  bool* mask = new bool[num_samples];
+  int num_valid_samples = num_samples;
+  for (int i = 0; i < num_samples; i++) {
+    float width = det_data[i]->mBox.mWidth, height = det_data[i]->mBox.mHeight;
+    ref_dists[i] = pose_nms_params->alpha * std::max(width, height);
+    float joints_score_sum = 0;
+    for (int j = 0; j < num_joints; j++) {
+      joints_score_sum += body_keypoints[i]->scores[j];
+    }
+    human_scores[i] = joints_score_sum / num_joints;
+    mask[i] = true;
+  }
+
+  while (num_valid_samples > 0) {
+    int pick_id;
+    for (int i = 0; i < num_samples; i++) {
+      if (mask[i]) {
+        pick_id = i;
+        break;
+      }
+    }
+    int relative_pick_id = 0;
+    for (int i = pick_id + 1; i < num_samples; i++) {
+      if (mask[i] && human_scores[i] > human_scores[pick_id]) {
+        pick_id = i;
+      }
+    }
+
+    // find overlap index
+    std::vector<float> dist;
+    std::vector<int> dist_indx;
+    for (int i = 0; i < num_samples; i++) {
+      if (i == pick_id) relative_pick_id = dist.size() / num_joints;
+      if (mask[i]) {
+        for (int j = 0; j < num_joints; j++) {
+          dist.push_back(
+              sqrt(pow(body_keypoints[i]->keypoints[j * 2] -
+                           body_keypoints[pick_id]->keypoints[j * 2],
+                       2) +
+                   pow(body_keypoints[i]->keypoints[j * 2 + 1] -
+                           body_keypoints[pick_id]->keypoints[j * 2 + 1],
+                       2.0)));
+          dist_indx.push_back(i * num_joints + j);
+        }
+      }
+    }
+
+    int keep_num = dist.size() / num_joints;
+    float* final_dist = new float[keep_num];
+    int* num_match_keypoints = new int[keep_num];
+    getParametricDistance(body_keypoints, dist, dist_indx, pick_id, num_joints,
+                          true, final_dist);
+    PCKMatchFullBody(dist, body_keypoints, pick_id, num_joints,
+                     ref_dists[pick_id], num_match_keypoints);
+    std::vector<int> delete_ids;
+    for (int i = 0; i < keep_num; i++) {
+      if (final_dist[i] > pose_nms_params->gamma ||
+          num_match_keypoints[i] >= pose_nms_params->matchThreds) {
+        int delete_id = dist_indx[i * num_joints] / num_joints;
+        delete_ids.push_back(i);
+        mask[delete_id] = false;
+        num_valid_samples -= 1;
+      }
+    }
+    delete[] final_dist;
+    delete[] num_match_keypoints;
+    if (delete_ids.size() == 0) {
+      delete_ids.push_back(relative_pick_id);
+      mask[pick_id] = false;
+      num_valid_samples -= 1;
+    }
+
+    float pick_max_score = 0;
+    for (int j = 0; j < num_joints; j++)
+      if (body_keypoints[pick_id]->scores[j] > pick_max_score)
+        pick_max_score = body_keypoints[pick_id]->scores[j];
+    if (pick_max_score < pose_nms_params->scoreThreds) continue;
+    pMergeFast(body_keypoints, delete_ids, dist, dist_indx, pick_id, num_joints,
+               ref_dists[pick_id]);
+    float merge_max_score = 0;
+    for (int j = 0; j < num_joints; j++)
+      if (body_keypoints[pick_id]->scores[j] > merge_max_score)
+        merge_max_score = body_keypoints[pick_id]->scores[j];
+    if (merge_max_score < pose_nms_params->scoreThreds) continue;
+    float xmax = body_keypoints[pick_id]->keypoints[0];
+    float xmin = xmax;
+    float ymax = body_keypoints[pick_id]->keypoints[1];
+    float ymin = ymax;
+    for (int j = 1; j < num_joints; j++) {
+      float cur_x = body_keypoints[pick_id]->keypoints[j * 2];
+      float cur_y = body_keypoints[pick_id]->keypoints[j * 2 + 1];
+      if (cur_x > xmax) xmax = cur_x;
+      if (cur_x < xmin) xmin = cur_x;
+      if (cur_y > ymax) ymax = cur_y;
+      if (cur_y < ymin) ymin = cur_y;
+    }
+    if (1.5 * 1.5 * (xmax - xmin) * (ymax - ymin) < area_thresh) continue;
+    pick_ids.push_back(pick_id);
+  }
+
+  delete[] ref_dists;
+  delete[] human_scores;
+  delete[] mask;
+}
+
+// 与FastposePostProcess::init中的参数一致
+inline PoseNMSParams makeParams(bool full_body) {
+  PoseNMSParams params;
+  params.face_factor = 1.9;
+  params.hand_factor = 0.55;
+  params.hand_weight_score = 0.1;
+  params.face_weight_score = 1.0;
+  params.hand_weight_dist = 1.5;
+  params.face_weight_dist = 1.0;
+  if (full_body) {
+    params.delta1 = 1.0;
+    params.mu = 1.65;
+    params.delta2 = 8.0;
+    params.gamma = 3.6;
+    params.scoreThreds = 0.01;
+    params.matchThreds = 3.0;
+    params.alpha = 0.15;
+  } else {
+    params.delta1 = 1.0;
+    params.mu = 1.7;
+    params.delta2 = 2.65;
+    params.gamma = 22.48;
+    params.scoreThreds = 0.3;
+    params.matchThreds = 5.0;
+    params.alpha = 0.1;
+  }
+  return params;
+}
+
+struct Scene {
+  Detections det_data;
+  Poses body_keypoints;
+};
+
+// 人站成若干排，每人由检测器给出1~4个略有偏移的框，关键点带噪声；
+// spread小于1时人之间的间距按比例缩小
+inline Scene makeScene(std::mt19937& rng, int num_people, int num_joints,
+                       float spread = 1.f) {
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::normal_distribution<float> noise(0.f, 1.f);
+  std::vector<float> skeleton(num_joints * 2);
+  for (int j = 0; j < num_joints; j++) {
+    skeleton[j * 2] = uniform(rng) * 60.f;
+    skeleton[j * 2 + 1] = (float)j / num_joints * 160.f;
+  }
+
+  Scene scene;
+  int per_row = 16;
+  for (int p = 0; p < num_people; p++) {
+    float cx = (p % per_row) * 55.f * spread + uniform(rng) * 20.f;
+    float cy = (p / per_row) * 70.f * spread + uniform(rng) * 20.f;
+    float scale = 0.8f + uniform(rng) * 0.4f;
+    float person_score = 0.2f + uniform(rng) * 0.8f;
+    int duplicates = 1 + rng() % 4;
+    for (int d = 0; d < duplicates; d++) {
+      float jitter = d == 0 ? 0.f : 3.f;
+      auto det = std::make_shared<common::DetectedObjectMetadata>();
+      det->mBox.mX = cx + noise(rng) * jitter;
+      det->mBox.mY = cy + noise(rng) * jitter;
+      det->mBox.mWidth = 60.f * scale;
+      det->mBox.mHeight = 160.f * scale;
+      auto pose = std::make_shared<common::PosedObjectMetadata>();
+      for (int j = 0; j < num_joints; j++) {
+        pose->keypoints.push_back(cx + skeleton[j * 2] * scale +
+                                  noise(rng) * (1.f + jitter));
+        pose->keypoints.push_back(cy + skeleton[j * 2 + 1] * scale +
+                                  noise(rng) * (1.f + jitter));
+        pose->scores.push_back(
+            std::max(1e-5f, person_score * (0.5f + uniform(rng) * 0.5f)));
+      }
+      scene.det_data.push_back(det);
+      scene.body_keypoints.push_back(pose);
+    }
+  }
+  return scene;
+}
+
+inline Poses clonePoses(const Poses& poses) {
+  Poses copy;
+  for (auto& pose : poses)
+    copy.push_back(std::make_shared<common::PosedObjectMetadata>(*pose));
+  return copy;
+}
+
+inline bool samePoses(const Poses& a, const Poses& b) {
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i]->keypoints.size() != b[i]->keypoints.size() ||
+        a[i]->scores.size() != b[i]->scores.size())
+      return false;
+    if (memcmp(a[i]->keypoints.data(), b[i]->keypoints.data(),
+               a[i]->keypoints.size() * sizeof(float)) != 0 ||
+        memcmp(a[i]->scores.data(), b[i]->scores.data(),
+               a[i]->scores.size() * sizeof(float)) != 0)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace pose_nms_reference
+
+#endif  // SOPHON_STREAM_TEST_POSE_NMS_REFERENCE_H_
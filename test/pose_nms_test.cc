@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "fastpose_pose_nms.h"
+
+#include <gtest/gtest.h>
+
+#include "pose_nms_reference.h"
+
+namespace pose_nms_reference {
+namespace {
+
+using element::fastpose::PoseNMS;
+
+/**
+ * @brief 在合成场景上运行PoseNMS和旧实现，要求保留的下标、合并后的关键点和
+ * 分数逐位一致
+ */
+void expectIdentical(int num_joints, int num_people, int frames,
+                     float spread = 1.f) {
+  bool full_body = num_joints == 136 || num_joints == 133;
+  PoseNMSParams params = makeParams(full_body);
+  ReferenceNMS reference;
+  reference.pose_nms_params = std::make_shared<PoseNMSParams>(params);
+  PoseNMS pose_nms(params);
+  float area_thresh = full_body ? 0.f : 100.f;
+  std::mt19937 rng(num_joints * 1000 + num_people);
+  size_t picked = 0;
+  for (int f = 0; f < frames; f++) {
+    Scene scene = makeScene(rng, num_people, num_joints, spread);
+    Poses ref_poses = clonePoses(scene.body_keypoints);
+    Poses new_poses = clonePoses(scene.body_keypoints);
+    std::vector<int> ref_ids, new_ids;
+    reference.poseNMS(scene.det_data, scene.det_data.size(), num_joints,
+                      area_thresh, ref_poses, ref_ids);
+    pose_nms.run(scene.det_data, num_joints, area_thresh, new_poses, new_ids);
+    ASSERT_EQ(ref_ids, new_ids) << "frame " << f;
+    ASSERT_TRUE(samePoses(ref_poses, new_poses)) << "frame " << f;
+    picked += new_ids.size();
+  }
+  EXPECT_GT(picked, 0u);
+}
+
+TEST(PoseNMSTest, Body17MatchesReference) {
+  expectIdentical(17, 10, 20);
+  expectIdentical(17, 100, 5);
+}
+
+TEST(PoseNMSTest, Body26MatchesReference) {
+  expectIdentical(26, 10, 20);
+  expectIdentical(26, 100, 5);
+}
+
+TEST(PoseNMSTest, FullBodyMatchesReference) {
+  expectIdentical(136, 10, 10);
+  expectIdentical(136, 40, 2);
+}
+
+TEST(PoseNMSTest, OverlappingCrowdMatchesReference) {
+  // 人之间只隔几个像素，包围框预判几乎不能排除候选
+  expectIdentical(17, 40, 10, 0.1f);
+  expectIdentical(136, 20, 2, 0.1f);
+}
+
+TEST(PoseNMSTest, SinglePose) {
+  expectIdentical(17, 1, 5);
+}
+
+}  // namespace
+}  // namespace pose_nms_reference
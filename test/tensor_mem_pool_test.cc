@@ -0,0 +1,285 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/tensor_mem_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/memory_budget.h"
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+/**
+ * @brief 记录调用次数的HostMemAllocator，capacity不为0时超出容量的申请失败
+ */
+class CountingAllocator : public HostMemAllocator {
+ public:
+  explicit CountingAllocator(std::size_t capacity = 0) : mCapacity(capacity) {}
+
+  bm_status_t allocate(bm_device_mem_t* mem, int heapId,
+                       unsigned int bytes) override {
+    if (mCapacity > 0 && mBytes + bytes > mCapacity) return BM_ERR_NOMEM;
+    auto ret = HostMemAllocator::allocate(mem, heapId, bytes);
+    if (BM_SUCCESS == ret) {
+      mBytes += bytes;
+      mAllocs++;
+    }
+    return ret;
+  }
+
+  void free(bm_device_mem_t& mem) override {
+    mBytes -= bm_mem_get_device_size(mem);
+    mFrees++;
+    HostMemAllocator::free(mem);
+  }
+
+  std::size_t mCapacity;
+  std::size_t mBytes = 0;
+  int mAllocs = 0;
+  int mFrees = 0;
+};
+
+TEST(TensorMemPoolTest, SizeClassRounding) {
+  EXPECT_EQ(4096u, TensorMemPool::sizeClass(0));
+  EXPECT_EQ(4096u, TensorMemPool::sizeClass(1));
+  EXPECT_EQ(4096u, TensorMemPool::sizeClass(4096));
+  EXPECT_EQ(8192u, TensorMemPool::sizeClass(4097));
+  EXPECT_EQ(65536u, TensorMemPool::sizeClass(65536));
+  // 64KB以上按2的幂区间的1/8对齐
+  EXPECT_EQ(73728u, TensorMemPool::sizeClass(65537));
+  EXPECT_EQ(106496u, TensorMemPool::sizeClass(100000));
+  EXPECT_EQ(1u << 20, TensorMemPool::sizeClass(1u << 20));
+  EXPECT_EQ(1179648u, TensorMemPool::sizeClass((1u << 20) + 1));
+  // 640x640x3 float，yolo类网络的单帧输入
+  EXPECT_EQ(5242880u, TensorMemPool::sizeClass(640 * 640 * 3 * 4));
+
+  for (unsigned int bytes = 1; bytes < (64u << 20); bytes = bytes * 3 + 7) {
+    unsigned int classBytes = TensorMemPool::sizeClass(bytes);
+    EXPECT_GE(classBytes, bytes);
+    EXPECT_EQ(0u, classBytes % 4096);
+    if (bytes > 65536) EXPECT_LE(classBytes - bytes, bytes / 8 + 8192);
+    EXPECT_EQ(classBytes, TensorMemPool::sizeClass(classBytes));
+  }
+}
+
+TEST(TensorMemPoolTest, RecycleOnRelease) {
+  auto allocator = std::make_shared<CountingAllocator>();
+  TensorMemPool pool(allocator, 0);
+
+  bm_device_mem_t first;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(100000, &first));
+  EXPECT_EQ(106496u, bm_mem_get_device_size(first));
+  unsigned long long addr = bm_mem_get_device_addr(first);
+  EXPECT_TRUE(pool.release(first));
+  EXPECT_EQ(0, allocator->mFrees);
+
+  // 同一size class的请求复用刚归还的显存
+  bm_device_mem_t second;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(105000, &second));
+  EXPECT_EQ(addr, bm_mem_get_device_addr(second));
+  EXPECT_EQ(1, allocator->mAllocs);
+
+  // 不同size class不复用
+  bm_device_mem_t third;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &third));
+  EXPECT_NE(addr, bm_mem_get_device_addr(third));
+  EXPECT_EQ(2, allocator->mAllocs);
+
+  // 调用者改写过size也按acquire时的size class缓存
+  second.size = 16;
+  EXPECT_TRUE(pool.release(second));
+  EXPECT_TRUE(pool.release(third));
+  auto stats = pool.getStats();
+  EXPECT_EQ(3u, stats.mAcquireCount);
+  EXPECT_EQ(1u, stats.mHitCount);
+  EXPECT_EQ(0u, stats.mBytesInUse);
+  EXPECT_EQ(106496u + 4096u, stats.mBytesCached);
+
+  pool.trim();
+  EXPECT_EQ(2, allocator->mFrees);
+  EXPECT_EQ(0u, allocator->mBytes);
+  EXPECT_EQ(0u, pool.getStats().mBytesCached);
+}
+
+TEST(TensorMemPoolTest, ReleaseForeignMemory) {
+  auto allocator = std::make_shared<CountingAllocator>();
+  TensorMemPool pool(allocator, 0);
+  bm_device_mem_t foreign;
+  ASSERT_EQ(BM_SUCCESS, allocator->allocate(&foreign, 0, 4096));
+  EXPECT_FALSE(pool.release(foreign));
+  EXPECT_EQ(0u, pool.getStats().mBytesCached);
+  allocator->free(foreign);
+}
+
+TEST(TensorMemPoolTest, MaxCachedBytes) {
+  auto allocator = std::make_shared<CountingAllocator>();
+  TensorMemPool pool(allocator, 0, 8192);
+  std::vector<bm_device_mem_t> mems(3);
+  for (auto& mem : mems) ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &mem));
+  for (auto& mem : mems) EXPECT_TRUE(pool.release(mem));
+  // 超出缓存上限的显存直接还给驱动
+  EXPECT_EQ(1, allocator->mFrees);
+  EXPECT_EQ(8192u, pool.getStats().mBytesCached);
+
+  pool.setMaxCachedBytes(0);
+  bm_device_mem_t mem;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &mem));
+  EXPECT_TRUE(pool.release(mem));
+  EXPECT_EQ(2, allocator->mFrees);
+}
+
+TEST(TensorMemPoolTest, ReservePrewarms) {
+  auto allocator = std::make_shared<CountingAllocator>();
+  TensorMemPool pool(allocator, 0);
+  pool.reserve(640 * 640 * 3, 3);
+  EXPECT_EQ(3, allocator->mAllocs);
+  unsigned int classBytes = TensorMemPool::sizeClass(640 * 640 * 3);
+  EXPECT_EQ(3u * classBytes, pool.getStats().mBytesCached);
+
+  // 已有足够的空闲显存时不再申请
+  pool.reserve(640 * 640 * 3, 2);
+  EXPECT_EQ(3, allocator->mAllocs);
+
+  std::vector<bm_device_mem_t> mems(4);
+  for (auto& mem : mems) ASSERT_EQ(BM_SUCCESS, pool.acquire(640 * 640 * 3, &mem));
+  auto stats = pool.getStats();
+  EXPECT_EQ(3u, stats.mHitCount);
+  EXPECT_EQ(4u, stats.mDriverAllocs);
+  for (auto& mem : mems) pool.release(mem);
+
+  // reserve受缓存上限约束
+  TensorMemPool small(allocator, 0, 2 * 4096);
+  small.reserve(4096, 5);
+  EXPECT_EQ(2u * 4096, small.getStats().mBytesCached);
+}
+
+TEST(TensorMemPoolTest, HighWaterMarks) {
+  auto allocator = std::make_shared<CountingAllocator>();
+  TensorMemPool pool(allocator, 0);
+  bm_device_mem_t a, b, c;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &a));
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(8192, &b));
+  EXPECT_TRUE(pool.release(a));
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(16384, &c));
+
+  auto stats = pool.getStats();
+  EXPECT_EQ(8192u + 16384u, stats.mBytesInUse);
+  EXPECT_EQ(8192u + 16384u, stats.mPeakBytesInUse);
+  EXPECT_EQ(4096u + 8192u + 16384u, stats.mPeakBytesTotal);
+
+  EXPECT_TRUE(pool.release(b));
+  EXPECT_TRUE(pool.release(c));
+  stats = pool.getStats();
+  EXPECT_EQ(0u, stats.mBytesInUse);
+  EXPECT_EQ(8192u + 16384u, stats.mPeakBytesInUse);
+  EXPECT_EQ(4096u + 8192u + 16384u, stats.mPeakBytesTotal);
+}
+
+TEST(TensorMemPoolTest, TrimCacheWhenDriverIsFull) {
+  auto allocator = std::make_shared<CountingAllocator>(3 * 4096);
+  TensorMemPool pool(allocator, 0);
+  std::vector<bm_device_mem_t> mems(3);
+  for (auto& mem : mems) ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &mem));
+  for (auto& mem : mems) pool.release(mem);
+
+  // 缓存占满了驱动容量，先把空闲显存还给驱动再申请
+  bm_device_mem_t large;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(2 * 4096, &large));
+  EXPECT_EQ(3, allocator->mFrees);
+  EXPECT_EQ(0u, pool.getStats().mBytesCached);
+
+  bm_device_mem_t tooLarge;
+  EXPECT_NE(BM_SUCCESS, pool.acquire(2 * 4096, &tooLarge));
+  EXPECT_EQ(2u * 4096, pool.getStats().mBytesInUse);
+  pool.release(large);
+}
+
+TEST(TensorMemPoolTest, RecycleFallsBackToAllocator) {
+  std::vector<std::shared_ptr<CountingAllocator>> created;
+  TensorMemPool::setAllocatorFactory([&created](int devId) {
+    created.push_back(std::make_shared<CountingAllocator>());
+    return created.back();
+  });
+  // 显存池注册表在进程内常驻，使用其他用例不会用到的设备号
+  const int devId = 901;
+  auto pool = TensorMemPool::getInstance(devId, 0);
+  EXPECT_EQ(pool, TensorMemPool::getInstance(devId, 0));
+  ASSERT_EQ(1u, created.size());
+  TensorMemPool::setAllocatorFactory(nullptr);
+
+  CountingAllocator fallback;
+  bm_device_mem_t pooled;
+  ASSERT_EQ(BM_SUCCESS, pool->acquire(4096, &pooled));
+  bm_device_mem_t copy = pooled;
+  TensorMemPool::recycle(devId, pooled, fallback);
+  EXPECT_EQ(0, fallback.mFrees);
+  EXPECT_EQ(4096u, pool->getStats().mBytesCached);
+
+  // 不属于任何显存池，或属于其他设备的显存池
+  bm_device_mem_t foreign;
+  ASSERT_EQ(BM_SUCCESS, fallback.allocate(&foreign, 0, 4096));
+  TensorMemPool::recycle(devId, foreign, fallback);
+  EXPECT_EQ(1, fallback.mFrees);
+
+  ASSERT_EQ(BM_SUCCESS, pool->acquire(4096, &pooled));
+  EXPECT_EQ(bm_mem_get_device_addr(copy), bm_mem_get_device_addr(pooled));
+  ASSERT_EQ(BM_SUCCESS, fallback.allocate(&foreign, 0, 4096));
+  bm_device_mem_t other = foreign;
+  TensorMemPool::recycle(devId + 1, other, fallback);
+  EXPECT_EQ(2, fallback.mFrees);
+  TensorMemPool::recycle(devId, pooled, fallback);
+  EXPECT_EQ(2, fallback.mFrees);
+  pool->trim();
+  EXPECT_EQ(0u, created[0]->mBytes);
+}
+
+TEST(TensorMemPoolTest, ChargesLendingGraph) {
+  const int devId = 911;
+  const int graphId = 911;
+  auto& budget = MemoryBudget::getInstance();
+  TensorMemPool pool(std::make_shared<CountingAllocator>(), 0);
+  pool.setDeviceId(devId);
+
+  MemoryBudget::setThreadGraph(graphId);
+  bm_device_mem_t mem;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(8192, &mem));
+  MemoryBudget::setThreadGraph(-1);
+  EXPECT_EQ(8192u, budget.getGraphUsage(graphId).mBytesInFlight);
+  EXPECT_EQ(8192u, budget.getDeviceUsage(devId).mBytesInFlight);
+
+  // 没有设置graph的线程借出的显存只计入设备
+  bm_device_mem_t deviceOnly;
+  ASSERT_EQ(BM_SUCCESS, pool.acquire(4096, &deviceOnly));
+  EXPECT_EQ(8192u, budget.getGraphUsage(graphId).mBytesInFlight);
+  EXPECT_EQ(8192u + 4096u, budget.getDeviceUsage(devId).mBytesInFlight);
+
+  // tensor显存参与graph的准入判断
+  budget.setGraphBudget(graphId, 8192 + 2048);
+  EXPECT_FALSE(budget.waitForAdmission(graphId, devId, 4096, 0));
+
+  // 在其他线程归还时仍从借出时的graph中扣除
+  std::thread([&]() {
+    pool.release(mem);
+    pool.release(deviceOnly);
+  }).join();
+  EXPECT_EQ(0u, budget.getGraphUsage(graphId).mBytesInFlight);
+  EXPECT_EQ(0u, budget.getDeviceUsage(devId).mBytesInFlight);
+  EXPECT_TRUE(budget.waitForAdmission(graphId, devId, 4096, 0));
+  budget.setGraphBudget(graphId, 0);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
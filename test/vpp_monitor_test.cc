@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/vpp_monitor.h"
+
+#include <gtest/gtest.h>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+// 每个用例使用不同的设备号，互不影响
+void submit(VppMonitor& monitor, double perImageUs, bool idle,
+            int images = 1) {
+  bool wasIdle = monitor.begin();
+  monitor.end(images, perImageUs * images, idle && wasIdle);
+}
+
+TEST(VppMonitorTest, InflightLimitSaturates) {
+  auto& monitor = VppMonitor::getInstance(801);
+  bool first = monitor.begin();
+  EXPECT_TRUE(first);
+  EXPECT_FALSE(monitor.isSaturated());
+  bool second = monitor.begin();
+  EXPECT_FALSE(second);
+  EXPECT_EQ(monitor.getInflight(), 2);
+  EXPECT_TRUE(monitor.isSaturated());
+  monitor.end(1, 100.0, second);
+  monitor.end(1, 100.0, first);
+  EXPECT_EQ(monitor.getInflight(), 0);
+  EXPECT_FALSE(monitor.isSaturated());
+}
+
+TEST(VppMonitorTest, BaselineUsesIdleSamplesOnly) {
+  auto& monitor = VppMonitor::getInstance(802);
+  submit(monitor, 250.0, true, 4);
+  EXPECT_DOUBLE_EQ(monitor.getBaselineUs(), 250.0);
+  EXPECT_DOUBLE_EQ(monitor.getLatencyUs(), 250.0);
+
+  // 排队中的样本只影响滑动平均，不影响基线
+  submit(monitor, 100.0, false);
+  EXPECT_DOUBLE_EQ(monitor.getBaselineUs(), 250.0);
+  EXPECT_DOUBLE_EQ(monitor.getLatencyUs(), 0.9 * 250.0 + 0.1 * 100.0);
+
+  // 基线取窗口内空闲样本的最小值
+  submit(monitor, 200.0, true);
+  EXPECT_DOUBLE_EQ(monitor.getBaselineUs(), 200.0);
+  submit(monitor, 300.0, true);
+  EXPECT_DOUBLE_EQ(monitor.getBaselineUs(), 200.0);
+}
+
+TEST(VppMonitorTest, LatencyHysteresis) {
+  auto& monitor = VppMonitor::getInstance(803);
+  submit(monitor, 100.0, true);
+  ASSERT_DOUBLE_EQ(monitor.getBaselineUs(), 100.0);
+  EXPECT_FALSE(monitor.isSaturated());
+
+  // 耗时升高，超过基线2倍后进入饱和
+  int steps = 0;
+  while (!monitor.isSaturated()) {
+    ASSERT_LT(monitor.getLatencyUs(), 200.0 + 1e-9);
+    submit(monitor, 400.0, false);
+    ASSERT_LT(++steps, 100);
+  }
+  EXPECT_GT(monitor.getLatencyUs(), 200.0);
+
+  // 耗时回落到基线的1.5~2倍之间，保持饱和
+  while (monitor.getLatencyUs() > 180.0) {
+    submit(monitor, 170.0, false);
+    EXPECT_TRUE(monitor.isSaturated());
+  }
+  for (int i = 0; i < 50; ++i) {
+    submit(monitor, 170.0, false);
+    EXPECT_TRUE(monitor.isSaturated());
+  }
+
+  // 降到1.5倍以下才退出
+  while (monitor.getLatencyUs() >= 150.0) {
+    EXPECT_TRUE(monitor.isSaturated());
+    submit(monitor, 100.0, false);
+  }
+  EXPECT_FALSE(monitor.isSaturated());
+
+  // 再回到1.5~2倍之间，保持不饱和
+  for (int i = 0; i < 50; ++i) {
+    submit(monitor, 170.0, false);
+    EXPECT_FALSE(monitor.isSaturated());
+  }
+}
+
+TEST(VppMonitorTest, InflightLimitOverridesLatency) {
+  auto& monitor = VppMonitor::getInstance(804);
+  submit(monitor, 100.0, true);
+  bool first = monitor.begin();
+  bool second = monitor.begin();
+  EXPECT_TRUE(monitor.isSaturated());
+  monitor.end(1, 100.0, second);
+  monitor.end(1, 100.0, first);
+  EXPECT_FALSE(monitor.isSaturated());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
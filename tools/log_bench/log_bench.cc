@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// 测量流水线线程上每条日志的耗时，用法见README.md
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/logger.h"
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Func>
+double measure(int threads, int count, Func func) {
+  std::vector<double> nsPerLog(threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      auto start = Clock::now();
+      for (int i = 0; i < count; ++i) func(t, i);
+      auto end = Clock::now();
+      nsPerLog[t] =
+          std::chrono::duration<double, std::nano>(end - start).count() /
+          count;
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  double sum = 0;
+  for (double ns : nsPerLog) sum += ns;
+  return sum / threads;
+}
+
+int main(int argc, char* argv[]) {
+  int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+  int count = argc > 2 ? std::atoi(argv[2]) : 2000;
+  std::string path = argc > 3 ? argv[3] : "log_bench.log";
+  logInit("info", path);
+
+#ifdef STREAM_LOG_ASYNC
+  const char* mode = "async";
+#else
+  const char* mode = "sync";
+#endif
+  std::fprintf(stderr, "mode %s, active level %d, %d threads x %d logs\n", mode,
+               STREAM_LOG_ACTIVE_LEVEL, threads, count);
+
+  double info = measure(threads, count, [](int t, int i) {
+    IVS_INFO("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}", 0,
+             t, i);
+  });
+  std::fprintf(stderr, "IVS_INFO              %8.1f ns/log\n", info);
+
+  double debug = measure(threads, count, [](int t, int i) {
+    IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}", 0,
+              t, i);
+  });
+  std::fprintf(stderr, "IVS_DEBUG (disabled)  %8.1f ns/log\n", debug);
+
+  double every = measure(threads, count, [](int t, int i) {
+    IVS_INFO_EVERY_MS(1000, "DataPipe is full, channel_id = {0}, frame_id = {1}",
+                      t, i);
+  });
+  std::fprintf(stderr, "IVS_INFO_EVERY_MS     %8.1f ns/log\n", every);
+
+  return 0;
+}
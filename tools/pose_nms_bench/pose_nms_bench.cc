@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// 用合成的密集人群比较fastpose姿态NMS新旧实现的结果和耗时，用法见README.md
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "pose_nms_reference.h"
+
+using namespace pose_nms_reference;
+using element::fastpose::PoseNMS;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+  int frames = argc > 1 ? atoi(argv[1]) : 200;
+  const int joints[] = {17, 26, 136};
+  const int people[] = {10, 40, 100};
+  bool identical = true;
+  printf("%7s %7s %7s %14s %14s %8s\n", "joints", "people", "boxes",
+         "reference(us)", "pose_nms(us)", "speedup");
+  for (int num_joints : joints) {
+    bool full_body = num_joints == 136 || num_joints == 133;
+    PoseNMSParams params = makeParams(full_body);
+    ReferenceNMS reference;
+    reference.pose_nms_params = std::make_shared<PoseNMSParams>(params);
+    PoseNMS pose_nms(params);
+    float area_thresh = full_body ? 0.f : 100.f;
+    for (int num_people : people) {
+      std::mt19937 rng(num_joints * 1000 + num_people);
+      double ref_us = 0, new_us = 0;
+      size_t boxes = 0;
+      for (int f = 0; f < frames; f++) {
+        Scene scene = makeScene(rng, num_people, num_joints);
+        boxes += scene.det_data.size();
+        Poses ref_poses = clonePoses(scene.body_keypoints);
+        Poses new_poses = clonePoses(scene.body_keypoints);
+        std::vector<int> ref_ids, new_ids;
+
+        auto start = Clock::now();
+        reference.poseNMS(scene.det_data, scene.det_data.size(), num_joints,
+                          area_thresh, ref_poses, ref_ids);
+        auto mid = Clock::now();
+        pose_nms.run(scene.det_data, num_joints, area_thresh, new_poses,
+                     new_ids);
+        auto end = Clock::now();
+        ref_us +=
+            std::chrono::duration<double, std::micro>(mid - start).count();
+        new_us += std::chrono::duration<double, std::micro>(end - mid).count();
+
+        if (ref_ids != new_ids || !samePoses(ref_poses, new_poses)) {
+          fprintf(stderr, "mismatch: joints %d, people %d, frame %d\n",
+                  num_joints, num_people, f);
+          identical = false;
+        }
+      }
+      printf("%7d %7d %7.1f %14.1f %14.1f %7.2fx\n", num_joints, num_people,
+             (double)boxes / frames, ref_us / frames, new_us / frames,
+             ref_us / new_us);
+    }
+  }
+  printf(identical ? "results identical\n" : "results differ\n");
+  return identical ? 0 : 1;
+}